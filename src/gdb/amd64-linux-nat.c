@@ -23,6 +23,7 @@
 #include "inferior.h"
 #include "gdbcore.h"
 #include "regcache.h"
+#include "objfiles.h"
 #include "linux-nat.h"
 #include "amd64-linux-tdep.h"
 
@@ -400,6 +401,164 @@ amd64_linux_child_post_startup_inferior (ptid_t ptid)
 }
 
 
+/* Make LWP PTID make system call NR32, or NR64 in a 64-bit program,
+   with arguments ARG1, ARG2 and ARG3, by placing a system call
+   instruction near the program's entry point, past the copies
+   displaced stepping makes there, and single-stepping it with the
+   arguments in registers.  Store the call's result in *RESULT and
+   return zero if it was made.  */
+
+static int
+amd64_linux_inferior_syscall (ptid_t ptid, int nr32, int nr64,
+			      ULONGEST arg1, ULONGEST arg2, ULONGEST arg3,
+			      LONGEST *result)
+{
+  struct user_regs_struct regs, saved_regs;
+  CORE_ADDR scratch;
+  long saved_insn, insn;
+  int tid, ok;
+
+  tid = TIDGET (ptid);
+  if (tid == 0)
+    tid = PIDGET (ptid);
+
+  scratch = entry_point_address ();
+  if (scratch == 0)
+    return -1;
+  scratch += 32;
+
+  errno = 0;
+  ptrace (PTRACE_GETREGS, tid, 0, (long) &saved_regs);
+  if (errno != 0)
+    return -1;
+  saved_insn = ptrace (PTRACE_PEEKTEXT, tid, scratch, 0);
+  if (errno != 0)
+    return -1;
+
+  regs = saved_regs;
+  regs.rip = scratch;
+  /* Don't let the kernel restart an interrupted system call.  */
+  regs.orig_rax = -1;
+  if (gdbarch_ptr_bit (current_gdbarch) == 32)
+    {
+      /* int $0x80, with the i386 numbering and calling
+	 convention.  */
+      insn = (saved_insn & ~0xffffL) | 0x80cd;
+      regs.rax = nr32;
+      regs.rbx = arg1;
+      regs.rcx = arg2;
+      regs.rdx = arg3;
+    }
+  else
+    {
+      /* syscall.  */
+      insn = (saved_insn & ~0xffffL) | 0x050f;
+      regs.rax = nr64;
+      regs.rdi = arg1;
+      regs.rsi = arg2;
+      regs.rdx = arg3;
+    }
+
+  ptrace (PTRACE_POKETEXT, tid, scratch, insn);
+  ptrace (PTRACE_SETREGS, tid, 0, (long) &regs);
+  if (errno != 0)
+    {
+      ptrace (PTRACE_POKETEXT, tid, scratch, saved_insn);
+      ptrace (PTRACE_SETREGS, tid, 0, (long) &saved_regs);
+      return -1;
+    }
+
+  ok = linux_nat_step_lwp (ptid);
+  if (ok)
+    ptrace (PTRACE_GETREGS, tid, 0, (long) &regs);
+
+  ptrace (PTRACE_POKETEXT, tid, scratch, saved_insn);
+  ptrace (PTRACE_SETREGS, tid, 0, (long) &saved_regs);
+
+  if (!ok || regs.rip != scratch + 2)
+    return -1;
+
+  if (gdbarch_ptr_bit (current_gdbarch) == 32)
+    *result = (int) regs.rax;
+  else
+    *result = (long) regs.rax;
+  return 0;
+}
+
+/* Make LWP PTID call mprotect (ADDR, LEN, PROT).  Return zero on
+   success.  */
+
+static int
+amd64_linux_inferior_mprotect (ptid_t ptid, CORE_ADDR addr, ULONGEST len,
+			       int prot)
+{
+  LONGEST result;
+
+  if (amd64_linux_inferior_syscall (ptid, 125, SYS_mprotect,
+				    addr, len, prot, &result) != 0)
+    return -1;
+
+  return result == 0 ? 0 : -1;
+}
+
+/* Find the alternate signal stack of LWP PTID, by making it call
+   sigaltstack with a buffer below its stack pointer, past the red
+   zone; signal handlers may overwrite that memory at any time, so the
+   program keeps nothing there.  Store the stack's address and size in
+   *ADDR and *SIZE, or zero in *SIZE if it has none, and return zero
+   on success.  */
+
+static int
+amd64_linux_inferior_sigaltstack (ptid_t ptid, CORE_ADDR *addr,
+				  ULONGEST *size)
+{
+  struct user_regs_struct regs;
+  CORE_ADDR buf;
+  LONGEST result;
+  long ss_sp, ss_flags, ss_size;
+  int tid;
+
+  tid = TIDGET (ptid);
+  if (tid == 0)
+    tid = PIDGET (ptid);
+
+  errno = 0;
+  ptrace (PTRACE_GETREGS, tid, 0, (long) &regs);
+  if (errno != 0)
+    return -1;
+  buf = (regs.rsp - 128 - 64) & ~(CORE_ADDR) 15;
+
+  if (amd64_linux_inferior_syscall (ptid, 186, SYS_sigaltstack,
+				    0, buf, 0, &result) != 0
+      || result != 0)
+    return -1;
+
+  /* Read the stack_t the call filled in.  */
+  errno = 0;
+  if (gdbarch_ptr_bit (current_gdbarch) == 32)
+    {
+      long word0 = ptrace (PTRACE_PEEKDATA, tid, buf, 0);
+      long word1 = ptrace (PTRACE_PEEKDATA, tid, buf + 8, 0);
+
+      ss_sp = word0 & 0xffffffff;
+      ss_flags = (int) (word0 >> 32);
+      ss_size = word1 & 0xffffffff;
+    }
+  else
+    {
+      ss_sp = ptrace (PTRACE_PEEKDATA, tid, buf, 0);
+      ss_flags = (int) ptrace (PTRACE_PEEKDATA, tid, buf + 8, 0);
+      ss_size = ptrace (PTRACE_PEEKDATA, tid, buf + 16, 0);
+    }
+  if (errno != 0)
+    return -1;
+
+  *addr = (unsigned long) ss_sp;
+  *size = (ss_flags & SS_DISABLE) ? 0 : (unsigned long) ss_size;
+  return 0;
+}
+
+
 /* Provide a prototype to silence -Wmissing-prototypes.  */
 void _initialize_amd64_linux_nat (void);
 
@@ -434,4 +593,6 @@ _initialize_amd64_linux_nat (void)
   /* Register the target.  */
   linux_nat_add_target (t);
   linux_nat_set_new_thread (t, amd64_linux_new_thread);
+  linux_nat_set_inferior_mprotect (t, amd64_linux_inferior_mprotect);
+  linux_nat_set_inferior_sigaltstack (t, amd64_linux_inferior_sigaltstack);
 }
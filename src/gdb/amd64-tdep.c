@@ -34,8 +34,10 @@
 #include "regcache.h"
 #include "regset.h"
 #include "symfile.h"
+#include "disasm.h"
 
 #include "gdb_assert.h"
+#include "gdb_string.h"
 
 #include "amd64-tdep.h"
 #include "i387-tdep.h"
@@ -1066,6 +1068,510 @@ amd64_regset_from_core_section (struct gdbarch *gdbarch,
 }
 
 
+/* Displaced instruction handling.  */
+
+/* The parts of an instruction we need to know about to execute it at
+   a different address.  */
+
+struct amd64_insn
+{
+  /* The number of opcode bytes.  */
+  int opcode_len;
+
+  /* The offset of the REX prefix, or -1 if there is none.  */
+  int rex_offset;
+
+  /* The offset of the first opcode byte.  */
+  int opcode_offset;
+
+  /* The offset of the ModRM byte, or -1 if there is none.  */
+  int modrm_offset;
+
+  /* The raw instruction.  */
+  gdb_byte *raw_insn;
+};
+
+struct displaced_step_closure
+{
+  /* Non-zero if the instruction's %rip-relative operand was rewritten
+     to use TMP_REGNUM as its base.  TMP_SAVE holds the register's
+     original value.  */
+  int tmp_used;
+  int tmp_regnum;
+  ULONGEST tmp_save;
+
+  /* The decoded instruction.  */
+  struct amd64_insn insn_details;
+
+  /* The (possibly modified) instruction.  This is a variable-length
+     field.  */
+  gdb_byte insn_buf[1];
+};
+
+/* Which one-byte opcodes are followed by a ModRM byte.  */
+
+static const unsigned char amd64_onebyte_has_modrm[256] = {
+  /*	   0 1 2 3 4 5 6 7 8 9 a b c d e f */
+  /* 0 */  1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,
+  /* 1 */  1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,
+  /* 2 */  1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,
+  /* 3 */  1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,
+  /* 4 */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* 5 */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* 6 */  0,0,1,1,0,0,0,0,0,1,0,1,0,0,0,0,
+  /* 7 */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* 8 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* 9 */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* a */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* b */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* c */  1,1,0,0,1,1,1,1,0,0,0,0,0,0,0,0,
+  /* d */  1,1,1,1,0,0,0,0,1,1,1,1,1,1,1,1,
+  /* e */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* f */  0,0,0,0,0,0,1,1,0,0,0,0,0,0,1,1
+};
+
+/* Which two-byte opcodes (those following an 0x0f escape byte) are
+   followed by a ModRM byte.  All three-byte opcodes are.  */
+
+static const unsigned char amd64_twobyte_has_modrm[256] = {
+  /*	   0 1 2 3 4 5 6 7 8 9 a b c d e f */
+  /* 0 */  1,1,1,1,0,0,0,0,0,0,0,0,0,1,0,1,
+  /* 1 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* 2 */  1,1,1,1,0,0,0,0,1,1,1,1,1,1,1,1,
+  /* 3 */  0,0,0,0,0,0,0,0,1,0,1,0,0,0,0,0,
+  /* 4 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* 5 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* 6 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* 7 */  1,1,1,1,1,1,1,0,1,1,1,1,1,1,1,1,
+  /* 8 */  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  /* 9 */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* a */  0,0,0,1,1,1,0,0,0,0,0,1,1,1,1,1,
+  /* b */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* c */  1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,
+  /* d */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* e */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  /* f */  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+};
+
+/* Return non-zero if PFX is a legacy instruction prefix.  */
+
+static int
+amd64_legacy_prefix_p (gdb_byte pfx)
+{
+  switch (pfx)
+    {
+    case 0x26: case 0x2e: case 0x36: case 0x3e:	/* segment overrides */
+    case 0x64: case 0x65:
+    case 0x66:			/* operand-size override */
+    case 0x67:			/* address-size override */
+    case 0xf0:			/* lock */
+    case 0xf2: case 0xf3:	/* rep/repne */
+      return 1;
+
+    default:
+      return 0;
+    }
+}
+
+/* Return non-zero if PFX is a REX prefix.  */
+
+static int
+amd64_rex_prefix_p (gdb_byte pfx)
+{
+  return (pfx & 0xf0) == 0x40;
+}
+
+/* Decode enough of the instruction in INSN to fill in *DETAILS.  */
+
+static void
+amd64_get_insn_details (gdb_byte *insn, struct amd64_insn *details)
+{
+  gdb_byte *start = insn;
+  int need_modrm;
+
+  details->raw_insn = insn;
+  details->opcode_len = -1;
+  details->rex_offset = -1;
+  details->opcode_offset = -1;
+  details->modrm_offset = -1;
+
+  /* Skip the legacy prefixes; a REX prefix, if any, must come right
+     before the opcode.  */
+  while (amd64_legacy_prefix_p (*insn))
+    ++insn;
+
+  if (amd64_rex_prefix_p (*insn))
+    {
+      details->rex_offset = insn - start;
+      ++insn;
+    }
+
+  details->opcode_offset = insn - start;
+
+  if (*insn == 0x0f)
+    {
+      /* Two or three-byte opcode.  */
+      ++insn;
+      if (*insn == 0x38 || *insn == 0x3a)
+	{
+	  details->opcode_len = 3;
+	  need_modrm = 1;
+	}
+      else
+	{
+	  details->opcode_len = 2;
+	  need_modrm = amd64_twobyte_has_modrm[*insn];
+	}
+    }
+  else
+    {
+      details->opcode_len = 1;
+      need_modrm = amd64_onebyte_has_modrm[*insn];
+    }
+
+  if (need_modrm)
+    details->modrm_offset = details->opcode_offset + details->opcode_len;
+}
+
+/* Return non-zero if the instruction described by DETAILS is an
+   absolute indirect jump.  */
+
+static int
+amd64_absolute_jmp_p (const struct amd64_insn *details)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  if (insn[0] == 0xff)
+    {
+      /* jump near, absolute indirect (/4) */
+      if ((insn[1] & 0x38) == 0x20)
+	return 1;
+
+      /* jump far, absolute indirect (/5) */
+      if ((insn[1] & 0x38) == 0x28)
+	return 1;
+    }
+
+  return 0;
+}
+
+/* Return non-zero if the instruction described by DETAILS is an
+   absolute indirect call.  */
+
+static int
+amd64_absolute_call_p (const struct amd64_insn *details)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  if (insn[0] == 0xff)
+    {
+      /* Call near, absolute indirect (/2) */
+      if ((insn[1] & 0x38) == 0x10)
+	return 1;
+
+      /* Call far, absolute indirect (/3) */
+      if ((insn[1] & 0x38) == 0x18)
+	return 1;
+    }
+
+  return 0;
+}
+
+static int
+amd64_ret_p (const struct amd64_insn *details)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  switch (insn[0])
+    {
+    case 0xc2: /* ret near, pop N bytes */
+    case 0xc3: /* ret near */
+    case 0xca: /* ret far, pop N bytes */
+    case 0xcb: /* ret far */
+    case 0xcf: /* iret */
+      return 1;
+
+    default:
+      return 0;
+    }
+}
+
+static int
+amd64_call_p (const struct amd64_insn *details)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  if (amd64_absolute_call_p (details))
+    return 1;
+
+  /* call near, relative */
+  if (insn[0] == 0xe8)
+    return 1;
+
+  return 0;
+}
+
+static int
+amd64_breakpoint_p (const struct amd64_insn *details)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  return insn[0] == 0xcc;	/* int 3 */
+}
+
+/* Return non-zero if the instruction described by DETAILS is a system
+   call, and set *LENGTHP to the length of its opcode.  */
+
+static int
+amd64_syscall_p (const struct amd64_insn *details, int *lengthp)
+{
+  const gdb_byte *insn = &details->raw_insn[details->opcode_offset];
+
+  /* syscall */
+  if (insn[0] == 0x0f && insn[1] == 0x05)
+    {
+      *lengthp = 2;
+      return 1;
+    }
+
+  /* int $N */
+  if (insn[0] == 0xcd)
+    {
+      *lengthp = 2;
+      return 1;
+    }
+
+  return 0;
+}
+
+/* Return the length of the instruction at ADDR.  */
+
+static int
+amd64_insn_length (CORE_ADDR addr)
+{
+  struct ui_file *null_stream = ui_file_new ();
+  struct cleanup *cleanups = make_cleanup_ui_file_delete (null_stream);
+  int len;
+
+  len = gdb_print_insn (addr, null_stream, NULL);
+  do_cleanups (cleanups);
+  return len;
+}
+
+/* If the instruction copied into DSC addresses memory relative to
+   %rip, rewrite it so that it can be executed from TO instead of
+   FROM.  The operand is turned into a displacement from a scratch
+   register which we load with the value %rip would have had at FROM;
+   amd64_displaced_step_fixup restores the register afterwards.  */
+
+static void
+amd64_displaced_step_fixup_riprel (struct displaced_step_closure *dsc,
+				   CORE_ADDR from, CORE_ADDR to,
+				   struct regcache *regs)
+{
+  const struct amd64_insn *details = &dsc->insn_details;
+  gdb_byte *insn = details->raw_insn;
+  int modrm_offset = details->modrm_offset;
+  gdb_byte modrm;
+  int reg, tmp;
+  CORE_ADDR next_pc;
+
+  if (modrm_offset == -1)
+    return;
+
+  /* Mod 00 with r/m 101 means disp32(%rip) in 64-bit mode.  */
+  modrm = insn[modrm_offset];
+  if ((modrm & 0xc7) != 0x05)
+    return;
+
+  /* Pick a scratch register the instruction doesn't name.  We use
+     %rsi, unless the ModRM reg field already refers to it, in which
+     case %rdi will do.  No instruction with a memory operand uses
+     either of them implicitly.  */
+  reg = (modrm >> 3) & 7;
+  if (details->rex_offset != -1 && (insn[details->rex_offset] & 0x04))
+    reg += 8;				/* REX.R */
+  if (reg == 6)
+    {
+      tmp = 7;
+      dsc->tmp_regnum = AMD64_RDI_REGNUM;
+    }
+  else
+    {
+      tmp = 6;
+      dsc->tmp_regnum = AMD64_RSI_REGNUM;
+    }
+
+  /* %rip-relative operands are relative to the next instruction.  */
+  next_pc = from + amd64_insn_length (from);
+  regcache_cooked_read_unsigned (regs, dsc->tmp_regnum, &dsc->tmp_save);
+  regcache_cooked_write_unsigned (regs, dsc->tmp_regnum, next_pc);
+  dsc->tmp_used = 1;
+
+  /* Mod 10 (disp32) with the scratch register as base.  REX.B was
+     ignored for the %rip-relative form; it must be clear now.  */
+  insn[modrm_offset] = 0x80 | (modrm & 0x38) | tmp;
+  if (details->rex_offset != -1)
+    insn[details->rex_offset] &= ~0x01;
+
+  if (debug_displaced)
+    fprintf_unfiltered (gdb_stdlog,
+			"displaced: %%rip-relative operand now based on "
+			"%s = 0x%s\n",
+			dsc->tmp_regnum == AMD64_RSI_REGNUM ? "%rsi" : "%rdi",
+			paddr_nz (next_pc));
+}
+
+struct displaced_step_closure *
+amd64_displaced_step_copy_insn (struct gdbarch *gdbarch,
+				CORE_ADDR from, CORE_ADDR to,
+				struct regcache *regs)
+{
+  int len = gdbarch_max_insn_length (gdbarch);
+  struct displaced_step_closure *dsc;
+  gdb_byte *buf;
+  int syscall_len;
+
+  /* Leave LEN bytes of zeroes after the copy, so that decoding a
+     truncated run of prefixes can't read past the end.  */
+  dsc = xmalloc (sizeof (*dsc) + 2 * len);
+  dsc->tmp_used = 0;
+  buf = dsc->insn_buf;
+  read_memory (from, buf, len);
+  memset (buf + len, 0, len);
+
+  amd64_get_insn_details (buf, &dsc->insn_details);
+
+  /* Some kernels report the single-step trap for a system call only
+     after the following instruction has executed as well.  Make sure
+     that instruction is harmless.  */
+  if (amd64_syscall_p (&dsc->insn_details, &syscall_len)
+      && dsc->insn_details.opcode_offset + syscall_len < len)
+    buf[dsc->insn_details.opcode_offset + syscall_len] = 0x90; /* nop */
+
+  amd64_displaced_step_fixup_riprel (dsc, from, to, regs);
+
+  write_memory (to, buf, len);
+
+  if (debug_displaced)
+    {
+      fprintf_unfiltered (gdb_stdlog, "displaced: copy 0x%s->0x%s: ",
+			  paddr_nz (from), paddr_nz (to));
+      displaced_step_dump_bytes (gdb_stdlog, buf, len);
+    }
+
+  return dsc;
+}
+
+/* Fix up the state of registers and memory after having single-stepped
+   a displaced instruction.  */
+
+void
+amd64_displaced_step_fixup (struct gdbarch *gdbarch,
+			    struct displaced_step_closure *dsc,
+			    CORE_ADDR from, CORE_ADDR to,
+			    struct regcache *regs)
+{
+  /* The offset we applied to the instruction's address.  */
+  ULONGEST insn_offset = to - from;
+  const struct amd64_insn *details = &dsc->insn_details;
+  gdb_byte *insn = details->raw_insn;
+
+  if (debug_displaced)
+    fprintf_unfiltered (gdb_stdlog,
+			"displaced: fixup (0x%s, 0x%s), "
+			"insn = 0x%02x 0x%02x ...\n",
+			paddr_nz (from), paddr_nz (to), insn[0], insn[1]);
+
+  /* Put back the scratch register used for a %rip-relative
+     operand.  */
+  if (dsc->tmp_used)
+    {
+      regcache_cooked_write_unsigned (regs, dsc->tmp_regnum, dsc->tmp_save);
+      if (debug_displaced)
+	fprintf_unfiltered (gdb_stdlog,
+			    "displaced: restored scratch register %d "
+			    "to 0x%s\n",
+			    dsc->tmp_regnum, paddr_nz (dsc->tmp_save));
+    }
+
+  /* This follows i386_displaced_step_fixup: unless the instruction
+     was an absolute or indirect jump or call, or a return, the new
+     %rip is relative to the displaced instruction.  */
+  if (! amd64_absolute_jmp_p (details)
+      && ! amd64_absolute_call_p (details)
+      && ! amd64_ret_p (details))
+    {
+      ULONGEST orig_rip;
+      int insn_len;
+
+      regcache_cooked_read_unsigned (regs, AMD64_RIP_REGNUM, &orig_rip);
+
+      /* A system call which left control anywhere but right after
+	 itself (or after the nop we placed behind it) must have been
+	 a signal return; leave %rip alone in that case.  */
+      if (amd64_syscall_p (details, &insn_len)
+	  && orig_rip != to + details->opcode_offset + insn_len
+	  && orig_rip != to + details->opcode_offset + insn_len + 1)
+	{
+	  if (debug_displaced)
+	    fprintf_unfiltered (gdb_stdlog,
+				"displaced: syscall changed %%rip; "
+				"not relocating\n");
+	}
+      else
+	{
+	  ULONGEST rip = orig_rip - insn_offset;
+
+	  /* Having stepped past the nop after a system call, back up
+	     to the instruction following the original.  */
+	  if (amd64_syscall_p (details, &insn_len)
+	      && orig_rip == to + details->opcode_offset + insn_len + 1)
+	    rip--;
+
+	  /* If we have stepped over a breakpoint, set %rip to point at
+	     the breakpoint instruction itself.  */
+	  if (amd64_breakpoint_p (details))
+	    {
+	      if (debug_displaced)
+		fprintf_unfiltered (gdb_stdlog,
+				    "displaced: stepped breakpoint\n");
+	      rip--;
+	    }
+
+	  regcache_cooked_write_unsigned (regs, AMD64_RIP_REGNUM, rip);
+
+	  if (debug_displaced)
+	    fprintf_unfiltered (gdb_stdlog,
+				"displaced: "
+				"relocated %%rip from 0x%s to 0x%s\n",
+				paddr_nz (orig_rip), paddr_nz (rip));
+	}
+    }
+
+  /* If the instruction was a call, the return address now atop the
+     stack is the address following the copied instruction.  We need
+     to make it the address following the original instruction.  */
+  if (amd64_call_p (details))
+    {
+      ULONGEST rsp;
+      ULONGEST retaddr;
+      const ULONGEST retaddr_len = 8;
+
+      regcache_cooked_read_unsigned (regs, AMD64_RSP_REGNUM, &rsp);
+      retaddr = read_memory_unsigned_integer (rsp, retaddr_len);
+      retaddr = retaddr - insn_offset;
+      write_memory_unsigned_integer (rsp, retaddr_len, retaddr);
+
+      if (debug_displaced)
+	fprintf_unfiltered (gdb_stdlog,
+			    "displaced: relocated return addr at 0x%s "
+			    "to 0x%s\n",
+			    paddr_nz (rsp), paddr_nz (retaddr));
+    }
+}
+
+
 /* Figure out where the longjmp will land.  Slurp the jmp_buf out of
    %rdi.  We expect its value to be a pointer to the jmp_buf structure
    from which we extract the address that we will land at.  This
@@ -24,6 +24,7 @@
 struct gdbarch;
 struct frame_info;
 struct regcache;
+struct displaced_step_closure;
 
 #include "i386-tdep.h"
 
@@ -62,6 +63,17 @@ enum amd64_regnum
 
 extern void amd64_init_abi (struct gdbarch_info info, struct gdbarch *gdbarch);
 
+/* Displaced stepping support.  The copy rewrites %rip-relative
+   operands, so these must be used together.  */
+
+extern struct displaced_step_closure *amd64_displaced_step_copy_insn
+  (struct gdbarch *gdbarch, CORE_ADDR from, CORE_ADDR to,
+   struct regcache *regs);
+extern void amd64_displaced_step_fixup (struct gdbarch *gdbarch,
+					struct displaced_step_closure *closure,
+					CORE_ADDR from, CORE_ADDR to,
+					struct regcache *regs);
+
 /* Functions from amd64-tdep.c which may be needed on architectures
    with extra registers.  */
 
@@ -67,6 +67,13 @@ simple_displaced_step_free_closure (struct gdbarch *gdbarch,
   xfree (closure);
 }
 
+int
+default_displaced_step_hw_singlestep (struct gdbarch *gdbarch,
+                                      struct displaced_step_closure *closure)
+{
+  return 1;
+}
+
 
 CORE_ADDR
 displaced_step_at_entry_point (struct gdbarch *gdbarch)
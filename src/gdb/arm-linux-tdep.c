@@ -33,6 +33,7 @@
 #include "trad-frame.h"
 #include "tramp-frame.h"
 #include "breakpoint.h"
+#include "arch-utils.h"
 
 #include "arm-tdep.h"
 #include "arm-linux-tdep.h"
@@ -210,6 +211,12 @@ static const char arm_linux_thumb_le_breakpoint[] = {0x01, 0xde};
 #define ARM_SET_R7_SIGRETURN		0xe3a07077
 #define ARM_SET_R7_RT_SIGRETURN		0xe3a070ad
 #define ARM_EABI_SYSCALL		0xef000000
+#define THUMB_EABI_SYSCALL		0xdf00
+
+/* The system call numbers of sigreturn and rt_sigreturn, for EABI
+   system calls.  */
+#define ARM_NR_sigreturn		119
+#define ARM_NR_rt_sigreturn		173
 
 static void
 arm_linux_sigtramp_cache (struct frame_info *this_frame,
@@ -589,6 +596,42 @@ arm_linux_software_single_step (struct frame_info *frame)
   return 1;
 }
 
+/* Copy the instruction at FROM for displaced stepping.  A sigreturn
+   system call would restore the PC from the signal frame, never
+   coming back to the breakpoint after the copy, so refuse it.  */
+
+static struct displaced_step_closure *
+arm_linux_displaced_step_copy_insn (struct gdbarch *gdbarch,
+				    CORE_ADDR from, CORE_ADDR to,
+				    struct regcache *regs)
+{
+  ULONGEST status, insn, r7;
+  int sigreturn;
+
+  regcache_cooked_read_unsigned (regs, ARM_PS_REGNUM, &status);
+  regcache_cooked_read_unsigned (regs, 7, &r7);
+  if (status & CPSR_T)
+    {
+      insn = read_memory_unsigned_integer (from, 2);
+      sigreturn = (insn == THUMB_EABI_SYSCALL
+		   && (r7 == ARM_NR_sigreturn || r7 == ARM_NR_rt_sigreturn));
+    }
+  else
+    {
+      insn = read_memory_unsigned_integer (from, 4);
+      sigreturn = (insn == ARM_LINUX_SIGRETURN_INSTR
+		   || insn == ARM_LINUX_RT_SIGRETURN_INSTR
+		   || (insn == ARM_EABI_SYSCALL
+		       && (r7 == ARM_NR_sigreturn
+			   || r7 == ARM_NR_rt_sigreturn)));
+    }
+
+  if (sigreturn)
+    error (_("Can not displaced step a sigreturn system call."));
+
+  return arm_displaced_step_copy_insn (gdbarch, from, to, regs);
+}
+
 static void
 arm_linux_init_abi (struct gdbarch_info info,
 		    struct gdbarch *gdbarch)
@@ -627,6 +670,17 @@ arm_linux_init_abi (struct gdbarch_info info,
   /* Single stepping.  */
   set_gdbarch_software_single_step (gdbarch, arm_linux_software_single_step);
 
+  /* Displaced stepping.  */
+  set_gdbarch_displaced_step_copy_insn (gdbarch,
+					arm_linux_displaced_step_copy_insn);
+  set_gdbarch_displaced_step_fixup (gdbarch, arm_displaced_step_fixup);
+  set_gdbarch_displaced_step_free_closure (gdbarch,
+					   simple_displaced_step_free_closure);
+  set_gdbarch_displaced_step_hw_singlestep (gdbarch,
+					    arm_displaced_step_hw_singlestep);
+  set_gdbarch_displaced_step_location (gdbarch, arm_displaced_step_location);
+  set_gdbarch_max_insn_length (gdbarch, 8);
+
   /* Shared library handling.  */
   set_gdbarch_skip_trampoline_code (gdbarch, find_solib_trampoline_target);
   set_gdbarch_skip_solib_resolver (gdbarch, glibc_skip_solib_resolver);
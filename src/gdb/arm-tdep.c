@@ -273,6 +273,13 @@ arm_pc_is_thumb (CORE_ADDR memaddr)
 {
   struct obj_section *sec;
   struct minimal_symbol *sym;
+  struct displaced_step_closure *dsc;
+
+  /* A copy of an instruction being displaced stepped is in the same
+     mode as the original.  */
+  dsc = get_displaced_step_closure_by_addr (memaddr);
+  if (dsc != NULL)
+    return dsc->is_thumb;
 
   /* If bit 0 of the address is set, assume this is a Thumb address.  */
   if (IS_THUMB_ADDR (memaddr))
@@ -2145,6 +2152,726 @@ arm_software_single_step (struct frame_info *frame)
   return 1;
 }
 
+/* Displaced stepping.
+
+   The instruction is copied to the scratch area followed by a
+   breakpoint, and the thread is resumed (not single-stepped) at the
+   copy; see arm_displaced_step_hw_singlestep.  Instructions which
+   read the PC are rewritten to take the value they expect from
+   scratch registers r0-r3 instead.  Instructions which write the PC
+   would leave the copy and never reach the breakpoint, so they are
+   replaced by a no-op and emulated by arm_displaced_step_fixup.  */
+
+/* The no-op instructions placed in the copy area instead of
+   emulated instructions.  */
+#define ARM_NOP_INSN	0xe1a00000	/* mov r0, r0 */
+#define THUMB_NOP_INSN	0x46c0		/* mov r8, r8 */
+
+/* Return the value register REGNO had before the step, as the
+   instruction at FROM would read it.  */
+
+static ULONGEST
+displaced_read_reg (struct regcache *regs, struct displaced_step_closure *dsc,
+		    CORE_ADDR from, int regno)
+{
+  ULONGEST val;
+
+  if (regno == ARM_PC_REGNUM)
+    return from + (dsc->is_thumb ? 4 : 8);
+
+  regcache_cooked_read_unsigned (regs, regno, &val);
+  return val;
+}
+
+/* Write VAL to the PC.  If EXCHANGE, bit 0 of VAL selects the
+   instruction set, as for BX; otherwise the state is unchanged.  */
+
+static void
+displaced_write_pc (struct regcache *regs, ULONGEST val, int exchange)
+{
+  ULONGEST ps;
+
+  regcache_cooked_read_unsigned (regs, ARM_PS_REGNUM, &ps);
+  if (exchange)
+    {
+      if (val & 1)
+	ps |= CPSR_T;
+      else
+	ps &= ~(ULONGEST) CPSR_T;
+      regcache_cooked_write_unsigned (regs, ARM_PS_REGNUM, ps);
+    }
+
+  if (ps & CPSR_T)
+    val &= ~(ULONGEST) 1;
+  else
+    val &= ~(ULONGEST) 3;
+  regcache_cooked_write_unsigned (regs, ARM_PC_REGNUM, val);
+}
+
+static void
+displaced_write_reg (struct regcache *regs, struct displaced_step_closure *dsc,
+		     int regno, ULONGEST val, int exchange)
+{
+  if (regno == ARM_PC_REGNUM)
+    {
+      displaced_write_pc (regs, val, exchange);
+      dsc->wrote_to_pc = 1;
+    }
+  else
+    regcache_cooked_write_unsigned (regs, regno, val);
+}
+
+/* Use register TMP (below r4) as a scratch register holding VAL.  */
+
+static void
+displaced_set_tmp (struct regcache *regs, struct displaced_step_closure *dsc,
+		   int tmp, ULONGEST val)
+{
+  regcache_cooked_read_unsigned (regs, tmp, &dsc->tmp[tmp]);
+  dsc->tmp_mask |= 1 << tmp;
+  regcache_cooked_write_unsigned (regs, tmp, val);
+}
+
+static void
+displaced_restore_tmps (struct regcache *regs,
+			struct displaced_step_closure *dsc)
+{
+  int tmp;
+
+  for (tmp = 0; tmp < 4; tmp++)
+    if (dsc->tmp_mask & (1 << tmp))
+      regcache_cooked_write_unsigned (regs, tmp, dsc->tmp[tmp]);
+}
+
+static void
+cleanup_branch (struct regcache *regs, struct displaced_step_closure *dsc,
+		CORE_ADDR from)
+{
+  if (dsc->u.branch.link)
+    regcache_cooked_write_unsigned (regs, ARM_LR_REGNUM,
+				    dsc->u.branch.link_value);
+  displaced_write_reg (regs, dsc, ARM_PC_REGNUM, dsc->u.branch.dest,
+		       dsc->u.branch.exchange);
+}
+
+static void
+cleanup_alu (struct regcache *regs, struct displaced_step_closure *dsc,
+	     CORE_ADDR from)
+{
+  ULONGEST result = dsc->u.alu.value;
+
+  if (dsc->u.alu.from_r0)
+    regcache_cooked_read_unsigned (regs, 0, &result);
+  displaced_restore_tmps (regs, dsc);
+
+  if (dsc->u.alu.write_rd)
+    displaced_write_reg (regs, dsc, dsc->u.alu.rd, result, 0);
+}
+
+static void
+cleanup_load_store (struct regcache *regs, struct displaced_step_closure *dsc,
+		    CORE_ADDR from)
+{
+  ULONGEST rt_val, rt2_val, rn_val;
+
+  regcache_cooked_read_unsigned (regs, 0, &rt_val);
+  regcache_cooked_read_unsigned (regs, 1, &rt2_val);
+  regcache_cooked_read_unsigned (regs, 2, &rn_val);
+  displaced_restore_tmps (regs, dsc);
+
+  if (dsc->u.ldst.writeback && dsc->u.ldst.rn != ARM_PC_REGNUM)
+    displaced_write_reg (regs, dsc, dsc->u.ldst.rn, rn_val, 0);
+
+  if (dsc->u.ldst.load)
+    {
+      /* Loads into the PC interwork, as they do from ARMv5T on.  */
+      displaced_write_reg (regs, dsc, dsc->u.ldst.rt, rt_val, 1);
+      if (dsc->u.ldst.dual)
+	displaced_write_reg (regs, dsc, dsc->u.ldst.rt + 1, rt2_val, 0);
+    }
+}
+
+static void
+cleanup_tmps (struct regcache *regs, struct displaced_step_closure *dsc,
+	      CORE_ADDR from)
+{
+  displaced_restore_tmps (regs, dsc);
+}
+
+static void
+cleanup_literal (struct regcache *regs, struct displaced_step_closure *dsc,
+		 CORE_ADDR from)
+{
+  ULONGEST val = read_memory_unsigned_integer (dsc->u.literal.addr, 4);
+
+  displaced_write_reg (regs, dsc, dsc->u.literal.rd, val, 0);
+}
+
+/* Emulate the block transfer in DSC->u.block.insn, which names the
+   PC among its registers.  */
+
+static void
+cleanup_block (struct regcache *regs, struct displaced_step_closure *dsc,
+	       CORE_ADDR from)
+{
+  unsigned long insn = dsc->u.block.insn;
+  int rn = bits (insn, 16, 19);
+  int load = bit (insn, 20);
+  int writeback = bit (insn, 21);
+  int up = bit (insn, 23);
+  int before = bit (insn, 24);
+  unsigned long reglist = bits (insn, 0, 15);
+  int count = bitcount (reglist);
+  ULONGEST base, addr, vals[16];
+  int regno;
+
+  regcache_cooked_read_unsigned (regs, rn, &base);
+
+  /* The registers are always transferred lowest-numbered first, at
+     the lowest address.  */
+  if (up)
+    addr = before ? base + 4 : base;
+  else
+    addr = before ? base - 4 * count : base - 4 * count + 4;
+
+  for (regno = 0; regno < 16; regno++)
+    {
+      if (!(reglist & (1 << regno)))
+	continue;
+
+      if (load)
+	vals[regno] = read_memory_unsigned_integer (addr, 4);
+      else
+	write_memory_unsigned_integer (addr, 4,
+				       displaced_read_reg (regs, dsc, from,
+							   regno));
+      addr += 4;
+    }
+
+  if (writeback && !(load && (reglist & (1 << rn))))
+    regcache_cooked_write_unsigned (regs, rn,
+				    up ? base + 4 * count
+				       : base - 4 * count);
+
+  if (load)
+    for (regno = 0; regno < 16; regno++)
+      if (reglist & (1 << regno))
+	displaced_write_reg (regs, dsc, regno, vals[regno], 1);
+}
+
+/* Prepare DSC to replace an instruction by a no-op, and emulate it
+   with CLEANUP after the step.  */
+
+static void
+displaced_emulate (struct displaced_step_closure *dsc,
+		   void (*cleanup) (struct regcache *,
+				    struct displaced_step_closure *,
+				    CORE_ADDR))
+{
+  dsc->modinsn = dsc->is_thumb ? THUMB_NOP_INSN : ARM_NOP_INSN;
+  dsc->cleanup = cleanup;
+}
+
+/* Branches: B, BL, BLX (immediate), and BX, BLX, BXJ (register).  */
+
+static void
+arm_copy_branch (unsigned long insn, struct regcache *regs,
+		 struct displaced_step_closure *dsc, CORE_ADDR from)
+{
+  if (bits (insn, 25, 27) == 5)
+    {
+      /* B, BL, or BLX with a Thumb target when the condition is
+	 NV.  */
+      dsc->u.branch.dest = BranchDest (from, insn);
+      dsc->u.branch.link = bit (insn, 24) || bits (insn, 28, 31) == INST_NV;
+      dsc->u.branch.exchange = bits (insn, 28, 31) == INST_NV;
+      if (dsc->u.branch.exchange)
+	dsc->u.branch.dest |= (bit (insn, 24) << 1) | 1;
+    }
+  else
+    {
+      dsc->u.branch.dest = displaced_read_reg (regs, dsc, from,
+					       bits (insn, 0, 3));
+      dsc->u.branch.link = bits (insn, 4, 7) == 3;
+      dsc->u.branch.exchange = 1;
+    }
+  dsc->u.branch.link_value = from + 4;
+
+  displaced_emulate (dsc, cleanup_branch);
+}
+
+/* Data-processing instructions naming the PC.  */
+
+static void
+arm_copy_alu (unsigned long insn, struct regcache *regs,
+	      struct displaced_step_closure *dsc, CORE_ADDR from)
+{
+  int imm = bit (insn, 25);
+  int reg_shift = !imm && bit (insn, 4);
+  int op = bits (insn, 21, 24);
+  int rn = bits (insn, 16, 19);
+  int rd = bits (insn, 12, 15);
+  int rm = bits (insn, 0, 3);
+  int rs = bits (insn, 8, 11);
+  /* MOV and MVN have no Rn; the field should be zero.  */
+  int has_rn = op != 0xd && op != 0xf;
+  ULONGEST rn_val = 0, rm_val = 0, rs_val = 0;
+
+  if ((!has_rn || rn != ARM_PC_REGNUM) && rd != ARM_PC_REGNUM
+      && (imm || rm != ARM_PC_REGNUM)
+      && (!reg_shift || rs != ARM_PC_REGNUM))
+    return;
+
+  /* With a register-specified shift, the PC reads as the
+     instruction's address plus 12.  */
+  if (has_rn)
+    {
+      rn_val = displaced_read_reg (regs, dsc, from, rn);
+      if (reg_shift && rn == ARM_PC_REGNUM)
+	rn_val += 4;
+    }
+  if (!imm)
+    {
+      rm_val = displaced_read_reg (regs, dsc, from, rm);
+      if (reg_shift && rm == ARM_PC_REGNUM)
+	rm_val += 4;
+    }
+  if (reg_shift)
+    rs_val = displaced_read_reg (regs, dsc, from, rs);
+
+  /* Compute into r0, from r1, r2 and r3.  */
+  displaced_set_tmp (regs, dsc, 0, 0);
+  dsc->modinsn = insn & 0xffff0fff;
+  if (has_rn)
+    {
+      displaced_set_tmp (regs, dsc, 1, rn_val);
+      dsc->modinsn = (dsc->modinsn & 0xfff0ffff) | 0x00010000;
+    }
+  if (!imm)
+    {
+      displaced_set_tmp (regs, dsc, 2, rm_val);
+      dsc->modinsn = (dsc->modinsn & ~0xful) | 2;
+    }
+  if (reg_shift)
+    {
+      displaced_set_tmp (regs, dsc, 3, rs_val);
+      dsc->modinsn = (dsc->modinsn & ~0xf00ul) | 0x300;
+    }
+
+  /* TST, TEQ, CMP and CMN only set the flags.  */
+  dsc->u.alu.rd = rd;
+  dsc->u.alu.write_rd = (op < 0x8 || op > 0xb);
+  dsc->u.alu.from_r0 = 1;
+  dsc->cleanup = cleanup_alu;
+}
+
+/* Loads and stores of a word or byte, or of a halfword, signed byte
+   or doubleword (EXTRA non-zero), naming the PC.  */
+
+static void
+arm_copy_load_store (unsigned long insn, int extra, struct regcache *regs,
+		     struct displaced_step_closure *dsc, CORE_ADDR from)
+{
+  int load = bit (insn, 20);
+  int rn = bits (insn, 16, 19);
+  int rt = bits (insn, 12, 15);
+  int rm = bits (insn, 0, 3);
+  int reg_offset = extra ? !bit (insn, 22) : bit (insn, 25);
+  int dual = extra && !load && bit (insn, 6);
+  ULONGEST rt_val, rt2_val = 0, rn_val, rm_val = 0;
+
+  if (rn != ARM_PC_REGNUM && rt != ARM_PC_REGNUM
+      && (!reg_offset || rm != ARM_PC_REGNUM))
+    return;
+
+  /* LDRD and STRD are encoded with the L bit clear; bit 5 tells
+     them apart.  */
+  if (dual)
+    load = !bit (insn, 5);
+
+  /* Read all the operands before any of r0-r3 is replaced, since
+     they may be among them.  */
+  rt_val = displaced_read_reg (regs, dsc, from, rt);
+  if (dual)
+    rt2_val = displaced_read_reg (regs, dsc, from, rt + 1);
+  rn_val = displaced_read_reg (regs, dsc, from, rn);
+  if (reg_offset)
+    rm_val = displaced_read_reg (regs, dsc, from, rm);
+
+  /* Transfer through r0 (and r1), based on r2, offset by r3.  */
+  displaced_set_tmp (regs, dsc, 0, rt_val);
+  if (dual)
+    displaced_set_tmp (regs, dsc, 1, rt2_val);
+  displaced_set_tmp (regs, dsc, 2, rn_val);
+  dsc->modinsn = (insn & 0xfff00fff) | 0x00020000;
+  if (reg_offset)
+    {
+      displaced_set_tmp (regs, dsc, 3, rm_val);
+      dsc->modinsn = (dsc->modinsn & ~0xful) | 3;
+    }
+
+  dsc->u.ldst.load = load;
+  dsc->u.ldst.dual = dual;
+  dsc->u.ldst.writeback = !bit (insn, 24) || bit (insn, 21);
+  dsc->u.ldst.rt = rt;
+  dsc->u.ldst.rn = rn;
+  dsc->cleanup = cleanup_load_store;
+}
+
+/* Coprocessor loads and stores (LDC, STC) relative to the PC.  */
+
+static void
+arm_copy_copro_load_store (unsigned long insn, struct regcache *regs,
+			   struct displaced_step_closure *dsc, CORE_ADDR from)
+{
+  if (bits (insn, 16, 19) != ARM_PC_REGNUM)
+    return;
+
+  /* The PC is word-aligned when used as the base.  */
+  displaced_set_tmp (regs, dsc, 0,
+		     displaced_read_reg (regs, dsc, from, ARM_PC_REGNUM) & ~3);
+  dsc->modinsn = insn & 0xfff0ffff;
+  dsc->cleanup = cleanup_tmps;
+}
+
+/* Set up DSC for the ARM instruction INSN at FROM.  */
+
+static void
+arm_process_displaced_insn (unsigned long insn, struct regcache *regs,
+			    struct displaced_step_closure *dsc,
+			    CORE_ADDR from)
+{
+  unsigned long cond = bits (insn, 28, 31);
+  ULONGEST status;
+
+  dsc->modinsn = insn;
+
+  if (cond == INST_NV)
+    {
+      /* Of the unconditional instructions, only BLX (immediate) and
+	 the coprocessor loads and stores can use the PC.  */
+      if (bits (insn, 25, 27) == 5)
+	arm_copy_branch (insn, regs, dsc, from);
+      else if (bits (insn, 25, 27) == 6)
+	arm_copy_copro_load_store (insn, regs, dsc, from);
+      return;
+    }
+
+  /* An instruction whose condition fails does nothing at all.  */
+  regcache_cooked_read_unsigned (regs, ARM_PS_REGNUM, &status);
+  if (!condition_true (cond, status))
+    {
+      dsc->modinsn = ARM_NOP_INSN;
+      return;
+    }
+
+  switch (bits (insn, 25, 27))
+    {
+    case 0:
+      if (bit (insn, 4) && bit (insn, 7))
+	{
+	  /* Multiplies and swaps can't name the PC; the other
+	     instructions here are the extra loads and stores.  */
+	  if (bits (insn, 5, 6) != 0)
+	    arm_copy_load_store (insn, 1, regs, dsc, from);
+	  break;
+	}
+      if (bits (insn, 23, 24) == 2 && !bit (insn, 20))
+	{
+	  /* Miscellaneous instructions; only the branches matter.  */
+	  if ((insn & 0x0ffffff0) == 0x012fff10	/* bx */
+	      || (insn & 0x0ffffff0) == 0x012fff20	/* bxj */
+	      || (insn & 0x0ffffff0) == 0x012fff30)	/* blx */
+	    arm_copy_branch (insn, regs, dsc, from);
+	  break;
+	}
+      arm_copy_alu (insn, regs, dsc, from);
+      break;
+
+    case 1:
+      /* MSR (immediate), MOVW and MOVT can't name the PC.  */
+      if (bits (insn, 23, 24) == 2 && !bit (insn, 20))
+	break;
+      arm_copy_alu (insn, regs, dsc, from);
+      break;
+
+    case 2:
+      arm_copy_load_store (insn, 0, regs, dsc, from);
+      break;
+
+    case 3:
+      /* Media instructions can't name the PC.  */
+      if (!bit (insn, 4))
+	arm_copy_load_store (insn, 0, regs, dsc, from);
+      break;
+
+    case 4:
+      /* LDM and STM including the PC in their register list.  */
+      if (bit (insn, 15))
+	{
+	  dsc->u.block.insn = insn;
+	  displaced_emulate (dsc, cleanup_block);
+	}
+      break;
+
+    case 5:
+      arm_copy_branch (insn, regs, dsc, from);
+      break;
+
+    case 6:
+      /* MCRR and MRRC use the Rn field for a transfer register.  */
+      if ((insn & 0x0fe00000) != 0x0c400000)
+	arm_copy_copro_load_store (insn, regs, dsc, from);
+      break;
+
+    case 7:
+      /* Coprocessor register transfers and SVC don't use the PC.
+	 A system call returns to the breakpoint after the copy.  */
+      break;
+    }
+}
+
+/* Set up DSC for the Thumb instruction at FROM, whose first halfword
+   is INSN1.  Returns zero if the instruction can't be displaced: of
+   the 32-bit instructions, only BL and BLX can.  */
+
+static int
+thumb_process_displaced_insn (unsigned short insn1, struct regcache *regs,
+			      struct displaced_step_closure *dsc,
+			      CORE_ADDR from)
+{
+  ULONGEST pc_val = from + 4;
+  ULONGEST status;
+
+  dsc->modinsn = insn1;
+
+  /* The copy of an instruction in an IT block would not be
+     conditional, and the copy of an IT instruction would make the
+     breakpoint after it conditional instead of the instructions of
+     its block.  Step those in place.  */
+  regcache_cooked_read_unsigned (regs, ARM_PS_REGNUM, &status);
+  if (bits (status, 10, 15) != 0 || bits (status, 25, 26) != 0)
+    return 0;
+  if ((insn1 & 0xff00) == 0xbf00 && bits (insn1, 0, 3) != 0)
+    return 0;
+
+  if ((insn1 & 0xe000) == 0xe000 && (insn1 & 0x1800) != 0)
+    {
+      /* A 32-bit instruction.  Of those, only the BL and BLX pairs
+	 of Thumb-1 are handled.  */
+      unsigned short insn2 = read_memory_unsigned_integer (from + 2, 2);
+
+      if ((insn1 & 0xf800) != 0xf000 || (insn2 & 0xe800) != 0xe800)
+	return 0;
+
+      dsc->insn_size = 4;
+      dsc->u.branch.dest = pc_val + ((sbits (insn1, 0, 10) << 12)
+				     + (bits (insn2, 0, 10) << 1));
+      dsc->u.branch.link = 1;
+      dsc->u.branch.link_value = (from + 4) | 1;
+      dsc->u.branch.exchange = 1;
+      if (bits (insn2, 11, 12) == 1)
+	dsc->u.branch.dest &= ~(CORE_ADDR) 3;	/* BLX, to ARM code.  */
+      else
+	dsc->u.branch.dest |= 1;
+      displaced_emulate (dsc, cleanup_branch);
+    }
+  else if ((insn1 & 0xff00) == 0x4700)
+    {
+      /* BX and BLX (register).  */
+      dsc->u.branch.dest = displaced_read_reg (regs, dsc, from,
+					       bits (insn1, 3, 6));
+      dsc->u.branch.link = bit (insn1, 7);
+      dsc->u.branch.link_value = (from + 2) | 1;
+      dsc->u.branch.exchange = 1;
+      displaced_emulate (dsc, cleanup_branch);
+    }
+  else if ((insn1 & 0xfc00) == 0x4400)
+    {
+      /* ADD, CMP and MOV with high registers.  */
+      int rd = (bit (insn1, 7) << 3) | bits (insn1, 0, 2);
+      int rm = bits (insn1, 3, 6);
+      ULONGEST rd_val = displaced_read_reg (regs, dsc, from, rd);
+      ULONGEST rm_val = displaced_read_reg (regs, dsc, from, rm);
+
+      if (rd != ARM_PC_REGNUM && rm != ARM_PC_REGNUM)
+	return 1;
+
+      switch (bits (insn1, 8, 9))
+	{
+	case 0:		/* add */
+	case 2:		/* mov */
+	  dsc->u.alu.rd = rd;
+	  dsc->u.alu.write_rd = 1;
+	  dsc->u.alu.from_r0 = 0;
+	  dsc->u.alu.value = bits (insn1, 8, 9) == 0 ? rd_val + rm_val : rm_val;
+	  displaced_emulate (dsc, cleanup_alu);
+	  break;
+
+	case 1:		/* cmp */
+	  displaced_set_tmp (regs, dsc, 0, rd_val);
+	  displaced_set_tmp (regs, dsc, 1, rm_val);
+	  dsc->modinsn = 0x4288;	/* cmp r0, r1 */
+	  dsc->cleanup = cleanup_tmps;
+	  break;
+	}
+    }
+  else if ((insn1 & 0xf800) == 0x4800)
+    {
+      /* LDR (literal).  */
+      dsc->u.literal.rd = bits (insn1, 8, 10);
+      dsc->u.literal.addr = (pc_val & ~3) + (bits (insn1, 0, 7) << 2);
+      displaced_emulate (dsc, cleanup_literal);
+    }
+  else if ((insn1 & 0xf800) == 0xa000)
+    {
+      /* ADR.  */
+      dsc->u.alu.rd = bits (insn1, 8, 10);
+      dsc->u.alu.write_rd = 1;
+      dsc->u.alu.from_r0 = 0;
+      dsc->u.alu.value = (pc_val & ~3) + (bits (insn1, 0, 7) << 2);
+      displaced_emulate (dsc, cleanup_alu);
+    }
+  else if ((insn1 & 0xff00) == 0xbd00)
+    {
+      /* POP, including the PC: the same as LDMIA sp!, {..., pc}.  */
+      dsc->u.block.insn = 0xe8bd8000 | bits (insn1, 0, 7);
+      displaced_emulate (dsc, cleanup_block);
+    }
+  else if ((insn1 & 0xf000) == 0xd000 && bits (insn1, 8, 11) < 0xe)
+    {
+      /* B<cond>.  An untaken branch does nothing.  */
+      if (condition_true (bits (insn1, 8, 11), status))
+	{
+	  dsc->u.branch.dest = pc_val + (sbits (insn1, 0, 7) << 1);
+	  dsc->u.branch.link = 0;
+	  dsc->u.branch.exchange = 0;
+	  displaced_emulate (dsc, cleanup_branch);
+	}
+      else
+	dsc->modinsn = THUMB_NOP_INSN;
+    }
+  else if ((insn1 & 0xf500) == 0xb100)
+    {
+      /* CBZ and CBNZ.  An untaken branch does nothing.  */
+      ULONGEST rn_val = displaced_read_reg (regs, dsc, from,
+					    bits (insn1, 0, 2));
+
+      if ((rn_val == 0) != bit (insn1, 11))
+	{
+	  dsc->u.branch.dest = pc_val + ((bit (insn1, 9) << 6)
+					 | (bits (insn1, 3, 7) << 1));
+	  dsc->u.branch.link = 0;
+	  dsc->u.branch.exchange = 0;
+	  displaced_emulate (dsc, cleanup_branch);
+	}
+      else
+	dsc->modinsn = THUMB_NOP_INSN;
+    }
+  else if ((insn1 & 0xf800) == 0xe000)
+    {
+      /* B.  */
+      dsc->u.branch.dest = pc_val + (sbits (insn1, 0, 10) << 1);
+      dsc->u.branch.link = 0;
+      dsc->u.branch.exchange = 0;
+      displaced_emulate (dsc, cleanup_branch);
+    }
+
+  return 1;
+}
+
+struct displaced_step_closure *
+arm_displaced_step_copy_insn (struct gdbarch *gdbarch,
+			      CORE_ADDR from, CORE_ADDR to,
+			      struct regcache *regs)
+{
+  struct gdbarch_tdep *tdep = gdbarch_tdep (gdbarch);
+  struct displaced_step_closure *dsc = xzalloc (sizeof (*dsc));
+  struct cleanup *old_chain = make_cleanup (xfree, dsc);
+  ULONGEST status;
+
+  regcache_cooked_read_unsigned (regs, ARM_PS_REGNUM, &status);
+  dsc->is_thumb = (status & CPSR_T) != 0;
+
+  if (dsc->is_thumb)
+    {
+      dsc->insn_size = 2;
+      if (!thumb_process_displaced_insn
+	    (read_memory_unsigned_integer (from, 2), regs, dsc, from))
+	{
+	  /* Let infrun step over the breakpoint in place.  */
+	  do_cleanups (old_chain);
+	  return NULL;
+	}
+      write_memory_unsigned_integer (to, 2, dsc->modinsn);
+      write_memory (to + 2, (const gdb_byte *) tdep->thumb_breakpoint,
+		    tdep->thumb_breakpoint_size);
+    }
+  else
+    {
+      dsc->insn_size = 4;
+      arm_process_displaced_insn (read_memory_unsigned_integer (from, 4),
+				  regs, dsc, from);
+      write_memory_unsigned_integer (to, 4, dsc->modinsn);
+      write_memory (to + 4, (const gdb_byte *) tdep->arm_breakpoint,
+		    tdep->arm_breakpoint_size);
+    }
+
+  if (debug_displaced)
+    fprintf_unfiltered (gdb_stdlog, "displaced: copy %s insn at 0x%s "
+			"to 0x%s as 0x%lx%s\n",
+			dsc->is_thumb ? "Thumb" : "ARM",
+			paddr_nz (from), paddr_nz (to), dsc->modinsn,
+			dsc->cleanup ? ", with fixup" : "");
+
+  discard_cleanups (old_chain);
+  return dsc;
+}
+
+void
+arm_displaced_step_fixup (struct gdbarch *gdbarch,
+			  struct displaced_step_closure *dsc,
+			  CORE_ADDR from, CORE_ADDR to,
+			  struct regcache *regs)
+{
+  if (dsc->cleanup)
+    dsc->cleanup (regs, dsc, from);
+
+  /* Unless the instruction branched, continue after the original.  */
+  if (!dsc->wrote_to_pc)
+    regcache_cooked_write_unsigned (regs, ARM_PC_REGNUM,
+				    from + dsc->insn_size);
+
+  if (debug_displaced)
+    {
+      ULONGEST pc;
+
+      regcache_cooked_read_unsigned (regs, ARM_PC_REGNUM, &pc);
+      fprintf_unfiltered (gdb_stdlog, "displaced: fixup (0x%s, 0x%s), "
+			  "pc now 0x%s\n", paddr_nz (from), paddr_nz (to),
+			  paddr_nz (pc));
+    }
+}
+
+/* The copy ends with a breakpoint, so the thread need only be
+   resumed.  */
+
+int
+arm_displaced_step_hw_singlestep (struct gdbarch *gdbarch,
+				  struct displaced_step_closure *closure)
+{
+  return 0;
+}
+
+/* Place the copy in the entry point's code, word-aligned so that ARM
+   instructions can be executed there.  */
+
+CORE_ADDR
+arm_displaced_step_location (struct gdbarch *gdbarch)
+{
+  return (displaced_step_at_entry_point (gdbarch) + 3) & ~(CORE_ADDR) 3;
+}
+
 #include "bfd-in2.h"
 #include "libcoff.h"
 
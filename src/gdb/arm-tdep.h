@@ -21,6 +21,7 @@
 
 /* Forward declarations.  */
 struct gdbarch;
+struct regcache;
 struct regset;
 
 /* Register numbers of various important registers.  */
@@ -178,6 +179,92 @@ CORE_ADDR arm_skip_stub (struct frame_info *, CORE_ADDR);
 CORE_ADDR arm_get_next_pc (struct frame_info *, CORE_ADDR);
 int arm_software_single_step (struct frame_info *);
 
+/* The state of an instruction being displaced stepped; see
+   arm_displaced_step_copy_insn.  */
+
+struct displaced_step_closure
+{
+  /* Non-zero if the instruction was copied from Thumb code.  */
+  int is_thumb;
+
+  /* The size of the original instruction, in bytes.  */
+  int insn_size;
+
+  /* The instruction placed in the copy area.  */
+  unsigned long modinsn;
+
+  /* Bit N is set if register rN (N < 4) is used as a scratch
+     register by MODINSN; TMP[N] holds its value before the step.  */
+  unsigned int tmp_mask;
+  ULONGEST tmp[4];
+
+  /* If non-NULL, finish the instruction's work after the step.  */
+  void (*cleanup) (struct regcache *regs,
+		   struct displaced_step_closure *dsc, CORE_ADDR from);
+
+  /* Set by CLEANUP if it wrote the PC.  */
+  int wrote_to_pc;
+
+  union
+  {
+    /* A branch, with or without link and state change.  */
+    struct
+    {
+      CORE_ADDR dest;
+      int link;
+      ULONGEST link_value;
+      int exchange;
+    } branch;
+
+    /* A data-processing instruction computing into r0, or a value
+       known when the instruction was copied.  */
+    struct
+    {
+      int rd;
+      int write_rd;
+      int from_r0;
+      ULONGEST value;
+    } alu;
+
+    /* A single or double register load or store, using r0 (and r1)
+       for the transfer register and r2 for the base.  */
+    struct
+    {
+      int load;
+      int dual;
+      int writeback;
+      int rt;
+      int rn;
+    } ldst;
+
+    /* A PC-relative literal load, from Thumb code.  */
+    struct
+    {
+      int rd;
+      CORE_ADDR addr;
+    } literal;
+
+    /* A block transfer involving the PC, as an ARM LDM/STM
+       instruction.  */
+    struct
+    {
+      unsigned long insn;
+    } block;
+  } u;
+};
+
+extern struct displaced_step_closure *
+  arm_displaced_step_copy_insn (struct gdbarch *gdbarch,
+				CORE_ADDR from, CORE_ADDR to,
+				struct regcache *regs);
+extern void arm_displaced_step_fixup (struct gdbarch *gdbarch,
+				      struct displaced_step_closure *dsc,
+				      CORE_ADDR from, CORE_ADDR to,
+				      struct regcache *regs);
+extern int arm_displaced_step_hw_singlestep
+  (struct gdbarch *gdbarch, struct displaced_step_closure *dsc);
+extern CORE_ADDR arm_displaced_step_location (struct gdbarch *gdbarch);
+
 /* Functions exported from armbsd-tdep.h.  */
 
 /* Return the appropriate register set for the core section identified
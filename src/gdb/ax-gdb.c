@@ -113,6 +113,13 @@ static void gen_binop (struct agent_expr *ax,
 		       struct axs_value *value2,
 		       enum agent_op op,
 		       enum agent_op op_unsigned, int may_carry, char *name);
+static void gen_comparison (struct agent_expr *ax, struct axs_value *value,
+			    struct axs_value *value1,
+			    struct axs_value *value2,
+			    int less, int negate, char *name);
+static void gen_logical_operand (struct agent_expr *ax,
+				 struct axs_value *value,
+				 enum exp_opcode op);
 static void gen_logical_not (struct agent_expr *ax, struct axs_value *value);
 static void gen_complement (struct agent_expr *ax, struct axs_value *value);
 static void gen_deref (struct agent_expr *, struct axs_value *);
@@ -1060,6 +1067,41 @@ gen_binop (struct agent_expr *ax, struct axs_value *value,
 }
 
 
+/* Generate code for a comparison of VALUE1 and VALUE2, leaving an
+   int on the stack.  If LESS is non-zero, test whether VALUE1 is less
+   than VALUE2, else whether they are equal; if NEGATE is non-zero,
+   invert the result.  NAME is the English name of the operator, used
+   in error messages.  */
+static void
+gen_comparison (struct agent_expr *ax, struct axs_value *value,
+		struct axs_value *value1, struct axs_value *value2,
+		int less, int negate, char *name)
+{
+  if (less)
+    gen_binop (ax, value, value1, value2,
+	       aop_less_signed, aop_less_unsigned, 0, name);
+  else
+    gen_binop (ax, value, value1, value2, aop_equal, aop_equal, 0, name);
+
+  if (negate)
+    ax_simple (ax, aop_log_not);
+  value->type = builtin_type_int;
+}
+
+/* Make sure VALUE, an operand of the logical operator OP, is an
+   rvalue which can be tested against zero.  */
+static void
+gen_logical_operand (struct agent_expr *ax, struct axs_value *value,
+		     enum exp_opcode op)
+{
+  if (TYPE_CODE (value->type) != TYPE_CODE_INT
+      && TYPE_CODE (value->type) != TYPE_CODE_PTR)
+    error (_("Invalid type of operand to `%s'."),
+	   op == BINOP_LOGICAL_AND ? "&&" : "||");
+
+  gen_usual_unary (ax, value);
+}
+
 static void
 gen_logical_not (struct agent_expr *ax, struct axs_value *value)
 {
@@ -1501,6 +1543,12 @@ gen_expr (union exp_element **pc, struct agent_expr *ax,
     case BINOP_BITWISE_AND:
     case BINOP_BITWISE_IOR:
     case BINOP_BITWISE_XOR:
+    case BINOP_EQUAL:
+    case BINOP_NOTEQUAL:
+    case BINOP_LESS:
+    case BINOP_GTR:
+    case BINOP_LEQ:
+    case BINOP_GEQ:
       (*pc)++;
       gen_expr (pc, ax, &value1);
       gen_usual_unary (ax, &value1);
@@ -1548,6 +1596,34 @@ gen_expr (union exp_element **pc, struct agent_expr *ax,
 		     aop_bit_xor, aop_bit_xor, 0, "bitwise exclusive-or");
 	  break;
 
+	case BINOP_EQUAL:
+	  gen_comparison (ax, value, &value1, &value2, 0, 0, "equality");
+	  break;
+
+	case BINOP_NOTEQUAL:
+	  gen_comparison (ax, value, &value1, &value2, 0, 1, "inequality");
+	  break;
+
+	  /* a > b is b < a, a <= b is !(b < a), and a >= b is
+	     !(a < b).  */
+	case BINOP_LESS:
+	  gen_comparison (ax, value, &value1, &value2, 1, 0, "comparison");
+	  break;
+
+	case BINOP_GTR:
+	  ax_simple (ax, aop_swap);
+	  gen_comparison (ax, value, &value1, &value2, 1, 0, "comparison");
+	  break;
+
+	case BINOP_LEQ:
+	  ax_simple (ax, aop_swap);
+	  gen_comparison (ax, value, &value1, &value2, 1, 1, "comparison");
+	  break;
+
+	case BINOP_GEQ:
+	  gen_comparison (ax, value, &value1, &value2, 1, 1, "comparison");
+	  break;
+
 	default:
 	  /* We should only list operators in the outer case statement
 	     that we actually handle in the inner case statement.  */
@@ -1556,6 +1632,40 @@ gen_expr (union exp_element **pc, struct agent_expr *ax,
 	}
       break;
 
+    case BINOP_LOGICAL_AND:
+    case BINOP_LOGICAL_OR:
+      {
+	int if_patch, end_patch;
+
+	(*pc)++;
+	gen_expr (pc, ax, &value1);
+	gen_logical_operand (ax, &value1, op);
+
+	/* Only evaluate the right operand if the left one doesn't
+	   decide the result already.  */
+	if (op == BINOP_LOGICAL_AND)
+	  {
+	    ax_simple (ax, aop_log_not);
+	    if_patch = ax_goto (ax, aop_if_goto);
+	  }
+	else
+	  if_patch = ax_goto (ax, aop_if_goto);
+
+	gen_expr (pc, ax, &value2);
+	gen_logical_operand (ax, &value2, op);
+	ax_simple (ax, aop_log_not);
+	ax_simple (ax, aop_log_not);
+	end_patch = ax_goto (ax, aop_goto);
+
+	ax_label (ax, if_patch, ax->len);
+	ax_const_l (ax, op == BINOP_LOGICAL_AND ? 0 : 1);
+	ax_label (ax, end_patch, ax->len);
+
+	value->kind = axs_rvalue;
+	value->type = builtin_type_int;
+      }
+      break;
+
       /* Note that we need to be a little subtle about generating code
          for comma.  In C, we can do some optimizations here because
          we know the left operand is only being evaluated for effect.
@@ -1762,6 +1872,31 @@ gen_trace_for_expr (CORE_ADDR scope, struct expression *expr)
   return ax;
 }
 
+/* Given a GDB expression EXPR, return bytecode to compute its value.
+   The result will leave the value on top of the stack, and will not
+   record any memory.  */
+struct agent_expr *
+gen_eval_for_expr (CORE_ADDR scope, struct expression *expr)
+{
+  struct cleanup *old_chain = 0;
+  struct agent_expr *ax = new_agent_expr (scope);
+  union exp_element *pc;
+  struct axs_value value;
+
+  old_chain = make_cleanup_free_agent_expr (ax);
+
+  pc = expr->elts;
+  trace_kludge = 0;
+  gen_expr (&pc, ax, &value);
+
+  /* Leave the value itself on the stack, and terminate.  */
+  require_rvalue (ax, &value);
+  ax_simple (ax, aop_end);
+
+  discard_cleanups (old_chain);
+  return ax;
+}
+
 static void
 agent_command (char *exp, int from_tty)
 {
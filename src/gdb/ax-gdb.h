@@ -98,4 +98,8 @@ struct axs_value
    function to discover which registers the expression uses.  */
 extern struct agent_expr *gen_trace_for_expr (CORE_ADDR, struct expression *);
 
+/* Given a GDB expression EXPR, return bytecode to compute its value,
+   leaving it on top of the stack.  */
+extern struct agent_expr *gen_eval_for_expr (CORE_ADDR, struct expression *);
+
 #endif /* AX_GDB_H */
@@ -36,6 +36,8 @@
 #include "command.h"
 #include "gdbcmd.h"
 #include "block.h"
+#include "observer.h"
+#include "gdb_string.h"
 
 /* Prototypes for exported functions. */
 
@@ -68,8 +70,49 @@ get_frame_block (struct frame_info *frame, CORE_ADDR *addr_in_block)
   return block_for_pc (pc);
 }
 
+/* A small cache of the results of get_pc_function_start.  Unwinding
+   a deep stack asks for the start of the same few functions once per
+   frame (to build frame IDs and to check for main and the entry
+   point), and each answer otherwise costs a symtab and a minimal
+   symbol lookup.  */
+
+#define PC_FUNCTION_START_CACHE_SIZE 61
+
+struct pc_function_start_cache_entry
+{
+  int valid;
+  CORE_ADDR pc;
+  CORE_ADDR start;
+};
+
+static struct pc_function_start_cache_entry
+  pc_function_start_cache[PC_FUNCTION_START_CACHE_SIZE];
+
+static CORE_ADDR get_pc_function_start_1 (CORE_ADDR pc);
+
 CORE_ADDR
 get_pc_function_start (CORE_ADDR pc)
+{
+  struct pc_function_start_cache_entry *entry;
+
+  /* Which sections are mapped can change behind our back when
+     debugging overlays, so don't cache anything then.  */
+  if (overlay_debugging)
+    return get_pc_function_start_1 (pc);
+
+  entry = &pc_function_start_cache[pc % PC_FUNCTION_START_CACHE_SIZE];
+  if (!entry->valid || entry->pc != pc)
+    {
+      entry->start = get_pc_function_start_1 (pc);
+      entry->pc = pc;
+      entry->valid = 1;
+    }
+
+  return entry->start;
+}
+
+static CORE_ADDR
+get_pc_function_start_1 (CORE_ADDR pc)
 {
   struct block *bl;
   struct minimal_symbol *msymbol;
@@ -148,6 +191,13 @@ clear_pc_function_cache (void)
   cache_pc_function_high = 0;
   cache_pc_function_name = (char *) 0;
   cache_pc_function_section = NULL;
+  memset (pc_function_start_cache, 0, sizeof (pc_function_start_cache));
+}
+
+static void
+pc_function_cache_new_objfile (struct objfile *objfile)
+{
+  clear_pc_function_cache ();
 }
 
 /* Finds the "function" (text symbol) that is smaller than PC but
@@ -368,3 +418,9 @@ block_innermost_frame (struct block *block)
 
   return NULL;
 }
+
+void
+_initialize_blockframe (void)
+{
+  observer_attach_new_objfile (pc_function_cache_new_objfile);
+}
@@ -56,6 +56,8 @@
 #include "ada-lang.h"
 #include "top.h"
 #include "wrapper.h"
+#include "ax.h"
+#include "ax-gdb.h"
 
 #include "mi/mi-common.h"
 
@@ -65,6 +67,8 @@ static void catch_command_1 (char *, int, int);
 
 static void enable_delete_command (char *, int);
 
+static void clear_cond_bytecode (struct bp_location *);
+
 static void enable_delete_breakpoint (struct breakpoint *);
 
 static void enable_once_command (char *, int);
@@ -189,6 +193,8 @@ allocate_bp_location (struct breakpoint *bpt, enum bptype bp_type);
 
 static void update_global_location_list (int);
 
+static void update_bp_location_table (VEC(bp_location_p) *added);
+
 static void update_global_location_list_nothrow (int);
 
 static int is_hardware_watchpoint (struct breakpoint *bpt);
@@ -292,6 +298,15 @@ static int overlay_events_enabled;
 	     B ? (TMP=B->global_next, 1): 0;	\
 	     B = TMP)
 
+/* Iterate over all breakpoint locations at address ADDR, using the
+   address-sorted index.  IX is an int used as the index cursor.  */
+
+#define ALL_BP_LOCATIONS_AT_ADDR(B,IX,ADDR)				\
+	for (IX = bp_location_lower_bound (ADDR);			\
+	     VEC_iterate (bp_location_p, bp_location_table, IX, B)	\
+	       && B->address == (ADDR);					\
+	     ++IX)
+
 /* True if breakpoint hit counts should be displayed in breakpoint info.  */
 
 int show_breakpoint_hit_counts = 1;
@@ -302,6 +317,35 @@ struct breakpoint *breakpoint_chain;
 
 struct bp_location *bp_location_chain;
 
+/* The same locations as in bp_location_chain, sorted by address.
+   Locations at the same address keep the order in which they were
+   added.  This lets the functions called on every stop find the
+   locations at a PC without walking the whole chain.  */
+static VEC(bp_location_p) *bp_location_table = NULL;
+
+/* Return the index of the first location in bp_location_table whose
+   address is not less than ADDRESS.  */
+
+static int
+bp_location_lower_bound (CORE_ADDR address)
+{
+  int lo = 0;
+  int hi = VEC_length (bp_location_p, bp_location_table);
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (VEC_index (bp_location_p, bp_location_table, mid)->address
+	  < address)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
 /* The locations that no longer correspond to any breakpoint,
    unlinked from bp_location_chain, but for which a hit
    may still be reported by a target.  */
@@ -591,6 +635,7 @@ condition_command (char *arg, int from_tty)
 		xfree (loc->cond);
 		loc->cond = 0;
 	      }
+	    clear_cond_bytecode (loc);
 	  }
 	if (b->cond_string != NULL)
 	  xfree (b->cond_string);
@@ -1032,17 +1077,202 @@ should_be_inserted (struct bp_location *bpt)
   return 1;
 }
 
+/* Forget the bytecode compiled from LOC's condition.  */
+
+static void
+clear_cond_bytecode (struct bp_location *loc)
+{
+  if (loc->cond_bytecode)
+    free_agent_expr (loc->cond_bytecode);
+  loc->cond_bytecode = NULL;
+  loc->cond_bytecode_valid = 0;
+}
+
+/* The deepest evaluation stack a condition may need for the target
+   to be given it; gdbserver allows this many entries.  */
+
+#define MAX_COND_BYTECODE_STACK 100
+
+/* Return the condition of BPT compiled to bytecode for the target to
+   evaluate, or NULL if the target should leave it to us.  */
+
+static struct agent_expr *
+bp_location_cond_bytecode (struct bp_location *bpt)
+{
+  struct bp_location *loc;
+  int ix;
+
+  if (bpt->cond == NULL
+      || bpt->loc_type != bp_loc_software_breakpoint
+      || !target_supports_evaluation_of_breakpoint_conditions ())
+    return NULL;
+
+  /* The bytecode is sent along when the breakpoint is inserted, so a
+     breakpoint which stays inserted would not see its condition
+     change.  */
+  if (always_inserted_mode)
+    return NULL;
+
+  /* Only one location is inserted per address.  If other breakpoints
+     are at this one, the target must stop for them whatever our
+     condition says.  update_inserted_cond_bytecode sends the target
+     the right conditions as such breakpoints come and go.  */
+  ALL_BP_LOCATIONS_AT_ADDR (loc, ix, bpt->address)
+    if (loc != bpt
+	&& (loc->loc_type == bp_loc_software_breakpoint
+	    || loc->loc_type == bp_loc_hardware_breakpoint)
+	&& breakpoint_enabled (loc->owner)
+	&& loc->enabled
+	&& !loc->shlib_disabled)
+      return NULL;
+
+  if (!bpt->cond_bytecode_valid)
+    {
+      volatile struct gdb_exception e;
+      struct agent_expr *aexpr = NULL;
+
+      /* Conditions which can't be compiled, e.g. because they call
+	 functions, are evaluated by GDB when the breakpoint is hit,
+	 as they always were.  */
+      TRY_CATCH (e, RETURN_MASK_ERROR)
+	{
+	  aexpr = gen_eval_for_expr (bpt->address, bpt->cond);
+	}
+
+      if (aexpr != NULL)
+	{
+	  struct agent_reqs reqs;
+
+	  ax_reqs (aexpr, &reqs);
+	  xfree (reqs.reg_mask);
+	  if (reqs.flaw != agent_flaw_none
+	      || reqs.min_height < 0
+	      || reqs.max_height > MAX_COND_BYTECODE_STACK)
+	    {
+	      free_agent_expr (aexpr);
+	      aexpr = NULL;
+	    }
+	}
+
+      bpt->cond_bytecode = aexpr;
+      bpt->cond_bytecode_valid = 1;
+    }
+
+  return bpt->cond_bytecode;
+}
+
+/* Make the conditions the target evaluates for the inserted
+   breakpoint locations agree with bp_location_cond_bytecode.  Which
+   conditions may be left to the target depends on the other
+   locations at the same address, and those come and go while the
+   inserted one stays inserted, e.g. when a step-resume breakpoint is
+   set on top of a conditional breakpoint.  Inserting a breakpoint the
+   target already has replaces its conditions.  */
+
+static void
+update_inserted_cond_bytecode (void)
+{
+  struct bp_location *loc;
+
+  ALL_BP_LOCATIONS (loc)
+    {
+      struct agent_expr *aexpr;
+
+      if (!loc->inserted
+	  || loc->loc_type != bp_loc_software_breakpoint
+	  || (loc->cond == NULL && loc->target_info.cond_bytecode == NULL))
+	continue;
+
+      aexpr = bp_location_cond_bytecode (loc);
+      if (aexpr == loc->target_info.cond_bytecode)
+	continue;
+
+      loc->target_info.cond_bytecode = aexpr;
+      if (target_insert_breakpoint (&loc->target_info) != 0)
+	warning (_("Could not update the condition of breakpoint %d."),
+		 loc->owner->number);
+    }
+}
+
+/* Record the result VAL of inserting the instruction breakpoint
+   location BPT: mark it inserted, or report why it could not be.
+   Returns VAL, or zero if the failure was dealt with by disabling
+   the breakpoint.  The other arguments are as for
+   insert_bp_location.  */
+
+static int
+note_bp_location_insertion (struct bp_location *bpt, int val,
+			    struct ui_file *tmp_error_stream,
+			    int *disabled_breaks, int *process_warning,
+			    int *hw_breakpoint_error)
+{
+  if (val)
+    {
+      /* Can't set the breakpoint.  */
+      if (solib_address (bpt->address))
+	{
+	  /* See also: disable_breakpoints_in_shlibs. */
+	  val = 0;
+	  bpt->shlib_disabled = 1;
+	  if (!*disabled_breaks)
+	    {
+	      fprintf_unfiltered (tmp_error_stream, 
+				  "Cannot insert breakpoint %d.\n", 
+				  bpt->owner->number);
+	      fprintf_unfiltered (tmp_error_stream, 
+				  "Temporarily disabling shared library breakpoints:\n");
+	    }
+	  *disabled_breaks = 1;
+	  fprintf_unfiltered (tmp_error_stream,
+			      "breakpoint #%d\n", bpt->owner->number);
+	}
+      else
+	{
+#ifdef ONE_PROCESS_WRITETEXT
+	  *process_warning = 1;
+#endif
+	  if (bpt->loc_type == bp_loc_hardware_breakpoint)
+	    {
+	      *hw_breakpoint_error = 1;
+	      fprintf_unfiltered (tmp_error_stream, 
+				  "Cannot insert hardware breakpoint %d.\n",
+				  bpt->owner->number);
+	    }
+	  else
+	    {
+	      fprintf_unfiltered (tmp_error_stream, 
+				  "Cannot insert breakpoint %d.\n", 
+				  bpt->owner->number);
+	      fprintf_filtered (tmp_error_stream, 
+				"Error accessing memory address ");
+	      fputs_filtered (paddress (bpt->address), tmp_error_stream);
+	      fprintf_filtered (tmp_error_stream, ": %s.\n",
+				safe_strerror (val));
+	    }
+	}
+    }
+  else
+    bpt->inserted = 1;
+
+  return val;
+}
+
 /* Insert a low-level "breakpoint" of some type.  BPT is the breakpoint.
    Any error messages are printed to TMP_ERROR_STREAM; and DISABLED_BREAKS,
    PROCESS_WARNING, and HW_BREAKPOINT_ERROR are used to report problems.
 
+   If DEFERRED is not NULL, a plain software breakpoint is not inserted
+   yet, but added to *DEFERRED, for the caller to insert along with the
+   others with insert_bp_location_batch.
+
    NOTE drow/2003-09-09: This routine could be broken down to an object-style
    method for each breakpoint or catchpoint type.  */
 static int
 insert_bp_location (struct bp_location *bpt,
 		    struct ui_file *tmp_error_stream,
 		    int *disabled_breaks, int *process_warning,
-		    int *hw_breakpoint_error)
+		    int *hw_breakpoint_error,
+		    VEC(bp_location_p) **deferred)
 {
   int val = 0;
 
@@ -1117,7 +1347,15 @@ Note: automatically using hardware breakpoints for read-only addresses.\n"));
 	  if (bpt->loc_type == bp_loc_hardware_breakpoint)
 	    val = target_insert_hw_breakpoint (&bpt->target_info);
 	  else
-	    val = target_insert_breakpoint (&bpt->target_info);
+	    {
+	      bpt->target_info.cond_bytecode = bp_location_cond_bytecode (bpt);
+	      if (deferred != NULL)
+		{
+		  VEC_safe_push (bp_location_p, *deferred, bpt);
+		  return 0;
+		}
+	      val = target_insert_breakpoint (&bpt->target_info);
+	    }
 	}
       else
 	{
@@ -1162,56 +1400,9 @@ Note: automatically using hardware breakpoints for read-only addresses.\n"));
 	    }
 	}
 
-      if (val)
-	{
-	  /* Can't set the breakpoint.  */
-	  if (solib_address (bpt->address))
-	    {
-	      /* See also: disable_breakpoints_in_shlibs. */
-	      val = 0;
-	      bpt->shlib_disabled = 1;
-	      if (!*disabled_breaks)
-		{
-		  fprintf_unfiltered (tmp_error_stream, 
-				      "Cannot insert breakpoint %d.\n", 
-				      bpt->owner->number);
-		  fprintf_unfiltered (tmp_error_stream, 
-				      "Temporarily disabling shared library breakpoints:\n");
-		}
-	      *disabled_breaks = 1;
-	      fprintf_unfiltered (tmp_error_stream,
-				  "breakpoint #%d\n", bpt->owner->number);
-	    }
-	  else
-	    {
-#ifdef ONE_PROCESS_WRITETEXT
-	      *process_warning = 1;
-#endif
-	      if (bpt->loc_type == bp_loc_hardware_breakpoint)
-		{
-		  *hw_breakpoint_error = 1;
-		  fprintf_unfiltered (tmp_error_stream, 
-				      "Cannot insert hardware breakpoint %d.\n",
-				      bpt->owner->number);
-		}
-	      else
-		{
-		  fprintf_unfiltered (tmp_error_stream, 
-				      "Cannot insert breakpoint %d.\n", 
-				      bpt->owner->number);
-		  fprintf_filtered (tmp_error_stream, 
-				    "Error accessing memory address ");
-		  fputs_filtered (paddress (bpt->address), tmp_error_stream);
-		  fprintf_filtered (tmp_error_stream, ": %s.\n",
-				    safe_strerror (val));
-		}
-
-	    }
-	}
-      else
-	bpt->inserted = 1;
-
-      return val;
+      return note_bp_location_insertion (bpt, val, tmp_error_stream,
+					 disabled_breaks, process_warning,
+					 hw_breakpoint_error);
     }
 
   else if (bpt->loc_type == bp_loc_hardware_watchpoint
@@ -1247,6 +1438,59 @@ Note: automatically using hardware breakpoints for read-only addresses.\n"));
   return 0;
 }
 
+/* Insert the software breakpoint locations in LOCS, which
+   insert_bp_location deferred, with a single request to the target.
+   Returns zero, or the last error as insert_bp_location would.  */
+
+static int
+insert_bp_location_batch (VEC(bp_location_p) *locs,
+			  struct ui_file *tmp_error_stream,
+			  int *disabled_breaks, int *process_warning,
+			  int *hw_breakpoint_error)
+{
+  int count = VEC_length (bp_location_p, locs);
+  struct bp_target_info **bp_tgts;
+  struct bp_location *bpt;
+  struct cleanup *old_chain;
+  int *results;
+  int error = 0;
+  int ix;
+
+  if (count == 0)
+    return 0;
+
+  bp_tgts = xmalloc (count * sizeof (struct bp_target_info *));
+  old_chain = make_cleanup (xfree, bp_tgts);
+  results = xmalloc (count * sizeof (int));
+  make_cleanup (xfree, results);
+
+  for (ix = 0; VEC_iterate (bp_location_p, locs, ix, bpt); ix++)
+    bp_tgts[ix] = &bpt->target_info;
+
+  target_insert_breakpoints (bp_tgts, count, results);
+
+  for (ix = 0; VEC_iterate (bp_location_p, locs, ix, bpt); ix++)
+    {
+      int val = note_bp_location_insertion (bpt, results[ix],
+					    tmp_error_stream,
+					    disabled_breaks, process_warning,
+					    hw_breakpoint_error);
+      if (val)
+	error = val;
+    }
+
+  do_cleanups (old_chain);
+  return error;
+}
+
+static void
+free_bp_location_vec (void *arg)
+{
+  VEC(bp_location_p) **vec = arg;
+
+  VEC_free (bp_location_p, *vec);
+}
+
 /* Make sure all breakpoints are inserted in inferior.
    Throws exception on any error.
    A breakpoint that is already inserted won't be inserted
@@ -1284,9 +1528,12 @@ insert_breakpoint_locations (void)
   int disabled_breaks = 0;
   int hw_breakpoint_error = 0;
   int process_warning = 0;
+  VEC(bp_location_p) *deferred = NULL;
+  struct cleanup *deferred_chain;
 
   struct ui_file *tmp_error_stream = mem_fileopen ();
   make_cleanup_ui_file_delete (tmp_error_stream);
+  deferred_chain = make_cleanup (free_bp_location_vec, &deferred);
   
   /* Explicitly mark the warning -- this will only be printed if
      there was an error.  */
@@ -1305,11 +1552,21 @@ insert_breakpoint_locations (void)
 
       val = insert_bp_location (b, tmp_error_stream,
 				    &disabled_breaks, &process_warning,
-				    &hw_breakpoint_error);
+				    &hw_breakpoint_error, &deferred);
       if (val)
 	error = val;
     }
 
+  /* Plain software breakpoints are inserted all together, which is
+     much cheaper when each insertion is a round trip to a remote
+     target.  */
+  val = insert_bp_location_batch (deferred, tmp_error_stream,
+				  &disabled_breaks, &process_warning,
+				  &hw_breakpoint_error);
+  if (val)
+    error = val;
+  do_cleanups (deferred_chain);
+
   /* If we failed to insert all locations of a watchpoint,
      remove them, as half-inserted watchpoint is of limited use.  */
   ALL_BREAKPOINTS (bpt)  
@@ -1366,22 +1623,83 @@ You may have requested too many hardware breakpoints/watchpoints.\n");
     }
 }
 
+/* Remove the inserted software breakpoint locations in LOCS with a
+   single request to the target.  Returns zero, or the first error as
+   remove_breakpoint would.  */
+
+static int
+remove_bp_location_batch (VEC(bp_location_p) *locs)
+{
+  int count = VEC_length (bp_location_p, locs);
+  struct bp_target_info **bp_tgts;
+  struct bp_location *b;
+  struct cleanup *old_chain;
+  int *results;
+  int error = 0;
+  int ix;
+
+  if (count == 0)
+    return 0;
+
+  bp_tgts = xmalloc (count * sizeof (struct bp_target_info *));
+  old_chain = make_cleanup (xfree, bp_tgts);
+  results = xmalloc (count * sizeof (int));
+  make_cleanup (xfree, results);
+
+  for (ix = 0; VEC_iterate (bp_location_p, locs, ix, b); ix++)
+    bp_tgts[ix] = &b->target_info;
+
+  target_remove_breakpoints (bp_tgts, count, results);
+
+  for (ix = 0; VEC_iterate (bp_location_p, locs, ix, b); ix++)
+    if (results[ix] == 0)
+      b->inserted = 0;
+    else if (error == 0)
+      error = results[ix];
+
+  do_cleanups (old_chain);
+  return error;
+}
+
 int
 remove_breakpoints (void)
 {
   struct bp_location *b;
-  int val;
+  VEC(bp_location_p) *batch = NULL;
+  struct cleanup *old_chain;
+  int val = 0;
+
+  old_chain = make_cleanup (free_bp_location_vec, &batch);
 
   ALL_BP_LOCATIONS (b)
   {
     if (b->inserted)
       {
+	/* Plain software breakpoints are removed all together, as
+	   insert_breakpoint_locations inserts them.  */
+	if (b->loc_type == bp_loc_software_breakpoint
+	    && b->owner->enable_state != bp_permanent
+	    && (overlay_debugging == ovly_off
+		|| b->section == NULL
+		|| !section_is_overlay (b->section)))
+	  {
+	    VEC_safe_push (bp_location_p, batch, b);
+	    continue;
+	  }
+
 	val = remove_breakpoint (b, mark_uninserted);
 	if (val != 0)
-	  return val;
+	  break;
       }
   }
-  return 0;
+
+  if (val == 0)
+    val = remove_bp_location_batch (batch);
+  else
+    remove_bp_location_batch (batch);
+
+  do_cleanups (old_chain);
+  return val;
 }
 
 int
@@ -1420,7 +1738,7 @@ reattach_breakpoints (int pid)
       {
 	b->inserted = 0;
 	val = insert_bp_location (b, tmp_error_stream,
-				  &dummy1, &dummy2, &dummy3);
+				  &dummy1, &dummy2, &dummy3, NULL);
 	if (val != 0)
 	  {
 	    do_cleanups (old_chain);
@@ -1774,18 +2092,18 @@ breakpoint_init_inferior (enum inf_context context)
 enum breakpoint_here
 breakpoint_here_p (CORE_ADDR pc)
 {
-  const struct bp_location *bpt;
+  struct bp_location *bpt;
   int any_breakpoint_here = 0;
+  int ix;
 
-  ALL_BP_LOCATIONS (bpt)
+  ALL_BP_LOCATIONS_AT_ADDR (bpt, ix, pc)
     {
       if (bpt->loc_type != bp_loc_software_breakpoint
 	  && bpt->loc_type != bp_loc_hardware_breakpoint)
 	continue;
 
-      if ((breakpoint_enabled (bpt->owner)
-	   || bpt->owner->enable_state == bp_permanent)
-	  && bpt->address == pc)	/* bp is enabled and matches pc */
+      if (breakpoint_enabled (bpt->owner)
+	  || bpt->owner->enable_state == bp_permanent)	/* bp is enabled */
 	{
 	  if (overlay_debugging 
 	      && section_is_overlay (bpt->section) 
@@ -1810,16 +2128,16 @@ breakpoint_here_p (CORE_ADDR pc)
 int
 regular_breakpoint_inserted_here_p (CORE_ADDR pc)
 {
-  const struct bp_location *bpt;
+  struct bp_location *bpt;
+  int ix;
 
-  ALL_BP_LOCATIONS (bpt)
+  ALL_BP_LOCATIONS_AT_ADDR (bpt, ix, pc)
     {
       if (bpt->loc_type != bp_loc_software_breakpoint
 	  && bpt->loc_type != bp_loc_hardware_breakpoint)
 	continue;
 
-      if (bpt->inserted
-	  && bpt->address == pc)	/* bp is inserted and matches pc */
+      if (bpt->inserted)	/* bp is inserted */
 	{
 	  if (overlay_debugging 
 	      && section_is_overlay (bpt->section) 
@@ -1853,16 +2171,15 @@ breakpoint_inserted_here_p (CORE_ADDR pc)
 int
 software_breakpoint_inserted_here_p (CORE_ADDR pc)
 {
-  const struct bp_location *bpt;
-  int any_breakpoint_here = 0;
+  struct bp_location *bpt;
+  int ix;
 
-  ALL_BP_LOCATIONS (bpt)
+  ALL_BP_LOCATIONS_AT_ADDR (bpt, ix, pc)
     {
       if (bpt->loc_type != bp_loc_software_breakpoint)
 	continue;
 
-      if (bpt->inserted
-	  && bpt->address == pc)	/* bp is enabled and matches pc */
+      if (bpt->inserted)	/* bp is inserted */
 	{
 	  if (overlay_debugging 
 	      && section_is_overlay (bpt->section) 
@@ -1886,12 +2203,13 @@ software_breakpoint_inserted_here_p (CORE_ADDR pc)
 int
 breakpoint_thread_match (CORE_ADDR pc, ptid_t ptid)
 {
-  const struct bp_location *bpt;
+  struct bp_location *bpt;
   int thread;
+  int ix;
 
   thread = pid_to_thread_id (ptid);
 
-  ALL_BP_LOCATIONS (bpt)
+  ALL_BP_LOCATIONS_AT_ADDR (bpt, ix, pc)
     {
       if (bpt->loc_type != bp_loc_software_breakpoint
 	  && bpt->loc_type != bp_loc_hardware_breakpoint)
@@ -1899,7 +2217,6 @@ breakpoint_thread_match (CORE_ADDR pc, ptid_t ptid)
 
       if ((breakpoint_enabled (bpt->owner)
 	   || bpt->owner->enable_state == bp_permanent)
-	  && bpt->address == pc
 	  && (bpt->owner->thread == -1 || bpt->owner->thread == thread))
 	{
 	  if (overlay_debugging 
@@ -2686,7 +3003,7 @@ watchpoint_check (void *p)
 
       fetch_watchpoint_value (b->exp, &new_val, NULL, NULL);
       if ((b->val != NULL) != (new_val != NULL)
-	  || (b->val != NULL && !value_equal (b->val, new_val)))
+	  || (b->val != NULL && !value_contents_equal (b->val, new_val)))
 	{
 	  if (new_val != NULL)
 	    {
@@ -4116,6 +4433,69 @@ breakpoint_address_is_meaningful (struct breakpoint *bpt)
 	  && type != bp_catch_vfork);
 }
 
+/* Order breakpoint locations by address, for qsort.  Locations at the
+   same address are ordered by breakpoint number, so that the result
+   does not depend on where they happen to be allocated.  */
+
+static int
+bp_location_compare (const void *ap, const void *bp)
+{
+  struct bp_location *a = *(struct bp_location **) ap;
+  struct bp_location *b = *(struct bp_location **) bp;
+
+  if (a->address != b->address)
+    return a->address < b->address ? -1 : 1;
+  if (a->owner->number != b->owner->number)
+    return a->owner->number < b->owner->number ? -1 : 1;
+  return (a > b) - (a < b);
+}
+
+/* Bring bp_location_table in sync with bp_location_chain.  Locations
+   still marked 1 are no longer on the chain and are dropped; the
+   locations in ADDED are merged in after any existing locations at
+   the same address.  This costs one pass over the table plus sorting
+   ADDED, instead of sorting every location again.  */
+
+static void
+update_bp_location_table (VEC(bp_location_p) *added)
+{
+  struct bp_location **table;
+  struct bp_location **new_locs;
+  int n = VEC_length (bp_location_p, bp_location_table);
+  int k = VEC_length (bp_location_p, added);
+  int i, j, out;
+
+  /* Squeeze out the locations that went away.  */
+  table = VEC_address (bp_location_p, bp_location_table);
+  for (i = 0, out = 0; i < n; i++)
+    if (table[i]->global_mark == 2)
+      table[out++] = table[i];
+    else
+      table[i]->global_mark = 0;
+  n = out;
+  VEC_truncate (bp_location_p, bp_location_table, n);
+
+  if (k == 0)
+    return;
+
+  new_locs = VEC_address (bp_location_p, added);
+  qsort (new_locs, k, sizeof (struct bp_location *), bp_location_compare);
+
+  /* Merge from the back, so that nothing needs to be moved twice.  */
+  VEC_safe_grow (bp_location_p, bp_location_table, n + k);
+  table = VEC_address (bp_location_p, bp_location_table);
+  i = n - 1;
+  j = k - 1;
+  out = n + k - 1;
+  while (j >= 0)
+    {
+      if (i >= 0 && table[i]->address > new_locs[j]->address)
+	table[out--] = table[i--];
+      else
+	table[out--] = new_locs[j--];
+    }
+}
+
 /* Rescan breakpoints at the same address and section as BPT,
    marking the first one as "first" and any others as "duplicates".
    This is so that the bpt instruction is only inserted once.
@@ -4128,14 +4508,14 @@ check_duplicates_for (CORE_ADDR address, asection *section)
   struct bp_location *b;
   int count = 0;
   struct bp_location *perm_bp = 0;
+  int ix;
 
-  ALL_BP_LOCATIONS (b)
+  ALL_BP_LOCATIONS_AT_ADDR (b, ix, address)
     if (b->owner->enable_state != bp_disabled
 	&& b->owner->enable_state != bp_call_disabled
 	&& b->enabled
 	&& !b->shlib_disabled
-	&& b->address == address	/* address / overlay match */
-	&& (!overlay_debugging || b->section == section)
+	&& (!overlay_debugging || b->section == section) /* overlay match */
 	&& breakpoint_address_is_meaningful (b->owner))
     {
       /* Have we found a permanent breakpoint?  */
@@ -4162,13 +4542,12 @@ check_duplicates_for (CORE_ADDR address, asection *section)
 			_("allegedly permanent breakpoint is not "
 			"actually inserted"));
 
-      ALL_BP_LOCATIONS (b)
+      ALL_BP_LOCATIONS_AT_ADDR (b, ix, address)
 	if (b != perm_bp)
 	  {
 	    if (b->owner->enable_state != bp_disabled
 		&& b->owner->enable_state != bp_call_disabled
 		&& b->enabled && !b->shlib_disabled		
-		&& b->address == address	/* address / overlay match */
 		&& (!overlay_debugging || b->section == section)
 		&& breakpoint_address_is_meaningful (b->owner))
 	      {
@@ -4313,6 +4692,8 @@ static void free_bp_location (struct bp_location *loc)
   if (loc->cond)
     xfree (loc->cond);
 
+  clear_cond_bytecode (loc);
+
   if (loc->function_name)
     xfree (loc->function_name);
   
@@ -7009,6 +7390,7 @@ update_global_location_list (int should_insert)
   struct bp_location *loc2;
   struct gdb_exception e;
   VEC(bp_location_p) *old_locations = NULL;
+  VEC(bp_location_p) *new_locations = NULL;
   int ret;
   int ix;
   
@@ -7016,6 +7398,9 @@ update_global_location_list (int should_insert)
   for (loc = bp_location_chain; loc; loc = loc->global_next)
     VEC_safe_push (bp_location_p, old_locations, loc);
 
+  /* Rebuild the chain.  Every location on it ends up with a global
+     mark of 2; the old locations that are still marked 1 afterwards
+     are the ones that went away.  */
   bp_location_chain = NULL;
   ALL_BREAKPOINTS (b)
     {
@@ -7024,9 +7409,16 @@ update_global_location_list (int should_insert)
 	  *next = loc;
 	  next = &(loc->global_next);
 	  *next = NULL;
+
+	  if (loc->global_mark == 0)
+	    VEC_safe_push (bp_location_p, new_locations, loc);
+	  loc->global_mark = 2;
 	}
     }
 
+  update_bp_location_table (new_locations);
+  VEC_free (bp_location_p, new_locations);
+
   /* Identify bp_location instances that are no longer present in the new
      list, and therefore should be freed.  Note that it's not necessary that
      those locations should be removed from inferior -- if there's another
@@ -7040,12 +7432,10 @@ update_global_location_list (int should_insert)
       /* Tells if the location should remain inserted in the target.  */
       int keep_in_target = 0;
       int removed = 0;
-      for (loc2 = bp_location_chain; loc2; loc2 = loc2->global_next)
-	if (loc2 == loc)
-	  {
-	    found_object = 1;
-	    break;
-	  }
+      int ix2;
+
+      if (loc->global_mark == 2)
+	found_object = 1;
 
       /* If this location is no longer present, and inserted, look if there's
 	 maybe a new location at the same address.  If so, mark that one 
@@ -7069,13 +7459,12 @@ update_global_location_list (int should_insert)
 		 See if there's another location at the same address, in which 
 		 case we don't need to remove this one from the target.  */
 	      if (breakpoint_address_is_meaningful (loc->owner))
-		for (loc2 = bp_location_chain; loc2; loc2 = loc2->global_next)
+		ALL_BP_LOCATIONS_AT_ADDR (loc2, ix2, loc->address)
 		  {
 		    /* For the sake of should_insert_location.  The
 		       call to check_duplicates will fix up this later.  */
 		    loc2->duplicate = 0;
-		    if (should_be_inserted (loc2)
-			&& loc2 != loc && loc2->address == loc->address)
+		    if (should_be_inserted (loc2) && loc2 != loc)
 		      {		  
 			loc2->inserted = 1;
 			loc2->target_info = loc->target_info;
@@ -7127,12 +7516,19 @@ update_global_location_list (int should_insert)
 	  free_bp_location (loc);
 	}
     }
+
+  VEC_free (bp_location_p, old_locations);
+
+  ALL_BP_LOCATIONS (loc)
+    loc->global_mark = 1;
     
   ALL_BREAKPOINTS (b)
     {
       check_duplicates (b);
     }
 
+  update_inserted_cond_bytecode ();
+
   if (always_inserted_mode && should_insert && target_has_execution)
     insert_breakpoint_locations ();
 }
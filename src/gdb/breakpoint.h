@@ -26,6 +26,7 @@
 
 struct value;
 struct block;
+struct agent_expr;
 
 /* This is the maximum number of bytes a breakpoint instruction can take.
    Feel free to increase it.  It's just used in a few places to size
@@ -196,6 +197,11 @@ struct bp_target_info
      (e.g. if a remote stub handled the details).  We may still
      need the size to remove the breakpoint safely.  */
   int placed_size;
+
+  /* If non-NULL, the breakpoint's condition compiled to agent
+     bytecode, for targets which can evaluate it themselves and only
+     report the hits for which it is true.  Owned by the location.  */
+  struct agent_expr *cond_bytecode;
 };
 
 /* GDB maintains two types of information about each breakpoint (or
@@ -228,6 +234,12 @@ struct bp_location
   /* Pointer to the next breakpoint location, in a global
      list of all breakpoint locations.  */
   struct bp_location *global_next;
+
+  /* Non-zero while this location is in the address-sorted index of
+     all breakpoint locations.  update_global_location_list also uses
+     it to tell which locations were added or removed since its last
+     call.  */
+  int global_mark;
  
   /* Type of this breakpoint location.  */
   enum bp_loc_type loc_type;
@@ -244,6 +256,12 @@ struct bp_location
      different locations.  */
   struct expression *cond;
 
+  /* COND compiled to agent bytecode, for the target to evaluate, and
+     whether that has been attempted yet.  COND_BYTECODE is NULL if
+     COND could not be compiled.  */
+  struct agent_expr *cond_bytecode;
+  int cond_bytecode_valid;
+
   /* This location's address is in an unloaded solib, and so this
      location should not be inserted.  It will be automatically
      enabled when that solib is loaded.  */
@@ -31,6 +31,7 @@
 #include "objfiles.h"
 #include "regcache.h"
 #include "value.h"
+#include "observer.h"
 
 #include "gdb_assert.h"
 #include "gdb_string.h"
@@ -109,9 +110,34 @@ struct dwarf2_fde
      section.  */
   unsigned char eh_frame_p;
 
+  /* The CFA program compiled into a table of rows, or NULL if it
+     hasn't been compiled yet.  */
+  struct dwarf2_frame_rows *rows;
+
   struct dwarf2_fde *next;
 };
 
+/* The FDEs of an objfile that cover any code, sorted by their initial
+   location.  */
+
+struct dwarf2_fde_table
+{
+  int num_entries;
+  struct dwarf2_fde_table_entry
+  {
+    struct dwarf2_fde *fde;
+
+    /* When several FDEs cover the same pc, the one with the lowest
+       ORDER is used.  */
+    int order;
+
+    /* The end of the code covered by this FDE or any FDE before it in
+       the table; when this isn't beyond a pc, no FDE from here on
+       backwards covers it.  */
+    CORE_ADDR max_end;
+  } *entries;
+};
+
 /* A minimal decoding of DWARF2 compilation units.  We only decode
    what's needed to get to the call frame information.  */
 
@@ -203,6 +229,46 @@ struct dwarf2_frame_state
    which is unused in that case.  */
 #define cfa_exp_len cfa_reg
 
+/* One row of the table a CFA program describes: the rules that apply
+   from a given pc up to the pc of the next row.  */
+
+struct dwarf2_frame_row
+{
+  /* The offset of the row's first pc from the start of the FDE.  */
+  CORE_ADDR offset;
+
+  /* The rule for the CFA, as in struct dwarf2_frame_state.  */
+  int cfa_how;
+  ULONGEST cfa_reg;
+  LONGEST cfa_offset;
+  gdb_byte *cfa_exp;
+
+  /* The rules for the registers, indexed by DWARF register number.
+     Consecutive rows with the same rules share this array.  */
+  int num_regs;
+  struct dwarf2_frame_state_reg *reg;
+};
+
+/* An FDE's CFA program, compiled into rows so that unwinding a frame
+   doesn't need to execute it again.  */
+
+struct dwarf2_frame_rows
+{
+  /* The architecture the program was compiled for.  */
+  struct gdbarch *gdbarch;
+
+  /* Non-zero if the program couldn't be compiled, because it moves
+     the location backwards; it is then executed for each frame.  */
+  int interpret;
+
+  /* Copied from struct dwarf2_frame_state.  */
+  int armcc_cfa_offsets_reversed;
+
+  /* The rows, sorted by offset.  */
+  int num_rows;
+  struct dwarf2_frame_row *row;
+};
+
 /* Assert that the register set RS is large enough to store gdbarch_num_regs
    columns.  If necessary, enlarge the register set.  */
 
@@ -368,19 +434,65 @@ execute_stack_op (gdb_byte *exp, ULONGEST len, int addr_size,
 }
 
 
+/* Record in ROWS the rules of FS, which apply from LOC up to FS->pc.
+   The row's offset is set to LOC itself for now, and its register
+   rules are allocated on OBSTACK.  */
+
+static void
+dwarf2_frame_add_row (struct dwarf2_frame_rows *rows,
+		      struct dwarf2_frame_state *fs, CORE_ADDR loc,
+		      struct obstack *obstack)
+{
+  struct dwarf2_frame_row *row, *prev;
+  size_t size = fs->regs.num_regs * sizeof (struct dwarf2_frame_state_reg);
+
+  if (fs->pc < loc)
+    {
+      rows->interpret = 1;
+      return;
+    }
+
+  /* ROWS->row is xrealloc'ed as it grows, doubling in size.  */
+  if ((rows->num_rows & (rows->num_rows - 1)) == 0)
+    rows->row = xrealloc (rows->row, (rows->num_rows ? 2 * rows->num_rows : 1)
+				     * sizeof (struct dwarf2_frame_row));
+
+  row = &rows->row[rows->num_rows++];
+  row->offset = loc;
+  row->cfa_how = fs->cfa_how;
+  row->cfa_reg = fs->cfa_reg;
+  row->cfa_offset = fs->cfa_offset;
+  row->cfa_exp = fs->cfa_exp;
+  row->num_regs = fs->regs.num_regs;
+
+  prev = rows->num_rows > 1 ? row - 1 : NULL;
+  if (prev != NULL && prev->num_regs == row->num_regs
+      && memcmp (prev->reg, fs->regs.reg, size) == 0)
+    row->reg = prev->reg;
+  else
+    {
+      row->reg = obstack_alloc (obstack, size);
+      memcpy (row->reg, fs->regs.reg, size);
+    }
+}
+
+/* Execute the CFA program from INSN_PTR to INSN_END, updating FS, up
+   to the row that applies to PC.  If ROWS is non-NULL, record each
+   row the program describes in it.  */
+
 static void
 execute_cfa_program (struct dwarf2_fde *fde, gdb_byte *insn_ptr,
-		     gdb_byte *insn_end, struct frame_info *this_frame,
-		     struct dwarf2_frame_state *fs)
+		     gdb_byte *insn_end, struct gdbarch *gdbarch,
+		     CORE_ADDR pc, struct dwarf2_frame_state *fs,
+		     struct dwarf2_frame_rows *rows)
 {
   int eh_frame_p = fde->eh_frame_p;
-  CORE_ADDR pc = get_frame_pc (this_frame);
   int bytes_read;
-  struct gdbarch *gdbarch = get_frame_arch (this_frame);
 
   while (insn_ptr < insn_end && fs->pc <= pc)
     {
       gdb_byte insn = *insn_ptr++;
+      CORE_ADDR loc = fs->pc;
       ULONGEST utmp, reg;
       LONGEST offset;
 
@@ -644,6 +756,10 @@ bad CFI data; mismatched DW_CFA_restore_state at 0x%s"), paddr (fs->pc));
 	      internal_error (__FILE__, __LINE__, _("Unknown CFI encountered."));
 	    }
 	}
+
+      if (rows != NULL && fs->pc != loc)
+	dwarf2_frame_add_row (rows, fs, loc,
+			      &fde->cie->unit->objfile->objfile_obstack);
     }
 
   /* Don't allow remember/restore between CIE and FDE programs.  */
@@ -865,101 +981,258 @@ struct dwarf2_frame_cache
   int addr_size;
 };
 
-static struct dwarf2_frame_cache *
-dwarf2_frame_cache (struct frame_info *this_frame, void **this_cache)
+/* The result of interpreting the CFI for a particular pc: the FDE
+   covering it, and the rules for finding the CFA and the saved
+   registers.  None of this depends on the contents of registers or
+   memory, so unlike a frame's cache it stays valid across stops, and
+   a backtrace through functions GDB has unwound before needn't search
+   for their FDEs or execute their CFA programs again.  */
+
+struct dwarf2_frame_plan
+{
+  /* Non-zero if this slot of the table holds a plan.  */
+  int valid;
+
+  /* The architecture and the pc the plan is for, and the address
+     used to find the FDE (see dwarf2_frame_cache).  */
+  struct gdbarch *gdbarch;
+  CORE_ADDR pc;
+  CORE_ADDR block_addr;
+
+  /* The FDE covering BLOCK_ADDR, or NULL if there is none, in which
+     case the rest of the plan is unused.  */
+  struct dwarf2_fde *fde;
+
+  /* Non-zero if this is a signal frame.  */
+  int signal_frame;
+
+  /* How to compute the CFA: either add CFA_OFFSET to DWARF register
+     CFA_REG, or evaluate the CFA_EXP_LEN bytes at CFA_EXP.  As in
+     struct dwarf2_frame_state, CFA_EXP_LEN is stored in CFA_REG.  */
+  int cfa_how;
+  ULONGEST cfa_reg;
+  LONGEST cfa_offset;
+  gdb_byte *cfa_exp;
+
+  /* The rest of the frame's cache, to be copied into it.  REG is
+     allocated with xmalloc.  */
+  int undefined_retaddr;
+  struct dwarf2_frame_state_reg *reg;
+  struct dwarf2_frame_state_reg retaddr_reg;
+  int addr_size;
+};
+
+#define DWARF2_FRAME_PLAN_SIZE 127
+
+static struct dwarf2_frame_plan dwarf2_frame_plans[DWARF2_FRAME_PLAN_SIZE];
+
+/* Forget all plans, e.g. when objfiles are added, relocated or
+   discarded.  */
+
+void
+dwarf2_frame_clear_plans (void)
+{
+  int i;
+
+  for (i = 0; i < DWARF2_FRAME_PLAN_SIZE; i++)
+    xfree (dwarf2_frame_plans[i].reg);
+  memset (dwarf2_frame_plans, 0, sizeof (dwarf2_frame_plans));
+}
+
+static void
+dwarf2_frame_plans_new_objfile (struct objfile *objfile)
+{
+  dwarf2_frame_clear_plans ();
+}
+
+/* Return the rows of FDE's CFA program for GDBARCH, compiling the
+   program the first time it is needed, or NULL if the program has to
+   be executed for each frame instead.  START is the address of the
+   first instruction covered by FDE, relocated.  */
+
+static struct dwarf2_frame_rows *
+dwarf2_frame_fde_rows (struct dwarf2_fde *fde, struct gdbarch *gdbarch,
+		       CORE_ADDR start)
+{
+  struct obstack *obstack = &fde->cie->unit->objfile->objfile_obstack;
+  struct dwarf2_frame_rows rows;
+  struct dwarf2_frame_state *fs;
+  struct cleanup *old_chain;
+  int i;
+
+  if (fde->rows == NULL)
+    {
+      memset (&rows, 0, sizeof (rows));
+      rows.gdbarch = gdbarch;
+
+      fs = XMALLOC (struct dwarf2_frame_state);
+      memset (fs, 0, sizeof (struct dwarf2_frame_state));
+      old_chain = make_cleanup (dwarf2_frame_state_free, fs);
+      make_cleanup (free_current_contents, &rows.row);
+
+      fs->pc = start;
+      fs->data_align = fde->cie->data_alignment_factor;
+      fs->code_align = fde->cie->code_alignment_factor;
+      fs->retaddr_column = fde->cie->return_address_register;
+      dwarf2_frame_find_quirks (fs, fde);
+
+      /* Run both programs to the end.  The initial instructions can't
+	 be allowed to move the location, since every row starts out
+	 from their rules.  */
+      execute_cfa_program (fde, fde->cie->initial_instructions,
+			   fde->cie->end, gdbarch, (CORE_ADDR) -1, fs, NULL);
+      if (fs->pc != start)
+	rows.interpret = 1;
+
+      fs->initial = fs->regs;
+      fs->initial.reg = dwarf2_frame_state_copy_regs (&fs->regs);
+
+      execute_cfa_program (fde, fde->instructions, fde->end,
+			   gdbarch, (CORE_ADDR) -1, fs, &rows);
+
+      /* The last row applies up to the end of the FDE.  */
+      dwarf2_frame_add_row (&rows, fs, fs->pc, obstack);
+
+      rows.armcc_cfa_offsets_reversed = fs->armcc_cfa_offsets_reversed;
+      for (i = 0; i < rows.num_rows; i++)
+	rows.row[i].offset -= start;
+
+      fde->rows = obstack_alloc (obstack, sizeof (rows));
+      *fde->rows = rows;
+      fde->rows->row = obstack_alloc (obstack, (rows.num_rows
+						* sizeof (rows.row[0])));
+      memcpy (fde->rows->row, rows.row, rows.num_rows * sizeof (rows.row[0]));
+
+      do_cleanups (old_chain);
+    }
+
+  if (fde->rows->gdbarch != gdbarch || fde->rows->interpret)
+    return NULL;
+
+  return fde->rows;
+}
+
+/* Return the row of ROWS that applies at OFFSET from the start of the
+   FDE.  */
+
+static struct dwarf2_frame_row *
+dwarf2_frame_find_row (struct dwarf2_frame_rows *rows, CORE_ADDR offset)
+{
+  int lo = 0, hi = rows->num_rows - 1;
+
+  /* Find the last row starting at or before OFFSET.  The first row
+     starts at offset zero.  */
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo + 1) / 2;
+
+      if (rows->row[mid].offset <= offset)
+	lo = mid;
+      else
+	hi = mid - 1;
+    }
+
+  return &rows->row[lo];
+}
+
+/* Interpret the CFI for THIS_FRAME, whose FDE is FDE, and store the
+   result in PLAN.  START is the address of the first instruction
+   covered by FDE, relocated.  */
+
+static void
+dwarf2_frame_build_plan (struct frame_info *this_frame,
+			 struct dwarf2_fde *fde, CORE_ADDR start,
+			 struct dwarf2_frame_plan *plan)
 {
   struct cleanup *old_chain;
   struct gdbarch *gdbarch = get_frame_arch (this_frame);
   const int num_regs = gdbarch_num_regs (gdbarch)
 		       + gdbarch_num_pseudo_regs (gdbarch);
-  struct dwarf2_frame_cache *cache;
+  CORE_ADDR pc = get_frame_pc (this_frame);
   struct dwarf2_frame_state *fs;
-  struct dwarf2_fde *fde;
-
-  if (*this_cache)
-    return *this_cache;
+  struct dwarf2_frame_rows *rows;
 
-  /* Allocate a new cache.  */
-  cache = FRAME_OBSTACK_ZALLOC (struct dwarf2_frame_cache);
-  cache->reg = FRAME_OBSTACK_CALLOC (num_regs, struct dwarf2_frame_state_reg);
+  plan->reg = XCALLOC (num_regs, struct dwarf2_frame_state_reg);
 
   /* Allocate and initialize the frame state.  */
   fs = XMALLOC (struct dwarf2_frame_state);
   memset (fs, 0, sizeof (struct dwarf2_frame_state));
   old_chain = make_cleanup (dwarf2_frame_state_free, fs);
 
-  /* Unwind the PC.
-
-     Note that if the next frame is never supposed to return (i.e. a call
-     to abort), the compiler might optimize away the instruction at
-     its return address.  As a result the return address will
-     point at some random instruction, and the CFI for that
-     instruction is probably worthless to us.  GCC's unwinder solves
-     this problem by substracting 1 from the return address to get an
-     address in the middle of a presumed call instruction (or the
-     instruction in the associated delay slot).  This should only be
-     done for "normal" frames and not for resume-type frames (signal
-     handlers, sentinel frames, dummy frames).  The function
-     get_frame_address_in_block does just this.  It's not clear how
-     reliable the method is though; there is the potential for the
-     register state pre-call being different to that on return.  */
-  fs->pc = get_frame_address_in_block (this_frame);
-
-  /* Find the correct FDE.  */
-  fde = dwarf2_frame_find_fde (&fs->pc);
-  gdb_assert (fde != NULL);
+  fs->pc = start;
 
   /* Extract any interesting information from the CIE.  */
   fs->data_align = fde->cie->data_alignment_factor;
   fs->code_align = fde->cie->code_alignment_factor;
   fs->retaddr_column = fde->cie->return_address_register;
-  cache->addr_size = fde->cie->addr_size;
+  plan->addr_size = fde->cie->addr_size;
 
-  /* Check for "quirks" - known bugs in producers.  */
-  dwarf2_frame_find_quirks (fs, fde);
+  rows = dwarf2_frame_fde_rows (fde, gdbarch, start);
+  if (rows != NULL)
+    {
+      /* Take the rules from the row for our target PC.  */
+      struct dwarf2_frame_row *row = dwarf2_frame_find_row (rows, pc - start);
+
+      fs->pc = start + row->offset;
+      fs->cfa_how = row->cfa_how;
+      fs->cfa_reg = row->cfa_reg;
+      fs->cfa_offset = row->cfa_offset;
+      fs->cfa_exp = row->cfa_exp;
+      fs->regs.num_regs = row->num_regs;
+      fs->regs.reg = XCALLOC (row->num_regs, struct dwarf2_frame_state_reg);
+      memcpy (fs->regs.reg, row->reg,
+	      row->num_regs * sizeof (struct dwarf2_frame_state_reg));
+      fs->armcc_cfa_offsets_reversed = rows->armcc_cfa_offsets_reversed;
+    }
+  else
+    {
+      /* Check for "quirks" - known bugs in producers.  */
+      dwarf2_frame_find_quirks (fs, fde);
 
-  /* First decode all the insns in the CIE.  */
-  execute_cfa_program (fde, fde->cie->initial_instructions,
-		       fde->cie->end, this_frame, fs);
+      /* First decode all the insns in the CIE.  */
+      execute_cfa_program (fde, fde->cie->initial_instructions,
+			   fde->cie->end, gdbarch, pc, fs, NULL);
 
-  /* Save the initialized register set.  */
-  fs->initial = fs->regs;
-  fs->initial.reg = dwarf2_frame_state_copy_regs (&fs->regs);
+      /* Save the initialized register set.  */
+      fs->initial = fs->regs;
+      fs->initial.reg = dwarf2_frame_state_copy_regs (&fs->regs);
 
-  /* Then decode the insns in the FDE up to our target PC.  */
-  execute_cfa_program (fde, fde->instructions, fde->end, this_frame, fs);
+      /* Then decode the insns in the FDE up to our target PC.  */
+      execute_cfa_program (fde, fde->instructions, fde->end,
+			   gdbarch, pc, fs, NULL);
+    }
 
-  /* Calculate the CFA.  */
+  /* Record how to calculate the CFA.  */
   switch (fs->cfa_how)
     {
     case CFA_REG_OFFSET:
-      cache->cfa = read_reg (this_frame, fs->cfa_reg);
+      plan->cfa_reg = fs->cfa_reg;
       if (fs->armcc_cfa_offsets_reversed)
-	cache->cfa -= fs->cfa_offset;
+	plan->cfa_offset = -fs->cfa_offset;
       else
-	cache->cfa += fs->cfa_offset;
+	plan->cfa_offset = fs->cfa_offset;
       break;
 
     case CFA_EXP:
-      cache->cfa =
-	execute_stack_op (fs->cfa_exp, fs->cfa_exp_len,
-			  cache->addr_size, this_frame, 0);
+      plan->cfa_exp = fs->cfa_exp;
+      plan->cfa_exp_len = fs->cfa_exp_len;
       break;
 
     default:
       internal_error (__FILE__, __LINE__, _("Unknown CFA rule."));
     }
+  plan->cfa_how = fs->cfa_how;
 
   /* Initialize the register state.  */
   {
     int regnum;
 
     for (regnum = 0; regnum < num_regs; regnum++)
-      dwarf2_frame_init_reg (gdbarch, regnum, &cache->reg[regnum], this_frame);
+      dwarf2_frame_init_reg (gdbarch, regnum, &plan->reg[regnum], this_frame);
   }
 
   /* Go through the DWARF2 CFI generated table and save its register
-     location information in the cache.  Note that we don't skip the
+     location information in the plan.  Note that we don't skip the
      return address column; it's perfectly all right for it to
      correspond to a real register.  If it doesn't correspond to a
      real register, or if we shouldn't treat it as such,
@@ -990,14 +1263,14 @@ dwarf2_frame_cache (struct frame_info *this_frame, void **this_cache)
 	   DWARF2 register numbers.  */
 	if (fs->regs.reg[column].how == DWARF2_FRAME_REG_UNSPECIFIED)
 	  {
-	    if (cache->reg[regnum].how == DWARF2_FRAME_REG_UNSPECIFIED)
+	    if (plan->reg[regnum].how == DWARF2_FRAME_REG_UNSPECIFIED)
 	      complaint (&symfile_complaints, _("\
 incomplete CFI data; unspecified registers (e.g., %s) at 0x%s"),
 			 gdbarch_register_name (gdbarch, regnum),
 			 paddr_nz (fs->pc));
 	  }
 	else
-	  cache->reg[regnum] = fs->regs.reg[column];
+	  plan->reg[regnum] = fs->regs.reg[column];
       }
   }
 
@@ -1008,8 +1281,8 @@ incomplete CFI data; unspecified registers (e.g., %s) at 0x%s"),
 
     for (regnum = 0; regnum < num_regs; regnum++)
       {
-	if (cache->reg[regnum].how == DWARF2_FRAME_REG_RA
-	    || cache->reg[regnum].how == DWARF2_FRAME_REG_RA_OFFSET)
+	if (plan->reg[regnum].how == DWARF2_FRAME_REG_RA
+	    || plan->reg[regnum].how == DWARF2_FRAME_REG_RA_OFFSET)
 	  {
 	    struct dwarf2_frame_state_reg *retaddr_reg =
 	      &fs->regs.reg[fs->retaddr_column];
@@ -1025,22 +1298,22 @@ incomplete CFI data; unspecified registers (e.g., %s) at 0x%s"),
 		&& retaddr_reg->how != DWARF2_FRAME_REG_UNSPECIFIED
 		&& retaddr_reg->how != DWARF2_FRAME_REG_SAME_VALUE)
 	      {
-		if (cache->reg[regnum].how == DWARF2_FRAME_REG_RA)
-		  cache->reg[regnum] = *retaddr_reg;
+		if (plan->reg[regnum].how == DWARF2_FRAME_REG_RA)
+		  plan->reg[regnum] = *retaddr_reg;
 		else
-		  cache->retaddr_reg = *retaddr_reg;
+		  plan->retaddr_reg = *retaddr_reg;
 	      }
 	    else
 	      {
-		if (cache->reg[regnum].how == DWARF2_FRAME_REG_RA)
+		if (plan->reg[regnum].how == DWARF2_FRAME_REG_RA)
 		  {
-		    cache->reg[regnum].loc.reg = fs->retaddr_column;
-		    cache->reg[regnum].how = DWARF2_FRAME_REG_SAVED_REG;
+		    plan->reg[regnum].loc.reg = fs->retaddr_column;
+		    plan->reg[regnum].how = DWARF2_FRAME_REG_SAVED_REG;
 		  }
 		else
 		  {
-		    cache->retaddr_reg.loc.reg = fs->retaddr_column;
-		    cache->retaddr_reg.how = DWARF2_FRAME_REG_SAVED_REG;
+		    plan->retaddr_reg.loc.reg = fs->retaddr_column;
+		    plan->retaddr_reg.how = DWARF2_FRAME_REG_SAVED_REG;
 		  }
 	      }
 	  }
@@ -1049,9 +1322,125 @@ incomplete CFI data; unspecified registers (e.g., %s) at 0x%s"),
 
   if (fs->retaddr_column < fs->regs.num_regs
       && fs->regs.reg[fs->retaddr_column].how == DWARF2_FRAME_REG_UNDEFINED)
-    cache->undefined_retaddr = 1;
+    plan->undefined_retaddr = 1;
 
   do_cleanups (old_chain);
+}
+
+/* Return the plan for unwinding THIS_FRAME, interpreting its CFI if
+   it isn't in the table already.  */
+
+static struct dwarf2_frame_plan *
+dwarf2_frame_find_plan (struct frame_info *this_frame)
+{
+  struct gdbarch *gdbarch = get_frame_arch (this_frame);
+  CORE_ADDR pc = get_frame_pc (this_frame);
+  struct dwarf2_frame_plan *plan;
+  struct dwarf2_frame_plan new_plan;
+  struct cleanup *old_chain;
+
+  /* Unwind the PC.
+
+     Note that if the next frame is never supposed to return (i.e. a call
+     to abort), the compiler might optimize away the instruction at
+     its return address.  As a result the return address will
+     point at some random instruction, and the CFI for that
+     instruction is probably worthless to us.  GCC's unwinder solves
+     this problem by substracting 1 from the return address to get an
+     address in the middle of a presumed call instruction (or the
+     instruction in the associated delay slot).  This should only be
+     done for "normal" frames and not for resume-type frames (signal
+     handlers, sentinel frames, dummy frames).  The function
+     get_frame_address_in_block does just this.  It's not clear how
+     reliable the method is though; there is the potential for the
+     register state pre-call being different to that on return.
+
+     If the frame is a signal frame whose start address is placed on
+     the stack by the OS, its FDE must extend one byte before its start
+     address or we could potentially select the FDE of the previous
+     function.  */
+  CORE_ADDR block_addr = get_frame_address_in_block (this_frame);
+
+  plan = &dwarf2_frame_plans[block_addr % DWARF2_FRAME_PLAN_SIZE];
+  if (plan->valid
+      && plan->gdbarch == gdbarch
+      && plan->pc == pc
+      && plan->block_addr == block_addr)
+    return plan;
+
+  /* Build the new plan on the side, so that an error leaves the
+     table consistent.  */
+  memset (&new_plan, 0, sizeof (new_plan));
+  old_chain = make_cleanup (free_current_contents, &new_plan.reg);
+
+  new_plan.gdbarch = gdbarch;
+  new_plan.pc = pc;
+  new_plan.block_addr = block_addr;
+
+  /* Find the correct FDE.  This sets BLOCK_ADDR to the start of the
+     code the FDE covers.  */
+  new_plan.fde = dwarf2_frame_find_fde (&block_addr);
+  if (new_plan.fde != NULL)
+    {
+      /* On some targets, signal trampolines may have unwind
+	 information.  We need to recognize them so that we set the
+	 frame type correctly.  */
+      new_plan.signal_frame
+	= (new_plan.fde->cie->signal_frame
+	   || dwarf2_frame_signal_frame_p (gdbarch, this_frame));
+
+      dwarf2_frame_build_plan (this_frame, new_plan.fde, block_addr,
+			       &new_plan);
+    }
+
+  discard_cleanups (old_chain);
+
+  xfree (plan->reg);
+  *plan = new_plan;
+  plan->valid = 1;
+  return plan;
+}
+
+static struct dwarf2_frame_cache *
+dwarf2_frame_cache (struct frame_info *this_frame, void **this_cache)
+{
+  struct gdbarch *gdbarch = get_frame_arch (this_frame);
+  const int num_regs = gdbarch_num_regs (gdbarch)
+		       + gdbarch_num_pseudo_regs (gdbarch);
+  struct dwarf2_frame_cache *cache;
+  struct dwarf2_frame_plan *plan;
+
+  if (*this_cache)
+    return *this_cache;
+
+  plan = dwarf2_frame_find_plan (this_frame);
+  gdb_assert (plan->fde != NULL);
+
+  /* Allocate a new cache, and fill it in from the plan.  */
+  cache = FRAME_OBSTACK_ZALLOC (struct dwarf2_frame_cache);
+  cache->reg = FRAME_OBSTACK_CALLOC (num_regs, struct dwarf2_frame_state_reg);
+  memcpy (cache->reg, plan->reg,
+	  num_regs * sizeof (struct dwarf2_frame_state_reg));
+  cache->retaddr_reg = plan->retaddr_reg;
+  cache->undefined_retaddr = plan->undefined_retaddr;
+  cache->addr_size = plan->addr_size;
+
+  /* Calculate the CFA.  */
+  switch (plan->cfa_how)
+    {
+    case CFA_REG_OFFSET:
+      cache->cfa = read_reg (this_frame, plan->cfa_reg) + plan->cfa_offset;
+      break;
+
+    case CFA_EXP:
+      cache->cfa =
+	execute_stack_op (plan->cfa_exp, plan->cfa_exp_len,
+			  cache->addr_size, this_frame, 0);
+      break;
+
+    default:
+      internal_error (__FILE__, __LINE__, _("Unknown CFA rule."));
+    }
 
   *this_cache = cache;
   return cache;
@@ -1151,25 +1540,12 @@ static int
 dwarf2_frame_sniffer (const struct frame_unwind *self,
 		      struct frame_info *this_frame, void **this_cache)
 {
-  /* Grab an address that is guarenteed to reside somewhere within the
-     function.  get_frame_pc(), with a no-return next function, can
-     end up returning something past the end of this function's body.
-     If the frame we're sniffing for is a signal frame whose start
-     address is placed on the stack by the OS, its FDE must
-     extend one byte before its start address or we could potentially
-     select the FDE of the previous function.  */
-  CORE_ADDR block_addr = get_frame_address_in_block (this_frame);
-  struct dwarf2_fde *fde = dwarf2_frame_find_fde (&block_addr);
-  if (!fde)
-    return 0;
+  struct dwarf2_frame_plan *plan = dwarf2_frame_find_plan (this_frame);
 
-  /* On some targets, signal trampolines may have unwind information.
-     We need to recognize them so that we set the frame type
-     correctly.  */
+  if (plan->fde == NULL)
+    return 0;
 
-  if (fde->cie->signal_frame
-      || dwarf2_frame_signal_frame_p (get_frame_arch (this_frame),
-				      this_frame))
+  if (plan->signal_frame)
     return self->type == SIGTRAMP_FRAME;
 
   return self->type != SIGTRAMP_FRAME;
@@ -1229,8 +1605,7 @@ static const struct frame_base dwarf2_frame_base =
 const struct frame_base *
 dwarf2_frame_base_sniffer (struct frame_info *this_frame)
 {
-  CORE_ADDR block_addr = get_frame_address_in_block (this_frame);
-  if (dwarf2_frame_find_fde (&block_addr))
+  if (dwarf2_frame_find_plan (this_frame)->fde != NULL)
     return &dwarf2_frame_base;
 
   return NULL;
@@ -1238,6 +1613,9 @@ dwarf2_frame_base_sniffer (struct frame_info *this_frame)
 
 const struct objfile_data *dwarf2_frame_objfile_data;
 
+/* The objfile's struct dwarf2_fde_table.  */
+static const struct objfile_data *dwarf2_frame_table_data;
+
 static unsigned int
 read_1_byte (bfd *abfd, gdb_byte *buf)
 {
@@ -1494,26 +1872,50 @@ dwarf2_frame_find_fde (CORE_ADDR *pc)
 
   ALL_OBJFILES (objfile)
     {
-      struct dwarf2_fde *fde;
-      CORE_ADDR offset;
+      struct dwarf2_fde_table *table;
+      struct dwarf2_fde *fde = NULL;
+      CORE_ADDR offset, addr;
+      int lo, hi, order = 0;
 
-      fde = objfile_data (objfile, dwarf2_frame_objfile_data);
-      if (fde == NULL)
+      table = objfile_data (objfile, dwarf2_frame_table_data);
+      if (table == NULL)
 	continue;
 
       gdb_assert (objfile->section_offsets);
       offset = ANOFFSET (objfile->section_offsets, SECT_OFF_TEXT (objfile));
+      addr = *pc - offset;
+
+      /* Find the number of FDEs starting at or before ADDR.  */
+      lo = 0;
+      hi = table->num_entries;
+      while (lo < hi)
+	{
+	  int mid = lo + (hi - lo) / 2;
+
+	  if (table->entries[mid].fde->initial_location <= addr)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
 
-      while (fde)
+      /* Normally the last of those is the only one that can cover
+	 ADDR, but search back through any that overlap it.  */
+      for (lo--; lo >= 0 && table->entries[lo].max_end > addr; lo--)
 	{
-	  if (*pc >= fde->initial_location + offset
-	      && *pc < fde->initial_location + offset + fde->address_range)
+	  struct dwarf2_fde_table_entry *entry = &table->entries[lo];
+
+	  if (addr < entry->fde->initial_location + entry->fde->address_range
+	      && (fde == NULL || entry->order < order))
 	    {
-	      *pc = fde->initial_location + offset;
-	      return fde;
+	      fde = entry->fde;
+	      order = entry->order;
 	    }
+	}
 
-	  fde = fde->next;
+      if (fde != NULL)
+	{
+	  *pc = fde->initial_location + offset;
+	  return fde;
 	}
     }
 
@@ -1527,6 +1929,63 @@ add_fde (struct comp_unit *unit, struct dwarf2_fde *fde)
   set_objfile_data (unit->objfile, dwarf2_frame_objfile_data, fde);
 }
 
+static int
+compare_fde_table_entries (const void *a, const void *b)
+{
+  const struct dwarf2_fde_table_entry *ea = a;
+  const struct dwarf2_fde_table_entry *eb = b;
+
+  if (ea->fde->initial_location != eb->fde->initial_location)
+    return ea->fde->initial_location < eb->fde->initial_location ? -1 : 1;
+
+  return ea->order - eb->order;
+}
+
+/* Build the table of OBJFILE's FDEs that dwarf2_frame_find_fde
+   searches.  The FDEs added last come first in the list, and take
+   precedence.  */
+
+static void
+build_fde_table (struct objfile *objfile)
+{
+  struct dwarf2_fde_table *table;
+  struct dwarf2_fde *fde;
+  CORE_ADDR max_end = 0;
+  int i, n = 0;
+
+  for (fde = objfile_data (objfile, dwarf2_frame_objfile_data);
+       fde != NULL; fde = fde->next)
+    if (fde->address_range != 0)
+      n++;
+
+  table = obstack_alloc (&objfile->objfile_obstack, sizeof (*table));
+  table->num_entries = 0;
+  table->entries = obstack_alloc (&objfile->objfile_obstack,
+				  n * sizeof (table->entries[0]));
+
+  for (fde = objfile_data (objfile, dwarf2_frame_objfile_data);
+       fde != NULL; fde = fde->next)
+    if (fde->address_range != 0)
+      {
+	table->entries[table->num_entries].fde = fde;
+	table->entries[table->num_entries].order = table->num_entries;
+	table->num_entries++;
+      }
+
+  qsort (table->entries, table->num_entries, sizeof (table->entries[0]),
+	 compare_fde_table_entries);
+
+  for (i = 0; i < table->num_entries; i++)
+    {
+      fde = table->entries[i].fde;
+      if (fde->initial_location + fde->address_range > max_end)
+	max_end = fde->initial_location + fde->address_range;
+      table->entries[i].max_end = max_end;
+    }
+
+  set_objfile_data (objfile, dwarf2_frame_table_data, table);
+}
+
 #ifdef CC_HAS_LONG_LONG
 #define DW64_CIE_ID 0xffffffffffffffffULL
 #else
@@ -1794,6 +2253,7 @@ decode_frame_entry_1 (struct comp_unit *unit, gdb_byte *start, int eh_frame_p)
       fde->end = end;
 
       fde->eh_frame_p = eh_frame_p;
+      fde->rows = NULL;
 
       add_fde (unit, fde);
     }
@@ -1962,6 +2422,8 @@ dwarf2_build_frame_info (struct objfile *objfile)
       while (frame_ptr < unit->dwarf_frame_buffer + unit->dwarf_frame_size)
 	frame_ptr = decode_frame_entry (unit, frame_ptr, 0);
     }
+
+  build_fde_table (objfile);
 }
 
 /* Provide a prototype to silence -Wmissing-prototypes.  */
@@ -1972,4 +2434,7 @@ _initialize_dwarf2_frame (void)
 {
   dwarf2_frame_data = gdbarch_data_register_pre_init (dwarf2_frame_init);
   dwarf2_frame_objfile_data = register_objfile_data ();
+  dwarf2_frame_table_data = register_objfile_data ();
+
+  observer_attach_new_objfile (dwarf2_frame_plans_new_objfile);
 }
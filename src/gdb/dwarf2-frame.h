@@ -117,4 +117,9 @@ extern const struct frame_base *
 
 void dwarf2_frame_build_info (struct objfile *objfile);
 
+/* Forget the interpreted CFI kept across stops, e.g. when objfiles
+   are relocated or discarded.  */
+
+extern void dwarf2_frame_clear_plans (void);
+
 #endif /* dwarf2-frame.h */
@@ -377,21 +377,24 @@ dwarf2_tracepoint_var_ref (struct symbol *symbol, struct agent_expr *ax,
       && data[0] <= DW_OP_reg31)
     {
       value->kind = axs_lvalue_register;
-      value->u.reg = data[0] - DW_OP_reg0;
+      value->u.reg = gdbarch_dwarf2_reg_to_regnum (current_gdbarch,
+						   data[0] - DW_OP_reg0);
     }
   else if (data[0] == DW_OP_regx)
     {
       ULONGEST reg;
       read_uleb128 (data + 1, data + size, &reg);
       value->kind = axs_lvalue_register;
-      value->u.reg = reg;
+      value->u.reg = gdbarch_dwarf2_reg_to_regnum (current_gdbarch, reg);
     }
   else if (data[0] == DW_OP_fbreg)
     {
-      /* And this is worse than just minimal; we should honor the frame base
-	 as above.  */
-      int frame_reg;
-      LONGEST frame_offset;
+      /* We only understand frame bases which are a register plus an
+	 offset, as found at SCOPE.  */
+      struct symbol *framefunc;
+      gdb_byte *base_data = NULL;
+      size_t base_size = 0;
+      LONGEST frame_offset, base_offset;
       gdb_byte *buf_end;
 
       buf_end = read_sleb128 (data + 1, data + size, &frame_offset);
@@ -399,10 +402,36 @@ dwarf2_tracepoint_var_ref (struct symbol *symbol, struct agent_expr *ax,
 	error (_("Unexpected opcode after DW_OP_fbreg for symbol \"%s\"."),
 	       SYMBOL_PRINT_NAME (symbol));
 
-      gdbarch_virtual_frame_pointer (current_gdbarch, 
-				     ax->scope, &frame_reg, &frame_offset);
-      ax_reg (ax, frame_reg);
-      ax_const_l (ax, frame_offset);
+      framefunc = find_pc_function (ax->scope);
+      if (framefunc != NULL
+	  && SYMBOL_OPS (framefunc) == &dwarf2_loclist_funcs)
+	base_data = find_location_expression (SYMBOL_LOCATION_BATON (framefunc),
+					      &base_size, ax->scope);
+      else if (framefunc != NULL
+	       && SYMBOL_OPS (framefunc) == &dwarf2_locexpr_funcs)
+	{
+	  struct dwarf2_locexpr_baton *symbaton
+	    = SYMBOL_LOCATION_BATON (framefunc);
+
+	  if (symbaton != NULL)
+	    {
+	      base_data = symbaton->data;
+	      base_size = symbaton->size;
+	    }
+	}
+
+      if (base_data == NULL
+	  || base_size == 0
+	  || base_data[0] < DW_OP_breg0
+	  || base_data[0] > DW_OP_breg31
+	  || (read_sleb128 (base_data + 1, base_data + base_size, &base_offset)
+	      != base_data + base_size))
+	error (_("Unsupported frame base for symbol \"%s\"."),
+	       SYMBOL_PRINT_NAME (symbol));
+
+      ax_reg (ax, gdbarch_dwarf2_reg_to_regnum (current_gdbarch,
+						base_data[0] - DW_OP_breg0));
+      ax_const_l (ax, base_offset + frame_offset);
       ax_simple (ax, aop_add);
 
       value->kind = axs_lvalue_memory;
@@ -420,7 +449,7 @@ dwarf2_tracepoint_var_ref (struct symbol *symbol, struct agent_expr *ax,
 	error (_("Unexpected opcode after DW_OP_breg%u for symbol \"%s\"."),
 	       reg, SYMBOL_PRINT_NAME (symbol));
 
-      ax_reg (ax, reg);
+      ax_reg (ax, gdbarch_dwarf2_reg_to_regnum (current_gdbarch, reg));
       ax_const_l (ax, offset);
       ax_simple (ax, aop_add);
 
@@ -51,18 +51,22 @@
 #include "gdb_string.h"
 #include "gdb_assert.h"
 #include <sys/types.h>
+#include "gdb_stat.h"
 #ifdef HAVE_ZLIB_H
 #include <zlib.h>
 #endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 /* A note on memory usage for this file.
    
-   At the present time, this code reads the debug info sections into
-   the objfile's objfile_obstack.  A definite improvement for startup
-   time, on platforms which do not emit relocations for debug
-   sections, would be to use mmap instead.  The object's complete
-   debug information is loaded into memory, partly to simplify
-   absolute DIE references.
+   Where the host supports it, debug sections which need neither
+   relocating nor uncompressing are mapped read-only straight from the
+   object file; see dwarf2_map_section.  Everything else is read into
+   the objfile's objfile_obstack.  The object's complete debug
+   information is available in memory, partly to simplify absolute DIE
+   references.
 
    Whether using obstacks or mmap, the sections should remain loaded
    until the objfile is released, and pointers into the section data
@@ -774,6 +778,10 @@ static void psymtab_to_symtab_1 (struct partial_symtab *);
 
 gdb_byte *dwarf2_read_section (struct objfile *, asection *);
 
+static int dwarf2_mapped_file_changed_p (struct objfile *);
+
+static void dwarf2_release_mapped_pages (struct objfile *);
+
 static void dwarf2_read_abbrevs (bfd *abfd, struct dwarf2_cu *cu);
 
 static void dwarf2_free_abbrev_table (void *);
@@ -1273,6 +1281,11 @@ dwarf2_build_psymtabs (struct objfile *objfile, int mainline)
       /* In this case we have to work a bit harder */
       dwarf2_build_psymtabs_hard (objfile, mainline);
     }
+
+  /* Having scanned all of .debug_info, we will now only look at the
+     parts of it belonging to the compilation units which get expanded,
+     so let the rest go.  */
+  dwarf2_release_mapped_pages (objfile);
 }
 
 #if 0
@@ -2414,6 +2427,14 @@ dwarf2_psymtab_to_symtab (struct partial_symtab *pst)
 	      gdb_flush (gdb_stdout);
 	    }
 
+	  /* What is mapped of the file now shows its new contents, not
+	     the ones the partial symbols were read from.  */
+	  if (dwarf2_mapped_file_changed_p (pst->objfile))
+	    error (_("\
+\"%s\" has changed since its symbols were read; they will be read\n\
+again when the program is next run."),
+		   pst->objfile->name);
+
 	  /* Restore our global data.  */
 	  dwarf2_per_objfile = objfile_data (pst->objfile,
 					     dwarf2_objfile_data_key);
@@ -5298,9 +5319,159 @@ zlib_decompress_section (struct objfile *objfile, asection *sectp,
 }
 
 
+/* A debug section mapped from its object file by dwarf2_map_section.
+   The mappings of an objfile are chained together, and released when
+   the objfile's symbols are.  */
+
+struct dwarf2_section_mapping
+{
+  struct dwarf2_section_mapping *next;
+
+  /* The page-aligned start and the length of the mapping.  */
+  void *addr;
+  size_t len;
+
+  /* The identity of the file mapped, when it was mapped.  */
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  time_t mtime;
+};
+
+static const struct objfile_data *dwarf2_mapping_data_key;
+
+static void
+dwarf2_free_mappings (struct objfile *objfile, void *arg)
+{
+#ifdef HAVE_MMAP
+  struct dwarf2_section_mapping *map, *next;
+
+  for (map = arg; map != NULL; map = next)
+    {
+      next = map->next;
+      munmap (map->addr, map->len);
+      xfree (map);
+    }
+#endif
+}
+
+/* Try to map the contents of SECTP, which must not need relocating,
+   read-only from OBJFILE's file.  Return a pointer to the section's
+   first byte, or NULL if the section could not be mapped, in which
+   case the caller should read it in instead.
+
+   The file is opened again by name, so it is only mapped if it is
+   the very file the BFD has open, unchanged since OBJFILE's symbols
+   were read; a file rebuilt meanwhile would not have the section at
+   the offset the BFD found it at.  */
+
+static gdb_byte *
+dwarf2_map_section (struct objfile *objfile, asection *sectp)
+{
+#ifdef HAVE_MMAP
+  bfd *abfd = objfile->obfd;
+  struct dwarf2_section_mapping *map;
+  bfd_size_type size = bfd_get_section_size (sectp);
+  file_ptr pagesize = getpagesize ();
+  file_ptr offset, start;
+  void *addr;
+  int fd;
+  struct stat bfd_st, st;
+
+  /* Archive members and BFDs built in memory (such as the vsyscall
+     DSO) do not correspond to a file we can map.  */
+  if (abfd->my_archive != NULL || (abfd->flags & BFD_IN_MEMORY) != 0)
+    return NULL;
+
+  offset = sectp->filepos;
+  start = offset & ~(pagesize - 1);
+
+  if (bfd_stat (abfd, &bfd_st) != 0 || bfd_st.st_mtime != objfile->mtime)
+    return NULL;
+
+  fd = open (bfd_get_filename (abfd), O_RDONLY | O_BINARY);
+  if (fd < 0)
+    return NULL;
+  if (fstat (fd, &st) != 0
+      || st.st_dev != bfd_st.st_dev || st.st_ino != bfd_st.st_ino
+      || st.st_size != bfd_st.st_size || st.st_mtime != bfd_st.st_mtime
+      || offset + size > st.st_size)
+    {
+      close (fd);
+      return NULL;
+    }
+  addr = mmap (NULL, size + (offset - start), PROT_READ, MAP_PRIVATE,
+	       fd, start);
+  close (fd);
+  if (addr == MAP_FAILED)
+    return NULL;
+
+  map = XMALLOC (struct dwarf2_section_mapping);
+  map->addr = addr;
+  map->len = size + (offset - start);
+  map->dev = st.st_dev;
+  map->ino = st.st_ino;
+  map->size = st.st_size;
+  map->mtime = st.st_mtime;
+  map->next = objfile_data (objfile, dwarf2_mapping_data_key);
+  set_objfile_data (objfile, dwarf2_mapping_data_key, map);
+
+  return (gdb_byte *) addr + (offset - start);
+#else
+  return NULL;
+#endif
+}
+
+/* Return non-zero if OBJFILE has debug sections mapped from its file,
+   and the file has changed since.  The pages of a mapping follow the
+   file as it is rewritten, and fault once it is truncated.  */
+
+static int
+dwarf2_mapped_file_changed_p (struct objfile *objfile)
+{
+#ifdef HAVE_MMAP
+  struct dwarf2_section_mapping *map;
+  struct stat st;
+
+  map = objfile_data (objfile, dwarf2_mapping_data_key);
+  if (map == NULL)
+    return 0;
+
+  return (stat (bfd_get_filename (objfile->obfd), &st) != 0
+	  || st.st_dev != map->dev || st.st_ino != map->ino
+	  || st.st_size != map->size || st.st_mtime != map->mtime);
+#else
+  return 0;
+#endif
+}
+
+/* Tell the host that the pages of OBJFILE's mapped debug sections will
+   not be needed for a while.  They stay mapped, and are read back in
+   from the file when next used, but they no longer count against
+   GDB's resident memory in the meantime.  Nothing is dropped once the
+   file has changed.  */
+
+static void
+dwarf2_release_mapped_pages (struct objfile *objfile)
+{
+#if defined (HAVE_MMAP) && defined (MADV_DONTNEED)
+  struct dwarf2_section_mapping *map;
+
+  if (dwarf2_mapped_file_changed_p (objfile))
+    return;
+
+  for (map = objfile_data (objfile, dwarf2_mapping_data_key);
+       map != NULL;
+       map = map->next)
+    madvise (map->addr, map->len, MADV_DONTNEED);
+#endif
+}
+
 /* Read the contents of the section at OFFSET and of size SIZE from the
    object file specified by OBJFILE into the objfile_obstack and return it.
-   If the section is compressed, uncompress it before returning.  */
+   If the section is compressed, uncompress it before returning.  If it
+   needs neither uncompressing nor relocating, it may instead be mapped
+   from the file.  */
 
 gdb_byte *
 dwarf2_read_section (struct objfile *objfile, asection *sectp)
@@ -5327,7 +5498,15 @@ dwarf2_read_section (struct objfile *objfile, asection *sectp)
         }
     }
 
-  /* If we get here, we are a normal, not-compressed section.  */
+  /* If we get here, we are a normal, not-compressed section.  Unless
+     it needs relocating, try to avoid copying it.  */
+  if ((sectp->flags & SEC_RELOC) == 0)
+    {
+      buf = dwarf2_map_section (objfile, sectp);
+      if (buf != NULL)
+	return buf;
+    }
+
   buf = obstack_alloc (&objfile->objfile_obstack, size);
   /* When debugging .o files, we may need to apply relocations; see
      http://sourceware.org/ml/gdb-patches/2002-04/msg00136.html .
@@ -10443,6 +10622,8 @@ void
 _initialize_dwarf2_read (void)
 {
   dwarf2_objfile_data_key = register_objfile_data ();
+  dwarf2_mapping_data_key
+    = register_objfile_data_with_cleanup (dwarf2_free_mappings);
 
   add_prefix_cmd ("dwarf2", class_maintenance, set_dwarf2_cmd, _("\
 Set DWARF 2 specific variables.\n\
@@ -382,6 +382,7 @@ build_section_table (struct bfd *some_bfd, struct section_table **start,
   bfd_map_over_sections (some_bfd, add_to_section_table, (char *) end);
   if (*end > *start + count)
     internal_error (__FILE__, __LINE__, _("failed internal consistency check"));
+  target_sections_changed ();
   /* We could realloc the table, but it probably loses for most files.  */
   return 0;
 }
@@ -441,6 +442,131 @@ map_vmap (bfd *abfd, bfd *arch)
   return vp;
 }
 
+/* Section tables sorted by address, so that xfer_memory can find the
+   section containing an address by binary search.  A core file has a
+   section for each thread's stack, so a linear search made every
+   memory access in a core with thousands of threads that much
+   slower.  */
+
+struct section_index
+{
+  /* The section table this indexes.  */
+  struct section_table *start, *end;
+
+  /* The value of section_table_generation when this was built.  */
+  unsigned int generation;
+
+  /* The sections of the table in order of address, or NULL if some
+     of them overlap, in which case the table is searched linearly,
+     so that the first of the overlapping sections wins.  */
+  struct section_table **sorted;
+
+  struct section_index *next;
+};
+
+static struct section_index *section_indexes;
+
+/* Incremented by target_sections_changed.  */
+
+static unsigned int section_table_generation;
+
+/* Note that a section table was built, resized, or its addresses
+   changed.  */
+
+void
+target_sections_changed (void)
+{
+  section_table_generation++;
+}
+
+static int
+compare_sections_by_addr (const void *a, const void *b)
+{
+  const struct section_table *sa = *(const struct section_table **) a;
+  const struct section_table *sb = *(const struct section_table **) b;
+
+  if (sa->addr != sb->addr)
+    return sa->addr < sb->addr ? -1 : 1;
+  if (sa->endaddr != sb->endaddr)
+    return sa->endaddr < sb->endaddr ? -1 : 1;
+  return 0;
+}
+
+/* Return the sorted index of TARGET's section table, building it if
+   needed, or NULL if the table must be searched linearly.  */
+
+static struct section_index *
+get_sorted_sections (struct target_ops *target)
+{
+  struct section_index *index, **prev;
+  int i, count = target->to_sections_end - target->to_sections;
+
+  prev = &section_indexes;
+  while ((index = *prev) != NULL)
+    {
+      if (index->generation != section_table_generation)
+	{
+	  /* Stale; the table may have been freed.  */
+	  *prev = index->next;
+	  xfree (index->sorted);
+	  xfree (index);
+	  continue;
+	}
+      if (index->start == target->to_sections
+	  && index->end == target->to_sections_end)
+	return index->sorted != NULL ? index : NULL;
+      prev = &index->next;
+    }
+
+  index = XZALLOC (struct section_index);
+  index->start = target->to_sections;
+  index->end = target->to_sections_end;
+  index->generation = section_table_generation;
+  index->next = section_indexes;
+  section_indexes = index;
+
+  if (count == 0)
+    return NULL;
+
+  index->sorted = xmalloc (count * sizeof (struct section_table *));
+  for (i = 0; i < count; i++)
+    index->sorted[i] = &target->to_sections[i];
+  qsort (index->sorted, count, sizeof (struct section_table *),
+	 compare_sections_by_addr);
+
+  for (i = 1; i < count; i++)
+    if (index->sorted[i]->addr < index->sorted[i - 1]->endaddr)
+      {
+	xfree (index->sorted);
+	index->sorted = NULL;
+	return NULL;
+      }
+
+  return index;
+}
+
+/* Transfer LEN bytes at MEMADDR to or from section P, as
+   xfer_memory.  */
+
+static int
+xfer_section_memory (struct section_table *p, CORE_ADDR memaddr,
+		     gdb_byte *myaddr, int len, int write)
+{
+  int res;
+
+  /* If the transfer runs past the section's end, just do part.  */
+  if (memaddr + len > p->endaddr)
+    len = p->endaddr - memaddr;
+
+  if (write)
+    res = bfd_set_section_contents (p->bfd, p->the_bfd_section,
+				    myaddr, memaddr - p->addr, len);
+  else
+    res = bfd_get_section_contents (p->bfd, p->the_bfd_section,
+				    myaddr, memaddr - p->addr, len);
+  return (res != 0) ? len : 0;
+}
+
 /* Read or write the exec file.
 
    Args are address within a BFD file, address within gdb address-space,
@@ -481,6 +607,38 @@ xfer_memory (CORE_ADDR memaddr, gdb_byte *myaddr, int len, int write,
   memend = memaddr + len;
   nextsectaddr = memend;
 
+  if (!overlay_debugging)
+    {
+      struct section_index *index = get_sorted_sections (target);
+
+      if (index != NULL)
+	{
+	  int lo = 0, hi = index->end - index->start;
+
+	  /* Find the first section starting above MEMADDR; the one
+	     before it is the only one which may contain MEMADDR.  */
+	  while (lo < hi)
+	    {
+	      int mid = lo + (hi - lo) / 2;
+
+	      if (index->sorted[mid]->addr <= memaddr)
+		lo = mid + 1;
+	      else
+		hi = mid;
+	    }
+
+	  if (lo > 0 && memaddr < index->sorted[lo - 1]->endaddr)
+	    return xfer_section_memory (index->sorted[lo - 1], memaddr,
+					myaddr, len, write);
+
+	  if (lo < index->end - index->start)
+	    nextsectaddr = min (nextsectaddr, index->sorted[lo]->addr);
+	  if (nextsectaddr >= memend)
+	    return 0;
+	  return -(nextsectaddr - memaddr);
+	}
+    }
+
   for (p = target->to_sections; p < target->to_sections_end; p++)
     {
       if (overlay_debugging && section && 
@@ -624,6 +782,7 @@ set_section_command (char *args, int from_tty)
 	  offset = secaddr - p->addr;
 	  p->addr += offset;
 	  p->endaddr += offset;
+	  target_sections_changed ();
 	  if (from_tty)
 	    exec_files_info (&exec_ops);
 	  return;
@@ -651,6 +810,7 @@ exec_set_section_address (const char *filename, int index, CORE_ADDR address)
 	{
 	  p->endaddr += address - p->addr;
 	  p->addr = address;
+	  target_sections_changed ();
 	}
     }
 }
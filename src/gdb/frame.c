@@ -1365,6 +1365,23 @@ frame_debug_got_null_frame (struct ui_file *file,
     }
 }
 
+/* The minimal symbol for "main" in SYMFILE_OBJFILE, as last looked up
+   by inside_main_func, which is asked about every frame unwound.
+   MAIN_MSYMBOL_OBJFILE and MAIN_MSYMBOL_NAME record what it was
+   looked up for; MAIN_MSYMBOL_OBJFILE is NULL if nothing is cached.
+   The address is read from the symbol each time, so that relocating
+   the objfile needs no special care.  */
+
+static struct objfile *main_msymbol_objfile;
+static char *main_msymbol_name;
+static struct minimal_symbol *main_msymbol;
+
+static void
+frame_observer_new_objfile (struct objfile *objfile)
+{
+  main_msymbol_objfile = NULL;
+}
+
 /* Is this (non-sentinel) frame in the "main"() function?  */
 
 static int
@@ -1375,7 +1392,15 @@ inside_main_func (struct frame_info *this_frame)
 
   if (symfile_objfile == 0)
     return 0;
-  msymbol = lookup_minimal_symbol (main_name (), NULL, symfile_objfile);
+  if (main_msymbol_objfile != symfile_objfile
+      || main_msymbol_name != main_name ())
+    {
+      main_msymbol = lookup_minimal_symbol (main_name (), NULL,
+					    symfile_objfile);
+      main_msymbol_objfile = symfile_objfile;
+      main_msymbol_name = main_name ();
+    }
+  msymbol = main_msymbol;
   if (msymbol == NULL)
     return 0;
   /* Make certain that the code, and not descriptor, address is
@@ -1887,6 +1912,7 @@ _initialize_frame (void)
   obstack_init (&frame_cache_obstack);
 
   observer_attach_target_changed (frame_observer_target_changed);
+  observer_attach_new_objfile (frame_observer_new_objfile);
 
   add_prefix_cmd ("backtrace", class_maintenance, set_backtrace_cmd, _("\
 Set backtrace specific variables.\n\
@@ -189,6 +189,8 @@ struct gdbarch
   gdbarch_adjust_breakpoint_address_ftype *adjust_breakpoint_address;
   gdbarch_memory_insert_breakpoint_ftype *memory_insert_breakpoint;
   gdbarch_memory_remove_breakpoint_ftype *memory_remove_breakpoint;
+  gdbarch_memory_insert_breakpoints_ftype *memory_insert_breakpoints;
+  gdbarch_memory_remove_breakpoints_ftype *memory_remove_breakpoints;
   CORE_ADDR decr_pc_after_break;
   CORE_ADDR deprecated_function_start_offset;
   gdbarch_remote_register_number_ftype *remote_register_number;
@@ -229,6 +231,7 @@ struct gdbarch
   gdbarch_skip_permanent_breakpoint_ftype *skip_permanent_breakpoint;
   ULONGEST max_insn_length;
   gdbarch_displaced_step_copy_insn_ftype *displaced_step_copy_insn;
+  gdbarch_displaced_step_hw_singlestep_ftype *displaced_step_hw_singlestep;
   gdbarch_displaced_step_fixup_ftype *displaced_step_fixup;
   gdbarch_displaced_step_free_closure_ftype *displaced_step_free_closure;
   gdbarch_displaced_step_location_ftype *displaced_step_location;
@@ -320,6 +323,8 @@ struct gdbarch startup_gdbarch =
   0,  /* adjust_breakpoint_address */
   default_memory_insert_breakpoint,  /* memory_insert_breakpoint */
   default_memory_remove_breakpoint,  /* memory_remove_breakpoint */
+  default_memory_insert_breakpoints,  /* memory_insert_breakpoints */
+  default_memory_remove_breakpoints,  /* memory_remove_breakpoints */
   0,  /* decr_pc_after_break */
   0,  /* deprecated_function_start_offset */
   default_remote_register_number,  /* remote_register_number */
@@ -360,6 +365,7 @@ struct gdbarch startup_gdbarch =
   0,  /* skip_permanent_breakpoint */
   0,  /* max_insn_length */
   0,  /* displaced_step_copy_insn */
+  default_displaced_step_hw_singlestep,  /* displaced_step_hw_singlestep */
   0,  /* displaced_step_fixup */
   NULL,  /* displaced_step_free_closure */
   NULL,  /* displaced_step_location */
@@ -434,6 +440,8 @@ gdbarch_alloc (const struct gdbarch_info *info,
   gdbarch->address_to_pointer = unsigned_address_to_pointer;
   gdbarch->memory_insert_breakpoint = default_memory_insert_breakpoint;
   gdbarch->memory_remove_breakpoint = default_memory_remove_breakpoint;
+  gdbarch->memory_insert_breakpoints = default_memory_insert_breakpoints;
+  gdbarch->memory_remove_breakpoints = default_memory_remove_breakpoints;
   gdbarch->remote_register_number = default_remote_register_number;
   gdbarch->stabs_argument_has_addr = default_stabs_argument_has_addr;
   gdbarch->convert_from_func_ptr_addr = convert_from_func_ptr_addr_identity;
@@ -448,6 +456,7 @@ gdbarch_alloc (const struct gdbarch_info *info,
   gdbarch->coff_make_msymbol_special = default_coff_make_msymbol_special;
   gdbarch->name_of_malloc = "malloc";
   gdbarch->register_reggroup_p = default_register_reggroup_p;
+  gdbarch->displaced_step_hw_singlestep = default_displaced_step_hw_singlestep;
   gdbarch->displaced_step_fixup = NULL;
   gdbarch->displaced_step_free_closure = NULL;
   gdbarch->displaced_step_location = NULL;
@@ -571,6 +580,8 @@ verify_gdbarch (struct gdbarch *gdbarch)
   /* Skip verify of adjust_breakpoint_address, has predicate */
   /* Skip verify of memory_insert_breakpoint, invalid_p == 0 */
   /* Skip verify of memory_remove_breakpoint, invalid_p == 0 */
+  /* Skip verify of memory_insert_breakpoints, invalid_p == 0 */
+  /* Skip verify of memory_remove_breakpoints, invalid_p == 0 */
   /* Skip verify of decr_pc_after_break, invalid_p == 0 */
   /* Skip verify of deprecated_function_start_offset, invalid_p == 0 */
   /* Skip verify of remote_register_number, invalid_p == 0 */
@@ -610,6 +621,7 @@ verify_gdbarch (struct gdbarch *gdbarch)
   /* Skip verify of skip_permanent_breakpoint, has predicate */
   /* Skip verify of max_insn_length, has predicate */
   /* Skip verify of displaced_step_copy_insn, has predicate */
+  /* Skip verify of displaced_step_hw_singlestep, invalid_p == 0 */
   /* Skip verify of displaced_step_fixup, has predicate */
   if ((! gdbarch->displaced_step_free_closure) != (! gdbarch->displaced_step_copy_insn))
     fprintf_unfiltered (log, "\n\tdisplaced_step_free_closure");
@@ -758,6 +770,9 @@ gdbarch_dump (struct gdbarch *gdbarch, struct ui_file *file)
   fprintf_unfiltered (file,
                       "gdbarch_dump: displaced_step_free_closure = <0x%lx>\n",
                       (long) gdbarch->displaced_step_free_closure);
+  fprintf_unfiltered (file,
+                      "gdbarch_dump: displaced_step_hw_singlestep = <0x%lx>\n",
+                      (long) gdbarch->displaced_step_hw_singlestep);
   fprintf_unfiltered (file,
                       "gdbarch_dump: displaced_step_location = <0x%lx>\n",
                       (long) gdbarch->displaced_step_location);
@@ -869,9 +884,15 @@ gdbarch_dump (struct gdbarch *gdbarch, struct ui_file *file)
   fprintf_unfiltered (file,
                       "gdbarch_dump: memory_insert_breakpoint = <0x%lx>\n",
                       (long) gdbarch->memory_insert_breakpoint);
+  fprintf_unfiltered (file,
+                      "gdbarch_dump: memory_insert_breakpoints = <0x%lx>\n",
+                      (long) gdbarch->memory_insert_breakpoints);
   fprintf_unfiltered (file,
                       "gdbarch_dump: memory_remove_breakpoint = <0x%lx>\n",
                       (long) gdbarch->memory_remove_breakpoint);
+  fprintf_unfiltered (file,
+                      "gdbarch_dump: memory_remove_breakpoints = <0x%lx>\n",
+                      (long) gdbarch->memory_remove_breakpoints);
   fprintf_unfiltered (file,
                       "gdbarch_dump: name_of_malloc = %s\n",
                       gdbarch->name_of_malloc);
@@ -2247,6 +2268,40 @@ set_gdbarch_memory_remove_breakpoint (struct gdbarch *gdbarch,
   gdbarch->memory_remove_breakpoint = memory_remove_breakpoint;
 }
 
+void
+gdbarch_memory_insert_breakpoints (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results)
+{
+  gdb_assert (gdbarch != NULL);
+  gdb_assert (gdbarch->memory_insert_breakpoints != NULL);
+  if (gdbarch_debug >= 2)
+    fprintf_unfiltered (gdb_stdlog, "gdbarch_memory_insert_breakpoints called\n");
+  gdbarch->memory_insert_breakpoints (gdbarch, bp_tgts, count, results);
+}
+
+void
+set_gdbarch_memory_insert_breakpoints (struct gdbarch *gdbarch,
+                                       gdbarch_memory_insert_breakpoints_ftype memory_insert_breakpoints)
+{
+  gdbarch->memory_insert_breakpoints = memory_insert_breakpoints;
+}
+
+void
+gdbarch_memory_remove_breakpoints (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results)
+{
+  gdb_assert (gdbarch != NULL);
+  gdb_assert (gdbarch->memory_remove_breakpoints != NULL);
+  if (gdbarch_debug >= 2)
+    fprintf_unfiltered (gdb_stdlog, "gdbarch_memory_remove_breakpoints called\n");
+  gdbarch->memory_remove_breakpoints (gdbarch, bp_tgts, count, results);
+}
+
+void
+set_gdbarch_memory_remove_breakpoints (struct gdbarch *gdbarch,
+                                       gdbarch_memory_remove_breakpoints_ftype memory_remove_breakpoints)
+{
+  gdbarch->memory_remove_breakpoints = memory_remove_breakpoints;
+}
+
 CORE_ADDR
 gdbarch_decr_pc_after_break (struct gdbarch *gdbarch)
 {
@@ -3038,6 +3093,23 @@ set_gdbarch_displaced_step_copy_insn (struct gdbarch *gdbarch,
   gdbarch->displaced_step_copy_insn = displaced_step_copy_insn;
 }
 
+int
+gdbarch_displaced_step_hw_singlestep (struct gdbarch *gdbarch, struct displaced_step_closure *closure)
+{
+  gdb_assert (gdbarch != NULL);
+  gdb_assert (gdbarch->displaced_step_hw_singlestep != NULL);
+  if (gdbarch_debug >= 2)
+    fprintf_unfiltered (gdb_stdlog, "gdbarch_displaced_step_hw_singlestep called\n");
+  return gdbarch->displaced_step_hw_singlestep (gdbarch, closure);
+}
+
+void
+set_gdbarch_displaced_step_hw_singlestep (struct gdbarch *gdbarch,
+                                          gdbarch_displaced_step_hw_singlestep_ftype displaced_step_hw_singlestep)
+{
+  gdbarch->displaced_step_hw_singlestep = displaced_step_hw_singlestep;
+}
+
 int
 gdbarch_displaced_step_fixup_p (struct gdbarch *gdbarch)
 {
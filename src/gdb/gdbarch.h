@@ -407,6 +407,22 @@ typedef int (gdbarch_memory_remove_breakpoint_ftype) (struct gdbarch *gdbarch, s
 extern int gdbarch_memory_remove_breakpoint (struct gdbarch *gdbarch, struct bp_target_info *bp_tgt);
 extern void set_gdbarch_memory_remove_breakpoint (struct gdbarch *gdbarch, gdbarch_memory_remove_breakpoint_ftype *memory_remove_breakpoint);
 
+/* Insert or remove COUNT software breakpoints at once, and store what
+   memory_insert_breakpoint or memory_remove_breakpoint would have
+   returned for each of them in RESULTS.  The default reads and writes
+   the breakpoints on each page of memory together, the way the default
+   memory_insert_breakpoint and memory_remove_breakpoint would; an
+   architecture which replaces those should use the simple_ versions,
+   which just call them once per breakpoint. */
+
+typedef void (gdbarch_memory_insert_breakpoints_ftype) (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results);
+extern void gdbarch_memory_insert_breakpoints (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results);
+extern void set_gdbarch_memory_insert_breakpoints (struct gdbarch *gdbarch, gdbarch_memory_insert_breakpoints_ftype *memory_insert_breakpoints);
+
+typedef void (gdbarch_memory_remove_breakpoints_ftype) (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results);
+extern void gdbarch_memory_remove_breakpoints (struct gdbarch *gdbarch, struct bp_target_info **bp_tgts, int count, int *results);
+extern void set_gdbarch_memory_remove_breakpoints (struct gdbarch *gdbarch, gdbarch_memory_remove_breakpoints_ftype *memory_remove_breakpoints);
+
 extern CORE_ADDR gdbarch_decr_pc_after_break (struct gdbarch *gdbarch);
 extern void set_gdbarch_decr_pc_after_break (struct gdbarch *gdbarch, CORE_ADDR decr_pc_after_break);
 
@@ -688,8 +704,8 @@ extern void set_gdbarch_max_insn_length (struct gdbarch *gdbarch, ULONGEST max_i
   
    Return a pointer to data of the architecture's choice to be passed
    to gdbarch_displaced_step_fixup.  Or, return NULL to indicate that
-   the instruction's effects have been completely simulated, with the
-   resulting state written back to REGS.
+   the instruction at FROM can't be displaced; GDB then steps over the
+   breakpoint there in place, with the breakpoints removed.
   
    For a general explanation of displaced stepping and how GDB uses it,
    see the comments in infrun.c.
@@ -711,6 +727,18 @@ typedef struct displaced_step_closure * (gdbarch_displaced_step_copy_insn_ftype)
 extern struct displaced_step_closure * gdbarch_displaced_step_copy_insn (struct gdbarch *gdbarch, CORE_ADDR from, CORE_ADDR to, struct regcache *regs);
 extern void set_gdbarch_displaced_step_copy_insn (struct gdbarch *gdbarch, gdbarch_displaced_step_copy_insn_ftype *displaced_step_copy_insn);
 
+/* Return non-zero if GDB should single-step the thread, using the
+   hardware or the target's single-step support, to execute the
+   instruction copied by gdbarch_displaced_step_copy_insn.  Return zero
+   if the copy already ends in a breakpoint instruction, so that GDB
+   need only resume the thread at the copy to regain control after it.
+  
+   CLOSURE is the result from gdbarch_displaced_step_copy_insn. */
+
+typedef int (gdbarch_displaced_step_hw_singlestep_ftype) (struct gdbarch *gdbarch, struct displaced_step_closure *closure);
+extern int gdbarch_displaced_step_hw_singlestep (struct gdbarch *gdbarch, struct displaced_step_closure *closure);
+extern void set_gdbarch_displaced_step_hw_singlestep (struct gdbarch *gdbarch, gdbarch_displaced_step_hw_singlestep_ftype *displaced_step_hw_singlestep);
+
 /* Fix up the state resulting from successfully single-stepping a
    displaced instruction, to give the result we would have gotten from
    stepping the instruction in its original location.
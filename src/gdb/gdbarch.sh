@@ -488,6 +488,15 @@ m:const gdb_byte *:breakpoint_from_pc:CORE_ADDR *pcptr, int *lenptr:pcptr, lenpt
 M:CORE_ADDR:adjust_breakpoint_address:CORE_ADDR bpaddr:bpaddr
 m:int:memory_insert_breakpoint:struct bp_target_info *bp_tgt:bp_tgt:0:default_memory_insert_breakpoint::0
 m:int:memory_remove_breakpoint:struct bp_target_info *bp_tgt:bp_tgt:0:default_memory_remove_breakpoint::0
+# Insert or remove COUNT software breakpoints at once, and store what
+# memory_insert_breakpoint or memory_remove_breakpoint would have
+# returned for each of them in RESULTS.  The default reads and writes
+# the breakpoints on each page of memory together, the way the default
+# memory_insert_breakpoint and memory_remove_breakpoint would; an
+# architecture which replaces those should use the simple_ versions,
+# which just call them once per breakpoint.
+m:void:memory_insert_breakpoints:struct bp_target_info **bp_tgts, int count, int *results:bp_tgts, count, results:0:default_memory_insert_breakpoints::0
+m:void:memory_remove_breakpoints:struct bp_target_info **bp_tgts, int count, int *results:bp_tgts, count, results:0:default_memory_remove_breakpoints::0
 v:CORE_ADDR:decr_pc_after_break:::0:::0
 
 # A function can be addressed by either it's "pointer" (possibly a
@@ -631,8 +640,8 @@ V:ULONGEST:max_insn_length:::0:0
 #
 # Return a pointer to data of the architecture's choice to be passed
 # to gdbarch_displaced_step_fixup.  Or, return NULL to indicate that
-# the instruction's effects have been completely simulated, with the
-# resulting state written back to REGS.
+# the instruction at FROM can't be displaced; GDB then steps over the
+# breakpoint there in place, with the breakpoints removed.
 #
 # For a general explanation of displaced stepping and how GDB uses it,
 # see the comments in infrun.c.
@@ -649,6 +658,15 @@ V:ULONGEST:max_insn_length:::0:0
 # here.
 M:struct displaced_step_closure *:displaced_step_copy_insn:CORE_ADDR from, CORE_ADDR to, struct regcache *regs:from, to, regs
 
+# Return non-zero if GDB should single-step the thread, using the
+# hardware or the target's single-step support, to execute the
+# instruction copied by gdbarch_displaced_step_copy_insn.  Return zero
+# if the copy already ends in a breakpoint instruction, so that GDB
+# need only resume the thread at the copy to regain control after it.
+#
+# CLOSURE is the result from gdbarch_displaced_step_copy_insn.
+m:int:displaced_step_hw_singlestep:struct displaced_step_closure *closure:closure::default_displaced_step_hw_singlestep::0
+
 # Fix up the state resulting from successfully single-stepping a
 # displaced instruction, to give the result we would have gotten from
 # stepping the instruction in its original location.
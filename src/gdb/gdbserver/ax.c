@@ -0,0 +1,1294 @@
+/* Agent expression evaluation for the remote server for GDB.
+   Copyright (C) 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "server.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/* The bytecodes we understand.  These must match the numbering in
+   GDB's ax.h.  */
+
+enum agent_op
+  {
+    aop_float = 0x01,
+    aop_add = 0x02,
+    aop_sub = 0x03,
+    aop_mul = 0x04,
+    aop_div_signed = 0x05,
+    aop_div_unsigned = 0x06,
+    aop_rem_signed = 0x07,
+    aop_rem_unsigned = 0x08,
+    aop_lsh = 0x09,
+    aop_rsh_signed = 0x0a,
+    aop_rsh_unsigned = 0x0b,
+    aop_trace = 0x0c,
+    aop_trace_quick = 0x0d,
+    aop_log_not = 0x0e,
+    aop_bit_and = 0x0f,
+    aop_bit_or = 0x10,
+    aop_bit_xor = 0x11,
+    aop_bit_not = 0x12,
+    aop_equal = 0x13,
+    aop_less_signed = 0x14,
+    aop_less_unsigned = 0x15,
+    aop_ext = 0x16,
+    aop_ref8 = 0x17,
+    aop_ref16 = 0x18,
+    aop_ref32 = 0x19,
+    aop_ref64 = 0x1a,
+    aop_ref_float = 0x1b,
+    aop_ref_double = 0x1c,
+    aop_ref_long_double = 0x1d,
+    aop_l_to_d = 0x1e,
+    aop_d_to_l = 0x1f,
+    aop_if_goto = 0x20,
+    aop_goto = 0x21,
+    aop_const8 = 0x22,
+    aop_const16 = 0x23,
+    aop_const32 = 0x24,
+    aop_const64 = 0x25,
+    aop_reg = 0x26,
+    aop_end = 0x27,
+    aop_dup = 0x28,
+    aop_pop = 0x29,
+    aop_zero_ext = 0x2a,
+    aop_swap = 0x2b,
+    aop_trace16 = 0x30
+  };
+
+/* The maximum depth of the evaluation stack.  GDB refuses to send
+   anything deeper than this would allow.  */
+
+#define AX_STACK_MAX 100
+
+/* The most negative LONGEST.  Dividing it by -1 overflows.  */
+
+#define AX_LONGEST_MIN \
+  ((LONGEST) ((ULONGEST) 1 << (sizeof (LONGEST) * 8 - 1)))
+
+/* Non-zero if A / B or A % B overflows.  */
+
+#define AX_DIVIDE_OVERFLOWS(a, b) ((a) == AX_LONGEST_MIN && (b) == -1)
+
+/* Non-zero if COUNT is too big, or negative, to shift a LONGEST by.  */
+
+#define AX_BAD_SHIFT(count) \
+  ((ULONGEST) (count) >= sizeof (LONGEST) * 8)
+
+static ULONGEST ax_operand (struct agent_expr *aexpr, int pc, int len);
+
+static int
+ax_fromhex (int a)
+{
+  if (a >= '0' && a <= '9')
+    return a - '0';
+  else if (a >= 'a' && a <= 'f')
+    return a - 'a' + 10;
+  else if (a >= 'A' && a <= 'F')
+    return a - 'A' + 10;
+  return -1;
+}
+
+/* Return the number of operand bytes following opcode OP, or -1 if
+   OP is not a bytecode we know.  */
+
+static int
+ax_operand_length (int op)
+{
+  switch (op)
+    {
+    case aop_ext:
+    case aop_zero_ext:
+    case aop_trace_quick:
+    case aop_const8:
+      return 1;
+
+    case aop_trace16:
+    case aop_if_goto:
+    case aop_goto:
+    case aop_const16:
+    case aop_reg:
+      return 2;
+
+    case aop_const32:
+      return 4;
+
+    case aop_const64:
+      return 8;
+
+    default:
+      if (op >= aop_float && op <= aop_swap)
+	return 0;
+      return -1;
+    }
+}
+
+/* Check AEXPR once, when GDB sends it, so that evaluating it at
+   every hit only has to worry about the values it computes.  Returns
+   non-zero if every opcode is known, has all its operand bytes, and
+   every jump lands on an opcode.  */
+
+static int
+validate_agent_expr (struct agent_expr *aexpr)
+{
+  char *is_insn = calloc (aexpr->length, 1);
+  int pc, len, valid = 1;
+
+  for (pc = 0; pc < aexpr->length; pc += len + 1)
+    {
+      len = ax_operand_length (aexpr->bytes[pc]);
+      if (len < 0 || pc + 1 + len > aexpr->length)
+	{
+	  free (is_insn);
+	  return 0;
+	}
+      is_insn[pc] = 1;
+    }
+
+  for (pc = 0; pc < aexpr->length; pc += len + 1)
+    {
+      int op = aexpr->bytes[pc];
+
+      len = ax_operand_length (op);
+      if (op == aop_if_goto || op == aop_goto)
+	{
+	  ULONGEST target = ax_operand (aexpr, pc + 1, 2);
+
+	  if (target >= aexpr->length || !is_insn[target])
+	    {
+	      valid = 0;
+	      break;
+	    }
+	}
+    }
+
+  free (is_insn);
+  return valid;
+}
+
+struct agent_expr *
+parse_agent_expr (char **actparm)
+{
+  char *act = *actparm;
+  struct agent_expr *aexpr;
+  int i;
+  long len;
+
+  len = strtol (act, &act, 16);
+  if (len <= 0 || *act != ',')
+    return NULL;
+  act++;
+
+  aexpr = malloc (sizeof (struct agent_expr));
+  aexpr->length = len;
+  aexpr->bytes = malloc (len);
+  aexpr->native_code = NULL;
+  aexpr->native_size = 0;
+  aexpr->native_tried = 0;
+
+  for (i = 0; i < len; i++)
+    {
+      int hi = ax_fromhex (act[0]);
+      int lo = hi < 0 ? -1 : ax_fromhex (act[1]);
+
+      if (lo < 0)
+	{
+	  free_agent_expr (aexpr);
+	  return NULL;
+	}
+      aexpr->bytes[i] = hi * 16 + lo;
+      act += 2;
+    }
+
+  if (!validate_agent_expr (aexpr))
+    {
+      free_agent_expr (aexpr);
+      return NULL;
+    }
+
+  *actparm = act;
+  return aexpr;
+}
+
+void
+free_agent_expr (struct agent_expr *aexpr)
+{
+  if (aexpr != NULL)
+    {
+#ifdef HAVE_SYS_MMAN_H
+      if (aexpr->native_code != NULL)
+	munmap (aexpr->native_code, aexpr->native_size);
+#endif
+      free (aexpr->bytes);
+      free (aexpr);
+    }
+}
+
+/* Fetch the LEN-byte big-endian operand at PC in AEXPR.  */
+
+static ULONGEST
+ax_operand (struct agent_expr *aexpr, int pc, int len)
+{
+  ULONGEST val = 0;
+  int i;
+
+  for (i = 0; i < len; i++)
+    val = (val << 8) | aexpr->bytes[pc + i];
+
+  return val;
+}
+
+/* Convert the LEN bytes at BUF, in the inferior's byte order, to an
+   unsigned integer.  Since gdbserver always runs on the target, that
+   is our own byte order.  */
+
+static ULONGEST
+ax_extract (const unsigned char *buf, int len)
+{
+  switch (len)
+    {
+    case 1:
+      return *buf;
+    case 2:
+      {
+	unsigned short val;
+	memcpy (&val, buf, sizeof (val));
+	return val;
+      }
+    case 4:
+      {
+	unsigned int val;
+	memcpy (&val, buf, sizeof (val));
+	return val;
+      }
+    default:
+      {
+	ULONGEST val;
+	memcpy (&val, buf, sizeof (val));
+	return val;
+      }
+    }
+}
+
+/* Evaluate AEXPR one bytecode at a time.  See eval_agent_expr.  */
+
+static enum eval_result_type
+interpret_agent_expr (struct agent_expr *aexpr, struct traceframe *tframe,
+		      ULONGEST *rslt)
+{
+  /* The value on top of the stack is kept in TOP; STACK holds the
+     DEPTH - 1 values below it.  */
+  LONGEST stack[AX_STACK_MAX];
+  LONGEST top = 0;
+  int depth = 0;
+  int pc = 0;
+  int len;
+  unsigned char buf[sizeof (ULONGEST)];
+
+  if (aexpr->length == 0)
+    return expr_eval_empty_expression;
+
+/* Make sure the stack holds at least N values.  */
+#define AX_NEED_STACK(n)				\
+  do							\
+    {							\
+      if (depth < (n))					\
+	return expr_eval_stack_underflow;		\
+    }							\
+  while (0)
+
+/* Pop the value below TOP into A.  */
+#define AX_POP_BELOW(a)					\
+  do							\
+    {							\
+      AX_NEED_STACK (2);				\
+      (a) = stack[depth - 2];				\
+      depth--;						\
+    }							\
+  while (0)
+
+/* Make room for a new value on top of the stack.  */
+#define AX_PUSH()					\
+  do							\
+    {							\
+      if (depth >= AX_STACK_MAX)			\
+	return expr_eval_stack_overflow;		\
+      if (depth > 0)					\
+	stack[depth - 1] = top;				\
+      depth++;						\
+    }							\
+  while (0)
+
+/* Discard TOP.  */
+#define AX_POP()					\
+  do							\
+    {							\
+      AX_NEED_STACK (1);				\
+      depth--;						\
+      if (depth > 0)					\
+	top = stack[depth - 1];				\
+    }							\
+  while (0)
+
+/* Make sure there are N more bytes of operand after PC.  */
+#define AX_NEED_BYTES(n)				\
+  do							\
+    {							\
+      if (pc + (n) > aexpr->length)			\
+	return expr_eval_unrecognized_opcode;		\
+    }							\
+  while (0)
+
+  while (pc < aexpr->length)
+    {
+      int op = aexpr->bytes[pc++];
+      LONGEST a;
+
+      switch (op)
+	{
+	case aop_add:
+	  AX_POP_BELOW (a);
+	  top = a + top;
+	  break;
+
+	case aop_sub:
+	  AX_POP_BELOW (a);
+	  top = a - top;
+	  break;
+
+	case aop_mul:
+	  AX_POP_BELOW (a);
+	  top = a * top;
+	  break;
+
+	case aop_div_signed:
+	  AX_POP_BELOW (a);
+	  if (top == 0)
+	    return expr_eval_divide_by_zero;
+	  if (AX_DIVIDE_OVERFLOWS (a, top))
+	    return expr_eval_overflow;
+	  top = a / top;
+	  break;
+
+	case aop_div_unsigned:
+	  AX_POP_BELOW (a);
+	  if (top == 0)
+	    return expr_eval_divide_by_zero;
+	  top = (ULONGEST) a / (ULONGEST) top;
+	  break;
+
+	case aop_rem_signed:
+	  AX_POP_BELOW (a);
+	  if (top == 0)
+	    return expr_eval_divide_by_zero;
+	  if (AX_DIVIDE_OVERFLOWS (a, top))
+	    return expr_eval_overflow;
+	  top = a % top;
+	  break;
+
+	case aop_rem_unsigned:
+	  AX_POP_BELOW (a);
+	  if (top == 0)
+	    return expr_eval_divide_by_zero;
+	  top = (ULONGEST) a % (ULONGEST) top;
+	  break;
+
+	case aop_lsh:
+	  AX_POP_BELOW (a);
+	  if (AX_BAD_SHIFT (top))
+	    return expr_eval_invalid_shift;
+	  top = (ULONGEST) a << top;
+	  break;
+
+	case aop_rsh_signed:
+	  AX_POP_BELOW (a);
+	  if (AX_BAD_SHIFT (top))
+	    return expr_eval_invalid_shift;
+	  top = a >> top;
+	  break;
+
+	case aop_rsh_unsigned:
+	  AX_POP_BELOW (a);
+	  if (AX_BAD_SHIFT (top))
+	    return expr_eval_invalid_shift;
+	  top = (ULONGEST) a >> top;
+	  break;
+
+	case aop_log_not:
+	  AX_NEED_STACK (1);
+	  top = !top;
+	  break;
+
+	case aop_bit_and:
+	  AX_POP_BELOW (a);
+	  top &= a;
+	  break;
+
+	case aop_bit_or:
+	  AX_POP_BELOW (a);
+	  top |= a;
+	  break;
+
+	case aop_bit_xor:
+	  AX_POP_BELOW (a);
+	  top ^= a;
+	  break;
+
+	case aop_bit_not:
+	  AX_NEED_STACK (1);
+	  top = ~top;
+	  break;
+
+	case aop_equal:
+	  AX_POP_BELOW (a);
+	  top = (a == top);
+	  break;
+
+	case aop_less_signed:
+	  AX_POP_BELOW (a);
+	  top = (a < top);
+	  break;
+
+	case aop_less_unsigned:
+	  AX_POP_BELOW (a);
+	  top = ((ULONGEST) a < (ULONGEST) top);
+	  break;
+
+	case aop_ext:
+	  AX_NEED_BYTES (1);
+	  AX_NEED_STACK (1);
+	  len = aexpr->bytes[pc++];
+	  if (len > 0 && len < 8 * sizeof (LONGEST))
+	    {
+	      LONGEST mask = (LONGEST) 1 << (len - 1);
+
+	      top &= ((LONGEST) 1 << len) - 1;
+	      top = (top ^ mask) - mask;
+	    }
+	  break;
+
+	case aop_zero_ext:
+	  AX_NEED_BYTES (1);
+	  AX_NEED_STACK (1);
+	  len = aexpr->bytes[pc++];
+	  if (len < 8 * sizeof (LONGEST))
+	    top &= ((LONGEST) 1 << len) - 1;
+	  break;
+
+	case aop_ref8:
+	case aop_ref16:
+	case aop_ref32:
+	case aop_ref64:
+	  AX_NEED_STACK (1);
+	  len = 1 << (op - aop_ref8);
+	  if (read_inferior_memory ((CORE_ADDR) top, buf, len) != 0)
+	    return expr_eval_memory_error;
+	  top = ax_extract (buf, len);
+	  break;
+
+	case aop_if_goto:
+	  AX_NEED_BYTES (2);
+	  AX_NEED_STACK (1);
+	  if (top)
+	    pc = ax_operand (aexpr, pc, 2);
+	  else
+	    pc += 2;
+	  AX_POP ();
+	  if (pc > aexpr->length)
+	    return expr_eval_invalid_goto;
+	  break;
+
+	case aop_goto:
+	  AX_NEED_BYTES (2);
+	  pc = ax_operand (aexpr, pc, 2);
+	  if (pc > aexpr->length)
+	    return expr_eval_invalid_goto;
+	  break;
+
+	case aop_const8:
+	case aop_const16:
+	case aop_const32:
+	case aop_const64:
+	  len = 1 << (op - aop_const8);
+	  AX_NEED_BYTES (len);
+	  AX_PUSH ();
+	  top = ax_operand (aexpr, pc, len);
+	  pc += len;
+	  break;
+
+	case aop_reg:
+	  {
+	    int regnum;
+
+	    AX_NEED_BYTES (2);
+	    regnum = ax_operand (aexpr, pc, 2);
+	    pc += 2;
+	    if (regnum >= register_count ())
+	      return expr_eval_unhandled_opcode;
+	    len = register_size (regnum);
+	    if (len != 1 && len != 2 && len != 4 && len != 8)
+	      return expr_eval_unhandled_opcode;
+	    collect_register (regnum, buf);
+	    AX_PUSH ();
+	    top = ax_extract (buf, len);
+	  }
+	  break;
+
+	case aop_end:
+	  if (rslt != NULL)
+	    {
+	      if (depth == 0)
+		return expr_eval_empty_stack;
+	      *rslt = top;
+	    }
+	  return expr_eval_no_error;
+
+	case aop_dup:
+	  AX_NEED_STACK (1);
+	  AX_PUSH ();
+	  break;
+
+	case aop_pop:
+	  AX_POP ();
+	  break;
+
+	case aop_swap:
+	  AX_NEED_STACK (2);
+	  a = stack[depth - 2];
+	  stack[depth - 2] = top;
+	  top = a;
+	  break;
+
+	case aop_trace:
+	  /* Pop an address and a size, and record that memory.  */
+	  AX_NEED_STACK (2);
+	  if (tframe == NULL)
+	    return expr_eval_unhandled_opcode;
+	  if (traceframe_record_memory (tframe, (CORE_ADDR) stack[depth - 2],
+					(ULONGEST) top) != 0)
+	    return expr_eval_memory_error;
+	  AX_POP ();
+	  AX_POP ();
+	  break;
+
+	case aop_trace_quick:
+	case aop_trace16:
+	  /* Record memory at the address on top of the stack, whose
+	     size is the operand, and leave the address there.  */
+	  len = op == aop_trace_quick ? 1 : 2;
+	  AX_NEED_STACK (1);
+	  if (tframe == NULL)
+	    return expr_eval_unhandled_opcode;
+	  if (traceframe_record_memory (tframe, (CORE_ADDR) top,
+					ax_operand (aexpr, pc, len)) != 0)
+	    return expr_eval_memory_error;
+	  pc += len;
+	  break;
+
+	case aop_float:
+	case aop_ref_float:
+	case aop_ref_double:
+	case aop_ref_long_double:
+	case aop_l_to_d:
+	case aop_d_to_l:
+	  /* We have no floating point support.  */
+	  return expr_eval_unhandled_opcode;
+
+	default:
+	  return expr_eval_unrecognized_opcode;
+	}
+    }
+
+  /* Ran off the end without an `end' bytecode.  */
+  return expr_eval_invalid_goto;
+
+#undef AX_NEED_STACK
+#undef AX_POP_BELOW
+#undef AX_PUSH
+#undef AX_POP
+#undef AX_NEED_BYTES
+}
+
+/* Compiling agent expressions to native code.
+
+   An expression is compiled the first time it is evaluated, if the
+   target can generate code for the host we run on (see struct
+   emit_ops in ax.h).  The depth of the stack at each bytecode is
+   worked out beforehand, so the compiled code needs no stack checks;
+   an expression whose depth is not the same along every path, or
+   which could overflow or underflow the stack, is interpreted
+   instead, as is one using bytecodes we do not compile.  What the
+   generated code does not do inline is done by the native_* helpers
+   below, which report errors by longjmp'ing back to
+   run_native_agent_expr.  */
+
+int agent_jit = 1;
+
+/* While compiled code runs: where its helpers report errors, the
+   trace frame for the trace bytecodes, and whether the caller wants
+   the expression's value.  */
+
+static jmp_buf *native_error_jmp;
+static struct traceframe *native_tframe;
+static int native_want_result;
+
+static void
+native_error (enum eval_result_type err)
+{
+  longjmp (*native_error_jmp, err);
+}
+
+void
+ax_emit_bytes (struct ax_code *code, const unsigned char *bytes, int n)
+{
+  if (code->len + n > code->alloc)
+    {
+      code->alloc = code->alloc * 2 + n;
+      code->buf = realloc (code->buf, code->alloc);
+    }
+  memcpy (code->buf + code->len, bytes, n);
+  code->len += n;
+}
+
+/* Helpers for the operations a target's emit_ops leave out.  */
+
+#define NATIVE_BINOP(name, expr)		\
+  static LONGEST				\
+  native_ ## name (LONGEST a, LONGEST top)	\
+  {						\
+    return (expr);				\
+  }
+
+NATIVE_BINOP (add, a + top)
+NATIVE_BINOP (sub, a - top)
+NATIVE_BINOP (mul, a * top)
+NATIVE_BINOP (bit_and, a & top)
+NATIVE_BINOP (bit_or, a | top)
+NATIVE_BINOP (bit_xor, a ^ top)
+NATIVE_BINOP (equal, a == top)
+NATIVE_BINOP (less_signed, a < top)
+NATIVE_BINOP (less_unsigned, (ULONGEST) a < (ULONGEST) top)
+
+#undef NATIVE_BINOP
+
+static LONGEST
+native_log_not (LONGEST top)
+{
+  return !top;
+}
+
+static LONGEST
+native_bit_not (LONGEST top)
+{
+  return ~top;
+}
+
+static LONGEST
+native_ext (LONGEST top, LONGEST bits)
+{
+  LONGEST mask = (LONGEST) 1 << (bits - 1);
+
+  top &= ((LONGEST) 1 << bits) - 1;
+  return (top ^ mask) - mask;
+}
+
+static LONGEST
+native_zero_ext (LONGEST top, LONGEST bits)
+{
+  return top & (((LONGEST) 1 << bits) - 1);
+}
+
+/* Helpers which always do the work of their bytecodes, since they
+   must check their operands first.  */
+
+static LONGEST
+native_div_signed (LONGEST a, LONGEST top)
+{
+  if (top == 0)
+    native_error (expr_eval_divide_by_zero);
+  if (AX_DIVIDE_OVERFLOWS (a, top))
+    native_error (expr_eval_overflow);
+  return a / top;
+}
+
+static LONGEST
+native_div_unsigned (LONGEST a, LONGEST top)
+{
+  if (top == 0)
+    native_error (expr_eval_divide_by_zero);
+  return (ULONGEST) a / (ULONGEST) top;
+}
+
+static LONGEST
+native_rem_signed (LONGEST a, LONGEST top)
+{
+  if (top == 0)
+    native_error (expr_eval_divide_by_zero);
+  if (AX_DIVIDE_OVERFLOWS (a, top))
+    native_error (expr_eval_overflow);
+  return a % top;
+}
+
+static LONGEST
+native_rem_unsigned (LONGEST a, LONGEST top)
+{
+  if (top == 0)
+    native_error (expr_eval_divide_by_zero);
+  return (ULONGEST) a % (ULONGEST) top;
+}
+
+static LONGEST
+native_lsh (LONGEST a, LONGEST top)
+{
+  if (AX_BAD_SHIFT (top))
+    native_error (expr_eval_invalid_shift);
+  return (ULONGEST) a << top;
+}
+
+static LONGEST
+native_rsh_signed (LONGEST a, LONGEST top)
+{
+  if (AX_BAD_SHIFT (top))
+    native_error (expr_eval_invalid_shift);
+  return a >> top;
+}
+
+static LONGEST
+native_rsh_unsigned (LONGEST a, LONGEST top)
+{
+  if (AX_BAD_SHIFT (top))
+    native_error (expr_eval_invalid_shift);
+  return (ULONGEST) a >> top;
+}
+
+static LONGEST
+native_ref (LONGEST addr, int len)
+{
+  unsigned char buf[sizeof (ULONGEST)];
+
+  if (read_inferior_memory ((CORE_ADDR) addr, buf, len) != 0)
+    native_error (expr_eval_memory_error);
+  return ax_extract (buf, len);
+}
+
+static LONGEST
+native_ref8 (LONGEST addr)
+{
+  return native_ref (addr, 1);
+}
+
+static LONGEST
+native_ref16 (LONGEST addr)
+{
+  return native_ref (addr, 2);
+}
+
+static LONGEST
+native_ref32 (LONGEST addr)
+{
+  return native_ref (addr, 4);
+}
+
+static LONGEST
+native_ref64 (LONGEST addr)
+{
+  return native_ref (addr, 8);
+}
+
+static LONGEST
+native_reg (LONGEST regnum)
+{
+  unsigned char buf[sizeof (ULONGEST)];
+  int len;
+
+  if (regnum >= register_count ())
+    native_error (expr_eval_unhandled_opcode);
+  len = register_size (regnum);
+  if (len != 1 && len != 2 && len != 4 && len != 8)
+    native_error (expr_eval_unhandled_opcode);
+  collect_register (regnum, buf);
+  return ax_extract (buf, len);
+}
+
+/* Record SIZE bytes at ADDR in the current trace frame, for `trace'
+   and (returning ADDR) for `trace_quick' and `trace16'.  */
+
+static LONGEST
+native_trace (LONGEST addr, LONGEST size)
+{
+  if (native_tframe == NULL)
+    native_error (expr_eval_unhandled_opcode);
+  if (traceframe_record_memory (native_tframe, (CORE_ADDR) addr,
+				(ULONGEST) size) != 0)
+    native_error (expr_eval_memory_error);
+  return addr;
+}
+
+/* Called for an `end' reached with nothing on the stack.  */
+
+static LONGEST
+native_end_empty (LONGEST dummy)
+{
+  if (native_want_result)
+    native_error (expr_eval_empty_stack);
+  return 0;
+}
+
+/* Return the number of values bytecode OP needs on the stack, and set
+   *DELTA to the change it makes to the depth.  Return -1 for the
+   bytecodes we do not compile.  */
+
+static int
+ax_stack_effect (int op, int *delta)
+{
+  switch (op)
+    {
+    case aop_add:
+    case aop_sub:
+    case aop_mul:
+    case aop_div_signed:
+    case aop_div_unsigned:
+    case aop_rem_signed:
+    case aop_rem_unsigned:
+    case aop_lsh:
+    case aop_rsh_signed:
+    case aop_rsh_unsigned:
+    case aop_bit_and:
+    case aop_bit_or:
+    case aop_bit_xor:
+    case aop_equal:
+    case aop_less_signed:
+    case aop_less_unsigned:
+      *delta = -1;
+      return 2;
+
+    case aop_log_not:
+    case aop_bit_not:
+    case aop_ext:
+    case aop_zero_ext:
+    case aop_ref8:
+    case aop_ref16:
+    case aop_ref32:
+    case aop_ref64:
+    case aop_trace_quick:
+    case aop_trace16:
+      *delta = 0;
+      return 1;
+
+    case aop_const8:
+    case aop_const16:
+    case aop_const32:
+    case aop_const64:
+    case aop_reg:
+      *delta = 1;
+      return 0;
+
+    case aop_dup:
+      *delta = 1;
+      return 1;
+
+    case aop_pop:
+    case aop_if_goto:
+      *delta = -1;
+      return 1;
+
+    case aop_swap:
+      *delta = 0;
+      return 2;
+
+    case aop_trace:
+      *delta = -2;
+      return 2;
+
+    case aop_goto:
+    case aop_end:
+      *delta = 0;
+      return 0;
+
+    default:
+      return -1;
+    }
+}
+
+/* Return an array giving the depth of the stack before each bytecode
+   of AEXPR, or -1 for bytecodes which can not be reached.  Return
+   NULL if AEXPR can not be compiled.  */
+
+static int *
+agent_expr_stack_depths (struct agent_expr *aexpr)
+{
+  int *depths = malloc (aexpr->length * sizeof (int));
+  int *work = malloc (aexpr->length * sizeof (int));
+  int nwork = 0;
+  int pc;
+
+  for (pc = 0; pc < aexpr->length; pc++)
+    depths[pc] = -1;
+  depths[0] = 0;
+  work[nwork++] = 0;
+
+  while (nwork > 0)
+    {
+      int op, need, delta, depth;
+      int succ[2], nsucc = 0, i;
+
+      pc = work[--nwork];
+      op = aexpr->bytes[pc];
+      need = ax_stack_effect (op, &delta);
+      depth = depths[pc];
+      if (need < 0 || depth < need || depth + delta > AX_STACK_MAX)
+	goto fail;
+      depth += delta;
+
+      if (op == aop_goto || op == aop_if_goto)
+	succ[nsucc++] = ax_operand (aexpr, pc + 1, 2);
+      if (op != aop_goto && op != aop_end)
+	succ[nsucc++] = pc + 1 + ax_operand_length (op);
+
+      for (i = 0; i < nsucc; i++)
+	{
+	  /* Running off the end is an error the interpreter reports.  */
+	  if (succ[i] >= aexpr->length)
+	    goto fail;
+
+	  if (depths[succ[i]] < 0)
+	    {
+	      depths[succ[i]] = depth;
+	      work[nwork++] = succ[i];
+	    }
+	  else if (depths[succ[i]] != depth)
+	    goto fail;
+	}
+    }
+
+  free (work);
+  return depths;
+
+ fail:
+  free (work);
+  free (depths);
+  return NULL;
+}
+
+/* Generate code for an operation OPS may do inline with EMIT, and
+   otherwise by calling FN.  */
+
+static void
+emit_binop (struct emit_ops *ops, struct ax_code *code,
+	    void (*emit) (struct ax_code *), ax_helper2 fn)
+{
+  if (emit != NULL)
+    (*emit) (code);
+  else
+    (*ops->emit_call2) (code, fn);
+}
+
+static void
+emit_unop (struct emit_ops *ops, struct ax_code *code,
+	   void (*emit) (struct ax_code *), ax_helper1 fn)
+{
+  if (emit != NULL)
+    (*emit) (code);
+  else
+    (*ops->emit_call1) (code, fn);
+}
+
+/* Likewise, for an operation with an immediate operand ARG.  */
+
+static void
+emit_arg_op (struct emit_ops *ops, struct ax_code *code,
+	     void (*emit) (struct ax_code *, int), ax_helper2 fn, int arg)
+{
+  if (emit != NULL)
+    (*emit) (code, arg);
+  else
+    {
+      (*ops->emit_stack_flush) (code);
+      (*ops->emit_const) (code, arg);
+      (*ops->emit_call2) (code, fn);
+    }
+}
+
+/* Copy the LEN bytes of code at BUF to executable memory.  Returns
+   NULL if we can not.  */
+
+static void *
+install_native_code (const unsigned char *buf, int len)
+{
+#ifdef HAVE_SYS_MMAN_H
+  void *mem = mmap (NULL, len, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (mem == MAP_FAILED)
+    return NULL;
+  memcpy (mem, buf, len);
+  if (mprotect (mem, len, PROT_READ | PROT_EXEC) != 0)
+    {
+      munmap (mem, len);
+      return NULL;
+    }
+  return mem;
+#else
+  return NULL;
+#endif
+}
+
+/* Try to compile AEXPR to native code, setting its native_code.
+   Returns non-zero on success.  */
+
+static int
+compile_agent_expr (struct agent_expr *aexpr)
+{
+  struct emit_ops *ops;
+  struct ax_code code;
+  int *depths, *labels, *fixup_from, *fixup_pc;
+  int nfixups = 0;
+  int pc, len, i;
+
+  if (the_target->emit_ops == NULL
+      || (ops = (*the_target->emit_ops) ()) == NULL)
+    return 0;
+
+  depths = agent_expr_stack_depths (aexpr);
+  if (depths == NULL)
+    return 0;
+
+  labels = malloc (aexpr->length * sizeof (int));
+  fixup_from = malloc (aexpr->length * sizeof (int));
+  fixup_pc = malloc (aexpr->length * sizeof (int));
+  code.buf = NULL;
+  code.len = code.alloc = 0;
+
+  (*ops->emit_prologue) (&code);
+
+  for (pc = 0; pc < aexpr->length; pc += len + 1)
+    {
+      int op = aexpr->bytes[pc];
+      int depth = depths[pc];
+      int arg;
+
+      len = ax_operand_length (op);
+      labels[pc] = code.len;
+      if (depth < 0)
+	continue;
+
+      switch (op)
+	{
+	case aop_add:
+	  emit_binop (ops, &code, ops->emit_add, native_add);
+	  break;
+	case aop_sub:
+	  emit_binop (ops, &code, ops->emit_sub, native_sub);
+	  break;
+	case aop_mul:
+	  emit_binop (ops, &code, ops->emit_mul, native_mul);
+	  break;
+	case aop_bit_and:
+	  emit_binop (ops, &code, ops->emit_bit_and, native_bit_and);
+	  break;
+	case aop_bit_or:
+	  emit_binop (ops, &code, ops->emit_bit_or, native_bit_or);
+	  break;
+	case aop_bit_xor:
+	  emit_binop (ops, &code, ops->emit_bit_xor, native_bit_xor);
+	  break;
+	case aop_equal:
+	  emit_binop (ops, &code, ops->emit_equal, native_equal);
+	  break;
+	case aop_less_signed:
+	  emit_binop (ops, &code, ops->emit_less_signed, native_less_signed);
+	  break;
+	case aop_less_unsigned:
+	  emit_binop (ops, &code, ops->emit_less_unsigned,
+		      native_less_unsigned);
+	  break;
+
+	case aop_div_signed:
+	  (*ops->emit_call2) (&code, native_div_signed);
+	  break;
+	case aop_div_unsigned:
+	  (*ops->emit_call2) (&code, native_div_unsigned);
+	  break;
+	case aop_rem_signed:
+	  (*ops->emit_call2) (&code, native_rem_signed);
+	  break;
+	case aop_rem_unsigned:
+	  (*ops->emit_call2) (&code, native_rem_unsigned);
+	  break;
+	case aop_lsh:
+	  (*ops->emit_call2) (&code, native_lsh);
+	  break;
+	case aop_rsh_signed:
+	  (*ops->emit_call2) (&code, native_rsh_signed);
+	  break;
+	case aop_rsh_unsigned:
+	  (*ops->emit_call2) (&code, native_rsh_unsigned);
+	  break;
+
+	case aop_log_not:
+	  emit_unop (ops, &code, ops->emit_log_not, native_log_not);
+	  break;
+	case aop_bit_not:
+	  emit_unop (ops, &code, ops->emit_bit_not, native_bit_not);
+	  break;
+
+	case aop_ext:
+	  arg = aexpr->bytes[pc + 1];
+	  if (arg > 0 && arg < 8 * sizeof (LONGEST))
+	    emit_arg_op (ops, &code, ops->emit_ext, native_ext, arg);
+	  break;
+	case aop_zero_ext:
+	  arg = aexpr->bytes[pc + 1];
+	  if (arg < 8 * sizeof (LONGEST))
+	    emit_arg_op (ops, &code, ops->emit_zero_ext, native_zero_ext, arg);
+	  break;
+
+	case aop_ref8:
+	  (*ops->emit_call1) (&code, native_ref8);
+	  break;
+	case aop_ref16:
+	  (*ops->emit_call1) (&code, native_ref16);
+	  break;
+	case aop_ref32:
+	  (*ops->emit_call1) (&code, native_ref32);
+	  break;
+	case aop_ref64:
+	  (*ops->emit_call1) (&code, native_ref64);
+	  break;
+
+	case aop_if_goto:
+	  fixup_from[nfixups] = (*ops->emit_if_goto) (&code, depth > 1);
+	  fixup_pc[nfixups++] = ax_operand (aexpr, pc + 1, 2);
+	  break;
+	case aop_goto:
+	  fixup_from[nfixups] = (*ops->emit_goto) (&code);
+	  fixup_pc[nfixups++] = ax_operand (aexpr, pc + 1, 2);
+	  break;
+
+	case aop_const8:
+	case aop_const16:
+	case aop_const32:
+	case aop_const64:
+	  if (depth > 0)
+	    (*ops->emit_stack_flush) (&code);
+	  (*ops->emit_const) (&code, ax_operand (aexpr, pc + 1, len));
+	  break;
+
+	case aop_reg:
+	  if (depth > 0)
+	    (*ops->emit_stack_flush) (&code);
+	  (*ops->emit_const) (&code, ax_operand (aexpr, pc + 1, 2));
+	  (*ops->emit_call1) (&code, native_reg);
+	  break;
+
+	case aop_end:
+	  if (depth == 0)
+	    {
+	      (*ops->emit_const) (&code, 0);
+	      (*ops->emit_call1) (&code, native_end_empty);
+	    }
+	  (*ops->emit_epilogue) (&code);
+	  break;
+
+	case aop_dup:
+	  (*ops->emit_stack_flush) (&code);
+	  break;
+
+	case aop_pop:
+	  if (depth > 1)
+	    (*ops->emit_pop) (&code);
+	  break;
+
+	case aop_swap:
+	  (*ops->emit_swap) (&code);
+	  break;
+
+	case aop_trace:
+	  (*ops->emit_call2) (&code, native_trace);
+	  if (depth > 2)
+	    (*ops->emit_pop) (&code);
+	  break;
+
+	case aop_trace_quick:
+	case aop_trace16:
+	  (*ops->emit_stack_flush) (&code);
+	  (*ops->emit_const) (&code, ax_operand (aexpr, pc + 1, len));
+	  (*ops->emit_call2) (&code, native_trace);
+	  break;
+	}
+    }
+
+  for (i = 0; i < nfixups; i++)
+    (*ops->emit_goto_address) (&code, fixup_from[i], labels[fixup_pc[i]]);
+
+  aexpr->native_code = install_native_code (code.buf, code.len);
+  if (aexpr->native_code != NULL)
+    aexpr->native_size = code.len;
+
+  free (code.buf);
+  free (fixup_pc);
+  free (fixup_from);
+  free (labels);
+  free (depths);
+  return aexpr->native_code != NULL;
+}
+
+/* Run the native code compiled for AEXPR.  */
+
+static enum eval_result_type
+run_native_agent_expr (struct agent_expr *aexpr, struct traceframe *tframe,
+		       ULONGEST *rslt)
+{
+  LONGEST (*fn) (void) = (LONGEST (*) (void)) aexpr->native_code;
+  jmp_buf env;
+  LONGEST value;
+  int err;
+
+  native_error_jmp = &env;
+  native_tframe = tframe;
+  native_want_result = (rslt != NULL);
+
+  err = setjmp (env);
+  if (err != 0)
+    return err;
+
+  value = (*fn) ();
+  if (rslt != NULL)
+    *rslt = value;
+  return expr_eval_no_error;
+}
+
+enum eval_result_type
+eval_agent_expr (struct agent_expr *aexpr, struct traceframe *tframe,
+		 ULONGEST *rslt)
+{
+  if (agent_jit && !aexpr->native_tried)
+    {
+      aexpr->native_tried = 1;
+      if (compile_agent_expr (aexpr) && debug_threads)
+	fprintf (stderr, "Compiled %d bytes of bytecode to %d bytes "
+		 "of native code.\n", aexpr->length, aexpr->native_size);
+    }
+
+  if (agent_jit && aexpr->native_code != NULL)
+    return run_native_agent_expr (aexpr, tframe, rslt);
+
+  return interpret_agent_expr (aexpr, tframe, rslt);
+}
@@ -0,0 +1,180 @@
+/* Agent expression evaluation for the remote server for GDB.
+   Copyright (C) 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef AX_H
+#define AX_H
+
+/* A bytecode expression sent by GDB, e.g. a breakpoint condition.
+   See the "Agent Expressions" appendix of the GDB manual for the
+   meaning of the bytecodes.  */
+
+struct agent_expr
+{
+  int length;
+  unsigned char *bytes;
+
+  /* Machine code compiled from BYTES, NATIVE_SIZE bytes long, or
+     NULL if it has not been compiled.  */
+  void *native_code;
+  int native_size;
+
+  /* Non-zero once we have tried to compile BYTES, whether or not
+     that worked.  */
+  int native_tried;
+};
+
+/* The ways evaluating an expression can fail.  */
+
+enum eval_result_type
+  {
+    expr_eval_no_error,
+    expr_eval_empty_expression,
+    expr_eval_empty_stack,
+    expr_eval_stack_overflow,
+    expr_eval_stack_underflow,
+    expr_eval_unhandled_opcode,
+    expr_eval_unrecognized_opcode,
+    expr_eval_divide_by_zero,
+    expr_eval_overflow,
+    expr_eval_invalid_shift,
+    expr_eval_invalid_goto,
+    expr_eval_memory_error
+  };
+
+/* Parse an expression of the form "LEN,HEXBYTES" at *ACTPARM, as
+   found in the condition list of a Z0 packet or a tracepoint action,
+   and advance *ACTPARM past it.  Returns NULL if the expression is
+   malformed: if it uses an opcode we don't know, if an operand runs
+   off its end, or if a jump does not land on an opcode.  */
+
+struct agent_expr *parse_agent_expr (char **actparm);
+
+/* Release an expression returned by parse_agent_expr.  */
+
+void free_agent_expr (struct agent_expr *aexpr);
+
+struct traceframe;
+
+/* Evaluate AEXPR against the registers and memory of the current
+   inferior.  If TFRAME is non-NULL, the trace bytecodes record memory
+   in it; otherwise they are an error.  If RSLT is non-NULL, store the
+   value left on top of the stack there; an expression evaluated only
+   for its side effects on TFRAME may leave the stack empty.
+
+   The first evaluation compiles AEXPR to native code if it can (see
+   agent_jit, below); later ones run that code.  */
+
+enum eval_result_type eval_agent_expr (struct agent_expr *aexpr,
+				       struct traceframe *tframe,
+				       ULONGEST *rslt);
+
+/* Non-zero if agent expressions should be compiled to native code,
+   where the target supports that (the "monitor set agent-jit"
+   command).  */
+
+extern int agent_jit;
+
+/* A buffer of machine code being generated for an agent expression.  */
+
+struct ax_code
+{
+  unsigned char *buf;
+  int len;
+  int alloc;
+};
+
+/* Append the N bytes at BYTES to CODE.  */
+
+void ax_emit_bytes (struct ax_code *code, const unsigned char *bytes, int n);
+
+/* Helpers which compiled code can call for the work it does not do
+   inline.  They take and return the values on the stack.  */
+
+typedef LONGEST (*ax_helper1) (LONGEST);
+typedef LONGEST (*ax_helper2) (LONGEST, LONGEST);
+
+/* How to generate native code for agent expressions on a particular
+   host.  Compiled code keeps the value on top of the agent
+   expression stack in a register, and the values below it on the
+   machine stack.  The compiled function takes no arguments, and
+   returns the top of the stack as a LONGEST.
+
+   The methods marked optional may be NULL; the operation is then
+   done by calling a helper with EMIT_CALL2, or EMIT_CALL1.  */
+
+struct emit_ops
+{
+  /* Start and finish a compiled function.  EMIT_EPILOGUE returns the
+     top of the stack, and may be used more than once.  */
+  void (*emit_prologue) (struct ax_code *code);
+  void (*emit_epilogue) (struct ax_code *code);
+
+  /* Replace the top two values with the result of the operation, as
+     for the bytecode of the same name.  Optional.  */
+  void (*emit_add) (struct ax_code *code);
+  void (*emit_sub) (struct ax_code *code);
+  void (*emit_mul) (struct ax_code *code);
+  void (*emit_bit_and) (struct ax_code *code);
+  void (*emit_bit_or) (struct ax_code *code);
+  void (*emit_bit_xor) (struct ax_code *code);
+  void (*emit_equal) (struct ax_code *code);
+  void (*emit_less_signed) (struct ax_code *code);
+  void (*emit_less_unsigned) (struct ax_code *code);
+
+  /* Operations on the top value only.  ARG is the number of bits to
+     extend from; it is always between 1 and 63 for EMIT_EXT and
+     between 0 and 63 for EMIT_ZERO_EXT.  Optional.  */
+  void (*emit_log_not) (struct ax_code *code);
+  void (*emit_bit_not) (struct ax_code *code);
+  void (*emit_ext) (struct ax_code *code, int arg);
+  void (*emit_zero_ext) (struct ax_code *code, int arg);
+
+  /* Set the top of the stack to NUM, without saving its old value;
+     use EMIT_STACK_FLUSH first for that.  */
+  void (*emit_const) (struct ax_code *code, LONGEST num);
+
+  /* Push the top of the stack onto the machine stack, leaving a copy
+     in place; this is how a value is pushed, and also `dup'.  */
+  void (*emit_stack_flush) (struct ax_code *code);
+
+  /* Discard the top of the stack, replacing it with the next value.  */
+  void (*emit_pop) (struct ax_code *code);
+
+  /* Exchange the top two values.  */
+  void (*emit_swap) (struct ax_code *code);
+
+  /* Jump if the top of the stack is non-zero, discarding it first if
+     POP is non-zero.  Return the offset in CODE of the jump's
+     destination, for EMIT_GOTO_ADDRESS.  */
+  int (*emit_if_goto) (struct ax_code *code, int pop);
+
+  /* Jump unconditionally; return as for EMIT_IF_GOTO.  */
+  int (*emit_goto) (struct ax_code *code);
+
+  /* Make the jump whose destination is at offset FROM in CODE go to
+     offset TO.  */
+  void (*emit_goto_address) (struct ax_code *code, int from, int to);
+
+  /* Replace the top of the stack with FN (top).  */
+  void (*emit_call1) (struct ax_code *code, ax_helper1 fn);
+
+  /* Replace the top two values with FN (below, top).  */
+  void (*emit_call2) (struct ax_code *code, ax_helper2 fn);
+};
+
+#endif /* AX_H */
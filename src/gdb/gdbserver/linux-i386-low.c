@@ -188,6 +188,326 @@ i386_breakpoint_at (CORE_ADDR pc)
   return 0;
 }
 
+/* Compiling agent expressions.  The top of the stack is kept in
+   %edx:%eax, and the values below it are pushed on the machine stack,
+   low word first.  %esi holds the stack pointer around calls to
+   helpers, which must be made with the stack aligned, and %edi is a
+   scratch register for them.  Multiplication, shifts and extension
+   are left to the helpers.  */
+
+#define EMIT_INSNS(code, insns) \
+  ax_emit_bytes ((code), (insns), sizeof (insns))
+
+static void
+i386_emit_prologue (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x55,				/* push %ebp */
+    0x89, 0xe5,				/* mov %esp,%ebp */
+    0x56,				/* push %esi */
+    0x57				/* push %edi */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_epilogue (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x8b, 0x75, 0xfc,			/* mov -0x4(%ebp),%esi */
+    0x8b, 0x7d, 0xf8,			/* mov -0x8(%ebp),%edi */
+    0xc9,				/* leave */
+    0xc3				/* ret */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_add (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x03, 0x04, 0x24,			/* add (%esp),%eax */
+    0x13, 0x54, 0x24, 0x04,		/* adc 0x4(%esp),%edx */
+    0x8d, 0x64, 0x24, 0x08		/* lea 0x8(%esp),%esp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_sub (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x29, 0x04, 0x24,			/* sub %eax,(%esp) */
+    0x19, 0x54, 0x24, 0x04,		/* sbb %edx,0x4(%esp) */
+    0x58,				/* pop %eax */
+    0x5a				/* pop %edx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+/* Combine the value below the top with the top, a word at a time,
+   using the instruction whose opcode byte is OPCODE.  */
+
+static void
+i386_emit_bitwise (struct ax_code *code, unsigned char opcode)
+{
+  unsigned char insns[] = {
+    0, 0x04, 0x24,			/* and/or/xor (%esp),%eax */
+    0, 0x54, 0x24, 0x04,		/* and/or/xor 0x4(%esp),%edx */
+    0x8d, 0x64, 0x24, 0x08		/* lea 0x8(%esp),%esp */
+  };
+  insns[0] = insns[3] = opcode;
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_bit_and (struct ax_code *code)
+{
+  i386_emit_bitwise (code, 0x23);
+}
+
+static void
+i386_emit_bit_or (struct ax_code *code)
+{
+  i386_emit_bitwise (code, 0x0b);
+}
+
+static void
+i386_emit_bit_xor (struct ax_code *code)
+{
+  i386_emit_bitwise (code, 0x33);
+}
+
+static void
+i386_emit_equal (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x3b, 0x04, 0x24,			/* cmp (%esp),%eax */
+    0x75, 0x04,				/* jne 1f */
+    0x3b, 0x54, 0x24, 0x04,		/* cmp 0x4(%esp),%edx */
+    0x0f, 0x94, 0xc0,			/* 1: sete %al */
+    0x0f, 0xb6, 0xc0,			/* movzbl %al,%eax */
+    0x31, 0xd2,				/* xor %edx,%edx */
+    0x8d, 0x64, 0x24, 0x08		/* lea 0x8(%esp),%esp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+/* Subtract the top from the value below it, and replace both with
+   the flag the SETCC opcode byte tests.  */
+
+static void
+i386_emit_compare (struct ax_code *code, unsigned char setcc)
+{
+  unsigned char insns[] = {
+    0x8b, 0x0c, 0x24,			/* mov (%esp),%ecx */
+    0x29, 0xc1,				/* sub %eax,%ecx */
+    0x8b, 0x4c, 0x24, 0x04,		/* mov 0x4(%esp),%ecx */
+    0x19, 0xd1,				/* sbb %edx,%ecx */
+    0x0f, 0, 0xc0,			/* setCC %al */
+    0x0f, 0xb6, 0xc0,			/* movzbl %al,%eax */
+    0x31, 0xd2,				/* xor %edx,%edx */
+    0x8d, 0x64, 0x24, 0x08		/* lea 0x8(%esp),%esp */
+  };
+  insns[12] = setcc;
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_less_signed (struct ax_code *code)
+{
+  i386_emit_compare (code, 0x9c);	/* setl */
+}
+
+static void
+i386_emit_less_unsigned (struct ax_code *code)
+{
+  i386_emit_compare (code, 0x92);	/* setb */
+}
+
+static void
+i386_emit_log_not (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x09, 0xd0,				/* or %edx,%eax */
+    0x0f, 0x94, 0xc0,			/* sete %al */
+    0x0f, 0xb6, 0xc0,			/* movzbl %al,%eax */
+    0x31, 0xd2				/* xor %edx,%edx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_bit_not (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0xf7, 0xd0,				/* not %eax */
+    0xf7, 0xd2				/* not %edx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_const (struct ax_code *code, LONGEST num)
+{
+  unsigned char insns[] = {
+    0xb8, 0, 0, 0, 0,			/* mov $LOW,%eax */
+    0xba, 0, 0, 0, 0			/* mov $HIGH,%edx */
+  };
+  memcpy (insns + 1, &num, 4);
+  memcpy (insns + 6, (unsigned char *) &num + 4, 4);
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_stack_flush (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x52,				/* push %edx */
+    0x50				/* push %eax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_pop (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x58,				/* pop %eax */
+    0x5a				/* pop %edx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_swap (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x8b, 0x0c, 0x24,			/* mov (%esp),%ecx */
+    0x89, 0x04, 0x24,			/* mov %eax,(%esp) */
+    0x89, 0xc8,				/* mov %ecx,%eax */
+    0x8b, 0x4c, 0x24, 0x04,		/* mov 0x4(%esp),%ecx */
+    0x89, 0x54, 0x24, 0x04,		/* mov %edx,0x4(%esp) */
+    0x89, 0xca				/* mov %ecx,%edx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static int
+i386_emit_if_goto (struct ax_code *code, int pop)
+{
+  static const unsigned char test[] = {
+    0x89, 0xc1,				/* mov %eax,%ecx */
+    0x09, 0xd1				/* or %edx,%ecx */
+  };
+  static const unsigned char jne[] = {
+    0x0f, 0x85, 0, 0, 0, 0		/* jne <target> */
+  };
+
+  EMIT_INSNS (code, test);
+  if (pop)
+    i386_emit_pop (code);
+  EMIT_INSNS (code, jne);
+  return code->len - 4;
+}
+
+static int
+i386_emit_goto (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0xe9, 0, 0, 0, 0			/* jmp <target> */
+  };
+  EMIT_INSNS (code, insns);
+  return code->len - 4;
+}
+
+static void
+i386_emit_goto_address (struct ax_code *code, int from, int to)
+{
+  int rel = to - (from + 4);
+
+  memcpy (code->buf + from, &rel, 4);
+}
+
+/* Call FN with the arguments pushed by the preceding code, then
+   restore the stack pointer from %esi.  FN's result is left in
+   %edx:%eax.  */
+
+static void
+i386_emit_call (struct ax_code *code, void *fn)
+{
+  unsigned char insns[] = {
+    0xb9, 0, 0, 0, 0,			/* mov $FN,%ecx */
+    0xff, 0xd1,				/* call *%ecx */
+    0x89, 0xf4				/* mov %esi,%esp */
+  };
+  memcpy (insns + 1, &fn, 4);
+  EMIT_INSNS (code, insns);
+}
+
+static void
+i386_emit_call1 (struct ax_code *code, ax_helper1 fn)
+{
+  static const unsigned char insns[] = {
+    0x89, 0xe6,				/* mov %esp,%esi */
+    0x83, 0xe4, 0xf0,			/* and $-16,%esp */
+    0x83, 0xec, 0x08,			/* sub $0x8,%esp */
+    0x52,				/* push %edx */
+    0x50				/* push %eax */
+  };
+  EMIT_INSNS (code, insns);
+  i386_emit_call (code, (void *) fn);
+}
+
+static void
+i386_emit_call2 (struct ax_code *code, ax_helper2 fn)
+{
+  static const unsigned char insns[] = {
+    0x8d, 0x74, 0x24, 0x08,		/* lea 0x8(%esp),%esi */
+    0x8b, 0x0c, 0x24,			/* mov (%esp),%ecx */
+    0x8b, 0x7c, 0x24, 0x04,		/* mov 0x4(%esp),%edi */
+    0x83, 0xe4, 0xf0,			/* and $-16,%esp */
+    0x52,				/* push %edx */
+    0x50,				/* push %eax */
+    0x57,				/* push %edi */
+    0x51				/* push %ecx */
+  };
+  EMIT_INSNS (code, insns);
+  i386_emit_call (code, (void *) fn);
+}
+
+#undef EMIT_INSNS
+
+static struct emit_ops i386_emit_ops = {
+  i386_emit_prologue,
+  i386_emit_epilogue,
+  i386_emit_add,
+  i386_emit_sub,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  i386_emit_bit_and,
+  i386_emit_bit_or,
+  i386_emit_bit_xor,
+  i386_emit_equal,
+  i386_emit_less_signed,
+  i386_emit_less_unsigned,
+  i386_emit_log_not,
+  i386_emit_bit_not,
+  NULL,
+  NULL,
+  i386_emit_const,
+  i386_emit_stack_flush,
+  i386_emit_pop,
+  i386_emit_swap,
+  i386_emit_if_goto,
+  i386_emit_goto,
+  i386_emit_goto_address,
+  i386_emit_call1,
+  i386_emit_call2
+};
+
 struct linux_target_ops the_low_target = {
   init_registers_i386_linux,
   i386_num_regs,
@@ -207,4 +527,5 @@ struct linux_target_ops the_low_target = {
   NULL,
   NULL,
   NULL,
+  &i386_emit_ops
 };
@@ -105,6 +105,10 @@ static int thread_db_active;
 
 static int must_set_ptrace_flags;
 
+/* The process stepping over a breakpoint while we hold all the others
+   stopped, or NULL.  */
+static struct process_info *step_over_process;
+
 /* This flag is true iff we've just created or attached to a new inferior
    but it has not stopped yet.  As soon as it does, we need to call the
    low target's arch_setup callback.  */
@@ -114,7 +118,11 @@ static void linux_resume_one_process (struct inferior_list_entry *entry,
 				      int step, int signal, siginfo_t *info);
 static void linux_resume (struct thread_resume *resume_info);
 static void stop_all_processes (void);
+static void start_step_over (struct process_info *process);
+static void finish_step_over (int resume);
 static int linux_wait_for_event (struct thread_info *child);
+static int linux_wait_for_event_1 (struct thread_info *child, int *wstatp,
+				   int options);
 static int check_removed_breakpoint (struct process_info *event_child);
 static void *add_process (unsigned long pid);
 
@@ -135,6 +143,45 @@ static int num_regsets;
 
 #define pid_of(proc) ((proc)->head.id)
 
+/* In non-stop mode, the SIGCHLD handler writes to this pipe, so that
+   the main loop can wait for events from GDB and from the inferior
+   at once.  */
+static int linux_event_pipe[2] = { -1, -1 };
+
+static void
+async_file_mark (void)
+{
+  int ret;
+
+  /* What the pipe contains doesn't matter, only that it becomes
+     readable.  If it is full, it is readable already.  */
+  do
+    ret = write (linux_event_pipe[1], "+", 1);
+  while (ret == -1 && errno == EINTR);
+}
+
+static void
+async_file_flush (void)
+{
+  int ret;
+  char buf;
+
+  do
+    ret = read (linux_event_pipe[0], &buf, 1);
+  while (ret >= 0 || (ret == -1 && errno == EINTR));
+}
+
+static void
+sigchld_handler (int signo)
+{
+  int old_errno = errno;
+
+  if (linux_event_pipe[1] != -1)
+    async_file_mark ();
+
+  errno = old_errno;
+}
+
 /* FIXME: Delete eventually.  */
 #define inferior_pid (pid_of (get_thread_process (current_inferior)))
 
@@ -395,6 +442,10 @@ linux_kill (void)
   if (thread == NULL)
     return;
 
+  /* PTRACE_KILL only works on stopped threads.  */
+  if (non_stop)
+    stop_all_processes ();
+
   for_each_inferior (&all_threads, linux_kill_one_process);
 
   /* See the comment in linux_kill_one_process.  We did not kill the first
@@ -446,6 +497,9 @@ linux_detach_one_process (struct inferior_list_entry *entry)
 static int
 linux_detach (void)
 {
+  if (non_stop)
+    stop_all_processes ();
+
   delete_all_breakpoints ();
   for_each_inferior (&all_threads, linux_detach_one_process);
   clear_inferiors ();
@@ -562,8 +616,14 @@ status_pending_p (struct inferior_list_entry *entry, void *dummy)
   return process->status_pending_p;
 }
 
-static void
-linux_wait_for_process (struct process_info **childp, int *wstatp)
+/* Wait for an event from *CHILDP, or from any process if *CHILDP is
+   NULL, and store its wait status in *WSTATP.  If OPTIONS includes
+   WNOHANG, return 0 if there is no event to collect; otherwise return
+   the LWP ID of the event process.  */
+
+static int
+linux_wait_for_process (struct process_info **childp, int *wstatp,
+			int options)
 {
   int ret;
   int to_wait_for = -1;
@@ -594,7 +654,23 @@ retry:
       else if (ret > 0)
 	break;
 
-      usleep (1000);
+      if (options & WNOHANG)
+	return 0;
+
+      /* Nothing is pending; block until something happens, rather
+	 than polling.  A stop requested by GDB meanwhile arrives as
+	 an event like any other.  Breakpoints whose conditions are
+	 false make this path hot.  */
+      ret = waitpid (to_wait_for, wstatp, __WALL);
+
+      if (ret > 0)
+	break;
+      else if (ret == -1 && errno != EINTR)
+	{
+	  if (errno != ECHILD)
+	    perror_with_name ("waitpid (WALL)");
+	  usleep (1000);
+	}
     }
 
   if (debug_threads
@@ -645,21 +721,33 @@ retry:
       if (the_low_target.get_pc != NULL)
 	get_stop_pc ();
     }
+
+  return ret;
 }
 
+/* Wait for an event from CHILD, or from any process if CHILD is NULL,
+   handling the events which are not for GDB.  Store the wait status of
+   the event to report in *WSTATP, and return non-zero.  If OPTIONS
+   includes WNOHANG, return zero if there is nothing to report yet.  */
+
 static int
-linux_wait_for_event (struct thread_info *child)
+linux_wait_for_event_1 (struct thread_info *child, int *wstatp, int options)
 {
   CORE_ADDR stop_pc;
   struct process_info *event_child;
-  int wstat;
   int bp_status;
 
+ retry:
   /* Check for a process with a pending status.  */
   /* It is possible that the user changed the pending task's registers since
      it stopped.  We correctly handle the change of PC if we hit a breakpoint
-     (in check_removed_breakpoint); signals should be reported anyway.  */
-  if (child == NULL)
+     (in check_removed_breakpoint); signals should be reported anyway.
+     While a process steps over a breakpoint, the pending statuses of
+     the others wait until it is done; reporting one would resume the
+     others with the breakpoint still out.  */
+  if (child == NULL && step_over_process != NULL)
+    event_child = NULL;
+  else if (child == NULL)
     {
       event_child = (struct process_info *)
 	find_inferior (&all_processes, status_pending_p, NULL);
@@ -681,11 +769,11 @@ linux_wait_for_event (struct thread_info *child)
 	  if (debug_threads)
 	    fprintf (stderr, "Got an event from pending child %ld (%04x)\n",
 		     event_child->lwpid, event_child->status_pending);
-	  wstat = event_child->status_pending;
+	  *wstatp = event_child->status_pending;
 	  event_child->status_pending_p = 0;
 	  event_child->status_pending = 0;
 	  current_inferior = get_process_thread (event_child);
-	  return wstat;
+	  return 1;
 	}
     }
 
@@ -695,12 +783,21 @@ linux_wait_for_event (struct thread_info *child)
      events.  */
   while (1)
     {
+      /* A process held stopped while another stepped over a
+	 breakpoint may have stopped for a reason of its own before it
+	 got our SIGSTOP.  Report that, rather than wait for an event
+	 which may never come.  */
+      if (child == NULL && step_over_process == NULL
+	  && find_inferior (&all_processes, status_pending_p, NULL) != NULL)
+	goto retry;
+
       if (child == NULL)
 	event_child = NULL;
       else
 	event_child = get_thread_process (child);
 
-      linux_wait_for_process (&event_child, &wstat);
+      if (linux_wait_for_process (&event_child, wstatp, options) == 0)
+	return 0;
 
       if (event_child == NULL)
 	error ("event from unknown child");
@@ -709,17 +806,20 @@ linux_wait_for_event (struct thread_info *child)
 	find_inferior_id (&all_threads, event_child->lwpid);
 
       /* Check for thread exit.  */
-      if (! WIFSTOPPED (wstat))
+      if (! WIFSTOPPED (*wstatp))
 	{
 	  if (debug_threads)
 	    fprintf (stderr, "LWP %ld exiting\n", event_child->head.id);
 
 	  /* If the last thread is exiting, just return.  */
 	  if (all_threads.head == all_threads.tail)
-	    return wstat;
+	    return 1;
 
 	  dead_thread_notify (thread_id_to_gdb_id (event_child->lwpid));
 
+	  if (event_child == step_over_process)
+	    finish_step_over (1);
+
 	  remove_inferior (&all_processes, &event_child->head);
 	  free (event_child);
 	  remove_thread (current_inferior);
@@ -728,14 +828,14 @@ linux_wait_for_event (struct thread_info *child)
 	  /* If we were waiting for this particular child to do something...
 	     well, it did something.  */
 	  if (child != NULL)
-	    return wstat;
+	    return 1;
 
 	  /* Wait for a more interesting event.  */
 	  continue;
 	}
 
-      if (WIFSTOPPED (wstat)
-	  && WSTOPSIG (wstat) == SIGSTOP
+      if (WIFSTOPPED (*wstatp)
+	  && WSTOPSIG (*wstatp) == SIGSTOP
 	  && event_child->stop_expected)
 	{
 	  if (debug_threads)
@@ -746,10 +846,10 @@ linux_wait_for_event (struct thread_info *child)
 	  continue;
 	}
 
-      if (WIFSTOPPED (wstat) && WSTOPSIG (wstat) == SIGTRAP
-	  && wstat >> 16 != 0)
+      if (WIFSTOPPED (*wstatp) && WSTOPSIG (*wstatp) == SIGTRAP
+	  && *wstatp >> 16 != 0)
 	{
-	  handle_extended_wait (event_child, wstat);
+	  handle_extended_wait (event_child, *wstatp);
 	  continue;
 	}
 
@@ -758,26 +858,28 @@ linux_wait_for_event (struct thread_info *child)
 	 inferior right away.  We do this for threading-related
 	 signals as well as any that GDB specifically requested we
 	 ignore.  But never ignore SIGSTOP if we sent it ourselves,
-	 and do not ignore signals when stepping - they may require
-	 special handling to skip the signal handler.  */
+	 either to stop all threads or because GDB asked us to stop
+	 this one, and do not ignore signals when stepping - they may
+	 require special handling to skip the signal handler.  */
       /* FIXME drow/2002-06-09: Get signal numbers from the inferior's
 	 thread library?  */
-      if (WIFSTOPPED (wstat)
+      if (WIFSTOPPED (*wstatp)
 	  && !event_child->stepping
 	  && (
 #ifdef USE_THREAD_DB
-	      (thread_db_active && (WSTOPSIG (wstat) == __SIGRTMIN
-				    || WSTOPSIG (wstat) == __SIGRTMIN + 1))
+	      (thread_db_active && (WSTOPSIG (*wstatp) == __SIGRTMIN
+				    || WSTOPSIG (*wstatp) == __SIGRTMIN + 1))
 	      ||
 #endif
-	      (pass_signals[target_signal_from_host (WSTOPSIG (wstat))]
-	       && (WSTOPSIG (wstat) != SIGSTOP || !stopping_threads))))
+	      (pass_signals[target_signal_from_host (WSTOPSIG (*wstatp))]
+	       && (WSTOPSIG (*wstatp) != SIGSTOP
+		   || (!stopping_threads && !event_child->stop_requested)))))
 	{
 	  siginfo_t info, *info_p;
 
 	  if (debug_threads)
 	    fprintf (stderr, "Ignored signal %d for LWP %ld.\n",
-		     WSTOPSIG (wstat), event_child->head.id);
+		     WSTOPSIG (*wstatp), event_child->head.id);
 
 	  if (ptrace (PTRACE_GETSIGINFO, event_child->lwpid, 0, &info) == 0)
 	    info_p = &info;
@@ -785,19 +887,19 @@ linux_wait_for_event (struct thread_info *child)
 	    info_p = NULL;
 	  linux_resume_one_process (&event_child->head,
 				    event_child->stepping,
-				    WSTOPSIG (wstat), info_p);
+				    WSTOPSIG (*wstatp), info_p);
 	  continue;
 	}
 
       /* If this event was not handled above, and is not a SIGTRAP, report
 	 it.  */
-      if (!WIFSTOPPED (wstat) || WSTOPSIG (wstat) != SIGTRAP)
-	return wstat;
+      if (!WIFSTOPPED (*wstatp) || WSTOPSIG (*wstatp) != SIGTRAP)
+	return 1;
 
       /* If this target does not support breakpoints, we simply report the
 	 SIGTRAP; it's of no concern to us.  */
       if (the_low_target.get_pc == NULL)
-	return wstat;
+	return 1;
 
       stop_pc = get_stop_pc ();
 
@@ -812,6 +914,17 @@ linux_wait_for_event (struct thread_info *child)
 	  reinsert_breakpoint (event_child->bp_reinsert);
 	  event_child->bp_reinsert = 0;
 
+	  if (event_child == step_over_process)
+	    finish_step_over (1);
+
+	  /* If GDB asked for this step, it is complete.  */
+	  if (event_child->step_after_reinsert)
+	    {
+	      event_child->step_after_reinsert = 0;
+	      event_child->stepping = 0;
+	      return 1;
+	    }
+
 	  /* Clear the single-stepping flag and SIGTRAP as we resume.  */
 	  linux_resume_one_process (&event_child->head, 0, 0, NULL);
 	  continue;
@@ -819,6 +932,18 @@ linux_wait_for_event (struct thread_info *child)
 
       bp_status = check_breakpoints (stop_pc);
 
+      /* If this is a breakpoint of GDB's whose conditions are all
+	 false, step over it as if it were one of ours.  A single-step
+	 which ended at the breakpoint must be reported regardless.  */
+      if (bp_status == 0
+	  && !event_child->stepping
+	  && !gdb_condition_true_at_breakpoint (stop_pc))
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Breakpoint condition is false.\n");
+	  bp_status = 1;
+	}
+
       if (bp_status != 0)
 	{
 	  if (debug_threads)
@@ -847,18 +972,29 @@ linux_wait_for_event (struct thread_info *child)
 
 	     Otherwise, call the target function to figure out where we need
 	     our temporary breakpoint, create it, and continue executing this
-	     process.  */
+	     process.
+
+	     Either way, the other processes are held stopped until the
+	     breakpoint is back, so that none of them can run past it
+	     meanwhile.  GDB's breakpoints whose conditions are false, and
+	     tracepoints, are hit often enough for that to matter.  */
 	  if (bp_status == 2)
-	    /* No need to reinsert.  */
-	    linux_resume_one_process (&event_child->head, 0, 0, NULL);
+	    {
+	      /* No need to reinsert.  */
+	      if (event_child == step_over_process)
+		finish_step_over (1);
+	      linux_resume_one_process (&event_child->head, 0, 0, NULL);
+	    }
 	  else if (the_low_target.breakpoint_reinsert_addr == NULL)
 	    {
+	      start_step_over (event_child);
 	      event_child->bp_reinsert = stop_pc;
 	      uninsert_breakpoint (stop_pc);
 	      linux_resume_one_process (&event_child->head, 1, 0, NULL);
 	    }
 	  else
 	    {
+	      start_step_over (event_child);
 	      reinsert_breakpoint_by_bp
 		(stop_pc, (*the_low_target.breakpoint_reinsert_addr) ());
 	      linux_resume_one_process (&event_child->head, 0, 0, NULL);
@@ -870,6 +1006,11 @@ linux_wait_for_event (struct thread_info *child)
       if (debug_threads)
 	fprintf (stderr, "Hit a non-gdbserver breakpoint.\n");
 
+      /* If we handled a hit of our own breakpoint here before deciding
+	 to report it, don't handle it again when GDB resumes us.  */
+      if (own_breakpoint_inserted_at (stop_pc))
+	event_child->handled_breakpoint = stop_pc;
+
       /* If we were single-stepping, we definitely want to report the
 	 SIGTRAP.  The single-step operation has completed, so also
          clear the stepping flag; in general this does not matter,
@@ -881,8 +1022,26 @@ linux_wait_for_event (struct thread_info *child)
 	 set.  It might be wiser to use a step_completed flag instead.  */
       if (event_child->stepping)
 	{
+	  /* If GDB asked us to step through a range, keep going until
+	     the PC leaves it.  A step which ends at a breakpoint or
+	     triggers a watchpoint must still be reported; stepping on
+	     would execute the breakpoint instruction.  Reads of
+	     inferior memory hide our breakpoints, so ask the
+	     breakpoint list rather than the_low_target.breakpoint_at.  */
+	  if (stop_pc >= event_child->step_range_start
+	      && stop_pc < event_child->step_range_end
+	      && !breakpoint_inserted_at (stop_pc)
+	      && !(the_low_target.stopped_by_watchpoint != NULL
+		   && (*the_low_target.stopped_by_watchpoint) ()))
+	    {
+	      if (debug_threads)
+		fprintf (stderr, "Range stepping at %08lx.\n", (long) stop_pc);
+	      linux_resume_one_process (&event_child->head, 1, 0, NULL);
+	      continue;
+	    }
+
 	  event_child->stepping = 0;
-	  return wstat;
+	  return 1;
 	}
 
       /* A SIGTRAP that we can't explain.  It may have been a breakpoint.
@@ -899,13 +1058,22 @@ linux_wait_for_event (struct thread_info *child)
 	  event_child->pending_stop_pc = stop_pc;
 	}
 
-      return wstat;
+      return 1;
     }
 
   /* NOTREACHED */
   return 0;
 }
 
+static int
+linux_wait_for_event (struct thread_info *child)
+{
+  int wstat;
+
+  linux_wait_for_event_1 (child, &wstat, 0);
+  return wstat;
+}
+
 /* Wait for process, returns status.  */
 
 static unsigned char
@@ -913,6 +1081,12 @@ linux_wait (char *status)
 {
   int w;
   struct thread_info *child = NULL;
+  struct process_info *event_child;
+  unsigned char sig;
+
+  /* Anything which happens from now on marks the event pipe again.  */
+  if (non_stop)
+    async_file_flush ();
 
 retry:
   /* If we were only supposed to resume one thread, only wait for
@@ -921,7 +1095,7 @@ retry:
      then we need to make sure we restart the other threads.  We could
      pick a thread at random or restart all; restarting all is less
      arbitrary.  */
-  if (cont_thread != 0 && cont_thread != -1)
+  if (!non_stop && cont_thread != 0 && cont_thread != -1)
     {
       child = (struct thread_info *) find_inferior_id (&all_threads,
 						       cont_thread);
@@ -932,12 +1106,32 @@ retry:
 	  struct thread_resume resume_info;
 	  resume_info.thread = -1;
 	  resume_info.step = resume_info.sig = resume_info.leave_stopped = 0;
+	  resume_info.stop = 0;
+	  resume_info.step_range_start = resume_info.step_range_end = 0;
 	  linux_resume (&resume_info);
 	}
     }
 
-  w = linux_wait_for_event (child);
-  stop_all_processes ();
+  /* In non-stop mode, the other threads keep running, and we only
+     collect the events which have already happened.  */
+  if (non_stop)
+    {
+      if (!linux_wait_for_event_1 (NULL, &w, WNOHANG))
+	{
+	  *status = '\0';
+	  return 0;
+	}
+    }
+  else
+    {
+      w = linux_wait_for_event (child);
+      stop_all_processes ();
+    }
+
+  /* If a process stepping over a breakpoint stopped for some other
+     reason, and that is what we report, stop holding the others.  In
+     all-stop mode, they are all stopped now anyway.  */
+  finish_step_over (non_stop);
 
   if (must_set_ptrace_flags)
     {
@@ -985,7 +1179,23 @@ retry:
     }
 
   *status = 'T';
-  return target_signal_from_host (WSTOPSIG (w));
+  sig = target_signal_from_host (WSTOPSIG (w));
+
+  /* If GDB asked us to stop this thread, report our SIGSTOP the way
+     an interrupt is reported.  If the thread stopped for another
+     reason first, that satisfies the request; discard the SIGSTOP
+     when it arrives.  */
+  event_child = get_thread_process (current_inferior);
+  if (event_child->stop_requested)
+    {
+      event_child->stop_requested = 0;
+      if (WSTOPSIG (w) == SIGSTOP)
+	sig = TARGET_SIGNAL_INT;
+      else
+	event_child->stop_expected = 1;
+    }
+
+  return sig;
 }
 
 /* Send a signal to an LWP.  For LinuxThreads, kill is enough; however, if
@@ -1093,6 +1303,98 @@ stop_all_processes (void)
   stopping_threads = 0;
 }
 
+static int
+hold_for_step_over (struct inferior_list_entry *entry, void *stepping)
+{
+  struct process_info *process = (struct process_info *) entry;
+
+  if (process != stepping && !process->stopped)
+    process->held_for_step_over = 1;
+
+  return 0;
+}
+
+/* Stop all the running processes but PROCESS, which is about to step
+   over the breakpoint at its pc with the breakpoint removed, and keep
+   any of them from being resumed until finish_step_over.  */
+
+static void
+start_step_over (struct process_info *process)
+{
+  /* If we are already stopping everything, or already stepping over
+     a breakpoint, the others are stopped or about to be.  */
+  if (stopping_threads || step_over_process != NULL)
+    return;
+
+  if (debug_threads)
+    fprintf (stderr, "Holding other processes while %ld steps.\n",
+	     process->lwpid);
+
+  find_inferior (&all_processes, hold_for_step_over, process);
+  stop_all_processes ();
+  step_over_process = process;
+}
+
+static int resume_held_processes;
+
+static void
+release_from_step_over (struct inferior_list_entry *entry)
+{
+  struct process_info *process = (struct process_info *) entry;
+
+  if (!process->held_for_step_over)
+    return;
+
+  process->held_for_step_over = 0;
+  if (resume_held_processes)
+    linux_resume_one_process (entry, process->stepping, 0, NULL);
+}
+
+/* The step over a breakpoint is done, or has been given up.  If
+   RESUME, resume the processes start_step_over stopped; otherwise
+   leave them stopped, for whoever stops everything anyway.  */
+
+static void
+finish_step_over (int resume)
+{
+  if (step_over_process == NULL)
+    return;
+
+  if (debug_threads)
+    fprintf (stderr, "Releasing processes held while %ld stepped.\n",
+	     step_over_process->lwpid);
+
+  step_over_process = NULL;
+  resume_held_processes = resume;
+  for_each_inferior (&all_processes, release_from_step_over);
+
+  /* In non-stop mode, no SIGCHLD will tell the main loop about the
+     status of a process which stopped for a reason of its own before
+     we held it.  */
+  if (non_stop
+      && find_inferior (&all_processes, status_pending_p, NULL) != NULL)
+    async_file_mark ();
+}
+
+/* Queue SIGNAL (with siginfo INFO, if non-NULL) for delivery to
+   PROCESS the next time it is resumed.  */
+
+static void
+enqueue_pending_signal (struct process_info *process, int signal,
+			siginfo_t *info)
+{
+  struct pending_signals *p_sig;
+
+  p_sig = malloc (sizeof (*p_sig));
+  p_sig->prev = process->pending_signals;
+  p_sig->signal = signal;
+  if (info == NULL)
+    memset (&p_sig->info, 0, sizeof (siginfo_t));
+  else
+    memcpy (&p_sig->info, info, sizeof (siginfo_t));
+  process->pending_signals = p_sig;
+}
+
 /* Resume execution of the inferior process.
    If STEP is nonzero, single-step it.
    If SIGNAL is nonzero, give it that signal.  */
@@ -1107,6 +1409,17 @@ linux_resume_one_process (struct inferior_list_entry *entry,
   if (process->stopped == 0)
     return;
 
+  /* While another process steps over a breakpoint, keep this one
+     stopped; finish_step_over resumes it as asked here.  */
+  if (step_over_process != NULL && process != step_over_process)
+    {
+      if (signal != 0)
+	enqueue_pending_signal (process, signal, info);
+      process->stepping = step;
+      process->held_for_step_over = 1;
+      return;
+    }
+
   /* If we have pending signals or status, and a new signal, enqueue the
      signal.  Also enqueue the signal if we are waiting to reinsert a
      breakpoint; it will be picked up again below.  */
@@ -1114,15 +1427,8 @@ linux_resume_one_process (struct inferior_list_entry *entry,
       && (process->status_pending_p || process->pending_signals != NULL
 	  || process->bp_reinsert != 0))
     {
-      struct pending_signals *p_sig;
-      p_sig = malloc (sizeof (*p_sig));
-      p_sig->prev = process->pending_signals;
-      p_sig->signal = signal;
-      if (info == NULL)
-	memset (&p_sig->info, 0, sizeof (siginfo_t));
-      else
-	memcpy (&p_sig->info, info, sizeof (siginfo_t));
-      process->pending_signals = p_sig;
+      enqueue_pending_signal (process, signal, info);
+      signal = 0;
     }
 
   if (process->status_pending_p && !check_removed_breakpoint (process))
@@ -1131,6 +1437,43 @@ linux_resume_one_process (struct inferior_list_entry *entry,
   saved_inferior = current_inferior;
   current_inferior = get_process_thread (process);
 
+  /* If we reported a stop at one of our own breakpoints (because GDB
+     has a breakpoint there too), its handler has already run.  Step
+     over it before resuming, or we would run the handler again for
+     the same hit -- or, for a single-step, execute the breakpoint
+     instruction itself.  */
+  if (process->handled_breakpoint != 0)
+    {
+      CORE_ADDR pc = process->handled_breakpoint;
+
+      process->handled_breakpoint = 0;
+      if (process->bp_reinsert == 0
+	  && (*the_low_target.get_pc) () == pc
+	  && own_breakpoint_inserted_at (pc))
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Stepping over handled breakpoint at %08lx\n",
+		     (long) pc);
+
+	  if (signal != 0)
+	    {
+	      enqueue_pending_signal (process, signal, info);
+	      signal = 0;
+	    }
+
+	  if (the_low_target.breakpoint_reinsert_addr == NULL)
+	    {
+	      process->bp_reinsert = pc;
+	      process->step_after_reinsert = step;
+	      uninsert_breakpoint (pc);
+	      step = 1;
+	    }
+	  else
+	    reinsert_breakpoint_by_bp
+	      (pc, (*the_low_target.breakpoint_reinsert_addr) ());
+	}
+    }
+
   if (debug_threads)
     fprintf (stderr, "Resuming process %ld (%s, signal %d, stop %s)\n", inferior_pid,
 	     step ? "step" : "continue", signal,
@@ -1220,6 +1563,8 @@ linux_set_resume_request (struct inferior_list_entry *entry)
     ndx++;
 
   process->resume = &resume_ptr[ndx];
+  process->step_range_start = process->resume->step_range_start;
+  process->step_range_end = process->resume->step_range_end;
 }
 
 /* This function is called once per thread.  We check the thread's resume
@@ -1301,7 +1646,7 @@ resume_status_pending_p (struct inferior_list_entry *entry, void *flag_p)
 
   /* Processes which will not be resumed are not interesting, because
      we might not wait for them next time through linux_wait.  */
-  if (process->resume->leave_stopped)
+  if (process->resume->leave_stopped || process->resume->stop)
     return 0;
 
   /* If this thread has a removed breakpoint, we won't have any
@@ -1321,6 +1666,97 @@ resume_status_pending_p (struct inferior_list_entry *entry, void *flag_p)
   return 0;
 }
 
+/* Return non-zero if this process is about to be resumed, and will
+   step over a breakpoint of ours when it is: either one which was
+   removed for it already, or one whose handler has run for it.  */
+
+static int
+resume_needs_step_over_p (struct inferior_list_entry *entry, void *dummy)
+{
+  struct process_info *process = (struct process_info *) entry;
+  struct thread_info *saved_inferior;
+  CORE_ADDR pc;
+
+  if (!process->stopped
+      || process->status_pending_p
+      || process->resume->leave_stopped
+      || process->resume->stop)
+    return 0;
+
+  if (process->bp_reinsert != 0)
+    return 1;
+
+  if (process->handled_breakpoint == 0
+      || !own_breakpoint_inserted_at (process->handled_breakpoint))
+    return 0;
+
+  saved_inferior = current_inferior;
+  current_inferior = get_process_thread (process);
+  pc = (*the_low_target.get_pc) ();
+  current_inferior = saved_inferior;
+
+  return pc == process->handled_breakpoint;
+}
+
+/* If one of the processes about to be resumed stopped half way
+   through stepping over a breakpoint, let it finish that before any
+   other runs, so that none of them can run past the breakpoint.  */
+
+static void
+start_resume_step_over (void)
+{
+  struct process_info *process;
+
+  if (step_over_process != NULL)
+    return;
+
+  process = (struct process_info *)
+    find_inferior (&all_processes, resume_needs_step_over_p, NULL);
+  if (process != NULL)
+    start_step_over (process);
+}
+
+/* This function is called once per thread in non-stop mode, where
+   each thread is resumed or stopped independently of the others.  A
+   thread which has a status pending is not resumed; the status is
+   reported instead.  */
+
+static void
+linux_resume_one_thread (struct inferior_list_entry *entry)
+{
+  struct thread_info *thread = (struct thread_info *) entry;
+  struct process_info *process = get_thread_process (thread);
+
+  if (process->resume->leave_stopped)
+    return;
+
+  if (process->resume->stop)
+    {
+      if (!process->stopped && !process->stop_requested)
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Stopping process %ld\n", process->lwpid);
+
+	  process->stop_requested = 1;
+
+	  /* If a SIGSTOP is already on its way, report that one
+	     instead of discarding it.  */
+	  if (process->stop_expected)
+	    process->stop_expected = 0;
+	  else
+	    kill_lwp (process->lwpid, SIGSTOP);
+	}
+
+      process->resume = NULL;
+      return;
+    }
+
+  if (process->status_pending_p)
+    linux_queue_one_thread (entry);
+  else
+    linux_continue_one_thread (entry);
+}
+
 static void
 linux_resume (struct thread_resume *resume_info)
 {
@@ -1331,6 +1767,19 @@ linux_resume (struct thread_resume *resume_info)
 
   for_each_inferior (&all_threads, linux_set_resume_request);
 
+  if (non_stop)
+    {
+      pending_flag = 0;
+      find_inferior (&all_processes, resume_status_pending_p, &pending_flag);
+      start_resume_step_over ();
+      for_each_inferior (&all_threads, linux_resume_one_thread);
+
+      /* No SIGCHLD will tell the main loop about a pending status.  */
+      if (pending_flag)
+	async_file_mark ();
+      return;
+    }
+
   /* If there is a thread which would otherwise be resumed, which
      has a pending status, then don't resume any threads - we can just
      report the pending status.  Make sure to queue any signals
@@ -1349,7 +1798,10 @@ linux_resume (struct thread_resume *resume_info)
   if (pending_flag)
     for_each_inferior (&all_threads, linux_queue_one_thread);
   else
-    for_each_inferior (&all_threads, linux_continue_one_thread);
+    {
+      start_resume_step_over ();
+      for_each_inferior (&all_threads, linux_continue_one_thread);
+    }
 }
 
 #ifdef HAVE_LINUX_USRREGS
@@ -1623,6 +2075,37 @@ linux_store_registers (int regno)
 }
 
 
+static int
+stopped_process_p (struct inferior_list_entry *entry, void *dummy)
+{
+  struct process_info *process = (struct process_info *) entry;
+
+  return process->stopped;
+}
+
+/* Return the process to access memory through.  In non-stop mode the
+   current thread may be running, and ptrace only works on stopped
+   threads; any other stopped thread shares its address space.  */
+
+static struct process_info *
+memory_access_process (void)
+{
+  struct process_info *process = get_thread_process (current_inferior);
+
+  if (!process->stopped)
+    {
+      struct process_info *stopped;
+
+      stopped = (struct process_info *) find_inferior (&all_processes,
+						       stopped_process_p,
+						       NULL);
+      if (stopped != NULL)
+	return stopped;
+    }
+
+  return process;
+}
+
 /* Copy LEN bytes from inferior's memory starting at MEMADDR
    to debugger memory starting at MYADDR.  */
 
@@ -1641,13 +2124,15 @@ linux_read_memory (CORE_ADDR memaddr, unsigned char *myaddr, int len)
     = (PTRACE_XFER_TYPE *) alloca (count * sizeof (PTRACE_XFER_TYPE));
   int fd;
   char filename[64];
+  struct process_info *process = memory_access_process ();
 
-  /* Try using /proc.  Don't bother for one word.  */
-  if (len >= 3 * sizeof (long))
+  /* Try using /proc.  Don't bother for one word, unless every thread
+     is running; ptrace can not read through a running thread.  */
+  if (len >= 3 * sizeof (long) || !process->stopped)
     {
       /* We could keep this file open and cache it - possibly one per
 	 thread.  That requires some juggling, but is even faster.  */
-      sprintf (filename, "/proc/%ld/mem", inferior_pid);
+      sprintf (filename, "/proc/%ld/mem", pid_of (process));
       fd = open (filename, O_RDONLY | O_LARGEFILE);
       if (fd == -1)
 	goto no_proc;
@@ -1675,7 +2160,8 @@ linux_read_memory (CORE_ADDR memaddr, unsigned char *myaddr, int len)
   for (i = 0; i < count; i++, addr += sizeof (PTRACE_XFER_TYPE))
     {
       errno = 0;
-      buffer[i] = ptrace (PTRACE_PEEKTEXT, inferior_pid, (PTRACE_ARG3_TYPE) addr, 0);
+      buffer[i] = ptrace (PTRACE_PEEKTEXT, pid_of (process),
+			  (PTRACE_ARG3_TYPE) addr, 0);
       if (errno)
 	return errno;
     }
@@ -1702,21 +2188,44 @@ linux_write_memory (CORE_ADDR memaddr, const unsigned char *myaddr, int len)
   = (((memaddr + len) - addr) + sizeof (PTRACE_XFER_TYPE) - 1) / sizeof (PTRACE_XFER_TYPE);
   /* Allocate buffer of that many longwords.  */
   register PTRACE_XFER_TYPE *buffer = (PTRACE_XFER_TYPE *) alloca (count * sizeof (PTRACE_XFER_TYPE));
+  struct process_info *process = memory_access_process ();
+  long pid = pid_of (process);
 
   if (debug_threads)
     {
       fprintf (stderr, "Writing %02x to %08lx\n", (unsigned)myaddr[0], (long)memaddr);
     }
 
+  /* If every thread is running, ptrace can not write through any of
+     them; try /proc instead.  */
+  if (!process->stopped)
+    {
+      char filename[64];
+      int fd, ret;
+
+      sprintf (filename, "/proc/%ld/mem", pid);
+      fd = open (filename, O_WRONLY | O_LARGEFILE);
+      if (fd == -1)
+	return errno;
+#ifdef HAVE_PREAD64
+      ret = (pwrite64 (fd, myaddr, len, memaddr) == len);
+#else
+      ret = (lseek (fd, memaddr, SEEK_SET) != -1
+	     && write (fd, myaddr, len) == len);
+#endif
+      close (fd);
+      return ret ? 0 : EIO;
+    }
+
   /* Fill start and end extra bytes of buffer with existing memory data.  */
 
-  buffer[0] = ptrace (PTRACE_PEEKTEXT, inferior_pid,
+  buffer[0] = ptrace (PTRACE_PEEKTEXT, pid,
 		      (PTRACE_ARG3_TYPE) addr, 0);
 
   if (count > 1)
     {
       buffer[count - 1]
-	= ptrace (PTRACE_PEEKTEXT, inferior_pid,
+	= ptrace (PTRACE_PEEKTEXT, pid,
 		  (PTRACE_ARG3_TYPE) (addr + (count - 1)
 				      * sizeof (PTRACE_XFER_TYPE)),
 		  0);
@@ -1731,7 +2240,7 @@ linux_write_memory (CORE_ADDR memaddr, const unsigned char *myaddr, int len)
   for (i = 0; i < count; i++, addr += sizeof (PTRACE_XFER_TYPE))
     {
       errno = 0;
-      ptrace (PTRACE_POKETEXT, inferior_pid, (PTRACE_ARG3_TYPE) addr, buffer[i]);
+      ptrace (PTRACE_POKETEXT, pid, (PTRACE_ARG3_TYPE) addr, buffer[i]);
       if (errno)
 	return errno;
     }
@@ -2012,6 +2521,90 @@ linux_read_offsets (CORE_ADDR *text_p, CORE_ADDR *data_p)
 }
 #endif
 
+static int
+linux_supports_conditional_breakpoints (void)
+{
+  /* linux_wait_for_event checks the conditions of GDB's breakpoints,
+     when we can insert them at all.  */
+  return the_low_target.breakpoint != NULL;
+}
+
+static CORE_ADDR
+linux_read_pc (void)
+{
+  return (*the_low_target.get_pc) ();
+}
+
+static void
+linux_write_pc (CORE_ADDR pc)
+{
+  (*the_low_target.set_pc) (pc);
+}
+
+static struct emit_ops *
+linux_emit_ops (void)
+{
+  return the_low_target.emit_ops;
+}
+
+static int
+linux_supports_range_stepping (void)
+{
+  /* linux_wait_for_event needs to find the PC and breakpoints, as
+     for conditional breakpoints.  */
+  return the_low_target.get_pc != NULL && the_low_target.breakpoint_at != NULL;
+}
+
+static int
+linux_start_non_stop (int nonstop)
+{
+  if (nonstop)
+    {
+      if (linux_event_pipe[0] == -1)
+	{
+	  if (pipe (linux_event_pipe) == -1)
+	    return -1;
+
+	  fcntl (linux_event_pipe[0], F_SETFL, O_NONBLOCK);
+	  fcntl (linux_event_pipe[1], F_SETFL, O_NONBLOCK);
+	}
+
+      signal (SIGCHLD, sigchld_handler);
+
+      /* Some events may have happened already.  */
+      async_file_mark ();
+    }
+  else
+    {
+      signal (SIGCHLD, SIG_DFL);
+
+      /* Going back to all-stop, everything must be stopped.  */
+      if (all_threads.head != NULL)
+	stop_all_processes ();
+
+      if (linux_event_pipe[0] != -1)
+	{
+	  close (linux_event_pipe[0]);
+	  close (linux_event_pipe[1]);
+	  linux_event_pipe[0] = linux_event_pipe[1] = -1;
+	}
+    }
+
+  return 0;
+}
+
+static int
+linux_event_fd (void)
+{
+  return linux_event_pipe[0];
+}
+
+static int
+linux_thread_stopped (struct thread_info *thread)
+{
+  return get_thread_process (thread)->stopped;
+}
+
 static struct target_ops linux_target_ops = {
   linux_create_inferior,
   linux_attach,
@@ -2044,6 +2637,14 @@ static struct target_ops linux_target_ops = {
 #endif
   NULL,
   hostio_last_error_from_errno,
+  linux_supports_conditional_breakpoints,
+  linux_read_pc,
+  linux_write_pc,
+  linux_emit_ops,
+  linux_supports_range_stepping,
+  linux_start_non_stop,
+  linux_event_fd,
+  linux_thread_stopped,
 };
 
 static void
@@ -2058,6 +2659,11 @@ void
 initialize_low (void)
 {
   thread_db_active = 0;
+  if (the_low_target.get_pc == NULL || the_low_target.set_pc == NULL)
+    {
+      linux_target_ops.read_pc = NULL;
+      linux_target_ops.write_pc = NULL;
+    }
   set_target_ops (&linux_target_ops);
   set_breakpoint_data (the_low_target.breakpoint,
 		       the_low_target.breakpoint_len);
@@ -73,6 +73,10 @@ struct linux_target_ops
      for registers smaller than an xfer unit).  */
   void (*collect_ptrace_register) (int regno, char *buf);
   void (*supply_ptrace_register) (int regno, const char *buf);
+
+  /* The code generator for agent expressions, or NULL.  Since
+     gdbserver runs on the target, this generates code for it.  */
+  struct emit_ops *emit_ops;
 };
 
 extern struct linux_target_ops the_low_target;
@@ -100,6 +104,10 @@ struct process_info
      event already received in a wait()).  */
   int stopped;
 
+  /* If this flag is set, GDB asked us to stop this process in non-stop
+     mode, and we sent it a SIGSTOP which we must report.  */
+  int stop_requested;
+
   /* When stopped is set, the last wait status recorded for this process.  */
   int last_status;
 
@@ -116,10 +124,28 @@ struct process_info
      stop (SIGTRAP stops only).  */
   CORE_ADDR bp_reinsert;
 
+  /* If this is non-zero, we reported a stop at one of our own
+     breakpoints, whose handler has already run for this hit.  */
+  CORE_ADDR handled_breakpoint;
+
+  /* If this flag is set, we are stepping over one of our breakpoints
+     on the way to carrying out a single-step GDB asked for; the step
+     is done once the breakpoint is reinserted.  */
+  int step_after_reinsert;
+
   /* If this flag is set, the last continue operation on this process
      was a single-step.  */
   int stepping;
 
+  /* If this flag is set, we stopped this process while another one
+     steps over a breakpoint, and must resume it once that is done.  */
+  int held_for_step_over;
+
+  /* If STEP_RANGE_END is non-zero, GDB asked us to step this process
+     until its PC leaves [STEP_RANGE_START, STEP_RANGE_END).  */
+  CORE_ADDR step_range_start;
+  CORE_ADDR step_range_end;
+
   /* If this is non-zero, it points to a chain of signals which need to
      be delivered to this process.  */
   struct pending_signals *pending_signals;
@@ -162,6 +162,351 @@ x86_64_breakpoint_at (CORE_ADDR pc)
   return 0;
 }
 
+/* Compiling agent expressions.  The top of the stack is kept in
+   %rax, and the values below it are pushed on the machine stack.
+   %rbx holds the stack pointer around calls to helpers, which must
+   be made with the stack aligned.  */
+
+#define EMIT_INSNS(code, insns) \
+  ax_emit_bytes ((code), (insns), sizeof (insns))
+
+static void
+x86_64_emit_prologue (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x55,				/* push %rbp */
+    0x48, 0x89, 0xe5,			/* mov %rsp,%rbp */
+    0x53				/* push %rbx */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_epilogue (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x8b, 0x5d, 0xf8,		/* mov -0x8(%rbp),%rbx */
+    0xc9,				/* leave */
+    0xc3				/* ret */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_add (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x03, 0x04, 0x24,		/* add (%rsp),%rax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_sub (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x29, 0x04, 0x24,		/* sub %rax,(%rsp) */
+    0x58				/* pop %rax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_mul (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x0f, 0xaf, 0x04, 0x24,	/* imul (%rsp),%rax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_bit_and (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x23, 0x04, 0x24,		/* and (%rsp),%rax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_bit_or (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x0b, 0x04, 0x24,		/* or (%rsp),%rax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_bit_xor (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x33, 0x04, 0x24,		/* xor (%rsp),%rax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+/* Compare the value below the top with the top, and replace both
+   with the flag the SETCC opcode byte tests.  */
+
+static void
+x86_64_emit_compare (struct ax_code *code, unsigned char setcc)
+{
+  unsigned char insns[] = {
+    0x48, 0x39, 0x04, 0x24,		/* cmp %rax,(%rsp) */
+    0x0f, 0, 0xc0,			/* setCC %al */
+    0x0f, 0xb6, 0xc0,			/* movzbl %al,%eax */
+    0x48, 0x8d, 0x64, 0x24, 0x08	/* lea 0x8(%rsp),%rsp */
+  };
+  insns[5] = setcc;
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_equal (struct ax_code *code)
+{
+  x86_64_emit_compare (code, 0x94);	/* sete */
+}
+
+static void
+x86_64_emit_less_signed (struct ax_code *code)
+{
+  x86_64_emit_compare (code, 0x9c);	/* setl */
+}
+
+static void
+x86_64_emit_less_unsigned (struct ax_code *code)
+{
+  x86_64_emit_compare (code, 0x92);	/* setb */
+}
+
+static void
+x86_64_emit_log_not (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x85, 0xc0,			/* test %rax,%rax */
+    0x0f, 0x94, 0xc0,			/* sete %al */
+    0x0f, 0xb6, 0xc0			/* movzbl %al,%eax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_bit_not (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0xf7, 0xd0			/* not %rax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_ext (struct ax_code *code, int arg)
+{
+  unsigned char insns[] = {
+    0x48, 0xc1, 0xe0, 0,		/* shl $(64 - ARG),%rax */
+    0x48, 0xc1, 0xf8, 0			/* sar $(64 - ARG),%rax */
+  };
+  insns[3] = insns[7] = 64 - arg;
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_zero_ext (struct ax_code *code, int arg)
+{
+  if (arg == 0)
+    {
+      static const unsigned char insns[] = {
+	0x31, 0xc0			/* xor %eax,%eax */
+      };
+      EMIT_INSNS (code, insns);
+    }
+  else if (arg == 32)
+    {
+      static const unsigned char insns[] = {
+	0x89, 0xc0			/* mov %eax,%eax */
+      };
+      EMIT_INSNS (code, insns);
+    }
+  else
+    {
+      unsigned char insns[] = {
+	0x48, 0xc1, 0xe0, 0,		/* shl $(64 - ARG),%rax */
+	0x48, 0xc1, 0xe8, 0		/* shr $(64 - ARG),%rax */
+      };
+      insns[3] = insns[7] = 64 - arg;
+      EMIT_INSNS (code, insns);
+    }
+}
+
+static void
+x86_64_emit_const (struct ax_code *code, LONGEST num)
+{
+  unsigned char insns[10];
+  int len;
+
+  if (num >= 0 && num <= 0xffffffffLL)
+    {
+      insns[0] = 0xb8;			/* mov $NUM,%eax */
+      len = 1;
+    }
+  else if (num >= -0x80000000LL && num < 0)
+    {
+      insns[0] = 0x48;			/* mov $NUM,%rax */
+      insns[1] = 0xc7;
+      insns[2] = 0xc0;
+      len = 3;
+    }
+  else
+    {
+      insns[0] = 0x48;			/* movabs $NUM,%rax */
+      insns[1] = 0xb8;
+      memcpy (insns + 2, &num, 8);
+      ax_emit_bytes (code, insns, 10);
+      return;
+    }
+
+  memcpy (insns + len, &num, 4);
+  ax_emit_bytes (code, insns, len + 4);
+}
+
+static void
+x86_64_emit_stack_flush (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x50				/* push %rax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_pop (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x58				/* pop %rax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_swap (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x8b, 0x14, 0x24,		/* mov (%rsp),%rdx */
+    0x48, 0x89, 0x04, 0x24,		/* mov %rax,(%rsp) */
+    0x48, 0x89, 0xd0			/* mov %rdx,%rax */
+  };
+  EMIT_INSNS (code, insns);
+}
+
+static int
+x86_64_emit_if_goto (struct ax_code *code, int pop)
+{
+  static const unsigned char test[] = {
+    0x48, 0x85, 0xc0			/* test %rax,%rax */
+  };
+  static const unsigned char jne[] = {
+    0x0f, 0x85, 0, 0, 0, 0		/* jne <target> */
+  };
+
+  EMIT_INSNS (code, test);
+  if (pop)
+    x86_64_emit_pop (code);
+  EMIT_INSNS (code, jne);
+  return code->len - 4;
+}
+
+static int
+x86_64_emit_goto (struct ax_code *code)
+{
+  static const unsigned char insns[] = {
+    0xe9, 0, 0, 0, 0			/* jmp <target> */
+  };
+  EMIT_INSNS (code, insns);
+  return code->len - 4;
+}
+
+static void
+x86_64_emit_goto_address (struct ax_code *code, int from, int to)
+{
+  int rel = to - (from + 4);
+
+  memcpy (code->buf + from, &rel, 4);
+}
+
+/* Call FN, whose arguments are already in place, with the stack
+   aligned.  FN's result is left in %rax.  */
+
+static void
+x86_64_emit_call (struct ax_code *code, void *fn)
+{
+  unsigned char insns[] = {
+    0x48, 0x89, 0xe3,			/* mov %rsp,%rbx */
+    0x48, 0x83, 0xe4, 0xf0,		/* and $-16,%rsp */
+    0x48, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0,	/* movabs $FN,%rax */
+    0xff, 0xd0,				/* call *%rax */
+    0x48, 0x89, 0xdc			/* mov %rbx,%rsp */
+  };
+  memcpy (insns + 9, &fn, 8);
+  EMIT_INSNS (code, insns);
+}
+
+static void
+x86_64_emit_call1 (struct ax_code *code, ax_helper1 fn)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x89, 0xc7			/* mov %rax,%rdi */
+  };
+  EMIT_INSNS (code, insns);
+  x86_64_emit_call (code, (void *) fn);
+}
+
+static void
+x86_64_emit_call2 (struct ax_code *code, ax_helper2 fn)
+{
+  static const unsigned char insns[] = {
+    0x48, 0x89, 0xc6,			/* mov %rax,%rsi */
+    0x5f				/* pop %rdi */
+  };
+  EMIT_INSNS (code, insns);
+  x86_64_emit_call (code, (void *) fn);
+}
+
+#undef EMIT_INSNS
+
+static struct emit_ops x86_64_emit_ops = {
+  x86_64_emit_prologue,
+  x86_64_emit_epilogue,
+  x86_64_emit_add,
+  x86_64_emit_sub,
+  x86_64_emit_mul,
+  x86_64_emit_bit_and,
+  x86_64_emit_bit_or,
+  x86_64_emit_bit_xor,
+  x86_64_emit_equal,
+  x86_64_emit_less_signed,
+  x86_64_emit_less_unsigned,
+  x86_64_emit_log_not,
+  x86_64_emit_bit_not,
+  x86_64_emit_ext,
+  x86_64_emit_zero_ext,
+  x86_64_emit_const,
+  x86_64_emit_stack_flush,
+  x86_64_emit_pop,
+  x86_64_emit_swap,
+  x86_64_emit_if_goto,
+  x86_64_emit_goto,
+  x86_64_emit_goto_address,
+  x86_64_emit_call1,
+  x86_64_emit_call2
+};
+
 struct linux_target_ops the_low_target = {
   init_registers_x86_64_linux,
   -1,
@@ -181,4 +526,5 @@ struct linux_target_ops the_low_target = {
   NULL,
   NULL,
   NULL,
+  &x86_64_emit_ops
 };
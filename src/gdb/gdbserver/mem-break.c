@@ -25,9 +25,22 @@ int breakpoint_len;
 
 #define MAX_BREAKPOINT_LEN 8
 
+/* A condition GDB asked us to evaluate when a breakpoint is hit.  */
+
+struct point_cond_list
+{
+  struct point_cond_list *next;
+  struct agent_expr *cond;
+};
+
 struct breakpoint
 {
   struct breakpoint *next;
+  struct breakpoint *prev;
+
+  /* The next breakpoint in the same bucket of breakpoint_hash.  */
+  struct breakpoint *hash_next;
+
   CORE_ADDR pc;
   unsigned char old_data[MAX_BREAKPOINT_LEN];
 
@@ -41,19 +54,41 @@ struct breakpoint
 
   /* Function to call when we hit this breakpoint.  If it returns 1,
      the breakpoint will be deleted; 0, it will be reinserted for
-     another round.  */
+     another round.  NULL if only GDB wants a breakpoint here.  */
   int (*handler) (CORE_ADDR);
+
+  /* Non-zero if GDB inserted a breakpoint at this address.  Hits are
+     reported to GDB (after calling HANDLER, if there is one).  */
+  int gdb_breakpoint;
+
+  /* For breakpoints inserted by GDB, the conditions GDB sent along
+     with the breakpoint.  The breakpoint is only reported if one of
+     them is true, or if there are none.  */
+  struct point_cond_list *cond_list;
 };
 
 struct breakpoint *breakpoints;
 
-void
-set_breakpoint_at (CORE_ADDR where, int (*handler) (CORE_ADDR))
+/* The same breakpoints, hashed by address, so that GDB can insert
+   and remove thousands of them on each resume without a search
+   through the whole list for each one.  */
+
+#define BREAKPOINT_HASH_SIZE 1024
+
+static struct breakpoint *breakpoint_hash[BREAKPOINT_HASH_SIZE];
+
+static struct breakpoint **
+breakpoint_hash_bucket (CORE_ADDR where)
 {
-  struct breakpoint *bp;
+  return &breakpoint_hash[(where ^ (where >> 10)) % BREAKPOINT_HASH_SIZE];
+}
 
-  if (breakpoint_data == NULL)
-    error ("Target does not support breakpoints.");
+static struct breakpoint *find_breakpoint_at (CORE_ADDR where);
+
+static struct breakpoint *
+insert_new_breakpoint (CORE_ADDR where, int (*handler) (CORE_ADDR))
+{
+  struct breakpoint *bp, **bucket;
 
   bp = malloc (sizeof (struct breakpoint));
   memset (bp, 0, sizeof (struct breakpoint));
@@ -67,48 +102,102 @@ set_breakpoint_at (CORE_ADDR where, int (*handler) (CORE_ADDR))
   bp->handler = handler;
 
   bp->next = breakpoints;
+  if (breakpoints != NULL)
+    breakpoints->prev = bp;
   breakpoints = bp;
+
+  bucket = breakpoint_hash_bucket (where);
+  bp->hash_next = *bucket;
+  *bucket = bp;
+  return bp;
 }
 
-static void
-delete_breakpoint (struct breakpoint *bp)
+void
+set_breakpoint_at (CORE_ADDR where, int (*handler) (CORE_ADDR))
 {
-  struct breakpoint *cur;
+  struct breakpoint *bp;
+
+  if (breakpoint_data == NULL)
+    error ("Target does not support breakpoints.");
 
-  if (breakpoints == bp)
+  /* Share a breakpoint GDB already inserted here, rather than
+     inserting a second one on top of it.  */
+  bp = find_breakpoint_at (where);
+  if (bp != NULL && bp->handler == NULL)
     {
-      breakpoints = bp->next;
-      (*the_target->write_memory) (bp->pc, bp->old_data,
-				   breakpoint_len);
-      free (bp);
+      bp->handler = handler;
       return;
     }
-  cur = breakpoints;
-  while (cur->next)
+
+  insert_new_breakpoint (where, handler);
+}
+
+static void
+clear_breakpoint_conditions (struct breakpoint *bp)
+{
+  while (bp->cond_list != NULL)
     {
-      if (cur->next == bp)
-	{
-	  cur->next = bp->next;
-	  (*the_target->write_memory) (bp->pc, bp->old_data,
-				       breakpoint_len);
-	  free (bp);
-	  return;
-	}
+      struct point_cond_list *cond = bp->cond_list;
+
+      bp->cond_list = cond->next;
+      free_agent_expr (cond->cond);
+      free (cond);
     }
-  warning ("Could not find breakpoint in list.");
 }
 
-static struct breakpoint *
-find_breakpoint_at (CORE_ADDR where)
+static void
+free_breakpoint (struct breakpoint *bp)
 {
-  struct breakpoint *bp = breakpoints;
+  struct breakpoint *cur;
+
+  /* A breakpoint we were stepping over may be deleted by GDB before
+     the step finishes; don't leave the step's breakpoint pointing
+     at it.  */
+  if (bp->reinserting)
+    for (cur = breakpoints; cur != NULL; cur = cur->next)
+      if (cur->breakpoint_to_reinsert == bp)
+	cur->breakpoint_to_reinsert = NULL;
+
+  (*the_target->write_memory) (bp->pc, bp->old_data,
+			       breakpoint_len);
+  clear_breakpoint_conditions (bp);
+  free (bp);
+}
 
-  while (bp != NULL)
+static void
+delete_breakpoint (struct breakpoint *bp)
+{
+  struct breakpoint **cur;
+
+  for (cur = breakpoint_hash_bucket (bp->pc); *cur != NULL;
+       cur = &(*cur)->hash_next)
+    if (*cur == bp)
+      break;
+  if (*cur == NULL)
     {
-      if (bp->pc == where)
-	return bp;
-      bp = bp->next;
+      warning ("Could not find breakpoint in list.");
+      return;
     }
+  *cur = bp->hash_next;
+
+  if (bp->prev != NULL)
+    bp->prev->next = bp->next;
+  else
+    breakpoints = bp->next;
+  if (bp->next != NULL)
+    bp->next->prev = bp->prev;
+
+  free_breakpoint (bp);
+}
+
+static struct breakpoint *
+find_breakpoint_at (CORE_ADDR where)
+{
+  struct breakpoint *bp;
+
+  for (bp = *breakpoint_hash_bucket (where); bp != NULL; bp = bp->hash_next)
+    if (bp->pc == where)
+      return bp;
 
   return NULL;
 }
@@ -117,8 +206,117 @@ void
 delete_breakpoint_at (CORE_ADDR addr)
 {
   struct breakpoint *bp = find_breakpoint_at (addr);
-  if (bp != NULL)
+  if (bp == NULL)
+    return;
+
+  /* If GDB still wants a breakpoint here, leave it to GDB.  */
+  if (bp->gdb_breakpoint)
+    bp->handler = NULL;
+  else
+    delete_breakpoint (bp);
+}
+
+int
+set_gdb_breakpoint_at (CORE_ADDR where)
+{
+  struct breakpoint *bp;
+
+  if (breakpoint_data == NULL)
+    return 1;
+
+  bp = find_breakpoint_at (where);
+  if (bp == NULL)
+    bp = insert_new_breakpoint (where, NULL);
+
+  /* GDB inserting a breakpoint it already inserted means it has a
+     new set of conditions for it.  */
+  clear_breakpoint_conditions (bp);
+  bp->gdb_breakpoint = 1;
+  return 0;
+}
+
+int
+delete_gdb_breakpoint_at (CORE_ADDR addr)
+{
+  struct breakpoint *bp;
+
+  if (breakpoint_data == NULL)
+    return 1;
+
+  bp = find_breakpoint_at (addr);
+  if (bp == NULL || !bp->gdb_breakpoint)
+    return -1;
+
+  /* Keep the breakpoint if we still need it ourselves.  */
+  if (bp->handler != NULL)
+    {
+      clear_breakpoint_conditions (bp);
+      bp->gdb_breakpoint = 0;
+    }
+  else
     delete_breakpoint (bp);
+  return 0;
+}
+
+int
+add_breakpoint_condition (CORE_ADDR addr, char **condition)
+{
+  struct breakpoint *bp = find_breakpoint_at (addr);
+  char *actparm = *condition;
+  struct agent_expr *cond;
+  struct point_cond_list *new_cond, **tail;
+
+  if (bp == NULL || !bp->gdb_breakpoint)
+    return 0;
+
+  if (*actparm != 'X')
+    return 0;
+  actparm++;
+
+  cond = parse_agent_expr (&actparm);
+  if (cond == NULL)
+    return 0;
+
+  new_cond = malloc (sizeof (*new_cond));
+  new_cond->cond = cond;
+  new_cond->next = NULL;
+
+  for (tail = &bp->cond_list; *tail != NULL; tail = &(*tail)->next)
+    ;
+  *tail = new_cond;
+
+  *condition = actparm;
+  return 1;
+}
+
+int
+gdb_condition_true_at_breakpoint (CORE_ADDR where)
+{
+  struct breakpoint *bp = find_breakpoint_at (where);
+  struct point_cond_list *cl;
+
+  if (bp == NULL || !bp->gdb_breakpoint || bp->cond_list == NULL)
+    return 1;
+
+  for (cl = bp->cond_list; cl != NULL; cl = cl->next)
+    {
+      ULONGEST value;
+      enum eval_result_type err = eval_agent_expr (cl->cond, NULL, &value);
+
+      /* If we can't evaluate a condition, let GDB have a go.  */
+      if (err != expr_eval_no_error)
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Breakpoint condition at %08lx failed: %d\n",
+		     (long) where, (int) err);
+	  return 1;
+	}
+
+      if (value != 0)
+	return 1;
+    }
+
+  return 0;
 }
 
 static int
@@ -130,9 +328,11 @@ reinsert_breakpoint_handler (CORE_ADDR stop_pc)
   if (stop_bp == NULL)
     error ("lost the stopping breakpoint.");
 
+  /* The breakpoint we stepped over is gone already if GDB removed it
+     in the meantime.  */
   orig_bp = stop_bp->breakpoint_to_reinsert;
   if (orig_bp == NULL)
-    error ("no breakpoint to reinsert");
+    return 1;
 
   (*the_target->write_memory) (orig_bp->pc, breakpoint_data,
 			       breakpoint_len);
@@ -180,9 +380,11 @@ reinsert_breakpoint (CORE_ADDR stopped_at)
 {
   struct breakpoint *bp;
 
+  /* GDB may have removed its breakpoint while we were stepping
+     over it.  */
   bp = find_breakpoint_at (stopped_at);
   if (bp == NULL)
-    error ("Could not find breakpoint in list (uninserting).");
+    return;
   if (! bp->reinserting)
     error ("Breakpoint already inserted at reinsert time.");
 
@@ -199,6 +401,11 @@ check_breakpoints (CORE_ADDR stop_pc)
   bp = find_breakpoint_at (stop_pc);
   if (bp == NULL)
     return 0;
+
+  /* GDB's own breakpoints are for GDB to deal with.  */
+  if (bp->handler == NULL)
+    return 0;
+
   if (bp->reinserting)
     {
       warning ("Hit a removed breakpoint?");
@@ -207,11 +414,41 @@ check_breakpoints (CORE_ADDR stop_pc)
 
   if ((*bp->handler) (bp->pc))
     {
+      if (bp->gdb_breakpoint)
+	{
+	  bp->handler = NULL;
+	  return 0;
+	}
+
       delete_breakpoint (bp);
       return 2;
     }
-  else
-    return 1;
+
+  /* Having handled the hit ourselves, let GDB see it too if it has
+     a breakpoint here.  */
+  return bp->gdb_breakpoint ? 0 : 1;
+}
+
+int
+own_breakpoint_inserted_at (CORE_ADDR where)
+{
+  struct breakpoint *bp = find_breakpoint_at (where);
+
+  return bp != NULL && bp->handler != NULL && !bp->reinserting;
+}
+
+int
+breakpoint_inserted_at (CORE_ADDR where)
+{
+  struct breakpoint *bp = find_breakpoint_at (where);
+
+  return bp != NULL && !bp->reinserting;
+}
+
+int
+breakpoints_supported (void)
+{
+  return breakpoint_data != NULL;
 }
 
 void
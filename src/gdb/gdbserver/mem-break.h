@@ -25,7 +25,9 @@
 
 /* Create a new breakpoint at WHERE, and call HANDLER when
    it is hit.  HANDLER should return 1 if the breakpoint
-   should be deleted, 0 otherwise.  */
+   should be deleted, 0 otherwise.  If GDB has a breakpoint at WHERE
+   already, HANDLER is attached to that one, and hits are reported
+   to GDB once HANDLER has run.  */
 
 void set_breakpoint_at (CORE_ADDR where,
 			int (*handler) (CORE_ADDR));
@@ -35,6 +37,29 @@ void set_breakpoint_at (CORE_ADDR where,
 
 void delete_breakpoint_at (CORE_ADDR addr);
 
+/* Insert a breakpoint at WHERE on GDB's behalf, as requested by a Z0
+   packet.  Returns 0 on success, 1 if breakpoints are not supported,
+   and -1 on failure.  */
+
+int set_gdb_breakpoint_at (CORE_ADDR where);
+
+/* Remove the breakpoint GDB inserted at ADDR.  Returns the same
+   values as set_gdb_breakpoint_at.  */
+
+int delete_gdb_breakpoint_at (CORE_ADDR addr);
+
+/* Parse one "XLEN,BYTES" condition at *CONDITION, attach it to the
+   breakpoint GDB inserted at ADDR, and advance *CONDITION past it.
+   Returns zero if the condition is malformed.  */
+
+int add_breakpoint_condition (CORE_ADDR addr, char **condition);
+
+/* Return non-zero if GDB should be told about hitting its breakpoint
+   at WHERE: if any of its conditions is true, if it has none, or if
+   one can not be evaluated.  */
+
+int gdb_condition_true_at_breakpoint (CORE_ADDR where);
+
 /* Create a reinsertion breakpoint at STOP_AT for the breakpoint
    currently at STOP_PC (and temporarily remove the breakpoint at
    STOP_PC).  */
@@ -66,6 +91,21 @@ void check_mem_read (CORE_ADDR mem_addr, unsigned char *buf, int mem_len);
 
 void check_mem_write (CORE_ADDR mem_addr, unsigned char *buf, int mem_len);
 
+/* Return non-zero if one of our own breakpoints (one with a
+   handler) is inserted at WHERE.  */
+
+int own_breakpoint_inserted_at (CORE_ADDR where);
+
+/* Return non-zero if any breakpoint, GDB's or our own, is inserted
+   at WHERE.  Unlike the_low_target.breakpoint_at, this sees through
+   the shadowing of inferior memory reads.  */
+
+int breakpoint_inserted_at (CORE_ADDR where);
+
+/* Return non-zero if we know how to insert memory breakpoints.  */
+
+int breakpoints_supported (void);
+
 /* Set the byte pattern to insert for memory breakpoints.  This function
    must be called before any breakpoints are set.  */
 
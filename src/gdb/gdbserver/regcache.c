@@ -157,6 +157,20 @@ registers_to_string (char *buf)
   convert_int_to_ascii (registers, buf, register_bytes);
 }
 
+void
+registers_to_raw (void *buf)
+{
+  unsigned char *registers = get_regcache (current_inferior, 1)->registers;
+
+  memcpy (buf, registers, register_bytes);
+}
+
+int
+register_cache_size (void)
+{
+  return register_bytes;
+}
+
 void
 registers_from_string (char *buf)
 {
@@ -202,6 +216,12 @@ find_register_by_number (int n)
   return &reg_defs[n];
 }
 
+int
+register_count (void)
+{
+  return num_registers;
+}
+
 int
 register_size (int n)
 {
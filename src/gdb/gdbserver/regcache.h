@@ -39,6 +39,14 @@ void regcache_invalidate (void);
 
 void registers_to_string (char *buf);
 
+/* Copy all registers, in the layout of the 'g' packet, to BUF.  */
+
+void registers_to_raw (void *buf);
+
+/* Return the size of the register cache in bytes.  */
+
+int register_cache_size (void);
+
 /* Convert a string to register values and fill our register cache.  */
 
 void registers_from_string (char *buf);
@@ -47,6 +55,10 @@ void registers_from_string (char *buf);
 
 struct reg *find_register_by_number (int n);
 
+/* Return the number of registers in the register cache.  */
+
+int register_count (void);
+
 int register_size (int n);
 
 int find_regno (const char *name);
@@ -510,10 +510,11 @@ try_rle (char *buf, int remaining, unsigned char *csum, char **p)
 
 /* Send a packet to the remote machine, with error checking.
    The data of the packet is in BUF, and the length of the
-   packet is in CNT.  Returns >= 0 on success, -1 otherwise.  */
+   packet is in CNT.  If IS_NOTIF, send it as a notification, which
+   GDB does not acknowledge.  Returns >= 0 on success, -1 otherwise.  */
 
-int
-putpkt_binary (char *buf, int cnt)
+static int
+putpkt_binary_1 (char *buf, int cnt, int is_notif)
 {
   int i;
   unsigned char csum = 0;
@@ -527,7 +528,7 @@ putpkt_binary (char *buf, int cnt)
      and giving it a checksum.  */
 
   p = buf2;
-  *p++ = '$';
+  *p++ = is_notif ? '%' : '$';
 
   for (i = 0; i < cnt;)
     i += try_rle (buf + i, cnt - i, &csum, &p);
@@ -551,6 +552,16 @@ putpkt_binary (char *buf, int cnt)
 	  return -1;
 	}
 
+      if (is_notif)
+	{
+	  if (remote_debug)
+	    {
+	      fprintf (stderr, "putpkt (\"%s\"); [notif]\n", buf2);
+	      fflush (stderr);
+	    }
+	  break;
+	}
+
       if (remote_debug)
 	{
 	  fprintf (stderr, "putpkt (\"%s\"); [looking for ack]\n", buf2);
@@ -584,6 +595,12 @@ putpkt_binary (char *buf, int cnt)
   return 1;			/* Success! */
 }
 
+int
+putpkt_binary (char *buf, int cnt)
+{
+  return putpkt_binary_1 (buf, cnt, 0);
+}
+
 /* Send a packet to the remote machine, with error checking.  The data
    of the packet is in BUF, and the packet should be a NUL-terminated
    string.  Returns >= 0 on success, -1 otherwise.  */
@@ -594,6 +611,15 @@ putpkt (char *buf)
   return putpkt_binary (buf, strlen (buf));
 }
 
+/* Send the notification in BUF, a NUL-terminated string, to GDB.
+   Returns >= 0 on success, -1 otherwise.  */
+
+int
+putpkt_notif (char *buf)
+{
+  return putpkt_binary_1 (buf, strlen (buf), 1);
+}
+
 /* Come here when we get an input interrupt from the remote side.  This
    interrupt should only be active while we are waiting for the child to do
    something.  About the only thing that should come through is a ^C, which
@@ -697,23 +723,24 @@ initialize_async_io (void)
   unblock_async_io ();
 }
 
+/* Characters read from GDB but not consumed yet.  */
+static unsigned char readchar_buf[BUFSIZ];
+static int readchar_bufcnt = 0;
+static unsigned char *readchar_bufp;
+
 /* Returns next char from remote GDB.  -1 if error.  */
 
 static int
 readchar (void)
 {
-  static unsigned char buf[BUFSIZ];
-  static int bufcnt = 0;
-  static unsigned char *bufp;
-
-  if (bufcnt-- > 0)
-    return *bufp++;
+  if (readchar_bufcnt-- > 0)
+    return *readchar_bufp++;
 
-  bufcnt = read (remote_desc, buf, sizeof (buf));
+  readchar_bufcnt = read (remote_desc, readchar_buf, sizeof (readchar_buf));
 
-  if (bufcnt <= 0)
+  if (readchar_bufcnt <= 0)
     {
-      if (bufcnt == 0)
+      if (readchar_bufcnt == 0)
 	fprintf (stderr, "readchar: Got EOF\n");
       else
 	perror ("readchar");
@@ -721,9 +748,46 @@ readchar (void)
       return -1;
     }
 
-  bufp = buf;
-  bufcnt--;
-  return *bufp++;
+  readchar_bufp = readchar_buf;
+  readchar_bufcnt--;
+  return *readchar_bufp++;
+}
+
+/* Wait until GDB sends us something, or until FD becomes readable
+   if it is not -1.  Return 1 if there is input from GDB, and 0
+   otherwise.  */
+
+int
+wait_for_remote_input (int fd)
+{
+  fd_set readset;
+  int maxfd;
+
+  if (readchar_bufcnt > 0)
+    return 1;
+
+  while (1)
+    {
+      FD_ZERO (&readset);
+      FD_SET (remote_desc, &readset);
+      maxfd = remote_desc;
+      if (fd != -1)
+	{
+	  FD_SET (fd, &readset);
+	  if (fd > maxfd)
+	    maxfd = fd;
+	}
+
+      if (select (maxfd + 1, &readset, 0, 0, NULL) == -1)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("select");
+	  return 1;
+	}
+
+      return FD_ISSET (remote_desc, &readset);
+    }
 }
 
 /* Read a packet from the remote machine, with error checking,
@@ -960,7 +1024,10 @@ prepare_resume_reply (char *buf, char status, unsigned char sig)
 	     what inferior_ptid is.  */
 	  if (1 || old_thread_from_wait != thread_from_wait)
 	    {
-	      general_thread = thread_from_wait;
+	      /* In non-stop mode, GDB may see this reply much later,
+		 and keeps track of the general thread itself.  */
+	      if (!non_stop)
+		general_thread = thread_from_wait;
 	      sprintf (buf, "thread:%x;", gdb_id_from_wait);
 	      buf += strlen (buf);
 	      old_thread_from_wait = thread_from_wait;
@@ -39,6 +39,10 @@ unsigned long thread_from_wait;
 unsigned long old_thread_from_wait;
 int server_waiting;
 
+/* Non-zero if GDB asked for non-stop mode, where threads run and stop
+   independently and stops are reported with notifications.  */
+int non_stop;
+
 static int extended_protocol;
 static int attached;
 static int response_needed;
@@ -63,6 +67,24 @@ const char *gdbserver_xmltarget;
 
 unsigned long signal_pid;
 
+/* In non-stop mode, a stop reply which GDB has not acknowledged with
+   vStopped yet.  GDB has been sent the first one in the queue, either
+   as a notification or as the reply to a '?' or vStopped packet.  */
+
+struct stop_reply
+{
+  struct stop_reply *next;
+
+  /* The status and signal, as returned by mywait.  */
+  char status;
+  int signal;
+
+  /* The reply, formatted when the event happened.  */
+  char *reply;
+};
+
+static struct stop_reply *stop_reply_queue;
+
 #ifdef SIGTTOU
 /* A file descriptor for the controlling terminal.  */
 int terminal_fd;
@@ -87,7 +109,7 @@ int disable_packet_Tthread;
 int disable_packet_qC;
 int disable_packet_qfThreadInfo;
 
-static int
+int
 target_running (void)
 {
   return all_threads.head != NULL;
@@ -147,6 +169,9 @@ start_inferior (char **argv, char *statusptr)
       resume_info.step = 0;
       resume_info.sig = 0;
       resume_info.leave_stopped = 0;
+      resume_info.stop = 0;
+      resume_info.step_range_start = 0;
+      resume_info.step_range_end = 0;
 
       sig = mywait (statusptr, 0);
       if (*statusptr != 'T')
@@ -241,6 +266,138 @@ write_qxfer_response (char *buf, const void *data, int len, int is_more)
 			       PBUFSIZ - 2) + 1;
 }
 
+/* Queue a stop reply for the event STATUS and SIGNAL of the current
+   thread.  */
+
+static void
+queue_stop_reply (char status, int signal)
+{
+  struct stop_reply *new_reply, **p;
+  char *buf = malloc (PBUFSIZ);
+
+  prepare_resume_reply (buf, status, signal);
+
+  new_reply = malloc (sizeof (*new_reply));
+  new_reply->next = NULL;
+  new_reply->status = status;
+  new_reply->signal = signal;
+  new_reply->reply = strdup (buf);
+  free (buf);
+
+  for (p = &stop_reply_queue; *p != NULL; p = &(*p)->next)
+    ;
+  *p = new_reply;
+}
+
+static void
+discard_queued_stop_replies (void)
+{
+  while (stop_reply_queue != NULL)
+    {
+      struct stop_reply *reply = stop_reply_queue;
+
+      stop_reply_queue = reply->next;
+      free (reply->reply);
+      free (reply);
+    }
+}
+
+/* Send GDB the first queued stop reply as a notification.  */
+
+static void
+send_stop_notification (void)
+{
+  char *buf = malloc (PBUFSIZ);
+
+  sprintf (buf, "Stop:%s", stop_reply_queue->reply);
+  putpkt_notif (buf);
+  free (buf);
+}
+
+/* In non-stop mode, queue a stop reply for each event the target has
+   to report.  If GDB had no stop reply left to acknowledge, tell it
+   about the first one.  */
+
+static void
+handle_target_events (void)
+{
+  int was_empty = (stop_reply_queue == NULL);
+  char status;
+  int signal;
+
+  while (target_running ())
+    {
+      signal = mywait (&status, 1);
+      if (status == '\0')
+	break;
+
+      queue_stop_reply (status, signal);
+    }
+
+  if (was_empty && stop_reply_queue != NULL)
+    send_stop_notification ();
+}
+
+/* Handle a '?' packet in non-stop mode: report every stopped thread,
+   the current one with STATUS and SIGNAL, the others as stopped with
+   no signal.  GDB fetches all but the first with vStopped.  */
+
+static void
+handle_status_non_stop (char *own_buf, char status, int signal)
+{
+  struct inferior_list_entry *entry;
+  struct thread_info *saved_inferior = current_inferior;
+
+  discard_queued_stop_replies ();
+
+  for (entry = all_threads.head; entry != NULL; entry = entry->next)
+    {
+      struct thread_info *thread = (struct thread_info *) entry;
+
+      if (!(*the_target->thread_stopped) (thread))
+	continue;
+
+      current_inferior = thread;
+      if (thread == saved_inferior)
+	queue_stop_reply (status, signal);
+      else
+	queue_stop_reply ('T', TARGET_SIGNAL_0);
+    }
+  current_inferior = saved_inferior;
+
+  if (stop_reply_queue != NULL)
+    strcpy (own_buf, stop_reply_queue->reply);
+  else
+    write_ok (own_buf);
+}
+
+/* GDB has acknowledged the first queued stop reply; drop it, and
+   reply with the next one, if any.  If the process exited, record
+   that in *STATUS and *SIGNAL.  */
+
+static void
+handle_v_stopped (char *own_buf, char *status, int *signal)
+{
+  if (stop_reply_queue != NULL)
+    {
+      struct stop_reply *reply = stop_reply_queue;
+
+      stop_reply_queue = reply->next;
+      if (reply->status == 'W' || reply->status == 'X')
+	{
+	  *status = reply->status;
+	  *signal = reply->signal;
+	}
+      free (reply->reply);
+      free (reply);
+    }
+
+  if (stop_reply_queue != NULL)
+    strcpy (own_buf, stop_reply_queue->reply);
+  else
+    write_ok (own_buf);
+}
+
 /* Handle all of the extended 'Q' packets.  */
 void
 handle_general_set (char *own_buf)
@@ -270,6 +427,45 @@ handle_general_set (char *own_buf)
       return;
     }
 
+  if (strncmp ("QNonStop:", own_buf, strlen ("QNonStop:")) == 0)
+    {
+      char *mode = own_buf + strlen ("QNonStop:");
+      int req;
+
+      if (strcmp (mode, "0") == 0)
+	req = 0;
+      else if (strcmp (mode, "1") == 0)
+	req = 1;
+      else
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+
+      if (req != non_stop)
+	{
+	  if (the_target->start_non_stop == NULL
+	      || (*the_target->start_non_stop) (req) != 0)
+	    {
+	      write_enn (own_buf);
+	      return;
+	    }
+
+	  discard_queued_stop_replies ();
+	  non_stop = req;
+	}
+
+      if (remote_debug)
+	fprintf (stderr, "[%s mode enabled]\n",
+		 non_stop ? "non-stop" : "all-stop");
+
+      write_ok (own_buf);
+      return;
+    }
+
+  if (handle_tracepoint_general_set (own_buf))
+    return;
+
   /* Otherwise we didn't know what packet it was.  Say we didn't
      understand it.  */
   own_buf[0] = 0;
@@ -321,6 +517,8 @@ monitor_show_help (void)
   monitor_output ("    Enable general debugging messages\n");  
   monitor_output ("  set remote-debug <0|1>\n");
   monitor_output ("    Enable remote protocol debugging messages\n");
+  monitor_output ("  set agent-jit <0|1>\n");
+  monitor_output ("    Enable compiling agent expressions to native code\n");
   monitor_output ("  exit\n");
   monitor_output ("    Quit GDBserver\n");
 }
@@ -479,6 +677,62 @@ handle_search_memory (char *own_buf, int packet_len)
       return;					\
     }
 
+/* Handle a "qRegisters:ID,ID,..." packet: reply with the 'g' packet
+   contents of each listed thread, as "ID:REGS;ID:REGS;...".  Threads
+   which do not exist or are running, and those which do not fit in
+   the reply, are left out; GDB fetches them separately.  */
+
+static void
+handle_qregisters (char *own_buf)
+{
+  struct thread_info *saved_inferior = current_inferior;
+  char *ids, *p, *q, *out, *end;
+  int entry_size = 2 * register_cache_size () + 10;
+
+  if (current_traceframe >= 0)
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  ids = strdup (own_buf + 11);
+  out = own_buf;
+  end = own_buf + PBUFSIZ - 1;
+
+  for (p = ids; *p != '\0'; p = q)
+    {
+      unsigned int gdb_id = strtoul (p, &q, 16);
+      struct thread_info *thread;
+
+      if (q == p || (*q != ',' && *q != '\0'))
+	break;
+      if (*q == ',')
+	q++;
+
+      thread = gdb_id_to_thread (gdb_id);
+      if (thread == NULL
+	  || (the_target->thread_stopped != NULL
+	      && !(*the_target->thread_stopped) (thread)))
+	continue;
+
+      if (end - out < entry_size)
+	break;
+
+      current_inferior = thread;
+      out += sprintf (out, "%x:", gdb_id);
+      registers_to_string (out);
+      out += strlen (out);
+      *out++ = ';';
+    }
+
+  if (out == own_buf)
+    strcpy (own_buf, "OK");
+  else
+    *out = '\0';
+  current_inferior = saved_inferior;
+  free (ids);
+}
+
 /* Handle all of the extended 'q' packets.  */
 void
 handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
@@ -495,6 +749,9 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       return;
     }
 
+  if (handle_tracepoint_query (own_buf))
+    return;
+
   if (strcmp ("qSymbol::", own_buf) == 0)
     {
       if (target_running () && the_target->look_up_symbols != NULL)
@@ -777,6 +1034,18 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	 qXfer:feature:read at all, we will never be re-queried.  */
       strcat (own_buf, ";qXfer:features:read+");
 
+      if (the_target->supports_conditional_breakpoints != NULL
+	  && (*the_target->supports_conditional_breakpoints) ())
+	strcat (own_buf, ";ConditionalBreakpoints+");
+
+      if (breakpoints_supported ())
+	strcat (own_buf, ";vBreakpoints+");
+
+      if (the_target->start_non_stop != NULL)
+	strcat (own_buf, ";QNonStop+");
+
+      strcat (own_buf, ";qRegisters+");
+
       return;
     }
 
@@ -841,6 +1110,14 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       /* Otherwise, pretend we do not understand this packet.  */
     }
 
+  /* Registers of several threads at once.  */
+  if (strncmp ("qRegisters:", own_buf, 11) == 0)
+    {
+      require_running (own_buf);
+      handle_qregisters (own_buf);
+      return;
+    }
+
   /* Handle "monitor" commands.  */
   if (strncmp ("qRcmd,", own_buf, 6) == 0)
     {
@@ -877,6 +1154,16 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	  remote_debug = 0;
 	  monitor_output ("Protocol debug output disabled.\n");
 	}
+      else if (strcmp (mon, "set agent-jit 1") == 0)
+	{
+	  agent_jit = 1;
+	  monitor_output ("Agent expression compilation enabled.\n");
+	}
+      else if (strcmp (mon, "set agent-jit 0") == 0)
+	{
+	  agent_jit = 0;
+	  monitor_output ("Agent expression compilation disabled.\n");
+	}
       else if (strcmp (mon, "help") == 0)
 	monitor_show_help ();
       else if (strcmp (mon, "exit") == 0)
@@ -928,8 +1215,11 @@ handle_v_cont (char *own_buf, char *status, int *signal)
 
   default_action.thread = -1;
   default_action.leave_stopped = 1;
+  default_action.stop = 0;
   default_action.step = 0;
   default_action.sig = 0;
+  default_action.step_range_start = 0;
+  default_action.step_range_end = 0;
 
   p = &own_buf[5];
   i = 0;
@@ -938,15 +1228,42 @@ handle_v_cont (char *own_buf, char *status, int *signal)
       p++;
 
       resume_info[i].leave_stopped = 0;
+      resume_info[i].stop = 0;
+      resume_info[i].step_range_start = 0;
+      resume_info[i].step_range_end = 0;
 
-      if (p[0] == 's' || p[0] == 'S')
+      if (p[0] == 's' || p[0] == 'S' || p[0] == 'r')
 	resume_info[i].step = 1;
       else if (p[0] == 'c' || p[0] == 'C')
 	resume_info[i].step = 0;
+      else if (p[0] == 't' && non_stop)
+	{
+	  resume_info[i].step = 0;
+	  resume_info[i].stop = 1;
+	}
       else
 	goto err;
 
-      if (p[0] == 'S' || p[0] == 'C')
+      if (p[0] == 'r')
+	{
+	  /* Step through the range STARTADDR,ENDADDR.  */
+	  int len;
+
+	  p++;
+	  len = strcspn (p, ",");
+	  if (len == 0 || p[len] != ',')
+	    goto err;
+	  decode_address (&resume_info[i].step_range_start, p, len);
+	  p += len + 1;
+
+	  len = strcspn (p, ":;");
+	  if (len == 0)
+	    goto err;
+	  decode_address (&resume_info[i].step_range_end, p, len);
+	  p += len;
+	  resume_info[i].sig = 0;
+	}
+      else if (p[0] == 'S' || p[0] == 'C')
 	{
 	  int sig;
 	  sig = strtol (p + 1, &q, 16);
@@ -1002,6 +1319,16 @@ handle_v_cont (char *own_buf, char *status, int *signal)
     cont_thread = -1;
   set_desired_inferior (0);
 
+  /* In non-stop mode, we reply at once; the threads' stops are
+     reported as they happen.  */
+  if (non_stop)
+    {
+      (*the_target->resume) (resume_info);
+      free (resume_info);
+      write_ok (own_buf);
+      return;
+    }
+
   enable_async_io ();
   (*the_target->resume) (resume_info);
 
@@ -1112,6 +1439,78 @@ handle_v_run (char *own_buf, char *status, int *signal)
     }
 }
 
+/* Parse one "Z0,ADDR,KIND" or "z0,ADDR,KIND" entry of a vBreakpoints
+   packet at P.  Store whether it is an insertion in *INSERT and the
+   address in *ADDR, and return a pointer past it, or NULL if it is
+   malformed.  */
+
+static char *
+parse_v_breakpoints_entry (char *p, int *insert, CORE_ADDR *addr)
+{
+  if ((p[0] != 'Z' && p[0] != 'z') || p[1] != '0' || p[2] != ',')
+    return NULL;
+  *insert = (p[0] == 'Z');
+
+  *addr = strtoul (p + 3, &p, 16);
+  if (*p != ',')
+    return NULL;
+
+  /* The kind is implied by the address.  */
+  strtoul (p + 1, &p, 16);
+  if (*p != ';' && *p != '\0')
+    return NULL;
+
+  return p;
+}
+
+/* Insert and remove the breakpoints listed in a vBreakpoints packet,
+   in order, up to the first one that fails.  */
+
+static void
+handle_v_breakpoints (char *own_buf)
+{
+  char *start = own_buf + strlen ("vBreakpoints:");
+  char *p;
+  CORE_ADDR addr;
+  int insert;
+  int n;
+
+  /* Check the whole packet first; a malformed one does nothing.  */
+  for (p = start; *p != '\0'; )
+    {
+      p = parse_v_breakpoints_entry (p, &insert, &addr);
+      if (p == NULL)
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+      if (*p == ';')
+	p++;
+    }
+
+  for (p = start, n = 0; *p != '\0'; n++)
+    {
+      int res;
+
+      p = parse_v_breakpoints_entry (p, &insert, &addr);
+      if (*p == ';')
+	p++;
+
+      if (insert)
+	res = set_gdb_breakpoint_at (addr);
+      else
+	res = delete_gdb_breakpoint_at (addr);
+
+      if (res != 0)
+	{
+	  sprintf (own_buf, "P%x", n);
+	  return;
+	}
+    }
+
+  write_ok (own_buf);
+}
+
 /* Handle all of the extended 'v' packets.  */
 void
 handle_v_requests (char *own_buf, char *status, int *signal,
@@ -1129,10 +1528,21 @@ handle_v_requests (char *own_buf, char *status, int *signal,
       if (strncmp (own_buf, "vCont?", 6) == 0)
 	{
 	  strcpy (own_buf, "vCont;c;C;s;S");
+	  if (the_target->supports_range_stepping != NULL
+	      && (*the_target->supports_range_stepping) ())
+	    strcat (own_buf, ";r");
+	  if (the_target->start_non_stop != NULL)
+	    strcat (own_buf, ";t");
 	  return;
 	}
     }
 
+  if (strcmp (own_buf, "vStopped") == 0 && non_stop)
+    {
+      handle_v_stopped (own_buf, status, signal);
+      return;
+    }
+
   if (strncmp (own_buf, "vFile:", 6) == 0
       && handle_vFile (own_buf, packet_len, new_packet_len))
     return;
@@ -1161,6 +1571,14 @@ handle_v_requests (char *own_buf, char *status, int *signal,
       return;
     }
 
+  if (strncmp (own_buf, "vBreakpoints:", 13) == 0
+      && breakpoints_supported ())
+    {
+      require_running (own_buf);
+      handle_v_breakpoints (own_buf);
+      return;
+    }
+
   /* Otherwise we didn't know what packet it was.  Say we didn't
      understand it.  */
   own_buf[0] = 0;
@@ -1183,12 +1601,18 @@ myresume (char *own_buf, int step, int *signalp, char *statusp)
       resume_info[0].step = step;
       resume_info[0].sig = sig;
       resume_info[0].leave_stopped = 0;
+      resume_info[0].stop = 0;
+      resume_info[0].step_range_start = 0;
+      resume_info[0].step_range_end = 0;
       n++;
     }
   resume_info[n].thread = -1;
   resume_info[n].step = 0;
   resume_info[n].sig = 0;
   resume_info[n].leave_stopped = (cont_thread != 0 && cont_thread != -1);
+  resume_info[n].stop = 0;
+  resume_info[n].step_range_start = 0;
+  resume_info[n].step_range_end = 0;
 
   enable_async_io ();
   (*the_target->resume) (resume_info);
@@ -1468,6 +1892,15 @@ main (int argc, char *argv[])
 	  int new_packet_len = -1;
 
 	  response_needed = 0;
+
+	  /* In non-stop mode, collect the inferior's events while we
+	     wait for GDB, so that we can tell it about them.  */
+	  if (non_stop)
+	    while (!wait_for_remote_input (target_running ()
+					   ? (*the_target->event_fd) ()
+					   : -1))
+	      handle_target_events ();
+
 	  packet_len = getpkt (own_buf);
 	  if (packet_len <= 0)
 	    break;
@@ -1490,6 +1923,7 @@ main (int argc, char *argv[])
 		write_enn (own_buf);
 	      else
 		{
+		  discard_queued_stop_replies ();
 		  write_ok (own_buf);
 
 		  if (extended_protocol)
@@ -1518,7 +1952,10 @@ main (int argc, char *argv[])
 	      write_ok (own_buf);
 	      break;
 	    case '?':
-	      prepare_resume_reply (own_buf, status, signal);
+	      if (non_stop && target_running ())
+		handle_status_non_stop (own_buf, status, signal);
+	      else
+		prepare_resume_reply (own_buf, status, signal);
 	      break;
 	    case 'H':
 	      if (own_buf[1] == 'c' || own_buf[1] == 'g' || own_buf[1] == 's')
@@ -1559,19 +1996,42 @@ main (int argc, char *argv[])
 		}
 	      break;
 	    case 'g':
+	      if (current_traceframe >= 0)
+		{
+		  traceframe_registers_to_string (current_traceframe,
+						  own_buf);
+		  break;
+		}
 	      require_running (own_buf);
 	      set_desired_inferior (1);
 	      registers_to_string (own_buf);
 	      break;
 	    case 'G':
 	      require_running (own_buf);
+	      if (current_traceframe >= 0)
+		{
+		  /* Trace frames are read-only.  */
+		  write_enn (own_buf);
+		  break;
+		}
 	      set_desired_inferior (1);
 	      registers_from_string (&own_buf[1]);
 	      write_ok (own_buf);
 	      break;
 	    case 'm':
-	      require_running (own_buf);
 	      decode_m_packet (&own_buf[1], &mem_addr, &len);
+	      if (current_traceframe >= 0)
+		{
+		  ULONGEST nbytes;
+
+		  if (traceframe_read_mem (current_traceframe, mem_addr,
+					   mem_buf, len, &nbytes) == 0)
+		    convert_int_to_ascii (mem_buf, own_buf, nbytes);
+		  else
+		    write_enn (own_buf);
+		  break;
+		}
+	      require_running (own_buf);
 	      if (read_inferior_memory (mem_addr, mem_buf, len) == 0)
 		convert_int_to_ascii (mem_buf, own_buf, len);
 	      else
@@ -1579,6 +2039,11 @@ main (int argc, char *argv[])
 	      break;
 	    case 'M':
 	      require_running (own_buf);
+	      if (current_traceframe >= 0)
+		{
+		  write_enn (own_buf);
+		  break;
+		}
 	      decode_M_packet (&own_buf[1], &mem_addr, &len, mem_buf);
 	      if (write_inferior_memory (mem_addr, mem_buf, len) == 0)
 		write_ok (own_buf);
@@ -1587,6 +2052,11 @@ main (int argc, char *argv[])
 	      break;
 	    case 'X':
 	      require_running (own_buf);
+	      if (current_traceframe >= 0)
+		{
+		  write_enn (own_buf);
+		  break;
+		}
 	      if (decode_X_packet (&own_buf[1], packet_len - 1,
 				   &mem_addr, &len, mem_buf) < 0
 		  || write_inferior_memory (mem_addr, mem_buf, len) != 0)
@@ -1630,8 +2100,34 @@ main (int argc, char *argv[])
 		int len = strtol (lenptr + 1, &dataptr, 16);
 		char type = own_buf[1];
 
-		if (the_target->insert_watchpoint == NULL
-		    || (type < '2' || type > '4'))
+		if (type == '0')
+		  {
+		    int res;
+
+		    require_running (own_buf);
+		    res = set_gdb_breakpoint_at (addr);
+
+		    /* Any conditions for us to evaluate follow.  */
+		    while (res == 0 && *dataptr == ';')
+		      {
+			dataptr++;
+			if (!add_breakpoint_condition (addr, &dataptr))
+			  {
+			    delete_gdb_breakpoint_at (addr);
+			    res = -1;
+			  }
+		      }
+
+		    if (res == 0)
+		      write_ok (own_buf);
+		    else if (res == 1)
+		      /* Unsupported.  */
+		      own_buf[0] = '\0';
+		    else
+		      write_enn (own_buf);
+		  }
+		else if (the_target->insert_watchpoint == NULL
+			 || (type < '2' || type > '4'))
 		  {
 		    /* No watchpoint support or not a watchpoint command;
 		       unrecognized either way.  */
@@ -1661,8 +2157,22 @@ main (int argc, char *argv[])
 		int len = strtol (lenptr + 1, &dataptr, 16);
 		char type = own_buf[1];
 
-		if (the_target->remove_watchpoint == NULL
-		    || (type < '2' || type > '4'))
+		if (type == '0')
+		  {
+		    int res;
+
+		    require_running (own_buf);
+		    res = delete_gdb_breakpoint_at (addr);
+		    if (res == 0)
+		      write_ok (own_buf);
+		    else if (res == 1)
+		      /* Unsupported.  */
+		      own_buf[0] = '\0';
+		    else
+		      write_enn (own_buf);
+		  }
+		else if (the_target->remove_watchpoint == NULL
+			 || (type < '2' || type > '4'))
 		  {
 		    /* No watchpoint support or not a watchpoint command;
 		       unrecognized either way.  */
@@ -1693,6 +2203,7 @@ main (int argc, char *argv[])
 
 	      fprintf (stderr, "Killing inferior\n");
 	      kill_inferior ();
+	      discard_queued_stop_replies ();
 
 	      /* When using the extended protocol, we wait with no
 		 program running.  The traditional protocol will exit
@@ -1822,6 +2333,14 @@ main (int argc, char *argv[])
 	  fprintf (stderr, "Remote side has terminated connection.  "
 			   "GDBserver will reopen the connection.\n");
 	  remote_close ();
+
+	  /* Stop everything; the next GDB may not use non-stop mode.  */
+	  if (non_stop)
+	    {
+	      discard_queued_stop_replies ();
+	      (*the_target->start_non_stop) (0);
+	      non_stop = 0;
+	    }
 	}
     }
 }
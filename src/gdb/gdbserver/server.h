@@ -77,6 +77,11 @@ typedef unsigned char gdb_byte;
    least the size of a (void *).  */
 typedef long long CORE_ADDR;
 
+/* Integer types wide enough for any target register or memory
+   word.  */
+typedef long long LONGEST;
+typedef unsigned long long ULONGEST;
+
 /* Generic information for tracking a list of ``inferiors'' - threads,
    processes, etc.  */
 struct inferior_list
@@ -105,6 +110,7 @@ struct dll_info
 
 #include "target.h"
 #include "mem-break.h"
+#include "ax.h"
 
 /* Target-specific functions */
 
@@ -155,6 +161,7 @@ extern unsigned long step_thread;
 extern unsigned long thread_from_wait;
 extern unsigned long old_thread_from_wait;
 extern int server_waiting;
+extern int non_stop;
 extern int debug_threads;
 extern int pass_signals[];
 
@@ -165,6 +172,32 @@ extern int disable_packet_Tthread;
 extern int disable_packet_qC;
 extern int disable_packet_qfThreadInfo;
 
+int target_running (void);
+
+/* Functions from tracepoint.c.  */
+
+/* The trace frame GDB is looking at, or -1.  */
+extern int current_traceframe;
+
+/* Handle the tracepoint 'Q' and 'q' packets.  Return non-zero if
+   OWN_BUF was one of them, after replacing it with the reply.  */
+int handle_tracepoint_general_set (char *own_buf);
+int handle_tracepoint_query (char *own_buf);
+
+/* Answer a 'g' packet from trace frame TFNUM.  */
+void traceframe_registers_to_string (int tfnum, char *buf);
+
+/* Read up to LENGTH bytes at ADDR from trace frame TFNUM, storing the
+   number of bytes read in *NBYTES.  Returns -1 if none of them were
+   collected.  */
+int traceframe_read_mem (int tfnum, CORE_ADDR addr, unsigned char *buf,
+			 ULONGEST length, ULONGEST *nbytes);
+
+/* Record LEN bytes of memory at ADDR in TFRAME.  Returns non-zero if
+   the memory can't be read.  */
+int traceframe_record_memory (struct traceframe *tframe, CORE_ADDR addr,
+			      ULONGEST len);
+
 /* Functions from hostio.c.  */
 extern int handle_vFile (char *, int, int *);
 
@@ -178,7 +211,9 @@ extern int all_symbols_looked_up;
 
 int putpkt (char *buf);
 int putpkt_binary (char *buf, int len);
+int putpkt_notif (char *buf);
 int getpkt (char *buf);
+int wait_for_remote_input (int fd);
 void remote_open (char *name);
 void remote_close (void);
 void write_ok (char *buf);
@@ -34,13 +34,25 @@ struct thread_resume
   /* If non-zero, leave this thread stopped.  */
   int leave_stopped;
 
+  /* If non-zero, stop this thread if it is running.  Only used in
+     non-stop mode.  */
+  int stop;
+
   /* If non-zero, we want to single-step.  */
   int step;
 
   /* If non-zero, send this signal when we resume.  */
   int sig;
+
+  /* If STEP is set and STEP_RANGE_END is non-zero, keep stepping
+     while the PC is within [STEP_RANGE_START, STEP_RANGE_END), and
+     only report the step which leaves that range.  */
+  CORE_ADDR step_range_start;
+  CORE_ADDR step_range_end;
 };
 
+struct emit_ops;
+
 struct target_ops
 {
   /* Start a new process.
@@ -91,7 +103,10 @@ struct target_ops
 
      Returns the signal which caused the process to stop, in the
      remote protocol numbering (e.g. TARGET_SIGNAL_STOP), or the
-     exit code as an integer if *STATUS is 'W'.  */
+     exit code as an integer if *STATUS is 'W'.
+
+     In non-stop mode this does not block; if no thread has anything
+     to report, *STATUS is set to '\0'.  */
 
   unsigned char (*wait) (char *status);
 
@@ -188,6 +203,37 @@ struct target_ops
   /* Fill BUF with an hostio error packet representing the last hostio
      error.  */
   void (*hostio_last_error) (char *buf);
+
+  /* Return non-zero if the target evaluates the conditions GDB sends
+     with its breakpoints, and only reports hits for which one of them
+     is true.  */
+  int (*supports_conditional_breakpoints) (void);
+
+  /* Read and write the PC of the current thread, in its register
+     cache.  */
+  CORE_ADDR (*read_pc) (void);
+  void (*write_pc) (CORE_ADDR pc);
+
+  /* Return the code generator for compiling agent expressions to
+     native code on this host, or NULL if there is none.  */
+  struct emit_ops *(*emit_ops) (void);
+
+  /* Return non-zero if the target honors the step ranges of resume
+     requests, stepping until the PC leaves them.  */
+  int (*supports_range_stepping) (void);
+
+  /* Switch non-stop mode on if NONSTOP is non-zero, or off otherwise.
+     In non-stop mode, threads are resumed and stopped independently,
+     and inferior events are collected without blocking.  Return 0 on
+     success, -1 otherwise.  */
+  int (*start_non_stop) (int nonstop);
+
+  /* Return a file descriptor which becomes readable when the wait
+     method has something to report in non-stop mode.  */
+  int (*event_fd) (void);
+
+  /* Return non-zero if THREAD is stopped.  */
+  int (*thread_stopped) (struct thread_info *thread);
 };
 
 extern struct target_ops *the_target;
@@ -0,0 +1,1128 @@
+/* Tracepoint support for the remote server for GDB.
+   Copyright (C) 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "server.h"
+#include "regdef.h"
+
+/* GDB defines tracepoints with QTDP packets, starts and stops the
+   experiment with QTStart and QTStop, and then selects the frames it
+   wants to look at with QTFrame.  While a frame is selected, the 'g'
+   and 'm' packets are answered from it instead of from the live
+   process.
+
+   Each tracepoint is an ordinary gdbserver breakpoint; when it is
+   hit, we run its actions, store what they collected as one trace
+   frame, and step over the breakpoint without telling GDB.  */
+
+/* One collection action, as sent by GDB in a QTDP packet.  */
+
+struct tracepoint_action
+{
+  struct tracepoint_action *next;
+
+  /* 'R' to collect registers, 'M' for a memory range, or 'X' for an
+     agent expression.  */
+  char type;
+
+  /* For 'M', the register the range is relative to (-1 if it is at
+     a fixed address), and its offset and length.  */
+  int basereg;
+  ULONGEST offset;
+  ULONGEST len;
+
+  /* For 'X', the expression.  */
+  struct agent_expr *expr;
+};
+
+struct tracepoint
+{
+  struct tracepoint *next;
+
+  /* GDB's number for the tracepoint.  */
+  int number;
+
+  CORE_ADDR address;
+  int enabled;
+
+  /* Stop the experiment after this many hits, if non-zero.  */
+  ULONGEST pass_count;
+  ULONGEST hit_count;
+
+  /* Non-zero if we inserted the breakpoint for this tracepoint's
+     address.  Tracepoints at the same address share one
+     breakpoint.  */
+  int inserted;
+
+  struct tracepoint_action *actions;
+};
+
+/* The tracepoints GDB defined, in the order it defined them.  */
+
+static struct tracepoint *tracepoints;
+static struct tracepoint *last_tracepoint;
+
+/* Non-zero while the experiment is running.  */
+
+static int tracing;
+
+/* Memory GDB told us is read-only, via QTro.  Requests for it that
+   the selected frame can't satisfy are answered from the live
+   process.  */
+
+struct readonly_region
+{
+  CORE_ADDR start;
+  CORE_ADDR end;
+};
+
+static struct readonly_region *readonly_regions;
+static int readonly_region_count;
+
+/* The trace frame selected by QTFrame, or -1 for the live process.  */
+
+int current_traceframe = -1;
+
+/* The trace buffer is a ring: when a new frame does not fit, the
+   oldest frames are discarded to make room.  Frames are numbered
+   from the oldest one still in the buffer.
+
+   Frames live between TRACE_BUFFER_START and TRACE_BUFFER_FREE.  When
+   the buffer has wrapped, the frames run from TRACE_BUFFER_START up
+   to TRACE_BUFFER_WRAP, and then from TRACE_BUFFER_LO up to
+   TRACE_BUFFER_FREE.  */
+
+#define DEFAULT_TRACE_BUFFER_SIZE (5 * 1024 * 1024)
+
+static ULONGEST trace_buffer_size = DEFAULT_TRACE_BUFFER_SIZE;
+
+static unsigned char *trace_buffer_lo;
+static unsigned char *trace_buffer_hi;
+static unsigned char *trace_buffer_start;
+static unsigned char *trace_buffer_free;
+static unsigned char *trace_buffer_wrap;
+
+/* The number of frames in the buffer, and the number collected since
+   the experiment started (including those discarded since).  */
+
+static int traceframe_count;
+static int traceframes_created;
+
+/* What starts each frame in the buffer.  The frame's data follows:
+   a series of blocks, each starting with a type character.
+
+   'R' is followed by the whole register cache, in the layout of the
+   'g' packet.
+
+   'r' is followed by a two-byte register number and the register's
+   contents.  Frames with no 'R' block have one of these for each of
+   the target's expedited registers, so that GDB can at least find
+   out where the frame is.
+
+   'M' is followed by an address, a four-byte length, and that many
+   bytes of memory.  */
+
+struct traceframe_header
+{
+  CORE_ADDR pc;
+  int tpnum;
+  unsigned int data_size;
+};
+
+/* Frames are kept aligned, so that the header can be read in
+   place.  */
+
+#define TRACEFRAME_ALIGN(n) (((n) + 7) & ~(ULONGEST) 7)
+#define TRACEFRAME_SIZE(tf) \
+  TRACEFRAME_ALIGN (sizeof (struct traceframe_header) + (tf)->data_size)
+
+/* A frame being collected.  Collection goes into a scratch buffer
+   first, as we don't know how big the frame will be until all the
+   actions have run.  */
+
+struct traceframe
+{
+  unsigned char *data;
+  unsigned int size;
+  unsigned int alloc;
+};
+
+static struct traceframe scratch_frame;
+
+/* The last frame found by find_traceframe, to make walking the
+   buffer in order cheap.  */
+
+static int cached_tfnum = -1;
+static unsigned char *cached_tf;
+
+/* Parse the hex number at P into *VAL, and return a pointer past
+   it.  */
+
+static char *
+unpack_hex (char *p, ULONGEST *val)
+{
+  ULONGEST ret = 0;
+
+  for (;; p++)
+    {
+      int c = *p;
+
+      if (c >= '0' && c <= '9')
+	ret = ret * 16 + c - '0';
+      else if (c >= 'a' && c <= 'f')
+	ret = ret * 16 + c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+	ret = ret * 16 + c - 'A' + 10;
+      else
+	break;
+    }
+
+  *val = ret;
+  return p;
+}
+
+static void
+clear_trace_buffer (void)
+{
+  trace_buffer_start = trace_buffer_free = trace_buffer_lo;
+  trace_buffer_wrap = trace_buffer_hi;
+  traceframe_count = 0;
+  traceframes_created = 0;
+  cached_tfnum = -1;
+}
+
+static void
+discard_oldest_traceframe (void)
+{
+  struct traceframe_header *tf
+    = (struct traceframe_header *) trace_buffer_start;
+
+  trace_buffer_start += TRACEFRAME_SIZE (tf);
+  traceframe_count--;
+
+  /* Once the frames at the top are gone, the buffer is contiguous
+     again.  */
+  if (trace_buffer_start == trace_buffer_wrap)
+    {
+      trace_buffer_start = trace_buffer_lo;
+      trace_buffer_wrap = trace_buffer_hi;
+    }
+
+  cached_tfnum = -1;
+}
+
+/* Make room for AMT bytes in the trace buffer, discarding the oldest
+   frames if necessary.  Returns NULL if AMT is more than the whole
+   buffer.  */
+
+static unsigned char *
+trace_buffer_alloc (ULONGEST amt)
+{
+  unsigned char *p;
+
+  if (amt > trace_buffer_hi - trace_buffer_lo)
+    return NULL;
+
+  while (1)
+    {
+      if (traceframe_count == 0)
+	{
+	  trace_buffer_start = trace_buffer_free = trace_buffer_lo;
+	  trace_buffer_wrap = trace_buffer_hi;
+	}
+
+      if (trace_buffer_free > trace_buffer_start
+	  || (trace_buffer_free == trace_buffer_start
+	      && traceframe_count == 0))
+	{
+	  /* The buffer has not wrapped; the free space is above the
+	     frames (and below them, if the oldest have been
+	     discarded).  */
+	  if (trace_buffer_hi - trace_buffer_free >= amt)
+	    break;
+
+	  trace_buffer_wrap = trace_buffer_free;
+	  trace_buffer_free = trace_buffer_lo;
+	  continue;
+	}
+
+      /* The free space is between the newest and the oldest
+	 frames.  */
+      if (trace_buffer_start - trace_buffer_free >= amt)
+	break;
+
+      discard_oldest_traceframe ();
+    }
+
+  p = trace_buffer_free;
+  trace_buffer_free += amt;
+  return p;
+}
+
+/* Return the frame numbered TFNUM, or NULL if there is none.  */
+
+static struct traceframe_header *
+find_traceframe (int tfnum)
+{
+  unsigned char *tf;
+  int n;
+
+  if (tfnum < 0 || tfnum >= traceframe_count)
+    return NULL;
+
+  if (cached_tfnum >= 0 && cached_tfnum <= tfnum)
+    {
+      n = cached_tfnum;
+      tf = cached_tf;
+    }
+  else
+    {
+      n = 0;
+      tf = trace_buffer_start;
+    }
+
+  for (; n < tfnum; n++)
+    {
+      tf += TRACEFRAME_SIZE ((struct traceframe_header *) tf);
+      if (tf == trace_buffer_wrap)
+	tf = trace_buffer_lo;
+    }
+
+  cached_tfnum = tfnum;
+  cached_tf = tf;
+  return (struct traceframe_header *) tf;
+}
+
+static unsigned char *
+traceframe_data (struct traceframe_header *tf)
+{
+  return (unsigned char *) (tf + 1);
+}
+
+/* Append a block of SIZE bytes, starting with TYPE, to TFRAME.
+   Returns a pointer to the space after the type.  */
+
+static unsigned char *
+traceframe_add_block (struct traceframe *tframe, char type,
+		      unsigned int size)
+{
+  unsigned char *block;
+
+  if (tframe->size + 1 + size > tframe->alloc)
+    {
+      tframe->alloc = 2 * tframe->alloc + 1 + size;
+      tframe->data = realloc (tframe->data, tframe->alloc);
+      if (tframe->data == NULL)
+	fatal ("Could not allocate trace frame.");
+    }
+
+  block = tframe->data + tframe->size;
+  *block = type;
+  tframe->size += 1 + size;
+  return block + 1;
+}
+
+int
+traceframe_record_memory (struct traceframe *tframe, CORE_ADDR addr,
+			  ULONGEST len)
+{
+  unsigned char *block;
+  unsigned int len32 = len;
+  unsigned int old_size = tframe->size;
+
+  /* Nothing that big would fit in the trace buffer anyway.  */
+  if (len == 0 || len > trace_buffer_size)
+    return -1;
+
+  block = traceframe_add_block (tframe, 'M', sizeof (addr) + 4 + len);
+  memcpy (block, &addr, sizeof (addr));
+  memcpy (block + sizeof (addr), &len32, 4);
+  if (read_inferior_memory (addr, block + sizeof (addr) + 4, len) != 0)
+    {
+      tframe->size = old_size;
+      return -1;
+    }
+
+  return 0;
+}
+
+static void
+traceframe_record_registers (struct traceframe *tframe)
+{
+  unsigned char *block;
+
+  block = traceframe_add_block (tframe, 'R', register_cache_size ());
+  registers_to_raw (block);
+}
+
+static void
+traceframe_record_register (struct traceframe *tframe, int regnum)
+{
+  unsigned char *block;
+  unsigned short regnum16 = regnum;
+
+  block = traceframe_add_block (tframe, 'r', 2 + register_size (regnum));
+  memcpy (block, &regnum16, 2);
+  collect_register (regnum, block + 2);
+}
+
+/* Run TPOINT's actions, and store what they collect as a new trace
+   frame.  The current inferior is the thread that hit it.  */
+
+static void
+collect_data_at_tracepoint (struct tracepoint *tpoint)
+{
+  struct traceframe *tframe = &scratch_frame;
+  struct tracepoint_action *action;
+  struct traceframe_header *tf;
+  int have_registers = 0;
+
+  tframe->size = 0;
+
+  for (action = tpoint->actions; action != NULL; action = action->next)
+    switch (action->type)
+      {
+      case 'R':
+	if (!have_registers)
+	  traceframe_record_registers (tframe);
+	have_registers = 1;
+	break;
+
+      case 'M':
+	{
+	  CORE_ADDR addr = action->offset;
+
+	  if (action->basereg >= 0)
+	    {
+	      ULONGEST base = 0;
+	      int size = register_size (action->basereg);
+
+	      if (size > sizeof (base))
+		break;
+
+	      /* Registers come in the target's byte order, which is
+		 ours.  */
+	      collect_register (action->basereg,
+				(unsigned char *) &base
+#ifdef WORDS_BIGENDIAN
+				+ sizeof (base) - size
+#endif
+				);
+	      addr += base;
+	    }
+
+	  if (traceframe_record_memory (tframe, addr, action->len) != 0
+	      && debug_threads)
+	    fprintf (stderr, "Tracepoint %d: can't collect %08llx,%lld\n",
+		     tpoint->number, (long long) addr,
+		     (long long) action->len);
+	}
+	break;
+
+      case 'X':
+	{
+	  enum eval_result_type err;
+
+	  err = eval_agent_expr (action->expr, tframe, NULL);
+	  if (err != expr_eval_no_error && debug_threads)
+	    fprintf (stderr, "Tracepoint %d: expression failed: %d\n",
+		     tpoint->number, (int) err);
+	}
+	break;
+      }
+
+  if (!have_registers && gdbserver_expedite_regs != NULL)
+    {
+      const char **regp;
+
+      for (regp = gdbserver_expedite_regs; *regp != NULL; regp++)
+	traceframe_record_register (tframe, find_regno (*regp));
+    }
+
+  tf = (struct traceframe_header *)
+    trace_buffer_alloc (TRACEFRAME_ALIGN (sizeof (*tf) + tframe->size));
+  if (tf == NULL)
+    {
+      if (debug_threads)
+	fprintf (stderr, "Tracepoint %d: frame of %u bytes does not fit\n",
+		 tpoint->number, tframe->size);
+      return;
+    }
+
+  tf->pc = tpoint->address;
+  tf->tpnum = tpoint->number;
+  tf->data_size = tframe->size;
+  memcpy (traceframe_data (tf), tframe->data, tframe->size);
+  traceframe_count++;
+  traceframes_created++;
+}
+
+static void stop_tracing (void);
+
+/* The breakpoint handler for tracepoints.  Collect a frame for each
+   enabled tracepoint at STOP_PC.  Returns 1 to delete the breakpoint
+   once the experiment is over.  */
+
+static int
+tracepoint_handler (CORE_ADDR stop_pc)
+{
+  struct tracepoint *tpoint;
+  CORE_ADDR saved_pc = 0;
+  int fix_pc;
+
+  if (!tracing)
+    {
+      for (tpoint = tracepoints; tpoint != NULL; tpoint = tpoint->next)
+	if (tpoint->address == stop_pc)
+	  tpoint->inserted = 0;
+      return 1;
+    }
+
+  /* The thread's PC may still point past the breakpoint; record the
+     address of the tracepoint instead.  */
+  fix_pc = (the_target->read_pc != NULL && the_target->write_pc != NULL);
+  if (fix_pc)
+    {
+      saved_pc = (*the_target->read_pc) ();
+      (*the_target->write_pc) (stop_pc);
+    }
+
+  for (tpoint = tracepoints; tpoint != NULL; tpoint = tpoint->next)
+    {
+      if (tpoint->address != stop_pc || !tpoint->enabled)
+	continue;
+
+      tpoint->hit_count++;
+      collect_data_at_tracepoint (tpoint);
+
+      if (tpoint->pass_count != 0
+	  && tpoint->hit_count >= tpoint->pass_count)
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Tracepoint %d reached its pass count.\n",
+		     tpoint->number);
+	  tracing = 0;
+	  break;
+	}
+    }
+
+  if (fix_pc)
+    (*the_target->write_pc) (saved_pc);
+
+  if (!tracing)
+    {
+      /* The other tracepoints' breakpoints go the next time they are
+	 hit, or at QTStop.  */
+      for (tpoint = tracepoints; tpoint != NULL; tpoint = tpoint->next)
+	if (tpoint->address == stop_pc)
+	  tpoint->inserted = 0;
+      return 1;
+    }
+
+  return 0;
+}
+
+static void
+start_tracing (void)
+{
+  struct tracepoint *tpoint, *other;
+
+  if (trace_buffer_lo == NULL
+      || trace_buffer_hi - trace_buffer_lo != trace_buffer_size)
+    {
+      free (trace_buffer_lo);
+      trace_buffer_lo = malloc (trace_buffer_size);
+      if (trace_buffer_lo == NULL)
+	error ("Could not allocate a trace buffer of %llu bytes.",
+	       trace_buffer_size);
+      trace_buffer_hi = trace_buffer_lo + trace_buffer_size;
+    }
+  clear_trace_buffer ();
+  current_traceframe = -1;
+
+  for (tpoint = tracepoints; tpoint != NULL; tpoint = tpoint->next)
+    {
+      tpoint->hit_count = 0;
+      if (!tpoint->enabled)
+	continue;
+
+      for (other = tracepoints; other != NULL; other = other->next)
+	if (other->inserted && other->address == tpoint->address)
+	  break;
+
+      if (other == NULL)
+	{
+	  set_breakpoint_at (tpoint->address, tracepoint_handler);
+	  tpoint->inserted = 1;
+	}
+    }
+
+  tracing = 1;
+}
+
+static void
+stop_tracing (void)
+{
+  struct tracepoint *tpoint;
+
+  tracing = 0;
+
+  for (tpoint = tracepoints; tpoint != NULL; tpoint = tpoint->next)
+    if (tpoint->inserted)
+      {
+	if (target_running ())
+	  delete_breakpoint_at (tpoint->address);
+	tpoint->inserted = 0;
+      }
+}
+
+static void
+free_tracepoint (struct tracepoint *tpoint)
+{
+  while (tpoint->actions != NULL)
+    {
+      struct tracepoint_action *action = tpoint->actions;
+
+      tpoint->actions = action->next;
+      free_agent_expr (action->expr);
+      free (action);
+    }
+
+  free (tpoint);
+}
+
+/* Handle QTinit: forget all tracepoints and collected data.  */
+
+static void
+cmd_qtinit (char *own_buf)
+{
+  stop_tracing ();
+
+  while (tracepoints != NULL)
+    {
+      struct tracepoint *tpoint = tracepoints;
+
+      tracepoints = tpoint->next;
+      free_tracepoint (tpoint);
+    }
+  last_tracepoint = NULL;
+
+  free (readonly_regions);
+  readonly_regions = NULL;
+  readonly_region_count = 0;
+
+  clear_trace_buffer ();
+  current_traceframe = -1;
+
+  write_ok (own_buf);
+}
+
+/* Parse the actions in a QTDP packet at P, adding them to TPOINT.
+   Returns zero if they are malformed, or ask for something we can't
+   do.  */
+
+static int
+parse_tracepoint_actions (struct tracepoint *tpoint, char *p)
+{
+  struct tracepoint_action **tail;
+
+  for (tail = &tpoint->actions; *tail != NULL; tail = &(*tail)->next)
+    ;
+
+  while (*p != '\0' && *p != '-')
+    {
+      struct tracepoint_action *action;
+      ULONGEST val;
+
+      action = malloc (sizeof (*action));
+      memset (action, 0, sizeof (*action));
+      action->type = *p++;
+
+      switch (action->type)
+	{
+	case 'R':
+	  /* We always collect all the registers, so the mask doesn't
+	     matter.  */
+	  p = unpack_hex (p, &val);
+	  break;
+
+	case 'M':
+	  if (strncmp (p, "-1", 2) == 0)
+	    {
+	      action->basereg = -1;
+	      p += 2;
+	    }
+	  else
+	    {
+	      p = unpack_hex (p, &val);
+	      action->basereg = val;
+	      if (action->basereg >= register_count ())
+		goto bad;
+	    }
+	  if (*p++ != ',')
+	    goto bad;
+	  p = unpack_hex (p, &action->offset);
+	  if (*p++ != ',')
+	    goto bad;
+	  p = unpack_hex (p, &action->len);
+	  break;
+
+	case 'X':
+	  action->expr = parse_agent_expr (&p);
+	  if (action->expr == NULL)
+	    goto bad;
+	  break;
+
+	default:
+	  /* Including 'S': we don't single-step after a hit, so
+	     while-stepping actions are not supported.  */
+	  goto bad;
+	}
+
+      *tail = action;
+      tail = &action->next;
+      continue;
+
+    bad:
+      free (action);
+      return 0;
+    }
+
+  return 1;
+}
+
+/* Handle QTDP, which defines a tracepoint or adds actions to the one
+   defined last.  */
+
+static void
+cmd_qtdp (char *own_buf)
+{
+  char *p = own_buf + strlen ("QTDP:");
+  int more_actions = 0;
+  ULONGEST num, addr;
+  struct tracepoint *tpoint;
+
+  if (*p == '-')
+    {
+      more_actions = 1;
+      p++;
+    }
+
+  p = unpack_hex (p, &num);
+  if (*p++ != ':')
+    goto bad;
+  p = unpack_hex (p, &addr);
+  if (*p++ != ':')
+    goto bad;
+
+  if (more_actions)
+    {
+      tpoint = last_tracepoint;
+      if (tpoint == NULL || tpoint->number != num
+	  || tpoint->address != addr)
+	goto bad;
+    }
+  else
+    {
+      ULONGEST step, pass;
+      int enabled;
+
+      if (*p != 'E' && *p != 'D')
+	goto bad;
+      enabled = (*p++ == 'E');
+      if (*p++ != ':')
+	goto bad;
+      p = unpack_hex (p, &step);
+      if (*p++ != ':')
+	goto bad;
+      p = unpack_hex (p, &pass);
+
+      tpoint = malloc (sizeof (*tpoint));
+      memset (tpoint, 0, sizeof (*tpoint));
+      tpoint->number = num;
+      tpoint->address = addr;
+      tpoint->enabled = enabled;
+      tpoint->pass_count = pass;
+
+      if (last_tracepoint == NULL)
+	tracepoints = tpoint;
+      else
+	last_tracepoint->next = tpoint;
+      last_tracepoint = tpoint;
+
+      if (*p != '\0' && *p != '-')
+	goto bad;
+      write_ok (own_buf);
+      return;
+    }
+
+  if (!parse_tracepoint_actions (tpoint, p))
+    goto bad;
+
+  write_ok (own_buf);
+  return;
+
+ bad:
+  write_enn (own_buf);
+}
+
+/* Handle QTro, which lists the read-only sections.  */
+
+static void
+cmd_qtro (char *own_buf)
+{
+  char *p = own_buf + strlen ("QTro");
+  int n = 0;
+
+  free (readonly_regions);
+  readonly_regions = NULL;
+  readonly_region_count = 0;
+
+  while (*p == ':')
+    {
+      ULONGEST start, end;
+
+      p = unpack_hex (p + 1, &start);
+      if (*p++ != ',')
+	break;
+      p = unpack_hex (p, &end);
+
+      readonly_regions = realloc (readonly_regions,
+				  (n + 1) * sizeof (*readonly_regions));
+      readonly_regions[n].start = start;
+      readonly_regions[n].end = end;
+      n++;
+    }
+
+  readonly_region_count = n;
+  write_ok (own_buf);
+}
+
+/* Does the frame TF match a QTFrame search?  */
+
+enum tfind_type
+  {
+    tfind_pc,
+    tfind_tp,
+    tfind_range,
+    tfind_outside
+  };
+
+static int
+traceframe_matches (struct traceframe_header *tf, enum tfind_type type,
+		    ULONGEST lo, ULONGEST hi)
+{
+  switch (type)
+    {
+    case tfind_pc:
+      return tf->pc == lo;
+    case tfind_tp:
+      return tf->tpnum == lo;
+    case tfind_range:
+      return tf->pc >= lo && tf->pc <= hi;
+    case tfind_outside:
+      return tf->pc < lo || tf->pc > hi;
+    }
+
+  return 0;
+}
+
+/* Handle QTFrame.  */
+
+static void
+cmd_qtframe (char *own_buf)
+{
+  char *p = own_buf + strlen ("QTFrame:");
+  struct traceframe_header *tf = NULL;
+  int tfnum;
+
+  if (strncmp (p, "pc:", 3) == 0 || strncmp (p, "tdp:", 4) == 0
+      || strncmp (p, "range:", 6) == 0 || strncmp (p, "outside:", 8) == 0)
+    {
+      enum tfind_type type;
+      ULONGEST lo, hi = 0;
+
+      if (*p == 'p')
+	type = tfind_pc;
+      else if (*p == 't')
+	type = tfind_tp;
+      else if (*p == 'r')
+	type = tfind_range;
+      else
+	type = tfind_outside;
+
+      p = strchr (p, ':') + 1;
+      p = unpack_hex (p, &lo);
+      if (type == tfind_range || type == tfind_outside)
+	{
+	  if (*p++ != ':')
+	    {
+	      write_enn (own_buf);
+	      return;
+	    }
+	  p = unpack_hex (p, &hi);
+	}
+
+      /* Search forward from the selected frame.  */
+      for (tfnum = current_traceframe + 1;
+	   (tf = find_traceframe (tfnum)) != NULL;
+	   tfnum++)
+	if (traceframe_matches (tf, type, lo, hi))
+	  break;
+    }
+  else
+    {
+      ULONGEST num;
+
+      unpack_hex (p, &num);
+      tfnum = (int) num;
+
+      /* GDB selects no frame at all with -1.  */
+      if (tfnum == -1)
+	{
+	  current_traceframe = -1;
+	  write_ok (own_buf);
+	  return;
+	}
+
+      tf = find_traceframe (tfnum);
+    }
+
+  if (tf == NULL)
+    {
+      strcpy (own_buf, "F-1");
+      return;
+    }
+
+  current_traceframe = tfnum;
+  sprintf (own_buf, "F%xT%x", tfnum, tf->tpnum);
+}
+
+/* Handle QTBuffer:size, which sets the size of the trace buffer used
+   by the next experiment.  */
+
+static void
+cmd_qtbuffer (char *own_buf)
+{
+  char *p = own_buf + strlen ("QTBuffer:size:");
+  ULONGEST size;
+
+  if (tracing)
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  if (strcmp (p, "-1") == 0)
+    size = DEFAULT_TRACE_BUFFER_SIZE;
+  else
+    {
+      unpack_hex (p, &size);
+      /* Leave room for at least one small frame.  */
+      if (size < 1024)
+	size = 1024;
+    }
+
+  trace_buffer_size = size;
+  write_ok (own_buf);
+}
+
+int
+handle_tracepoint_general_set (char *own_buf)
+{
+  if (strcmp ("QTinit", own_buf) == 0)
+    cmd_qtinit (own_buf);
+  else if (strncmp ("QTDP:", own_buf, strlen ("QTDP:")) == 0)
+    cmd_qtdp (own_buf);
+  else if (strncmp ("QTro", own_buf, strlen ("QTro")) == 0)
+    cmd_qtro (own_buf);
+  else if (strcmp ("QTStart", own_buf) == 0)
+    {
+      if (!target_running () || !breakpoints_supported ())
+	write_enn (own_buf);
+      else
+	{
+	  start_tracing ();
+	  write_ok (own_buf);
+	}
+    }
+  else if (strcmp ("QTStop", own_buf) == 0)
+    {
+      stop_tracing ();
+      write_ok (own_buf);
+    }
+  else if (strncmp ("QTFrame:", own_buf, strlen ("QTFrame:")) == 0)
+    cmd_qtframe (own_buf);
+  else if (strncmp ("QTBuffer:size:", own_buf,
+		    strlen ("QTBuffer:size:")) == 0)
+    cmd_qtbuffer (own_buf);
+  else
+    return 0;
+
+  return 1;
+}
+
+int
+handle_tracepoint_query (char *own_buf)
+{
+  if (strcmp ("qTStatus", own_buf) == 0)
+    {
+      ULONGEST used;
+
+      if (traceframe_count == 0)
+	used = 0;
+      else if (trace_buffer_free > trace_buffer_start)
+	used = trace_buffer_free - trace_buffer_start;
+      else
+	used = ((trace_buffer_wrap - trace_buffer_start)
+		+ (trace_buffer_free - trace_buffer_lo));
+
+      sprintf (own_buf, "T%d;tframes:%x;tcreated:%x;tfree:%llx;tsize:%llx",
+	       tracing ? 1 : 0, traceframe_count, traceframes_created,
+	       trace_buffer_lo == NULL ? trace_buffer_size
+	       : (ULONGEST) (trace_buffer_hi - trace_buffer_lo) - used,
+	       trace_buffer_lo == NULL ? trace_buffer_size
+	       : (ULONGEST) (trace_buffer_hi - trace_buffer_lo));
+      return 1;
+    }
+
+  return 0;
+}
+
+void
+traceframe_registers_to_string (int tfnum, char *buf)
+{
+  struct traceframe_header *tf = find_traceframe (tfnum);
+  int size = register_cache_size ();
+  unsigned char *p, *end;
+
+  /* Registers we didn't collect are unavailable.  */
+  memset (buf, 'x', 2 * size);
+  buf[2 * size] = '\0';
+
+  if (tf == NULL)
+    return;
+
+  p = traceframe_data (tf);
+  end = p + tf->data_size;
+  while (p < end)
+    {
+      char type = *p++;
+
+      if (type == 'R')
+	{
+	  convert_int_to_ascii (p, buf, size);
+	  p += size;
+	}
+      else if (type == 'r')
+	{
+	  unsigned short regnum;
+	  int offset;
+
+	  char *hex, saved;
+
+	  memcpy (&regnum, p, 2);
+	  offset = find_register_by_number (regnum)->offset / 8;
+
+	  /* convert_int_to_ascii terminates its output; don't let that
+	     cut off the registers after this one.  */
+	  hex = buf + 2 * (offset + register_size (regnum));
+	  saved = *hex;
+	  convert_int_to_ascii (p + 2, buf + 2 * offset,
+				register_size (regnum));
+	  *hex = saved;
+	  p += 2 + register_size (regnum);
+	}
+      else
+	{
+	  unsigned int len;
+
+	  memcpy (&len, p + sizeof (CORE_ADDR), 4);
+	  p += sizeof (CORE_ADDR) + 4 + len;
+	}
+    }
+}
+
+int
+traceframe_read_mem (int tfnum, CORE_ADDR addr, unsigned char *buf,
+		     ULONGEST length, ULONGEST *nbytes)
+{
+  struct traceframe_header *tf = find_traceframe (tfnum);
+  unsigned char *p, *end;
+  ULONGEST avail = length;
+  int i;
+
+  *nbytes = 0;
+  if (tf == NULL)
+    return -1;
+
+  p = traceframe_data (tf);
+  end = p + tf->data_size;
+  while (p < end)
+    {
+      char type = *p++;
+
+      if (type == 'M')
+	{
+	  CORE_ADDR maddr;
+	  unsigned int mlen;
+
+	  memcpy (&maddr, p, sizeof (maddr));
+	  memcpy (&mlen, p + sizeof (maddr), 4);
+
+	  if (addr >= maddr && addr < maddr + mlen)
+	    {
+	      if (length > maddr + mlen - addr)
+		length = maddr + mlen - addr;
+	      memcpy (buf, p + sizeof (maddr) + 4 + (addr - maddr), length);
+	      *nbytes = length;
+	      return 0;
+	    }
+
+	  /* Don't let a read from elsewhere hide this block.  */
+	  if (maddr > addr && maddr - addr < avail)
+	    avail = maddr - addr;
+
+	  p += sizeof (maddr) + 4 + mlen;
+	}
+      else if (type == 'R')
+	p += register_cache_size ();
+      else
+	{
+	  unsigned short regnum;
+
+	  memcpy (&regnum, p, 2);
+	  p += 2 + register_size (regnum);
+	}
+    }
+
+  /* Read-only memory is the same now as when the frame was
+     collected.  */
+  for (i = 0; i < readonly_region_count; i++)
+    if (addr >= readonly_regions[i].start && addr < readonly_regions[i].end)
+      {
+	if (avail > readonly_regions[i].end - addr)
+	  avail = readonly_regions[i].end - addr;
+	if (!target_running ()
+	    || read_inferior_memory (addr, buf, avail) != 0)
+	  return -1;
+	*nbytes = avail;
+	return 0;
+      }
+
+  return -1;
+}
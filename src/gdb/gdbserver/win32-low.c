@@ -727,6 +727,9 @@ win32_detach (void)
     resume.step = 0;
     resume.sig = 0;
     resume.leave_stopped = 0;
+    resume.stop = 0;
+    resume.step_range_start = 0;
+    resume.step_range_end = 0;
     win32_resume (&resume);
   }
 
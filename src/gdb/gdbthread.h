@@ -126,6 +126,11 @@ extern void delete_thread (ptid_t);
    exited, for example.  */
 extern void delete_thread_silent (ptid_t);
 
+/* Change the ptid of the thread whose ptid is OLD_PTID to NEW_PTID.
+   Used when a target learns the real id of a thread it has already
+   added.  */
+extern void thread_change_ptid (ptid_t old_ptid, ptid_t new_ptid);
+
 /* Delete a step_resume_breakpoint from the thread database. */
 extern void delete_step_resume_breakpoint (void *);
 
@@ -22,6 +22,8 @@
 #include "command.h"
 #include "gdbcmd.h"
 #include "target.h"
+#include "gdb_assert.h"
+#include "gdb_string.h"
 
 /* Support for hardware watchpoints and breakpoints using the i386
    debug registers.
@@ -55,7 +57,11 @@
 				  status (DR6) register.
 
    The functions below implement debug registers sharing by reference
-   counts, and allow to watch regions up to 16 bytes long.  */
+   counts, and allow to watch regions up to 16 bytes long.  When the
+   regions to watch don't fit in the debug registers one by one,
+   adjacent and overlapping regions with the same access type are
+   merged, so that e.g. the fields of a small structure watched
+   separately can share debug registers.  */
 
 #ifdef I386_USE_GENERIC_WATCHPOINTS
 
@@ -105,7 +111,7 @@
 
    Currently, all watchpoint are locally enabled.  If you need to
    enable them globally, read the comment which pertains to this in
-   i386_insert_aligned_watchpoint below.  */
+   i386_apply_layout below.  */
 #define DR_LOCAL_ENABLE_SHIFT	0 /* Extra shift to the local enable bit.  */
 #define DR_GLOBAL_ENABLE_SHIFT	1 /* Extra shift to the global enable bit.  */
 #define DR_ENABLE_SIZE		2 /* Two enable bits per debug register.  */
@@ -175,8 +181,34 @@ static int dr_ref_count[DR_NADDR];
 /* Whether or not to print the mirrored debug registers.  */
 static int maint_show_dr;
 
-/* Types of operations supported by i386_handle_nonaligned_watchpoint.  */
-typedef enum { WP_INSERT, WP_REMOVE, WP_COUNT } i386_wp_op_t;
+/* A region of memory GDB asked us to watch, or, when TYPE is
+   hw_execute, an address GDB asked us to break at.  Requests for the
+   same region and type share one entry.  */
+struct i386_dr_request
+{
+  struct i386_dr_request *next;
+  CORE_ADDR addr;
+  int len;
+  enum target_hw_bp_type type;
+  int ref_count;
+};
+
+/* All the outstanding requests.  The debug registers are always
+   programmed from this list; see i386_update_dregs.  */
+static struct i386_dr_request *dr_requests;
+
+/* An assignment of aligned regions to debug registers.  */
+struct i386_dr_layout
+{
+  /* The number of debug registers used.  */
+  int count;
+
+  /* The address, DR7 length and access bits, and number of users of
+     each debug register used.  */
+  CORE_ADDR addr[DR_NADDR];
+  unsigned len_rw[DR_NADDR];
+  int ref_count[DR_NADDR];
+};
 
 /* Internal functions.  */
 
@@ -185,31 +217,19 @@ typedef enum { WP_INSERT, WP_REMOVE, WP_COUNT } i386_wp_op_t;
    have the value of 1, 2, or 4.  */
 static unsigned i386_length_and_rw_bits (int len, enum target_hw_bp_type type);
 
-/* Insert a watchpoint at address ADDR, which is assumed to be aligned
-   according to the length of the region to watch.  LEN_RW_BITS is the
-   value of the bit-field from DR7 which describes the length and
-   access type of the region to be watched by this watchpoint.  Return
-   0 on success, -1 on failure.  */
-static int i386_insert_aligned_watchpoint (CORE_ADDR addr,
-					   unsigned len_rw_bits);
-
-/* Remove a watchpoint at address ADDR, which is assumed to be aligned
-   according to the length of the region to watch.  LEN_RW_BITS is the
-   value of the bits from DR7 which describes the length and access
-   type of the region watched by this watchpoint.  Return 0 on
-   success, -1 on failure.  */
-static int i386_remove_aligned_watchpoint (CORE_ADDR addr,
-					   unsigned len_rw_bits);
-
-/* Insert or remove a (possibly non-aligned) watchpoint, or count the
-   number of debug registers required to watch a region at address
-   ADDR whose length is LEN for accesses of type TYPE.  Return 0 on
-   successful insertion or removal, a positive number when queried
-   about the number of registers, or -1 on failure.  If WHAT is not a
-   valid value, bombs through internal_error.  */
-static int i386_handle_nonaligned_watchpoint (i386_wp_op_t what,
-					      CORE_ADDR addr, int len,
-					      enum target_hw_bp_type type);
+/* Add the aligned regions needed to watch a (possibly non-aligned)
+   region at address ADDR whose length is LEN for accesses of type
+   TYPE to LAYOUT, sharing debug registers with identical regions
+   already there.  USERS is added to the reference count of each
+   debug register used.  Return 0 on success, or -1 if LAYOUT runs
+   out of debug registers.  */
+static int i386_layout_add_region (struct i386_dr_layout *layout,
+				   CORE_ADDR addr, int len,
+				   enum target_hw_bp_type type, int users);
+
+/* Program the debug registers according to the outstanding requests.
+   Return 0 on success, or -1 if they don't fit.  */
+static int i386_update_dregs (void);
 
 /* Implementation.  */
 
@@ -221,6 +241,14 @@ i386_cleanup_dregs (void)
 {
   int i;
 
+  while (dr_requests != NULL)
+    {
+      struct i386_dr_request *r = dr_requests;
+
+      dr_requests = r->next;
+      xfree (r);
+    }
+
   ALL_DEBUG_REGISTERS(i)
     {
       dr_mirror[i] = 0;
@@ -327,194 +355,372 @@ Invalid hardware breakpoint length %d in i386_length_and_rw_bits.\n"), len);
     }
 }
 
-/* Insert a watchpoint at address ADDR, which is assumed to be aligned
-   according to the length of the region to watch.  LEN_RW_BITS is the
-   value of the bits from DR7 which describes the length and access
-   type of the region to be watched by this watchpoint.  Return 0 on
-   success, -1 on failure.  */
+/* Add the aligned regions needed to watch a (possibly non-aligned)
+   region at address ADDR whose length is LEN for accesses of type
+   TYPE to LAYOUT, sharing debug registers with identical regions
+   already there.  USERS is added to the reference count of each
+   debug register used.  Return 0 on success, or -1 if LAYOUT runs
+   out of debug registers.  */
 
 static int
-i386_insert_aligned_watchpoint (CORE_ADDR addr, unsigned len_rw_bits)
+i386_layout_add_region (struct i386_dr_layout *layout,
+			CORE_ADDR addr, int len,
+			enum target_hw_bp_type type, int users)
 {
-  int i;
+  int max_wp_len = TARGET_HAS_DR_LEN_8 ? 8 : 4;
 
-  /* First, look for an occupied debug register with the same address
-     and the same RW and LEN definitions.  If we find one, we can
-     reuse it for this watchpoint as well (and save a register).  */
-  ALL_DEBUG_REGISTERS(i)
+  static int size_try_array[8][8] =
+  {
+    {1, 1, 1, 1, 1, 1, 1, 1},	/* Trying size one.  */
+    {2, 1, 2, 1, 2, 1, 2, 1},	/* Trying size two.  */
+    {2, 1, 2, 1, 2, 1, 2, 1},	/* Trying size three.  */
+    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size four.  */
+    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size five.  */
+    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size six.  */
+    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size seven.  */
+    {8, 1, 2, 1, 4, 1, 2, 1},	/* Trying size eight.  */
+  };
+
+  while (len > 0)
     {
-      if (!I386_DR_VACANT (i)
-	  && dr_mirror[i] == addr
-	  && I386_DR_GET_RW_LEN (i) == len_rw_bits)
+      int align = addr % max_wp_len;
+      /* Four (eight on AMD64) is the maximum length a debug register
+	 can watch.  */
+      int try = (len > max_wp_len ? (max_wp_len - 1) : len - 1);
+      int size = size_try_array[try][align];
+      unsigned len_rw = i386_length_and_rw_bits (size, type);
+      int i;
+
+      /* size_try_array[] is defined such that each iteration through
+	 the loop is guaranteed to produce an address and a size that
+	 can be watched with a single debug register.  */
+      for (i = 0; i < layout->count; i++)
+	if (layout->addr[i] == addr && layout->len_rw[i] == len_rw)
+	  break;
+
+      if (i == layout->count)
 	{
-	  dr_ref_count[i]++;
-	  return 0;
+	  /* No more debug registers!  */
+	  if (layout->count == DR_NADDR)
+	    return -1;
+
+	  layout->addr[i] = addr;
+	  layout->len_rw[i] = len_rw;
+	  layout->ref_count[i] = 0;
+	  layout->count++;
 	}
-    }
+      layout->ref_count[i] += users;
 
-  /* Next, look for a vacant debug register.  */
-  ALL_DEBUG_REGISTERS(i)
-    {
-      if (I386_DR_VACANT (i))
-	break;
+      addr += size;
+      len -= size;
     }
 
-  /* No more debug registers!  */
-  if (i >= DR_NADDR)
-    return -1;
+  return 0;
+}
 
-  /* Now set up the register I to watch our region.  */
-
-  /* Record the info in our local mirrored array.  */
-  dr_mirror[i] = addr;
-  dr_ref_count[i] = 1;
-  I386_DR_SET_RW_LEN (i, len_rw_bits);
-  /* Note: we only enable the watchpoint locally, i.e. in the current
-     task.  Currently, no i386 target allows or supports global
-     watchpoints; however, if any target would want that in the
-     future, GDB should probably provide a command to control whether
-     to enable watchpoints globally or locally, and the code below
-     should use global or local enable and slow-down flags as
-     appropriate.  */
-  I386_DR_LOCAL_ENABLE (i);
-  dr_control_mirror |= DR_LOCAL_SLOWDOWN;
-  dr_control_mirror &= I386_DR_CONTROL_MASK;
-
-  /* Finally, actually pass the info to the inferior.  */
-  I386_DR_LOW_SET_ADDR (i, addr);
-  I386_DR_LOW_SET_CONTROL (dr_control_mirror);
+/* Compare two requests by access type, then by address, for
+   qsort.  */
 
+static int
+i386_dr_request_compare (const void *ap, const void *bp)
+{
+  const struct i386_dr_request *a = ap;
+  const struct i386_dr_request *b = bp;
+  unsigned a_rw = i386_length_and_rw_bits (1, a->type);
+  unsigned b_rw = i386_length_and_rw_bits (1, b->type);
+
+  if (a_rw != b_rw)
+    return a_rw < b_rw ? -1 : 1;
+  if (a->addr != b->addr)
+    return a->addr < b->addr ? -1 : 1;
   return 0;
 }
 
-/* Remove a watchpoint at address ADDR, which is assumed to be aligned
-   according to the length of the region to watch.  LEN_RW_BITS is the
-   value of the bits from DR7 which describes the length and access
-   type of the region watched by this watchpoint.  Return 0 on
-   success, -1 on failure.  */
+/* Compute in LAYOUT the debug registers needed for all the
+   outstanding requests.  If COALESCE is non-zero, merge adjacent and
+   overlapping data regions with the same access type first.  Return
+   0 on success, or -1 if the requests don't fit.  */
 
 static int
-i386_remove_aligned_watchpoint (CORE_ADDR addr, unsigned len_rw_bits)
+i386_compute_layout (struct i386_dr_layout *layout, int coalesce)
 {
-  int i, retval = -1;
+  struct i386_dr_request *r, *sorted;
+  int i, j, n, retval = 0;
 
-  ALL_DEBUG_REGISTERS(i)
+  memset (layout, 0, sizeof (*layout));
+
+  if (!coalesce)
     {
-      if (!I386_DR_VACANT (i)
-	  && dr_mirror[i] == addr
-	  && I386_DR_GET_RW_LEN (i) == len_rw_bits)
+      for (r = dr_requests; r != NULL; r = r->next)
+	if (i386_layout_add_region (layout, r->addr, r->len, r->type,
+				    r->ref_count) != 0)
+	  return -1;
+      return 0;
+    }
+
+  n = 0;
+  for (r = dr_requests; r != NULL; r = r->next)
+    n++;
+  if (n == 0)
+    return 0;
+
+  sorted = xmalloc (n * sizeof (struct i386_dr_request));
+  n = 0;
+  for (r = dr_requests; r != NULL; r = r->next)
+    sorted[n++] = *r;
+  qsort (sorted, n, sizeof (struct i386_dr_request),
+	 i386_dr_request_compare);
+
+  for (i = 0; i < n && retval == 0; i = j)
+    {
+      unsigned rw = i386_length_and_rw_bits (1, sorted[i].type);
+      CORE_ADDR start = sorted[i].addr;
+      CORE_ADDR end = start + sorted[i].len;
+      int users = sorted[i].ref_count;
+
+      /* Hardware breakpoints always watch a single byte, so there is
+	 nothing to gain by merging them.  */
+      for (j = i + 1; j < n; j++)
 	{
-	  if (--dr_ref_count[i] == 0) /* no longer in use? */
-	    {
-	      /* Reset our mirror.  */
-	      dr_mirror[i] = 0;
-	      I386_DR_DISABLE (i);
-	      /* Reset it in the inferior.  */
-	      I386_DR_LOW_SET_CONTROL (dr_control_mirror);
-	      I386_DR_LOW_RESET_ADDR (i);
-	    }
-	  retval = 0;
+	  if (rw == DR_RW_EXECUTE
+	      || i386_length_and_rw_bits (1, sorted[j].type) != rw
+	      || sorted[j].addr > end)
+	    break;
+
+	  if (sorted[j].addr + sorted[j].len > end)
+	    end = sorted[j].addr + sorted[j].len;
+	  users += sorted[j].ref_count;
 	}
+
+      retval = i386_layout_add_region (layout, start, end - start,
+				       sorted[i].type, users);
     }
 
+  xfree (sorted);
   return retval;
 }
 
-/* Insert or remove a (possibly non-aligned) watchpoint, or count the
-   number of debug registers required to watch a region at address
-   ADDR whose length is LEN for accesses of type TYPE.  Return 0 on
-   successful insertion or removal, a positive number when queried
-   about the number of registers, or -1 on failure.  If WHAT is not a
-   valid value, bombs through internal_error.  */
+/* Program the debug registers according to LAYOUT.  Registers which
+   already watch a region of LAYOUT are left alone.  */
 
-static int
-i386_handle_nonaligned_watchpoint (i386_wp_op_t what, CORE_ADDR addr, int len,
-				   enum target_hw_bp_type type)
+static void
+i386_apply_layout (const struct i386_dr_layout *layout)
 {
-  int retval = 0, status = 0;
-  int max_wp_len = TARGET_HAS_DR_LEN_8 ? 8 : 4;
+  int slot[DR_NADDR], used[DR_NADDR], freed[DR_NADDR];
+  unsigned old_control = dr_control_mirror;
+  int i, j;
 
-  static int size_try_array[8][8] =
-  {
-    {1, 1, 1, 1, 1, 1, 1, 1},	/* Trying size one.  */
-    {2, 1, 2, 1, 2, 1, 2, 1},	/* Trying size two.  */
-    {2, 1, 2, 1, 2, 1, 2, 1},	/* Trying size three.  */
-    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size four.  */
-    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size five.  */
-    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size six.  */
-    {4, 1, 2, 1, 4, 1, 2, 1},	/* Trying size seven.  */
-    {8, 1, 2, 1, 4, 1, 2, 1},	/* Trying size eight.  */
-  };
+  ALL_DEBUG_REGISTERS(i)
+    {
+      used[i] = 0;
+      freed[i] = 0;
+    }
 
-  while (len > 0)
+  /* First, find the regions which are already being watched.  */
+  for (j = 0; j < layout->count; j++)
     {
-      int align = addr % max_wp_len;
-      /* Four (eight on AMD64) is the maximum length a debug register
-	 can watch.  */
-      int try = (len > max_wp_len ? (max_wp_len - 1) : len - 1);
-      int size = size_try_array[try][align];
+      slot[j] = -1;
+      ALL_DEBUG_REGISTERS(i)
+	{
+	  if (!used[i]
+	      && !I386_DR_VACANT (i)
+	      && dr_mirror[i] == layout->addr[j]
+	      && I386_DR_GET_RW_LEN (i) == layout->len_rw[j])
+	    {
+	      slot[j] = i;
+	      used[i] = 1;
+	      break;
+	    }
+	}
+    }
 
-      if (what == WP_COUNT)
+  /* Next, release the debug registers which are no longer needed.
+     Reset their length too, and tell the inferior before reusing
+     them: some kernels check that an address suits the length
+     recorded in DR7 even for a disabled register.  */
+  ALL_DEBUG_REGISTERS(i)
+    {
+      dr_ref_count[i] = 0;
+      if (!used[i] && !I386_DR_VACANT (i))
 	{
-	  /* size_try_array[] is defined such that each iteration
-	     through the loop is guaranteed to produce an address and a
-	     size that can be watched with a single debug register.
-	     Thus, for counting the registers required to watch a
-	     region, we simply need to increment the count on each
-	     iteration.  */
-	  retval++;
+	  dr_mirror[i] = 0;
+	  I386_DR_DISABLE (i);
+	  I386_DR_SET_RW_LEN (i, 0);
+	  freed[i] = 1;
 	}
-      else
+    }
+  if (dr_control_mirror != old_control)
+    {
+      I386_DR_LOW_SET_CONTROL (dr_control_mirror);
+      old_control = dr_control_mirror;
+    }
+
+  /* Now set up vacant registers to watch the new regions.  */
+  for (j = 0; j < layout->count; j++)
+    {
+      if (slot[j] < 0)
 	{
-	  unsigned len_rw = i386_length_and_rw_bits (size, type);
-
-	  if (what == WP_INSERT)
-	    status = i386_insert_aligned_watchpoint (addr, len_rw);
-	  else if (what == WP_REMOVE)
-	    status = i386_remove_aligned_watchpoint (addr, len_rw);
-	  else
-	    internal_error (__FILE__, __LINE__, _("\
-Invalid value %d of operation in i386_handle_nonaligned_watchpoint.\n"),
-			    (int)what);
-	  /* We keep the loop going even after a failure, because some
-	     of the other aligned watchpoints might still succeed
-	     (e.g. if they watch addresses that are already watched,
-	     in which case we just increment the reference counts of
-	     occupied debug registers).  If we break out of the loop
-	     too early, we could cause those addresses watched by
-	     other watchpoints to be disabled when breakpoint.c reacts
-	     to our failure to insert this watchpoint and tries to
-	     remove it.  */
-	  if (status)
-	    retval = status;
+	  ALL_DEBUG_REGISTERS(i)
+	    {
+	      if (!used[i])
+		break;
+	    }
+	  gdb_assert (i < DR_NADDR);
+
+	  slot[j] = i;
+	  used[i] = 1;
+	  freed[i] = 0;
+
+	  /* Record the info in our local mirrored array.  */
+	  dr_mirror[i] = layout->addr[j];
+	  I386_DR_SET_RW_LEN (i, layout->len_rw[j]);
+	  /* Note: we only enable the watchpoint locally, i.e. in the
+	     current task.  Currently, no i386 target allows or
+	     supports global watchpoints; however, if any target would
+	     want that in the future, GDB should probably provide a
+	     command to control whether to enable watchpoints globally
+	     or locally, and the code below should use global or local
+	     enable and slow-down flags as appropriate.  */
+	  I386_DR_LOCAL_ENABLE (i);
+	  dr_control_mirror |= DR_LOCAL_SLOWDOWN;
+	  dr_control_mirror &= I386_DR_CONTROL_MASK;
+
+	  I386_DR_LOW_SET_ADDR (i, layout->addr[j]);
 	}
+      dr_ref_count[slot[j]] = layout->ref_count[j];
+    }
 
-      addr += size;
-      len -= size;
+  /* Finally, actually pass the info to the inferior.  */
+  if (dr_control_mirror != old_control)
+    I386_DR_LOW_SET_CONTROL (dr_control_mirror);
+  ALL_DEBUG_REGISTERS(i)
+    {
+      if (freed[i])
+	I386_DR_LOW_RESET_ADDR (i);
     }
+}
 
-  return retval;
+/* Program the debug registers according to the outstanding requests.
+   Return 0 on success, or -1 if they don't fit.  */
+
+static int
+i386_update_dregs (void)
+{
+  struct i386_dr_layout layout;
+
+  /* Give each region its own debug registers if they fit, so that a
+     hit tells exactly which region was accessed.  Otherwise, merging
+     neighboring regions may need fewer registers: two adjacent 4-byte
+     variables fit in a single 8-byte aligned register, for
+     instance.  */
+  if (i386_compute_layout (&layout, 0) != 0
+      && i386_compute_layout (&layout, 1) != 0)
+    return -1;
+
+  i386_apply_layout (&layout);
+  return 0;
 }
 
-/* Insert a watchpoint to watch a memory region which starts at
-   address ADDR and whose length is LEN bytes.  Watch memory accesses
-   of the type TYPE.  Return 0 on success, -1 on failure.  */
+/* Return the outstanding request to watch LEN bytes at ADDR for
+   accesses of type TYPE, or NULL if there is none.  */
 
-int
-i386_insert_watchpoint (CORE_ADDR addr, int len, int type)
+static struct i386_dr_request *
+i386_find_request (CORE_ADDR addr, int len, enum target_hw_bp_type type)
+{
+  struct i386_dr_request *r;
+
+  for (r = dr_requests; r != NULL; r = r->next)
+    if (r->addr == addr && r->len == len && r->type == type)
+      return r;
+
+  return NULL;
+}
+
+/* Drop one reference to the request R, and forget it if that was the
+   last one.  */
+
+static void
+i386_release_request (struct i386_dr_request *r)
 {
-  int retval;
+  struct i386_dr_request **rp;
 
-  if (((len != 1 && len !=2 && len !=4) && !(TARGET_HAS_DR_LEN_8 && len == 8))
-      || addr % len != 0)
-    retval = i386_handle_nonaligned_watchpoint (WP_INSERT, addr, len, type);
+  if (--r->ref_count > 0)
+    return;
+
+  for (rp = &dr_requests; *rp != r; rp = &(*rp)->next)
+    ;
+  *rp = r->next;
+  xfree (r);
+}
+
+/* Ask to watch LEN bytes at ADDR for accesses of type TYPE, and
+   reprogram the debug registers.  Return 0 on success, or -1 if the
+   debug registers can't accommodate the new request, in which case
+   they are left unchanged.  */
+
+static int
+i386_insert_request (CORE_ADDR addr, int len, enum target_hw_bp_type type)
+{
+  struct i386_dr_request *r, **rp;
+
+  r = i386_find_request (addr, len, type);
+  if (r != NULL)
+    r->ref_count++;
   else
     {
-      unsigned len_rw = i386_length_and_rw_bits (len, type);
+      r = XZALLOC (struct i386_dr_request);
+      r->addr = addr;
+      r->len = len;
+      r->type = type;
+      r->ref_count = 1;
+
+      /* Keep the requests in the order they were made.  */
+      for (rp = &dr_requests; *rp != NULL; rp = &(*rp)->next)
+	;
+      *rp = r;
+    }
 
-      retval = i386_insert_aligned_watchpoint (addr, len_rw);
+  if (i386_update_dregs () != 0)
+    {
+      i386_release_request (r);
+      return -1;
     }
 
+  return 0;
+}
+
+/* Stop watching LEN bytes at ADDR for accesses of type TYPE, and
+   reprogram the debug registers.  Return 0 on success, or -1 if there
+   was no such request.  */
+
+static int
+i386_remove_request (CORE_ADDR addr, int len, enum target_hw_bp_type type)
+{
+  struct i386_dr_request *r;
+
+  r = i386_find_request (addr, len, type);
+  if (r == NULL)
+    return -1;
+
+  i386_release_request (r);
+
+  /* Removing a region from the middle of a merged one can leave
+     pieces which need more debug registers than the whole did.  If
+     the rest doesn't fit anymore, leave the debug registers as they
+     are: they still cover every remaining region.  */
+  i386_update_dregs ();
+  return 0;
+}
+
+/* Insert a watchpoint to watch a memory region which starts at
+   address ADDR and whose length is LEN bytes.  Watch memory accesses
+   of the type TYPE.  Return 0 on success, -1 on failure.  */
+
+int
+i386_insert_watchpoint (CORE_ADDR addr, int len, int type)
+{
+  int retval = i386_insert_request (addr, len, type);
+
   if (maint_show_dr)
     i386_show_dr ("insert_watchpoint", addr, len, type);
 
@@ -527,17 +733,7 @@ i386_insert_watchpoint (CORE_ADDR addr, int len, int type)
 int
 i386_remove_watchpoint (CORE_ADDR addr, int len, int type)
 {
-  int retval;
-
-  if (((len != 1 && len !=2 && len !=4) && !(TARGET_HAS_DR_LEN_8 && len == 8))
-      || addr % len != 0)
-    retval = i386_handle_nonaligned_watchpoint (WP_REMOVE, addr, len, type);
-  else
-    {
-      unsigned len_rw = i386_length_and_rw_bits (len, type);
-
-      retval = i386_remove_aligned_watchpoint (addr, len_rw);
-    }
+  int retval = i386_remove_request (addr, len, type);
 
   if (maint_show_dr)
     i386_show_dr ("remove_watchpoint", addr, len, type);
@@ -551,12 +747,12 @@ i386_remove_watchpoint (CORE_ADDR addr, int len, int type)
 int
 i386_region_ok_for_watchpoint (CORE_ADDR addr, int len)
 {
-  int nregs;
+  struct i386_dr_layout layout;
 
-  /* Compute how many aligned watchpoints we would need to cover this
-     region.  */
-  nregs = i386_handle_nonaligned_watchpoint (WP_COUNT, addr, len, hw_write);
-  return nregs <= DR_NADDR ? 1 : 0;
+  /* Check whether the aligned watchpoints we would need to cover this
+     region fit in the debug registers.  */
+  memset (&layout, 0, sizeof (layout));
+  return i386_layout_add_region (&layout, addr, len, hw_write, 1) == 0;
 }
 
 /* If the inferior has some watchpoint that triggered, set the
@@ -624,14 +820,57 @@ i386_stopped_by_hwbp (void)
   return 0;
 }
 
+/* Return non-zero if ADDR, as returned by i386_stopped_data_address,
+   tells that the LENGTH bytes at START may have been accessed.  ADDR
+   is the start of the region watched by the debug register which
+   triggered, and that region may cover several watched regions when
+   they had to be merged to fit; any of them may have been accessed.  */
+
+static int
+i386_watchpoint_addr_within_range (struct target_ops *target,
+				   CORE_ADDR addr,
+				   CORE_ADDR start, int length)
+{
+  int i;
+
+  ALL_DEBUG_REGISTERS(i)
+    {
+      if (!I386_DR_VACANT (i)
+	  && dr_mirror[i] == addr
+	  && I386_DR_GET_RW_LEN (i) != 0)
+	{
+	  int len;
+
+	  switch (I386_DR_GET_RW_LEN (i) & ~3)
+	    {
+	    case DR_LEN_1:
+	      len = 1;
+	      break;
+	    case DR_LEN_2:
+	      len = 2;
+	      break;
+	    case DR_LEN_8:
+	      len = 8;
+	      break;
+	    default:
+	      len = 4;
+	      break;
+	    }
+
+	  return addr < start + length && start < addr + len;
+	}
+    }
+
+  return addr >= start && addr < start + length;
+}
+
 /* Insert a hardware-assisted breakpoint at BP_TGT->placed_address.
    Return 0 on success, EBUSY on failure.  */
 int
 i386_insert_hw_breakpoint (struct bp_target_info *bp_tgt)
 {
-  unsigned len_rw = i386_length_and_rw_bits (1, hw_execute);
   CORE_ADDR addr = bp_tgt->placed_address;
-  int retval = i386_insert_aligned_watchpoint (addr, len_rw) ? EBUSY : 0;
+  int retval = i386_insert_request (addr, 1, hw_execute) ? EBUSY : 0;
 
   if (maint_show_dr)
     i386_show_dr ("insert_hwbp", addr, 1, hw_execute);
@@ -645,9 +884,8 @@ i386_insert_hw_breakpoint (struct bp_target_info *bp_tgt)
 int
 i386_remove_hw_breakpoint (struct bp_target_info *bp_tgt)
 {
-  unsigned len_rw = i386_length_and_rw_bits (1, hw_execute);
   CORE_ADDR addr = bp_tgt->placed_address;
-  int retval = i386_remove_aligned_watchpoint (addr, len_rw);
+  int retval = i386_remove_request (addr, 1, hw_execute);
 
   if (maint_show_dr)
     i386_show_dr ("remove_hwbp", addr, 1, hw_execute);
@@ -690,6 +928,7 @@ i386_use_watchpoints (struct target_ops *t)
   t->to_region_ok_for_hw_watchpoint = i386_region_ok_for_watchpoint;
   t->to_stopped_by_watchpoint = i386_stopped_by_watchpoint;
   t->to_stopped_data_address = i386_stopped_data_address;
+  t->to_watchpoint_addr_within_range = i386_watchpoint_addr_within_range;
   t->to_insert_watchpoint = i386_insert_watchpoint;
   t->to_remove_watchpoint = i386_remove_watchpoint;
   t->to_insert_hw_breakpoint = i386_insert_hw_breakpoint;
@@ -172,6 +172,8 @@ inf_child_target (void)
   t->to_prepare_to_store = inf_child_prepare_to_store;
   t->to_insert_breakpoint = memory_insert_breakpoint;
   t->to_remove_breakpoint = memory_remove_breakpoint;
+  t->to_insert_breakpoints = memory_insert_breakpoints;
+  t->to_remove_breakpoints = memory_remove_breakpoints;
   t->to_terminal_init = terminal_init_inferior;
   t->to_terminal_inferior = terminal_inferior;
   t->to_terminal_ours_for_output = terminal_ours_for_output;
@@ -29,6 +29,7 @@ struct ui_file;
 struct type;
 struct gdbarch;
 struct regcache;
+struct displaced_step_closure;
 
 /* For bpstat.  */
 #include "breakpoint.h"
@@ -321,6 +322,14 @@ extern int stopped_by_random_signal;
 extern CORE_ADDR step_range_start;	/* Inclusive */
 extern CORE_ADDR step_range_end;	/* Exclusive */
 
+/* Nonzero if the thread being single-stepped may be stepped by the
+   target through the whole of the range above, reporting a stop only
+   once its PC leaves the range (or a breakpoint or watchpoint is
+   hit), instead of after every instruction.  Set by resume for the
+   step it requests, and cleared once that step is under way.  */
+
+extern int may_range_step;
+
 /* Stack frame address as of when stepping command was issued.
    This is how we know when we step into a subroutine call,
    and how to set the frame for the breakpoint used to step out.  */
@@ -404,6 +413,12 @@ extern int debug_displaced;
 void displaced_step_dump_bytes (struct ui_file *file,
                                 const gdb_byte *buf, size_t len);
 
+/* If ADDR is where the instruction being displaced-stepped was
+   copied to, return the closure gdbarch_displaced_step_copy_insn
+   returned for it.  Otherwise, return NULL.  */
+extern struct displaced_step_closure *
+  get_displaced_step_closure_by_addr (CORE_ADDR addr);
+
 
 /* When set, normal_stop will not call the normal_stop observer.  */
 extern int suppress_stop_observer;
@@ -241,6 +241,10 @@ static struct symbol *step_start_function;
 
 static int stepping_over_breakpoint;
 
+/* See inferior.h.  */
+
+int may_range_step;
+
 /* Nonzero if we want to give control to the user when we're notified
    of shared library events by the dynamic linker.  */
 static int stop_on_solib_events;
@@ -682,7 +686,10 @@ displaced_step_dump_bytes (struct ui_file *file,
    explain how we handle this case instead.
 
    Returns 1 if preparing was successful -- this thread is going to be
-   stepped now; or 0 if displaced stepping this thread got queued.  */
+   stepped now; 0 if displaced stepping this thread got queued; or -1
+   if the architecture can not displace the instruction at the
+   thread's pc, in which case the thread must step over the breakpoint
+   in place, with the breakpoints removed.  */
 static int
 displaced_step_prepare (ptid_t ptid)
 {
@@ -757,31 +764,51 @@ displaced_step_prepare (ptid_t ptid)
 
   closure = gdbarch_displaced_step_copy_insn (gdbarch,
                                               original, copy, regcache);
+  if (closure == NULL)
+    {
+      if (debug_displaced)
+	fprintf_unfiltered (gdb_stdlog,
+			    "displaced: can't displace insn at 0x%s\n",
+			    paddr_nz (original));
 
-  /* We don't support the fully-simulated case at present.  */
-  gdb_assert (closure);
+      write_memory (copy, displaced_step_saved_copy, len);
+      do_cleanups (old_cleanups);
+      return -1;
+    }
 
   make_cleanup (cleanup_displaced_step_closure, closure);
 
-  /* Resume execution at the copy.  */
-  regcache_write_pc (regcache, copy);
-
   discard_cleanups (old_cleanups);
 
-  if (debug_displaced)
-    fprintf_unfiltered (gdb_stdlog, "displaced: displaced pc to 0x%s\n",
-                        paddr_nz (copy));
-
   /* Save the information we need to fix things up if the step
-     succeeds.  */
+     succeeds.  Do this before moving the PC, which may need to know
+     what the copy area holds (see get_displaced_step_closure_by_addr).  */
   displaced_step_ptid = ptid;
   displaced_step_gdbarch = gdbarch;
   displaced_step_closure = closure;
   displaced_step_original = original;
   displaced_step_copy = copy;
+
+  /* Resume execution at the copy.  */
+  regcache_write_pc (regcache, copy);
+
+  if (debug_displaced)
+    fprintf_unfiltered (gdb_stdlog, "displaced: displaced pc to 0x%s\n",
+                        paddr_nz (copy));
+
   return 1;
 }
 
+struct displaced_step_closure *
+get_displaced_step_closure_by_addr (CORE_ADDR addr)
+{
+  if (!ptid_equal (displaced_step_ptid, null_ptid)
+      && addr == displaced_step_copy)
+    return displaced_step_closure;
+
+  return NULL;
+}
+
 static void
 displaced_step_clear_cleanup (void *ignore)
 {
@@ -843,10 +870,11 @@ displaced_step_fixup (ptid_t event_ptid, enum target_signal signal)
 
   /* Are there any pending displaced stepping requests?  If so, run
      one now.  */
-  if (displaced_step_request_queue)
+  while (displaced_step_request_queue)
     {
       struct displaced_step_request *head;
       ptid_t ptid;
+      int prepared;
 
       head = displaced_step_request_queue;
       ptid = head->ptid;
@@ -860,8 +888,33 @@ displaced_step_fixup (ptid_t event_ptid, enum target_signal signal)
 
 
       displaced_step_ptid = null_ptid;
-      displaced_step_prepare (ptid);
-      target_resume (ptid, 1, TARGET_SIGNAL_0);
+      prepared = displaced_step_prepare (ptid);
+      if (prepared > 0)
+	target_resume (ptid,
+		       gdbarch_displaced_step_hw_singlestep
+			 (displaced_step_gdbarch, displaced_step_closure),
+		       TARGET_SIGNAL_0);
+      else if (non_stop)
+	{
+	  /* Stepping over the breakpoint in place would let the
+	     running threads run without breakpoints.  Leave this
+	     thread stopped, and try the next request.  */
+	  warning (_("\
+Can't step %s over the breakpoint at its pc without displaced stepping\n\
+while other threads are running; the thread is left stopped."),
+		   target_pid_to_str (ptid));
+	  set_executing (ptid, 0);
+	  set_running (ptid, 0);
+	  continue;
+	}
+      else
+	{
+	  /* Step over the breakpoint in place; keep_going puts the
+	     breakpoints back once the step is done.  */
+	  remove_breakpoints ();
+	  target_resume (ptid, 1, TARGET_SIGNAL_0);
+	}
+      break;
     }
 }
 
@@ -917,6 +970,7 @@ void
 resume (int step, enum target_signal sig)
 {
   int should_resume = 1;
+  int displaced = 0;
   struct cleanup *old_cleanups = make_cleanup (resume_cleanups, 0);
   struct regcache *regcache = get_current_regcache ();
   struct gdbarch *gdbarch = get_regcache_arch (regcache);
@@ -967,7 +1021,9 @@ a command like `return' or `jump' to continue execution."));
       && stepping_over_breakpoint
       && sig == TARGET_SIGNAL_0)
     {
-      if (!displaced_step_prepare (inferior_ptid))
+      int prepared = displaced_step_prepare (inferior_ptid);
+
+      if (prepared == 0)
 	{
 	  /* Got placed in displaced stepping queue.  Will be resumed
 	     later when all the currently queued displaced stepping
@@ -975,6 +1031,30 @@ a command like `return' or `jump' to continue execution."));
 	  discard_cleanups (old_cleanups);
 	  return;
 	}
+
+      if (prepared > 0)
+	{
+	  /* The copy may end with a breakpoint of its own, in which
+	     case the thread need only be resumed, not stepped.  */
+	  displaced = 1;
+	  step = gdbarch_displaced_step_hw_singlestep (gdbarch,
+						       displaced_step_closure);
+	}
+      else
+	{
+	  /* The architecture can't displace this instruction; step
+	     over the breakpoint in place, as without displaced
+	     stepping.  keep_going puts the breakpoints back once the
+	     step is done.  In non-stop mode, other threads would run
+	     without breakpoints meanwhile, so refuse.  */
+	  if (non_stop)
+	    error (_("\
+Can't step over the breakpoint at 0x%s without displaced stepping\n\
+while other threads are running."),
+		   paddr_nz (pc));
+	  remove_breakpoints ();
+	  step = 1;
+	}
     }
 
   if (step && gdbarch_software_single_step_p (gdbarch))
@@ -1043,7 +1123,7 @@ a command like `return' or `jump' to continue execution."));
 	  resume_ptid = inferior_ptid;
 	}
 
-      if ((step || singlestep_breakpoints_inserted_p)
+      if ((step || singlestep_breakpoints_inserted_p || displaced)
 	  && stepping_over_breakpoint)
 	{
 	  /* We're allowing a thread to run past a breakpoint it has
@@ -1096,7 +1176,24 @@ a command like `return' or `jump' to continue execution."));
           displaced_step_dump_bytes (gdb_stdlog, buf, sizeof (buf));
         }
 
+      /* A step within the line being stepped may be left to the
+	 target as a whole, unless GDB has to see each instruction:
+	 to step over a breakpoint once and reinsert it, to check
+	 software watchpoints, or to stepi.  */
+      may_range_step = (step
+			&& !displaced
+			&& !stepping_over_breakpoint
+			&& step_range_end > 1
+			&& pc >= step_range_start && pc < step_range_end
+			&& step_resume_breakpoint == NULL
+			&& !bpstat_should_step ());
+
       target_resume (resume_ptid, step, sig);
+
+      /* The other calls to target_resume, such as the single-steps
+	 over watchpoints in handle_inferior_event, step exactly one
+	 instruction.  */
+      may_range_step = 0;
     }
 
   discard_cleanups (old_cleanups);
@@ -3278,8 +3375,7 @@ infrun: BPSTAT_WHAT_SET_LONGJMP_RESUME (!gdbarch_get_longjmp_target)\n");
      new line in mid-statement, we continue stepping.  This makes
      things like for(;;) statements work better.)  */
 
-  step_range_start = stop_pc_sal.pc;
-  step_range_end = stop_pc_sal.end;
+  find_pc_line_pc_range (stop_pc, &step_range_start, &step_range_end);
   step_frame_id = get_frame_id (get_current_frame ());
   tss->current_line = stop_pc_sal.line;
   tss->current_symtab = stop_pc_sal.symtab;
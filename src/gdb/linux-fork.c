@@ -26,6 +26,9 @@
 #include "gdb_string.h"
 #include "linux-fork.h"
 #include "linux-nat.h"
+#include "observer.h"
+#include "reggroups.h"
+#include "exceptions.h"
 
 #include <sys/ptrace.h>
 #include "gdb_wait.h"
@@ -42,6 +45,22 @@ extern void _initialize_linux_fork (void);
 int detach_fork = 1;		/* Default behavior is to detach
 				   newly forked processes (legacy).  */
 
+/* The most checkpoints to keep; when there would be more, the least
+   recently used one is deleted.  UINT_MAX means no limit.  */
+static unsigned int max_checkpoints = UINT_MAX;
+
+/* Take a checkpoint automatically every this many breakpoint hits,
+   or never if zero.  */
+static int checkpoint_interval = 0;
+
+/* The number of breakpoint hits since the last automatic
+   checkpoint.  */
+static int breakpoint_hits_since_checkpoint;
+
+/* Incremented each time a checkpoint is created or restored, to
+   find the least recently used one.  */
+static unsigned long checkpoint_clock;
+
 /* Fork list data structure:  */
 struct fork_info
 {
@@ -54,6 +73,10 @@ struct fork_info
   ULONGEST pc;			/* PC for info fork.  */
   off_t *filepos;		/* Set of open file descriptors' offsets.  */
   int maxfd;
+  int checkpoint_p;		/* True if made by "checkpoint", rather
+				   than by the program forking.  */
+  unsigned long last_used;	/* Value of checkpoint_clock when this
+				   checkpoint was last made or restored.  */
 };
 
 /* Fork list methods:  */
@@ -230,6 +253,68 @@ call_lseek (int fd, off_t offset, int whence)
   return (off_t) parse_and_eval_long (&exp[0]);
 }
 
+/* Return the file position of descriptor FD in process PID, as shown
+   in /proc, or -1 if it is not available there.  This is much cheaper
+   than calling lseek in the inferior.  */
+
+static off_t
+proc_fd_position (pid_t pid, int fd)
+{
+  char path[MAXPATHLEN];
+  char line[80];
+  off_t pos = -1;
+  FILE *f;
+
+  snprintf (path, MAXPATHLEN, "/proc/%ld/fdinfo/%d", (long) pid, fd);
+  f = fopen (path, "r");
+  if (f == NULL)
+    return -1;
+
+  while (fgets (line, sizeof (line), f) != NULL)
+    if (strncmp (line, "pos:", 4) == 0)
+      {
+	pos = (off_t) strtoulst (line + 4, NULL, 10);
+	break;
+      }
+
+  fclose (f);
+  return pos;
+}
+
+/* Write the registers saved in SAVEDREGS to the current inferior.
+   Rather than storing them one at a time, fetch all the registers of
+   the inferior once, overwrite them with the saved values, and store
+   them all at once.  The current regcache is left valid.  */
+
+static void
+fork_restore_registers (struct regcache *savedregs)
+{
+  struct regcache *regcache = get_current_regcache ();
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  gdb_byte buf[MAX_REGISTER_SIZE];
+  int regnum;
+
+  target_fetch_registers (regcache, -1);
+  for (regnum = 0; regnum < gdbarch_num_regs (gdbarch); regnum++)
+    if (gdbarch_register_reggroup_p (gdbarch, regnum, restore_reggroup)
+	&& regcache_valid_p (savedregs, regnum))
+      {
+	regcache_raw_read (savedregs, regnum, buf);
+	regcache_raw_supply (regcache, regnum, buf);
+      }
+  target_store_registers (regcache, -1);
+
+  /* Pseudo registers which live in memory are restored as usual.  */
+  for (; regnum < gdbarch_num_regs (gdbarch) + gdbarch_num_pseudo_regs (gdbarch);
+       regnum++)
+    if (gdbarch_register_reggroup_p (gdbarch, regnum, restore_reggroup)
+	&& regcache_valid_p (savedregs, regnum))
+      {
+	regcache_cooked_read (savedregs, regnum, buf);
+	regcache_cooked_write (regcache, regnum, buf);
+      }
+}
+
 /* Load infrun state for the fork PTID.  */
 
 static void
@@ -242,20 +327,21 @@ fork_load_infrun_state (struct fork_info *fp)
 
   linux_nat_switch_fork (inferior_ptid);
 
-  if (fp->savedregs && fp->clobber_regs)
-    regcache_cpy (get_current_regcache (), fp->savedregs);
-
   registers_changed ();
-  reinit_frame_cache ();
+  if (fp->savedregs && fp->clobber_regs)
+    fork_restore_registers (fp->savedregs);
 
   stop_pc = read_pc ();
   nullify_last_target_wait_ptid ();
 
-  /* Now restore the file positions of open file descriptors.  */
+  /* Now restore the file positions of open file descriptors.  Forks
+     share their open files, so most positions have not moved; only
+     call lseek for those which have.  */
   if (fp->filepos)
     {
       for (i = 0; i <= fp->maxfd; i++)
-	if (fp->filepos[i] != (off_t) -1)
+	if (fp->filepos[i] != (off_t) -1
+	    && proc_fd_position (PIDGET (fp->ptid), i) != fp->filepos[i])
 	  call_lseek (i, fp->filepos[i], SEEK_SET);
       /* NOTE: I can get away with using SEEK_SET and SEEK_CUR because
 	 this is native-only.  If it ever has to be cross, we'll have
@@ -312,7 +398,9 @@ fork_save_infrun_state (struct fork_info *fp, int clobber_regs)
 	    if (isdigit (de->d_name[0]))
 	      {
 		tmp = strtol (&de->d_name[0], NULL, 10);
-		fp->filepos[tmp] = call_lseek (tmp, 0, SEEK_CUR);
+		fp->filepos[tmp] = proc_fd_position (PIDGET (fp->ptid), tmp);
+		if (fp->filepos[tmp] == (off_t) -1)
+		  fp->filepos[tmp] = call_lseek (tmp, 0, SEEK_CUR);
 	      }
 	  closedir (d);
 	}
@@ -525,8 +613,48 @@ save_detach_fork (int *saved_val)
   return make_cleanup (restore_detach_fork, (void *) saved_val);
 }
 
+/* Kill the least recently used checkpoint other than the current
+   process, if there are more than MAX_CHECKPOINTS.  */
+
 static void
-checkpoint_command (char *args, int from_tty)
+delete_old_checkpoints (void)
+{
+  struct fork_info *fp, *oldest;
+  unsigned int count;
+  pid_t pid, ret;
+  int status;
+
+  while (1)
+    {
+      count = 0;
+      oldest = NULL;
+      for (fp = fork_list; fp; fp = fp->next)
+	if (fp->checkpoint_p)
+	  {
+	    count++;
+	    if (!ptid_equal (fp->ptid, inferior_ptid)
+		&& (oldest == NULL || fp->last_used < oldest->last_used))
+	      oldest = fp;
+	  }
+
+      if (count <= max_checkpoints || oldest == NULL)
+	return;
+
+      pid = PIDGET (oldest->ptid);
+      do {
+	kill (pid, SIGKILL);
+	ret = waitpid (pid, &status, 0);
+      } while (ret == pid && WIFSTOPPED (status));
+
+      delete_fork (oldest->ptid);
+    }
+}
+
+/* Make the inferior fork, and keep the child stopped as a
+   checkpoint.  */
+
+static void
+take_checkpoint (int from_tty)
 {
   struct target_waitstatus last_target_waitstatus;
   ptid_t last_target_ptid;
@@ -582,7 +710,102 @@ checkpoint_command (char *args, int from_tty)
   if (!fp)
     error (_("Failed to find new fork"));
   fork_save_infrun_state (fp, 1);
+  fp->checkpoint_p = 1;
+  fp->last_used = ++checkpoint_clock;
   insert_breakpoints ();
+
+  delete_old_checkpoints ();
+}
+
+static void
+checkpoint_command (char *args, int from_tty)
+{
+  take_checkpoint (from_tty);
+}
+
+/* Return non-zero if the inferior is a process debugged natively,
+   which can be made to fork.  */
+
+static int
+checkpoint_target_p (void)
+{
+  struct target_ops *t;
+
+  if (!target_has_execution || non_stop)
+    return 0;
+
+  for (t = current_target.beneath; t != NULL; t = t->beneath)
+    if (t->to_stratum == process_stratum)
+      return strcmp (t->to_shortname, "child") == 0;
+
+  return 0;
+}
+
+static int
+take_checkpoint_wrapper (void *arg)
+{
+  take_checkpoint (0);
+  return 1;
+}
+
+/* Take a checkpoint every CHECKPOINT_INTERVAL stops at a user
+   breakpoint.  */
+
+static void
+checkpoint_normal_stop (struct bpstats *bs)
+{
+  int hit = 0;
+
+  if (checkpoint_interval <= 0 || !checkpoint_target_p ())
+    return;
+
+  for (; bs != NULL; bs = bs->next)
+    if (bs->stop && bs->breakpoint_at != NULL)
+      {
+	struct breakpoint *b = bs->breakpoint_at->owner;
+
+	if (b->number > 0
+	    && (b->type == bp_breakpoint
+		|| b->type == bp_hardware_breakpoint))
+	  hit = 1;
+      }
+
+  if (!hit || ++breakpoint_hits_since_checkpoint < checkpoint_interval)
+    return;
+
+  breakpoint_hits_since_checkpoint = 0;
+  catch_errors (take_checkpoint_wrapper, NULL,
+		"Could not take a checkpoint:\n", RETURN_MASK_ERROR);
+}
+
+static void
+set_checkpoint_interval (char *args, int from_tty, struct cmd_list_element *c)
+{
+  if (checkpoint_interval < 0)
+    {
+      checkpoint_interval = 0;
+      error (_("The checkpoint interval can not be negative."));
+    }
+  breakpoint_hits_since_checkpoint = 0;
+}
+
+static void
+show_checkpoint_interval (struct ui_file *file, int from_tty,
+			  struct cmd_list_element *c, const char *value)
+{
+  if (checkpoint_interval == 0)
+    fprintf_filtered (file, _("Checkpoints are not taken automatically.\n"));
+  else
+    fprintf_filtered (file, _("\
+A checkpoint is taken every %s breakpoint hits.\n"), value);
+}
+
+static void
+show_max_checkpoints (struct ui_file *file, int from_tty,
+		      struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("The number of checkpoints kept is %s.\n"),
+		    value);
 }
 
 static void
@@ -604,6 +827,9 @@ linux_fork_context (struct fork_info *newfp, int from_tty)
   fork_load_infrun_state (newfp);
   insert_breakpoints ();
 
+  if (newfp->checkpoint_p)
+    newfp->last_used = ++checkpoint_clock;
+
   printf_filtered (_("Switching to %s\n"), 
 		   target_pid_to_str (inferior_ptid));
 
@@ -668,6 +894,30 @@ Show whether gdb will detach the child of a fork."), _("\
 Tells gdb whether to detach the child of a fork."), 
 			   NULL, NULL, &setlist, &showlist);
 
+  /* Set/show max-checkpoints and checkpoint-interval: keep a bounded
+     number of checkpoints, taken automatically if requested.  */
+
+  add_setshow_uinteger_cmd ("max-checkpoints", class_obscure,
+			    &max_checkpoints, _("\
+Set the maximum number of checkpoints kept."), _("\
+Show the maximum number of checkpoints kept."), _("\
+When a new checkpoint would exceed this limit, the least recently\n\
+created or restarted checkpoint is deleted.  Zero means no limit."),
+			    NULL, show_max_checkpoints,
+			    &setlist, &showlist);
+
+  add_setshow_zinteger_cmd ("checkpoint-interval", class_obscure,
+			    &checkpoint_interval, _("\
+Set how often checkpoints are taken automatically."), _("\
+Show how often checkpoints are taken automatically."), _("\
+If N is not zero, a checkpoint is taken each N times the program\n\
+stops at a breakpoint; with 1, at every breakpoint hit.\n\
+Zero means never."),
+			    set_checkpoint_interval, show_checkpoint_interval,
+			    &setlist, &showlist);
+
+  observer_attach_normal_stop (checkpoint_normal_stop);
+
   /* Set/show restart-auto-finish: user-settable count.  Causes the
      first "restart" of a fork to do some number of "finish" commands
      before returning to user.
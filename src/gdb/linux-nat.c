@@ -46,6 +46,7 @@
 #include "gdbthread.h"		/* for struct thread_info etc. */
 #include "gdb_stat.h"		/* for struct stat */
 #include <fcntl.h>		/* for O_RDONLY */
+#include <sys/mman.h>		/* for PROT_READ etc. */
 #include "inf-loop.h"
 #include "event-loop.h"
 #include "event-top.h"
@@ -655,6 +656,16 @@ linux_enable_event_reporting (ptid_t ptid)
   ptrace (PTRACE_SETOPTIONS, pid, 0, options);
 }
 
+/* Return non-zero if linux_enable_event_reporting asks the LWPs it is
+   given to report the LWPs they clone, so that every thread created
+   since they were attached appears on LWP_LIST.  */
+
+int
+linux_nat_reports_clones (void)
+{
+  return linux_supports_tracefork_flag > 0;
+}
+
 static void
 linux_child_post_attach (int pid)
 {
@@ -929,6 +940,9 @@ static int stop_wait_callback (struct lwp_info *lp, void *data);
 static int linux_nat_thread_alive (ptid_t ptid);
 static char *linux_child_pid_to_exec_file (int pid);
 static int cancel_breakpoint (struct lwp_info *lp);
+static int page_watch_fault_p (int lwpid, int status, CORE_ADDR *addr);
+static int linux_nat_page_watch_fault (struct lwp_info *lp, int status);
+static void page_watch_forget (void);
 
 
 /* Convert wait status STATUS to a string.  Used for printing debug
@@ -1577,6 +1591,7 @@ linux_nat_detach (char *args, int from_tty)
 
   /* Destroy LWP info; it's no longer valid.  */
   init_lwp_list ();
+  page_watch_forget ();
 
   pid = GET_PID (inferior_ptid);
   inferior_ptid = pid_to_ptid (pid);
@@ -1602,6 +1617,7 @@ resume_callback (struct lwp_info *lp, void *data)
       lp->stopped = 0;
       lp->step = 0;
       memset (&lp->siginfo, 0, sizeof (lp->siginfo));
+      lp->stopped_by_page_watch = 0;
     }
   else if (lp->stopped && debug_linux_nat)
     fprintf_unfiltered (gdb_stdlog, "RC: Not resuming sibling %s (has pending)\n",
@@ -1733,6 +1749,7 @@ linux_nat_resume (ptid_t ptid, int step, enum target_signal signo)
 
   linux_ops->to_resume (ptid, step, signo);
   memset (&lp->siginfo, 0, sizeof (lp->siginfo));
+  lp->stopped_by_page_watch = 0;
 
   if (debug_linux_nat)
     fprintf_unfiltered (gdb_stdlog,
@@ -1912,6 +1929,9 @@ linux_handle_extended_wait (struct lwp_info *lp, int status,
 	 parent on a vfork, because detach_breakpoints would think
 	 that breakpoints are not inserted.  */
       mark_breakpoints_out ();
+
+      /* The pages protected for watchpoints are gone too.  */
+      page_watch_forget ();
       return 0;
     }
 
@@ -2105,6 +2125,7 @@ stop_wait_callback (struct lwp_info *lp, void *data)
   if (!lp->stopped)
     {
       int status;
+      CORE_ADDR addr;
 
       status = wait_lwp (lp);
       if (status == 0)
@@ -2128,6 +2149,15 @@ stop_wait_callback (struct lwp_info *lp, void *data)
 
       maybe_clear_ignore_sigint (lp);
 
+      if (page_watch_fault_p (GET_LWP (lp->ptid), status, &addr))
+	{
+	  /* An access to a page protected for a watchpoint.  The
+	     instruction hasn't completed, and will fault again when
+	     LP is resumed; see linux_nat_page_watch_fault.  */
+	  ptrace (PTRACE_CONT, GET_LWP (lp->ptid), 0, 0);
+	  return stop_wait_callback (lp, NULL);
+	}
+
       if (WSTOPSIG (status) != SIGSTOP)
 	{
 	  if (WSTOPSIG (status) == SIGTRAP)
@@ -2857,6 +2887,15 @@ retry:
 	      continue;
 	    }
 
+	  /* Step over accesses to pages protected for watchpoints.  */
+	  status = linux_nat_page_watch_fault (lp, status);
+	  if (status == -1)
+	    {
+	      /* A discarded event.  */
+	      status = 0;
+	      continue;
+	    }
+
 	  break;
 	}
 
@@ -3128,6 +3167,7 @@ linux_nat_mourn_inferior (void)
 {
   /* Destroy LWP info; it's no longer valid.  */
   init_lwp_list ();
+  page_watch_forget ();
 
   if (! forks_exist_p ())
     {
@@ -3803,10 +3843,10 @@ linux_nat_info_proc_cmd (char *args, int from_tty)
     }
 }
 
-/* Implement the to_xfer_partial interface for memory reads using the /proc
-   filesystem.  Because we can use a single read() call for /proc, this
-   can be much more efficient than banging away at PTRACE_PEEKTEXT,
-   but it doesn't support writes.  */
+/* Implement the to_xfer_partial interface for memory reads and writes
+   using the /proc filesystem.  Because we can use a single read() or
+   write() call for /proc, this can be much more efficient than banging
+   away at PTRACE_PEEKTEXT and PTRACE_POKETEXT.  */
 
 static LONGEST
 linux_proc_xfer_partial (struct target_ops *ops, enum target_object object,
@@ -3818,7 +3858,7 @@ linux_proc_xfer_partial (struct target_ops *ops, enum target_object object,
   int fd;
   char filename[64];
 
-  if (object != TARGET_OBJECT_MEMORY || !readbuf)
+  if (object != TARGET_OBJECT_MEMORY)
     return 0;
 
   /* Don't bother for one word.  */
@@ -3828,22 +3868,40 @@ linux_proc_xfer_partial (struct target_ops *ops, enum target_object object,
   /* We could keep this file open and cache it - possibly one per
      thread.  That requires some juggling, but is even faster.  */
   sprintf (filename, "/proc/%d/mem", PIDGET (inferior_ptid));
-  fd = open (filename, O_RDONLY | O_LARGEFILE);
+  fd = open (filename, (readbuf ? O_RDONLY : O_WRONLY) | O_LARGEFILE);
   if (fd == -1)
     return 0;
 
   /* If pread64 is available, use it.  It's faster if the kernel
      supports it (only one syscall), and it's 64-bit safe even on
      32-bit platforms (for instance, SPARC debugging a SPARC64
-     application).  */
+     application).  Writing is only allowed by newer kernels;
+     if it fails, we fall back to ptrace.  pwrite64 comes with
+     pread64.  */
+  if (readbuf)
+    {
 #ifdef HAVE_PREAD64
-  if (pread64 (fd, readbuf, len, offset) != len)
+      if (pread64 (fd, readbuf, len, offset) != len)
 #else
-  if (lseek (fd, offset, SEEK_SET) == -1 || read (fd, readbuf, len) != len)
+      if (lseek (fd, offset, SEEK_SET) == -1
+	  || read (fd, readbuf, len) != len)
 #endif
-    ret = 0;
+	ret = 0;
+      else
+	ret = len;
+    }
   else
-    ret = len;
+    {
+#ifdef HAVE_PREAD64
+      if (pwrite64 (fd, writebuf, len, offset) != len)
+#else
+      if (lseek (fd, offset, SEEK_SET) == -1
+	  || write (fd, writebuf, len) != len)
+#endif
+	ret = 0;
+      else
+	ret = len;
+    }
 
   close (fd);
   return ret;
@@ -4411,6 +4469,705 @@ linux_nat_stop (ptid_t ptid)
     linux_ops->to_stop (ptid);
 }
 
+/* Watchpoints implemented with page protection.
+
+   When the lower layer can't watch a region, e.g. because it is
+   larger than the debug registers can cover, we can still watch it at
+   nearly full speed by removing write access (for write watchpoints)
+   or all access (for read and access watchpoints) from the pages
+   holding it.  An access to such a page then faults with SIGSEGV
+   before the accessing instruction completes; we restore the page's
+   original protection, single-step the instruction, protect the page
+   again, and report a watchpoint trap if the access hit a watched
+   region.  Accesses to unwatched parts of the page are stepped over
+   transparently.
+
+   Page protections are changed by making the inferior call mprotect,
+   using the method registered with linux_nat_set_inferior_mprotect.
+   The memory accesses GDB itself makes through ptrace ignore them.  */
+
+/* A region watched by protecting the pages it covers.  */
+
+struct page_watch
+{
+  struct page_watch *next;
+  CORE_ADDR addr;
+  int len;
+  int type;
+};
+
+/* A page whose protection we changed.  */
+
+struct protected_page
+{
+  struct protected_page *next;
+
+  /* The page's address.  */
+  CORE_ADDR addr;
+
+  /* The PROT_* protection the program gave it, and the one it has
+     now.  */
+  int orig_prot;
+  int prot;
+};
+
+/* The regions watched by protecting pages, and the pages
+   protected.  */
+static struct page_watch *page_watches;
+static struct protected_page *protected_pages;
+
+/* The process in which the pages above are protected.  */
+static int page_watch_pid;
+
+/* The method to make the inferior call mprotect, if any.  */
+static int (*linux_nat_inferior_mprotect) (ptid_t, CORE_ADDR, ULONGEST, int);
+
+/* The method to find an LWP's alternate signal stack, if any.  */
+static int (*linux_nat_inferior_sigaltstack) (ptid_t, CORE_ADDR *,
+					      ULONGEST *);
+
+/* The lower layer's watchpoint methods.  */
+static int (*super_insert_watchpoint) (CORE_ADDR, int, int);
+static int (*super_remove_watchpoint) (CORE_ADDR, int, int);
+static int (*super_region_ok_for_hw_watchpoint) (CORE_ADDR, int);
+static int (*super_stopped_by_watchpoint) (void);
+static int (*super_stopped_data_address) (struct target_ops *, CORE_ADDR *);
+
+/* Whether GDB may watch regions by protecting pages.  Off unless the
+   user asks for it, since the program then runs with protections it
+   did not choose.  */
+static int can_use_page_watchpoints = 0;
+
+/* An instruction may access more bytes than the faulting address; a
+   watched region that far past it may have been accessed too.  */
+#define PAGE_WATCH_MAX_ACCESS 64
+
+/* The most pages a single instruction is expected to touch.  */
+#define PAGE_WATCH_MAX_PAGES 4
+
+static void
+show_can_use_page_watchpoints (struct ui_file *file, int from_tty,
+			       struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("\
+Debugger's willingness to watch memory by protecting pages is %s.\n"),
+		    value);
+}
+
+/* Return the page holding ADDR.  */
+
+static CORE_ADDR
+page_watch_page (CORE_ADDR addr)
+{
+  return addr & ~((CORE_ADDR) getpagesize () - 1);
+}
+
+/* Return the protected page holding ADDR, or NULL.  */
+
+static struct protected_page *
+find_protected_page (CORE_ADDR addr)
+{
+  struct protected_page *pp;
+
+  addr = page_watch_page (addr);
+  for (pp = protected_pages; pp != NULL; pp = pp->next)
+    if (pp->addr == addr)
+      return pp;
+
+  return NULL;
+}
+
+/* Return the protection PAGE needs for the current page watches, if
+   the program gave it ORIG_PROT.  */
+
+static int
+page_watch_prot (CORE_ADDR page, int orig_prot)
+{
+  CORE_ADDR end = page + getpagesize ();
+  struct page_watch *w;
+  int prot = orig_prot;
+
+  for (w = page_watches; w != NULL; w = w->next)
+    if (w->addr < end && page < w->addr + w->len)
+      {
+	if (w->type == hw_write)
+	  prot &= ~PROT_WRITE;
+	else
+	  prot = PROT_NONE;
+      }
+
+  return prot;
+}
+
+/* Return non-zero if the memory from START to END in process PID
+   may hold a stack the kernel writes signal frames to: that of one of
+   its threads, or an alternate signal stack one of them set up with
+   sigaltstack.  Writing a signal frame to a protected page would fail
+   and kill the program.  The stack of a running thread can't be
+   found, so if any is running, assume any memory may be its stack.  */
+
+static int
+page_watch_stack_p (int pid, CORE_ADDR start, CORE_ADDR end)
+{
+  struct lwp_info *lp;
+
+  if (linux_nat_inferior_sigaltstack == NULL)
+    return 1;
+
+  for (lp = lwp_list; lp != NULL; lp = lp->next)
+    {
+      struct regcache *regcache;
+      struct gdbarch *gdbarch;
+      ULONGEST sp, ss_size;
+      CORE_ADDR ss_sp;
+
+      if (GET_PID (lp->ptid) != pid)
+	continue;
+
+      if (!lp->stopped)
+	return 1;
+
+      regcache = get_thread_regcache (lp->ptid);
+      gdbarch = get_regcache_arch (regcache);
+      if (gdbarch_sp_regnum (gdbarch) < 0)
+	return 1;
+      regcache_cooked_read_unsigned (regcache, gdbarch_sp_regnum (gdbarch),
+				     &sp);
+      if (sp >= start && sp <= end)
+	return 1;
+
+      if (linux_nat_inferior_sigaltstack (lp->ptid, &ss_sp, &ss_size) != 0)
+	return 1;
+      if (ss_size != 0 && ss_sp < end && start < ss_sp + ss_size)
+	return 1;
+    }
+
+  return 0;
+}
+
+/* Find in process PID's memory map the mapping holding ADDR.  Store
+   its end in *END and its protection in *PROT, and return non-zero,
+   if there is one and it holds no stack (see page_watch_stack_p).
+   Otherwise, return zero.  */
+
+static int
+page_watch_mapping (int pid, CORE_ADDR addr, CORE_ADDR *end, int *prot)
+{
+  char mapsfilename[MAXPATHLEN];
+  FILE *mapsfile;
+  long long start, endaddr, offset, inode;
+  char permissions[8], device[8], filename[MAXPATHLEN];
+  int found = 0;
+
+  sprintf (mapsfilename, "/proc/%d/maps", pid);
+  mapsfile = fopen (mapsfilename, "r");
+  if (mapsfile == NULL)
+    return 0;
+
+  while (read_mapping (mapsfile, &start, &endaddr, &permissions[0],
+		       &offset, &device[0], &inode, &filename[0]))
+    if (addr >= start && addr < endaddr)
+      {
+	*end = endaddr;
+	*prot = ((strchr (permissions, 'r') ? PROT_READ : 0)
+		 | (strchr (permissions, 'w') ? PROT_WRITE : 0)
+		 | (strchr (permissions, 'x') ? PROT_EXEC : 0));
+	found = 1;
+	break;
+      }
+
+  fclose (mapsfile);
+
+  return (found
+	  && strstr (filename, "[stack]") == NULL
+	  && !page_watch_stack_p (pid, start, endaddr));
+}
+
+/* Give each page covering the LEN bytes at ADDR the protection the
+   current page watches need, using LWP PTID to make the calls.
+   Return 0 on success, -1 on failure.  */
+
+static int
+page_watch_update (ptid_t ptid, CORE_ADDR addr, int len)
+{
+  CORE_ADDR page, last, map_end = 0;
+  CORE_ADDR run_start = 0, run_end = 0;
+  int run_prot = 0, map_prot = 0;
+  int pagesize = getpagesize ();
+
+  last = page_watch_page (addr + len - 1);
+  for (page = page_watch_page (addr); ; page += pagesize)
+    {
+      struct protected_page *pp = NULL;
+      int orig, prot, want;
+
+      if (page <= last)
+	pp = find_protected_page (page);
+
+      if (page > last)
+	want = prot = -1;
+      else
+	{
+	  if (pp != NULL)
+	    orig = pp->orig_prot;
+	  else
+	    {
+	      if (page >= map_end
+		  && !page_watch_mapping (GET_PID (ptid), page,
+					  &map_end, &map_prot))
+		return -1;
+	      orig = map_prot;
+	    }
+
+	  prot = pp != NULL ? pp->prot : orig;
+	  want = page_watch_prot (page, orig);
+	}
+
+      /* Change the protection of consecutive pages needing the same
+	 one in a single call.  */
+      if (run_end != run_start
+	  && (page != run_end || want != run_prot || want == prot))
+	{
+	  if (linux_nat_inferior_mprotect (ptid, run_start,
+					   run_end - run_start,
+					   run_prot) != 0)
+	    return -1;
+	  run_start = run_end;
+	}
+
+      if (page > last)
+	break;
+
+      if (want != prot)
+	{
+	  if (run_end == run_start)
+	    {
+	      run_start = page;
+	      run_prot = want;
+	    }
+	  run_end = page + pagesize;
+	}
+
+      if (want == orig && pp != NULL)
+	{
+	  struct protected_page **ppp;
+
+	  for (ppp = &protected_pages; *ppp != pp; ppp = &(*ppp)->next)
+	    ;
+	  *ppp = pp->next;
+	  xfree (pp);
+	}
+      else if (want != orig)
+	{
+	  if (pp == NULL)
+	    {
+	      pp = XZALLOC (struct protected_page);
+	      pp->addr = page;
+	      pp->orig_prot = orig;
+	      pp->next = protected_pages;
+	      protected_pages = pp;
+	    }
+	  pp->prot = want;
+	}
+    }
+
+  return 0;
+}
+
+/* Forget about the page watches without touching the inferior, e.g.
+   because it is gone, or has exec'd.  */
+
+static void
+page_watch_forget (void)
+{
+  while (page_watches != NULL)
+    {
+      struct page_watch *w = page_watches;
+
+      page_watches = w->next;
+      xfree (w);
+    }
+
+  while (protected_pages != NULL)
+    {
+      struct protected_page *pp = protected_pages;
+
+      protected_pages = pp->next;
+      xfree (pp);
+    }
+}
+
+/* Return the LWP of the current inferior thread, for making calls.  */
+
+static ptid_t
+page_watch_ptid (void)
+{
+  if (is_lwp (inferior_ptid))
+    return inferior_ptid;
+  return BUILD_LWP (GET_PID (inferior_ptid), GET_PID (inferior_ptid));
+}
+
+/* Watch LEN bytes at ADDR for accesses of type TYPE by protecting
+   the pages holding them.  Return 0 on success, -1 on failure.  */
+
+static int
+page_watch_insert (CORE_ADDR addr, int len, int type)
+{
+  ptid_t ptid = page_watch_ptid ();
+  struct page_watch *w;
+
+  if (page_watches == NULL && protected_pages == NULL)
+    page_watch_pid = GET_PID (ptid);
+  else if (GET_PID (ptid) != page_watch_pid)
+    return -1;
+
+  w = XZALLOC (struct page_watch);
+  w->addr = addr;
+  w->len = len;
+  w->type = type;
+  w->next = page_watches;
+  page_watches = w;
+
+  if (page_watch_update (ptid, addr, len) != 0)
+    {
+      page_watches = w->next;
+      xfree (w);
+      page_watch_update (ptid, addr, len);
+      return -1;
+    }
+
+  return 0;
+}
+
+/* Stop watching LEN bytes at ADDR for accesses of type TYPE by
+   protecting pages.  Return 0 on success, -1 if there is no such
+   watch.  */
+
+static int
+page_watch_remove (CORE_ADDR addr, int len, int type)
+{
+  ptid_t ptid = page_watch_ptid ();
+  struct page_watch **wp, *w;
+
+  for (wp = &page_watches; *wp != NULL; wp = &(*wp)->next)
+    if ((*wp)->addr == addr && (*wp)->len == len && (*wp)->type == type)
+      break;
+  if (*wp == NULL)
+    return -1;
+
+  if (GET_PID (ptid) != page_watch_pid)
+    {
+      /* This is a fork child about to be detached (see
+	 detach_breakpoints); it inherited the protections, but not
+	 our bookkeeping.  Give its pages their original protection
+	 back.  */
+      CORE_ADDR page;
+
+      for (page = page_watch_page (addr); page < addr + len;
+	   page += getpagesize ())
+	{
+	  struct protected_page *pp = find_protected_page (page);
+
+	  if (pp != NULL)
+	    linux_nat_inferior_mprotect (ptid, page, getpagesize (),
+					 pp->orig_prot);
+	}
+      return 0;
+    }
+
+  w = *wp;
+  *wp = w->next;
+  xfree (w);
+
+  return page_watch_update (ptid, addr, len);
+}
+
+/* Return the watched region which an access faulting at ADDR may
+   have hit, or NULL.  */
+
+static struct page_watch *
+page_watch_hit (CORE_ADDR addr)
+{
+  struct page_watch *w;
+
+  for (w = page_watches; w != NULL; w = w->next)
+    if (w->addr < addr + PAGE_WATCH_MAX_ACCESS && addr < w->addr + w->len)
+      return w;
+
+  return NULL;
+}
+
+/* Return non-zero if LWP LWPID's last stop was a fault on a page
+   protected for a watchpoint, and store the faulting address in
+   *ADDR.  */
+
+static int
+page_watch_fault_p (int lwpid, int status, CORE_ADDR *addr)
+{
+  siginfo_t siginfo;
+
+  if (protected_pages == NULL
+      || !WIFSTOPPED (status) || WSTOPSIG (status) != SIGSEGV)
+    return 0;
+
+  errno = 0;
+  ptrace (PTRACE_GETSIGINFO, lwpid, (PTRACE_TYPE_ARG3) 0, &siginfo);
+  if (errno != 0
+      || siginfo.si_signo != SIGSEGV
+      /* Sent by kill or similar, not a real fault.  */
+      || siginfo.si_code <= 0)
+    return 0;
+
+  *addr = (CORE_ADDR) (uintptr_t) siginfo.si_addr;
+  return find_protected_page (*addr) != NULL;
+}
+
+/* Single-step the stopped LWP LWPID over one instruction, and return
+   its wait status.  Signals reported before the instruction
+   completes are held back, and sent again once it has.  If PAGES is
+   non-NULL, faults on pages protected for watchpoints are stepped
+   over by giving the pages their original protection; they are added
+   to PAGES, and *NPAGES updated, for the caller to protect them
+   again.  */
+
+static int
+step_lwp (int lwpid, CORE_ADDR *pages, int *npages)
+{
+  sigset_t held;
+  int status, signo;
+  CORE_ADDR addr;
+
+  sigemptyset (&held);
+
+  for (;;)
+    {
+      errno = 0;
+      ptrace (PTRACE_SINGLESTEP, lwpid, 0, 0);
+      if (errno != 0
+	  || my_waitpid (lwpid, &status, __WALL) != lwpid)
+	{
+	  status = 0;
+	  break;
+	}
+
+      if (!WIFSTOPPED (status) || WSTOPSIG (status) == SIGTRAP)
+	break;
+
+      if (pages != NULL
+	  && *npages < PAGE_WATCH_MAX_PAGES
+	  && page_watch_fault_p (lwpid, status, &addr))
+	{
+	  struct protected_page *pp = find_protected_page (addr);
+
+	  if (linux_nat_inferior_mprotect (pid_to_ptid (lwpid), pp->addr,
+					   getpagesize (),
+					   pp->orig_prot) != 0)
+	    break;
+	  pages[(*npages)++] = pp->addr;
+	  continue;
+	}
+
+      /* A fault means the instruction can't complete; let the
+	 caller handle it.  */
+      signo = WSTOPSIG (status);
+      if (signo == SIGSEGV || signo == SIGBUS
+	  || signo == SIGILL || signo == SIGFPE)
+	break;
+
+      sigaddset (&held, signo);
+    }
+
+  for (signo = 1; signo < NSIG; signo++)
+    if (sigismember (&held, signo))
+      kill_lwp (lwpid, signo);
+
+  return status;
+}
+
+/* Single-step the stopped LWP PTID over one instruction, holding
+   back any signal which arrives meanwhile.  */
+
+int
+linux_nat_step_lwp (ptid_t ptid)
+{
+  int lwpid = GET_LWP (ptid) ? GET_LWP (ptid) : GET_PID (ptid);
+  int status = step_lwp (lwpid, NULL, NULL);
+
+  return WIFSTOPPED (status) && WSTOPSIG (status) == SIGTRAP;
+}
+
+/* LP stopped with STATUS.  If that is a fault on a page protected for
+   a watchpoint, step over the faulting instruction and return the
+   status to report instead: a SIGTRAP if the instruction accessed a
+   watched region, or was being single-stepped, or -1 after resuming
+   LP if neither.  Otherwise, return STATUS.  */
+
+static int
+linux_nat_page_watch_fault (struct lwp_info *lp, int status)
+{
+  CORE_ADDR addr, pages[PAGE_WATCH_MAX_PAGES];
+  int lwpid = GET_LWP (lp->ptid);
+  int i, npages = 0;
+  struct protected_page *pp;
+  struct page_watch *w;
+
+  if (!page_watch_fault_p (lwpid, status, &addr))
+    return status;
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LLW: %s faulted on watched page at 0x%s\n",
+			target_pid_to_str (lp->ptid), paddr_nz (addr));
+
+  pp = find_protected_page (addr);
+  if (linux_nat_inferior_mprotect (lp->ptid, pp->addr, getpagesize (),
+				   pp->orig_prot) != 0)
+    return status;
+  pages[npages++] = pp->addr;
+
+  status = step_lwp (lwpid, pages, &npages);
+
+  if (WIFSTOPPED (status))
+    for (i = 0; i < npages; i++)
+      {
+	pp = find_protected_page (pages[i]);
+	linux_nat_inferior_mprotect (lp->ptid, pp->addr, getpagesize (),
+				     pp->prot);
+      }
+
+  if (!WIFSTOPPED (status) || WSTOPSIG (status) != SIGTRAP)
+    return status;
+
+  save_siginfo (lp);
+
+  w = page_watch_hit (addr);
+  if (w != NULL)
+    {
+      lp->stopped_by_page_watch = 1;
+      lp->page_watch_addr = addr > w->addr ? addr : w->addr;
+      return status;
+    }
+
+  if (lp->step)
+    return status;
+
+  /* The access was to an unwatched neighbor of a watched region.  */
+  registers_changed ();
+  linux_ops->to_resume (pid_to_ptid (lwpid), 0, TARGET_SIGNAL_0);
+  memset (&lp->siginfo, 0, sizeof (lp->siginfo));
+  return -1;
+}
+
+static int
+linux_nat_insert_watchpoint (CORE_ADDR addr, int len, int type)
+{
+  if (super_insert_watchpoint (addr, len, type) == 0)
+    return 0;
+
+  if (!can_use_page_watchpoints || ptid_equal (inferior_ptid, null_ptid))
+    return -1;
+
+  return page_watch_insert (addr, len, type);
+}
+
+static int
+linux_nat_remove_watchpoint (CORE_ADDR addr, int len, int type)
+{
+  if (page_watch_remove (addr, len, type) == 0)
+    return 0;
+
+  return super_remove_watchpoint (addr, len, type);
+}
+
+static int
+linux_nat_region_ok_for_hw_watchpoint (CORE_ADDR addr, int len)
+{
+  CORE_ADDR page, map_end = 0;
+  int map_prot;
+
+  if (super_region_ok_for_hw_watchpoint (addr, len))
+    return 1;
+
+  if (!can_use_page_watchpoints || ptid_equal (inferior_ptid, null_ptid)
+      || len <= 0)
+    return 0;
+
+  for (page = page_watch_page (addr); page < addr + len;
+       page += getpagesize ())
+    if (page >= map_end
+	&& !page_watch_mapping (GET_PID (inferior_ptid), page,
+				&map_end, &map_prot))
+      return 0;
+
+  return 1;
+}
+
+static int
+linux_nat_stopped_by_watchpoint (void)
+{
+  struct lwp_info *lp = find_lwp_pid (inferior_ptid);
+
+  if (lp != NULL && lp->stopped_by_page_watch)
+    return 1;
+
+  return super_stopped_by_watchpoint ();
+}
+
+static int
+linux_nat_stopped_data_address (struct target_ops *ops, CORE_ADDR *addr_p)
+{
+  struct lwp_info *lp = find_lwp_pid (inferior_ptid);
+
+  if (lp != NULL && lp->stopped_by_page_watch)
+    {
+      *addr_p = lp->page_watch_addr;
+      return 1;
+    }
+
+  return super_stopped_data_address (ops, addr_p);
+}
+
+/* Register a method to make LWP PTID call mprotect (ADDR, LEN, PROT),
+   returning zero on success; this enables watching regions by
+   protecting pages.  */
+
+void
+linux_nat_set_inferior_mprotect (struct target_ops *t,
+				 int (*mprotect_fn) (ptid_t, CORE_ADDR,
+						     ULONGEST, int))
+{
+  /* Save the pointer.  We only support a single registered instance
+     of the GNU/Linux native target, so we do not need to map this to
+     T.  */
+  linux_nat_inferior_mprotect = mprotect_fn;
+
+  super_insert_watchpoint = t->to_insert_watchpoint;
+  super_remove_watchpoint = t->to_remove_watchpoint;
+  super_region_ok_for_hw_watchpoint = t->to_region_ok_for_hw_watchpoint;
+  super_stopped_by_watchpoint = t->to_stopped_by_watchpoint;
+  super_stopped_data_address = t->to_stopped_data_address;
+
+  t->to_insert_watchpoint = linux_nat_insert_watchpoint;
+  t->to_remove_watchpoint = linux_nat_remove_watchpoint;
+  t->to_region_ok_for_hw_watchpoint = linux_nat_region_ok_for_hw_watchpoint;
+  t->to_stopped_by_watchpoint = linux_nat_stopped_by_watchpoint;
+  t->to_stopped_data_address = linux_nat_stopped_data_address;
+}
+
+/* Register a method to find the alternate signal stack of the stopped
+   LWP PTID.  It should store its address and size in *ADDR and *SIZE,
+   or zero in *SIZE if there is none, and return zero on success.
+   Without it, no memory is watched by protecting pages.  */
+
+void
+linux_nat_set_inferior_sigaltstack (struct target_ops *t,
+				    int (*sigaltstack_fn) (ptid_t,
+							   CORE_ADDR *,
+							   ULONGEST *))
+{
+  linux_nat_inferior_sigaltstack = sigaltstack_fn;
+}
+
 void
 linux_nat_add_target (struct target_ops *t)
 {
@@ -4554,6 +5311,18 @@ Tells gdb whether to control the GNU/Linux inferior in asynchronous mode."),
   /* Install the default mode.  */
   linux_nat_set_async_mode (linux_async_permitted);
 
+  add_setshow_boolean_cmd ("can-use-page-watchpoints", class_support,
+			   &can_use_page_watchpoints, _("\
+Set debugger's willingness to watch memory by protecting pages."), _("\
+Show debugger's willingness to watch memory by protecting pages."), _("\
+If zero, gdb will not watch memory the hardware can't watch by changing\n\
+the protection of the pages holding it, and will use software watchpoints\n\
+instead.  Such watchpoints make system calls which access the watched\n\
+pages fail.  This only affects watchpoints set afterwards."),
+			   NULL,
+			   show_can_use_page_watchpoints,
+			   &setlist, &showlist);
+
   add_setshow_boolean_cmd ("disable-randomization", class_support,
 			   &disable_randomization, _("\
 Set disabling of debuggee's virtual address space randomization."), _("\
@@ -62,6 +62,11 @@ struct lwp_info
      be the address of a hardware watchpoint.  */
   struct siginfo siginfo;
 
+  /* Non-zero if this LWP stopped after accessing a region watched
+     by protecting pages, and the address of the access.  */
+  int stopped_by_page_watch;
+  CORE_ADDR page_watch_addr;
+
   /* Non-zero if we expect a duplicated SIGINT.  */
   int ignore_sigint;
 
@@ -104,6 +109,7 @@ void linux_proc_pending_signals (int pid, sigset_t *pending, sigset_t *blocked,
 
 /* linux-nat functions for handling fork events.  */
 extern void linux_enable_event_reporting (ptid_t ptid);
+extern int linux_nat_reports_clones (void);
 
 extern int lin_lwp_attach_lwp (ptid_t ptid);
 
@@ -128,6 +134,25 @@ void linux_nat_add_target (struct target_ops *);
 /* Register a method to call whenever a new thread is attached.  */
 void linux_nat_set_new_thread (struct target_ops *, void (*) (ptid_t));
 
+/* Register a method to make LWP PTID call mprotect (ADDR, LEN, PROT),
+   returning zero on success; this enables watching regions by
+   protecting pages.  */
+void linux_nat_set_inferior_mprotect (struct target_ops *,
+				      int (*) (ptid_t, CORE_ADDR,
+					       ULONGEST, int));
+
+/* Register a method to find the alternate signal stack of the stopped
+   LWP PTID, storing its address and size, or a size of zero if there
+   is none, and returning zero on success.  Memory is only watched by
+   protecting pages if there is one.  */
+void linux_nat_set_inferior_sigaltstack (struct target_ops *,
+					 int (*) (ptid_t, CORE_ADDR *,
+						  ULONGEST *));
+
+/* Single-step the stopped LWP PTID over one instruction, holding back
+   any signal which arrives meanwhile.  Return non-zero on success.  */
+int linux_nat_step_lwp (ptid_t ptid);
+
 /* Update linux-nat internal state when changing from one fork
    to another.  */
 void linux_nat_switch_fork (ptid_t new_ptid);
@@ -99,6 +99,13 @@ static struct ps_prochandle proc_handle;
 /* Connection to the libthread_db library.  */
 static td_thragent_t *thread_agent;
 
+/* Non-zero if the last walk over libthread_db's thread list attached
+   to every thread it found, and linux-nat reports the LWPs cloned
+   since then.  Every thread is then either known already or has an
+   LWP on LWP_LIST, so thread_db_find_new_threads need only examine
+   the LWPs that have no thread information yet.  */
+static int thread_list_complete;
+
 /* Pointers to the libthread_db functions.  */
 
 static td_err_e (*td_init_p) (void);
@@ -662,6 +669,7 @@ check_for_thread_db (void)
       /* The thread library was detected.  Activate the thread_db target.  */
       push_target (&thread_db_ops);
       using_thread_db = 1;
+      thread_list_complete = 0;
 
       enable_thread_event_reporting ();
       thread_db_find_new_threads ();
@@ -969,6 +977,11 @@ thread_db_async_mask (int mask)
   return target_beneath->to_async_mask (mask);
 }
 
+/* A callback function for td_ta_thr_iter, which attaches to the
+   thread TH_P if GDB does not know about it yet.  If DATA is not NULL,
+   it points to an int which is cleared if the thread could not be
+   attached to.  */
+
 static int
 find_new_threads_callback (const td_thrhandle_t *th_p, void *data)
 {
@@ -1005,11 +1018,53 @@ find_new_threads_callback (const td_thrhandle_t *th_p, void *data)
 
   tp = find_thread_pid (ptid);
   if (tp == NULL || tp->private == NULL)
-    attach_thread (ptid, th_p, &ti);
+    {
+      attach_thread (ptid, th_p, &ti);
+
+      tp = find_thread_pid (ptid);
+      if ((tp == NULL || tp->private == NULL) && data != NULL)
+	*(int *) data = 0;
+    }
 
   return 0;
 }
 
+/* Look up the user-level thread of each LWP that has no thread
+   information yet, and attach to it.  Return zero if one of those
+   LWPs could not be examined, in which case the caller should walk
+   the whole thread list instead.  */
+
+static int
+find_new_lwp_threads (void)
+{
+  struct lwp_info *lp;
+  struct thread_info *tp;
+  td_thrhandle_t th;
+  td_err_e err;
+  ptid_t ptid;
+
+  ALL_LWPS (lp, ptid)
+    {
+      tp = find_thread_pid (ptid);
+      if (tp != NULL && tp->private != NULL)
+	continue;
+
+      /* libthread_db reads the registers of the LWP to find its
+	 thread.  */
+      if (!lp->stopped)
+	return 0;
+
+      proc_handle.pid = GET_LWP (ptid);
+      err = td_ta_map_lwp2thr_p (thread_agent, GET_LWP (ptid), &th);
+      if (err != TD_OK)
+	return 0;
+
+      find_new_threads_callback (&th, NULL);
+    }
+
+  return 1;
+}
+
 /* Search for new threads, accessing memory through stopped thread
    PTID.  */
 
@@ -1019,6 +1074,7 @@ thread_db_find_new_threads (void)
   td_err_e err;
   struct lwp_info *lp;
   ptid_t ptid;
+  int complete;
 
   /* In linux, we can only read memory through a stopped lwp.  */
   ALL_LWPS (lp, ptid)
@@ -1029,14 +1085,22 @@ thread_db_find_new_threads (void)
     /* There is no stopped thread.  Bail out.  */
     return;
 
+  /* If no thread can have escaped linux-nat since the last walk,
+     only the LWPs we have not seen as threads need looking at.  */
+  if (thread_list_complete && find_new_lwp_threads ())
+    return;
+
   /* Access an lwp we know is stopped.  */
   proc_handle.pid = GET_LWP (ptid);
   /* Iterate over all user-space threads to discover new threads.  */
-  err = td_ta_thr_iter_p (thread_agent, find_new_threads_callback, NULL,
+  thread_list_complete = 0;
+  complete = linux_nat_reports_clones ();
+  err = td_ta_thr_iter_p (thread_agent, find_new_threads_callback, &complete,
 			  TD_THR_ANY_STATE, TD_THR_LOWEST_PRIORITY,
 			  TD_SIGNO_MASK, TD_THR_ANY_USER_FLAGS);
   if (err != TD_OK)
     error (_("Cannot find new threads: %s"), thread_db_err_str (err));
+  thread_list_complete = complete;
 }
 
 static char *
@@ -923,6 +923,10 @@ m32r_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
 					m32r_memory_insert_breakpoint);
   set_gdbarch_memory_remove_breakpoint (gdbarch,
 					m32r_memory_remove_breakpoint);
+  set_gdbarch_memory_insert_breakpoints (gdbarch,
+					 simple_memory_insert_breakpoints);
+  set_gdbarch_memory_remove_breakpoints (gdbarch,
+					 simple_memory_remove_breakpoints);
 
   set_gdbarch_frame_align (gdbarch, m32r_frame_align);
 
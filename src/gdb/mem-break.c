@@ -29,6 +29,7 @@
 #include "breakpoint.h"
 #include "inferior.h"
 #include "target.h"
+#include "gdb_string.h"
 
 
 /* Insert a breakpoint on targets that don't have any better
@@ -88,3 +89,220 @@ memory_remove_breakpoint (struct bp_target_info *bp_tgt)
 {
   return gdbarch_memory_remove_breakpoint (current_gdbarch, bp_tgt);
 }
+
+/* Software breakpoints on the same page of this size are read and
+   written together by default_memory_insert_breakpoints and
+   default_memory_remove_breakpoints.  */
+
+#define BREAKPOINT_GROUP_SIZE 4096
+
+/* One breakpoint handed to default_memory_insert_breakpoints or
+   default_memory_remove_breakpoints, with where its result goes.  */
+
+struct bp_tgt_slot
+{
+  struct bp_target_info *bp_tgt;
+  const gdb_byte *contents;
+  int *result;
+};
+
+static int
+compare_bp_tgt_slots (const void *ap, const void *bp)
+{
+  const struct bp_tgt_slot *a = ap;
+  const struct bp_tgt_slot *b = bp;
+
+  if (a->bp_tgt->placed_address < b->bp_tgt->placed_address)
+    return -1;
+  if (a->bp_tgt->placed_address > b->bp_tgt->placed_address)
+    return 1;
+  return 0;
+}
+
+/* Return the index one past the last of the sorted SLOTS, starting
+   at START, that are on the same page as SLOTS[START].  */
+
+static int
+bp_tgt_group_end (struct bp_tgt_slot *slots, int start, int count)
+{
+  CORE_ADDR mask = ~(CORE_ADDR) (BREAKPOINT_GROUP_SIZE - 1);
+  CORE_ADDR page = slots[start].bp_tgt->placed_address & mask;
+  int end;
+
+  for (end = start + 1; end < count; end++)
+    if ((slots[end].bp_tgt->placed_address & mask) != page)
+      break;
+
+  return end;
+}
+
+/* Insert or remove the breakpoints in BP_TGTS, a page at a time.  The
+   memory covering the breakpoints on each page is read once, with
+   any breakpoints already inserted there left in place, patched, and
+   written back once.  If INSERT, the breakpoint instructions are
+   patched in and their shadows saved; otherwise the shadows are put
+   back.  A group that can not be read is handled one breakpoint at a
+   time, so that each gets its own result.  */
+
+static void
+memory_update_breakpoints (struct gdbarch *gdbarch,
+			   struct bp_target_info **bp_tgts, int count,
+			   int *results, int insert)
+{
+  struct bp_tgt_slot *slots;
+  struct cleanup *old_chain;
+  gdb_byte *buf = NULL;
+  int start, end, i;
+
+  if (count == 0)
+    return;
+
+  slots = xmalloc (count * sizeof (struct bp_tgt_slot));
+  old_chain = make_cleanup (free_current_contents, &slots);
+  make_cleanup (free_current_contents, &buf);
+
+  for (i = 0; i < count; i++)
+    {
+      struct bp_target_info *bp_tgt = bp_tgts[i];
+
+      slots[i].bp_tgt = bp_tgt;
+      slots[i].result = &results[i];
+      slots[i].contents = NULL;
+
+      if (insert)
+	{
+	  slots[i].contents = gdbarch_breakpoint_from_pc
+	    (gdbarch, &bp_tgt->placed_address, &bp_tgt->placed_size);
+	  if (slots[i].contents == NULL)
+	    error (_("Software breakpoints not implemented for this target."));
+	  bp_tgt->shadow_len = bp_tgt->placed_size;
+	}
+    }
+
+  qsort (slots, count, sizeof (struct bp_tgt_slot), compare_bp_tgt_slots);
+
+  for (start = 0; start < count; start = end)
+    {
+      CORE_ADDR lo, hi;
+      struct cleanup *show_chain;
+      gdb_byte *raw, *shadow;
+      int len, val;
+
+      end = bp_tgt_group_end (slots, start, count);
+
+      lo = slots[start].bp_tgt->placed_address;
+      hi = lo;
+      for (i = start; i < end; i++)
+	{
+	  struct bp_target_info *bp_tgt = slots[i].bp_tgt;
+
+	  if (bp_tgt->placed_address + bp_tgt->placed_size > hi)
+	    hi = bp_tgt->placed_address + bp_tgt->placed_size;
+	}
+      len = hi - lo;
+
+      buf = xrealloc (buf, 2 * len);
+      raw = buf;
+      shadow = buf + len;
+
+      show_chain = make_show_memory_breakpoints_cleanup (1);
+      val = target_read_memory (lo, raw, len);
+      do_cleanups (show_chain);
+
+      if (val != 0)
+	{
+	  for (i = start; i < end; i++)
+	    if (insert)
+	      *slots[i].result
+		= gdbarch_memory_insert_breakpoint (gdbarch, slots[i].bp_tgt);
+	    else
+	      *slots[i].result
+		= gdbarch_memory_remove_breakpoint (gdbarch, slots[i].bp_tgt);
+	  continue;
+	}
+
+      /* What a plain read would have returned, for the shadows.  */
+      if (insert)
+	{
+	  memcpy (shadow, raw, len);
+	  breakpoint_restore_shadows (shadow, lo, len);
+	}
+
+      for (i = start; i < end; i++)
+	{
+	  struct bp_target_info *bp_tgt = slots[i].bp_tgt;
+	  int offset = bp_tgt->placed_address - lo;
+
+	  if (insert)
+	    {
+	      memcpy (bp_tgt->shadow_contents, shadow + offset,
+		      bp_tgt->placed_size);
+	      memcpy (raw + offset, slots[i].contents, bp_tgt->placed_size);
+	    }
+	  else
+	    memcpy (raw + offset, bp_tgt->shadow_contents,
+		    bp_tgt->placed_size);
+	}
+
+      val = target_write_memory (lo, raw, len);
+      for (i = start; i < end; i++)
+	*slots[i].result = val;
+    }
+
+  do_cleanups (old_chain);
+}
+
+void
+default_memory_insert_breakpoints (struct gdbarch *gdbarch,
+				   struct bp_target_info **bp_tgts,
+				   int count, int *results)
+{
+  memory_update_breakpoints (gdbarch, bp_tgts, count, results, 1);
+}
+
+void
+default_memory_remove_breakpoints (struct gdbarch *gdbarch,
+				   struct bp_target_info **bp_tgts,
+				   int count, int *results)
+{
+  memory_update_breakpoints (gdbarch, bp_tgts, count, results, 0);
+}
+
+/* Versions of the above for architectures with their own
+   memory_insert_breakpoint and memory_remove_breakpoint methods.  */
+
+void
+simple_memory_insert_breakpoints (struct gdbarch *gdbarch,
+				  struct bp_target_info **bp_tgts,
+				  int count, int *results)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    results[i] = gdbarch_memory_insert_breakpoint (gdbarch, bp_tgts[i]);
+}
+
+void
+simple_memory_remove_breakpoints (struct gdbarch *gdbarch,
+				  struct bp_target_info **bp_tgts,
+				  int count, int *results)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    results[i] = gdbarch_memory_remove_breakpoint (gdbarch, bp_tgts[i]);
+}
+
+void
+memory_insert_breakpoints (struct bp_target_info **bp_tgts, int count,
+			   int *results)
+{
+  gdbarch_memory_insert_breakpoints (current_gdbarch, bp_tgts, count, results);
+}
+
+void
+memory_remove_breakpoints (struct bp_target_info **bp_tgts, int count,
+			   int *results)
+{
+  gdbarch_memory_remove_breakpoints (current_gdbarch, bp_tgts, count, results);
+}
@@ -791,6 +791,267 @@ mi_cmd_data_read_memory (char *command, char **argv, int argc)
   do_cleanups (cleanups);
 }
 
+/* The encodings of -data-read-memory-bytes.  */
+
+enum mi_memory_encoding
+  {
+    MI_MEMORY_HEX,
+    MI_MEMORY_BASE64
+  };
+
+/* Encodes memory into a stream, a chunk at a time.  */
+
+struct mi_memory_encoder
+{
+  enum mi_memory_encoding encoding;
+  struct ui_file *stream;
+
+  /* Bytes not yet encoded, since base64 encodes three bytes at a
+     time.  */
+  gdb_byte pending[3];
+  int nr_pending;
+};
+
+static const char mi_base64_digits[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Encode the three bytes in ENCODER's pending buffer, of which
+   NR_PENDING are valid, as four base64 digits.  */
+
+static void
+mi_encode_base64_group (struct mi_memory_encoder *encoder)
+{
+  const gdb_byte *p = encoder->pending;
+  int n = encoder->nr_pending;
+  char out[4];
+
+  out[0] = mi_base64_digits[p[0] >> 2];
+  out[1] = mi_base64_digits[((p[0] & 0x03) << 4)
+			    | (n > 1 ? p[1] >> 4 : 0)];
+  out[2] = (n > 1
+	    ? mi_base64_digits[((p[1] & 0x0f) << 2)
+			       | (n > 2 ? p[2] >> 6 : 0)]
+	    : '=');
+  out[3] = n > 2 ? mi_base64_digits[p[2] & 0x3f] : '=';
+  ui_file_write (encoder->stream, out, 4);
+  encoder->nr_pending = 0;
+}
+
+/* Append the LEN bytes at BUF to ENCODER's stream.  */
+
+static void
+mi_encode_memory (struct mi_memory_encoder *encoder,
+		  const gdb_byte *buf, LONGEST len)
+{
+  static const char hex_digits[] = "0123456789abcdef";
+  char out[128];
+  int n = 0;
+  LONGEST i;
+
+  if (encoder->encoding == MI_MEMORY_HEX)
+    {
+      for (i = 0; i < len; i++)
+	{
+	  out[n++] = hex_digits[buf[i] >> 4];
+	  out[n++] = hex_digits[buf[i] & 0x0f];
+	  if (n == sizeof (out))
+	    {
+	      ui_file_write (encoder->stream, out, n);
+	      n = 0;
+	    }
+	}
+      ui_file_write (encoder->stream, out, n);
+      return;
+    }
+
+  for (i = 0; i < len; i++)
+    {
+      encoder->pending[encoder->nr_pending++] = buf[i];
+      if (encoder->nr_pending == 3)
+	mi_encode_base64_group (encoder);
+    }
+}
+
+/* Encode the bytes ENCODER still holds, padding the output.  */
+
+static void
+mi_encode_memory_flush (struct mi_memory_encoder *encoder)
+{
+  if (encoder->encoding == MI_MEMORY_BASE64 && encoder->nr_pending > 0)
+    mi_encode_base64_group (encoder);
+}
+
+/* Output the block of memory from BEGIN to END, whose contents
+   ENCODER has collected, as a tuple of the memory list.  */
+
+static void
+mi_output_memory_block (struct mi_memory_encoder *encoder,
+			struct ui_stream *stream,
+			CORE_ADDR begin, CORE_ADDR end)
+{
+  struct cleanup *cleanup_tuple;
+
+  mi_encode_memory_flush (encoder);
+  cleanup_tuple = make_cleanup_ui_out_tuple_begin_end (uiout, NULL);
+  ui_out_field_core_addr (uiout, "begin", begin);
+  ui_out_field_core_addr (uiout, "end", end);
+  ui_out_field_stream (uiout, "contents", stream);
+  do_cleanups (cleanup_tuple);
+}
+
+/* The number of bytes -data-read-memory-bytes reads from the target
+   at a time.  */
+#define MI_READ_MEMORY_CHUNK 65536
+
+/* How far -data-read-memory-bytes skips when it finds unreadable
+   memory, before trying to read again.  */
+#define MI_READ_MEMORY_SKIP 4096
+
+/* DATA-READ-MEMORY-BYTES:
+
+   ENCODING: optional argument.  Must be preceeded by '-e'.  The
+   encoding of the memory contents, "hex" (the default) or "base64".
+   ADDR COUNT: the address and length of a range of memory to read.
+   Any number of ranges can be given.
+
+   Reads each range from the target in large chunks, and outputs the
+   readable blocks of memory in it, each as a tuple with the BEGIN and
+   END addresses of the block and the encoded CONTENTS of the block.
+   Unreadable memory is skipped.
+
+   Prints:
+
+   memory=[{begin="0x...",end="0x...",contents="..."},...]  */
+
+void
+mi_cmd_data_read_memory_bytes (char *command, char **argv, int argc)
+{
+  struct cleanup *cleanups = make_cleanup (null_cleanup, NULL);
+  struct cleanup *cleanup_list_memory;
+  struct mi_memory_encoder encoder;
+  struct ui_stream *stream;
+  gdb_byte *buf;
+  CORE_ADDR *addrs;
+  ULONGEST *counts;
+  int nr_ranges;
+  int optind = 0;
+  char *optarg;
+  int i;
+  enum opt
+    {
+      ENCODING_OPT
+    };
+  static struct mi_opt opts[] =
+  {
+    {"e", ENCODING_OPT, 1},
+    { 0, 0, 0 }
+  };
+
+  memset (&encoder, 0, sizeof (encoder));
+  encoder.encoding = MI_MEMORY_HEX;
+
+  while (1)
+    {
+      int opt = mi_getopt ("mi_cmd_data_read_memory_bytes", argc, argv, opts,
+			   &optind, &optarg);
+      if (opt < 0)
+	break;
+      switch ((enum opt) opt)
+	{
+	case ENCODING_OPT:
+	  if (strcmp (optarg, "hex") == 0)
+	    encoder.encoding = MI_MEMORY_HEX;
+	  else if (strcmp (optarg, "base64") == 0)
+	    encoder.encoding = MI_MEMORY_BASE64;
+	  else
+	    error ("mi_cmd_data_read_memory_bytes: unknown encoding `%s'.",
+		   optarg);
+	  break;
+	}
+    }
+  argv += optind;
+  argc -= optind;
+
+  if (argc < 2 || argc % 2 != 0)
+    error ("mi_cmd_data_read_memory_bytes: Usage: [-e ENCODING] ADDR COUNT [ADDR COUNT]...");
+
+  /* Check all the ranges before reading any.  */
+  nr_ranges = argc / 2;
+  addrs = xmalloc (nr_ranges * sizeof (CORE_ADDR));
+  make_cleanup (xfree, addrs);
+  counts = xmalloc (nr_ranges * sizeof (ULONGEST));
+  make_cleanup (xfree, counts);
+  for (i = 0; i < nr_ranges; i++)
+    {
+      long count;
+
+      addrs[i] = parse_and_eval_address (argv[2 * i]);
+      count = atol (argv[2 * i + 1]);
+      if (count <= 0)
+	error ("mi_cmd_data_read_memory_bytes: invalid count `%s'.",
+	       argv[2 * i + 1]);
+      counts[i] = count;
+    }
+
+  buf = xmalloc (MI_READ_MEMORY_CHUNK);
+  make_cleanup (xfree, buf);
+  stream = ui_out_stream_new (uiout);
+  make_cleanup_ui_out_stream_delete (stream);
+  encoder.stream = stream->stream;
+
+  cleanup_list_memory = make_cleanup_ui_out_list_begin_end (uiout, "memory");
+  for (i = 0; i < nr_ranges; i++)
+    {
+      CORE_ADDR addr = addrs[i];
+      ULONGEST remaining = counts[i];
+      CORE_ADDR begin = addr;
+      int in_block = 0;
+
+      while (remaining > 0)
+	{
+	  LONGEST len = min (remaining, MI_READ_MEMORY_CHUNK);
+	  LONGEST nr_bytes;
+	  ULONGEST skip;
+
+	  nr_bytes = target_read_until_error (&current_target,
+					      TARGET_OBJECT_MEMORY, NULL,
+					      buf, addr, len);
+	  if (nr_bytes > 0)
+	    {
+	      if (!in_block)
+		{
+		  begin = addr;
+		  in_block = 1;
+		}
+	      mi_encode_memory (&encoder, buf, nr_bytes);
+	      addr += nr_bytes;
+	      remaining -= nr_bytes;
+	    }
+
+	  if (nr_bytes == len)
+	    continue;
+
+	  /* The memory at ADDR can not be read.  Finish the current
+	     block, and try again further on.  */
+	  if (in_block)
+	    {
+	      mi_output_memory_block (&encoder, stream, begin, addr);
+	      in_block = 0;
+	    }
+	  skip = MI_READ_MEMORY_SKIP - addr % MI_READ_MEMORY_SKIP;
+	  if (skip >= remaining)
+	    break;
+	  addr += skip;
+	  remaining -= skip;
+	}
+
+      if (in_block)
+	mi_output_memory_block (&encoder, stream, begin, addr);
+    }
+  do_cleanups (cleanup_list_memory);
+  do_cleanups (cleanups);
+}
+
 /* DATA-MEMORY-WRITE:
 
    COLUMN_OFFSET: optional argument. Must be preceeded by '-o'. The
@@ -23,13 +23,19 @@
 #include "defs.h"
 #include "ui-out.h"
 #include "mi-out.h"
+#include "gdb_string.h"
 
 struct ui_out_data
   {
     int suppress_field_separator;
     int suppress_output;
     int mi_version;
-    struct ui_file *buffer;
+
+    /* The text of the record being built, LENGTH characters long, in
+       a buffer of SIZE characters which is only ever grown.  */
+    char *buffer;
+    long length;
+    long size;
   };
 typedef struct ui_out_data mi_out_data;
 
@@ -98,6 +104,69 @@ static void mi_open (struct ui_out *uiout, const char *name,
 		     enum ui_out_type type);
 static void mi_close (struct ui_out *uiout, enum ui_out_type type);
 
+/* How each character is written inside a quoted MI string: NULL if
+   it stands for itself, or else its escape sequence, the same that
+   fputstr_unfiltered would print.  Characters from 0xa0 up are only
+   escaped if sevenbit_strings is set.  */
+static const char *mi_escapes[256];
+
+/* Make room for LEN more characters in DATA's buffer.  */
+
+static void
+mi_out_reserve (mi_out_data *data, long len)
+{
+  if (data->length + len > data->size)
+    {
+      while (data->length + len > data->size)
+	data->size *= 2;
+      data->buffer = xrealloc (data->buffer, data->size);
+    }
+}
+
+/* Append the LEN characters at TEXT to DATA's buffer.  */
+
+static void
+mi_out_append (mi_out_data *data, const char *text, long len)
+{
+  mi_out_reserve (data, len);
+  memcpy (data->buffer + data->length, text, len);
+  data->length += len;
+}
+
+/* Append the character C to DATA's buffer.  */
+
+static void
+mi_out_append_char (mi_out_data *data, char c)
+{
+  mi_out_reserve (data, 1);
+  data->buffer[data->length++] = c;
+}
+
+/* Append STRING to DATA's buffer, escaped for use inside double
+   quotes.  Runs of characters that need no escaping are copied
+   together.  */
+
+static void
+mi_out_append_quoted (mi_out_data *data, const char *string)
+{
+  const char *run = string;
+  const char *p;
+
+  for (p = string; *p != '\0'; p++)
+    {
+      unsigned char c = *p;
+      const char *escape = mi_escapes[c];
+
+      if (escape == NULL || (c >= 0xa0 && !sevenbit_strings))
+	continue;
+
+      mi_out_append (data, run, p - run);
+      mi_out_append (data, escape, strlen (escape));
+      run = p + 1;
+    }
+  mi_out_append (data, run, p - run);
+}
+
 /* Mark beginning of a table */
 
 void
@@ -195,7 +264,7 @@ mi_field_int (struct ui_out *uiout, int fldno, int width,
   if (data->suppress_output)
     return;
 
-  sprintf (buffer, "%d", value);
+  xsnprintf (buffer, sizeof (buffer), "%d", value);
   mi_field_string (uiout, fldno, width, alignment, fldname, buffer);
 }
 
@@ -227,11 +296,14 @@ mi_field_string (struct ui_out *uiout,
     return;
   field_separator (uiout);
   if (fldname)
-    fprintf_unfiltered (data->buffer, "%s=", fldname);
-  fprintf_unfiltered (data->buffer, "\"");
+    {
+      mi_out_append (data, fldname, strlen (fldname));
+      mi_out_append_char (data, '=');
+    }
+  mi_out_append_char (data, '"');
   if (string)
-    fputstr_unfiltered (string, '"', data->buffer);
-  fprintf_unfiltered (data->buffer, "\"");
+    mi_out_append_quoted (data, string);
+  mi_out_append_char (data, '"');
 }
 
 /* This is the only field function that does not align */
@@ -244,15 +316,21 @@ mi_field_fmt (struct ui_out *uiout, int fldno,
 	      va_list args)
 {
   mi_out_data *data = ui_out_data (uiout);
+  char *text;
+
   if (data->suppress_output)
     return;
   field_separator (uiout);
   if (fldname)
-    fprintf_unfiltered (data->buffer, "%s=\"", fldname);
-  else
-    fputs_unfiltered ("\"", data->buffer);
-  vfprintf_unfiltered (data->buffer, format, args);
-  fputs_unfiltered ("\"", data->buffer);
+    {
+      mi_out_append (data, fldname, strlen (fldname));
+      mi_out_append_char (data, '=');
+    }
+  mi_out_append_char (data, '"');
+  text = xstrvprintf (format, args);
+  mi_out_append (data, text, strlen (text));
+  xfree (text);
+  mi_out_append_char (data, '"');
 }
 
 void
@@ -281,8 +359,7 @@ mi_wrap_hint (struct ui_out *uiout, char *identstring)
 void
 mi_flush (struct ui_out *uiout)
 {
-  mi_out_data *data = ui_out_data (uiout);
-  gdb_flush (data->buffer);
+  /* The record is only written out by mi_out_put.  */
 }
 
 /* local functions */
@@ -296,7 +373,7 @@ field_separator (struct ui_out *uiout)
   if (data->suppress_field_separator)
     data->suppress_field_separator = 0;
   else
-    fputc_unfiltered (',', data->buffer);
+    mi_out_append_char (data, ',');
 }
 
 static void
@@ -308,14 +385,17 @@ mi_open (struct ui_out *uiout,
   field_separator (uiout);
   data->suppress_field_separator = 1;
   if (name)
-    fprintf_unfiltered (data->buffer, "%s=", name);
+    {
+      mi_out_append (data, name, strlen (name));
+      mi_out_append_char (data, '=');
+    }
   switch (type)
     {
     case ui_out_type_tuple:
-      fputc_unfiltered ('{', data->buffer);
+      mi_out_append_char (data, '{');
       break;
     case ui_out_type_list:
-      fputc_unfiltered ('[', data->buffer);
+      mi_out_append_char (data, '[');
       break;
     default:
       internal_error (__FILE__, __LINE__, _("bad switch"));
@@ -330,10 +410,10 @@ mi_close (struct ui_out *uiout,
   switch (type)
     {
     case ui_out_type_tuple:
-      fputc_unfiltered ('}', data->buffer);
+      mi_out_append_char (data, '}');
       break;
     case ui_out_type_list:
-      fputc_unfiltered (']', data->buffer);
+      mi_out_append_char (data, ']');
       break;
     default:
       internal_error (__FILE__, __LINE__, _("bad switch"));
@@ -347,7 +427,7 @@ void
 mi_out_buffered (struct ui_out *uiout, char *string)
 {
   mi_out_data *data = ui_out_data (uiout);
-  fprintf_unfiltered (data->buffer, "%s", string);
+  mi_out_append (data, string, strlen (string));
 }
 
 /* clear the buffer */
@@ -356,24 +436,19 @@ void
 mi_out_rewind (struct ui_out *uiout)
 {
   mi_out_data *data = ui_out_data (uiout);
-  ui_file_rewind (data->buffer);
+  data->length = 0;
 }
 
-/* dump the buffer onto the specified stream */
-
-static void
-do_write (void *data, const char *buffer, long length_buffer)
-{
-  ui_file_write (data, buffer, length_buffer);
-}
+/* dump the buffer onto the specified stream, in one write */
 
 void
 mi_out_put (struct ui_out *uiout,
 	    struct ui_file *stream)
 {
   mi_out_data *data = ui_out_data (uiout);
-  ui_file_put (data->buffer, do_write, stream);
-  ui_file_rewind (data->buffer);
+  if (data->length > 0)
+    ui_file_write (stream, data->buffer, data->length);
+  data->length = 0;
 }
 
 /* Current MI version.  */
@@ -395,9 +470,9 @@ mi_out_new (int mi_version)
   data->suppress_field_separator = 0;
   data->suppress_output = 0;
   data->mi_version = mi_version;
-  /* FIXME: This code should be using a ``string_file'' and not the
-     TUI buffer hack. */
-  data->buffer = mem_fileopen ();
+  data->size = 1024;
+  data->buffer = xmalloc (data->size);
+  data->length = 0;
   return ui_out_new (&mi_ui_out_impl, data, flags);
 }
 
@@ -405,5 +480,43 @@ mi_out_new (int mi_version)
 void
 _initialize_mi_out (void)
 {
-  /* nothing happens here */
+  int c;
+
+  for (c = 0; c < 256; c++)
+    {
+      if (c < 0x20 || c >= 0x7f)
+	{
+	  switch (c)
+	    {
+	    case '\n':
+	      mi_escapes[c] = "\\n";
+	      break;
+	    case '\b':
+	      mi_escapes[c] = "\\b";
+	      break;
+	    case '\t':
+	      mi_escapes[c] = "\\t";
+	      break;
+	    case '\f':
+	      mi_escapes[c] = "\\f";
+	      break;
+	    case '\r':
+	      mi_escapes[c] = "\\r";
+	      break;
+	    case '\033':
+	      mi_escapes[c] = "\\e";
+	      break;
+	    case '\007':
+	      mi_escapes[c] = "\\a";
+	      break;
+	    default:
+	      mi_escapes[c] = xstrprintf ("\\%.3o", c);
+	      break;
+	    }
+	}
+      else if (c == '\\')
+	mi_escapes[c] = "\\\\";
+      else if (c == '"')
+	mi_escapes[c] = "\\\"";
+    }
 }
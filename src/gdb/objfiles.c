@@ -50,6 +50,7 @@
 #include "addrmap.h"
 #include "arch-utils.h"
 #include "exec.h"
+#include "dwarf2-frame.h"
 
 /* Prototypes for local functions */
 
@@ -425,6 +426,10 @@ free_objfile (struct objfile *objfile)
       (*objfile->sf->sym_finish) (objfile);
     }
 
+  /* Drop any pending idle-time reads of this objfile's symtabs.  */
+
+  forget_psymtab_prefetches (objfile);
+
   /* We always close the bfd. */
 
   if (objfile->obfd != NULL)
@@ -456,6 +461,8 @@ free_objfile (struct objfile *objfile)
   /* Not all our callers call clear_symtab_users (objfile_purge_solibs,
      for example), so we need to call this here.  */
   clear_pc_function_cache ();
+  clear_pc_line_cache ();
+  dwarf2_frame_clear_plans ();
 
   /* Clear globals which might have pointed into a removed objfile.
      FIXME: It's not clear which of these are supposed to persist
@@ -486,8 +493,12 @@ free_objfile (struct objfile *objfile)
     }
   if (objfile->global_psymbols.list)
     xfree (objfile->global_psymbols.list);
+  if (objfile->global_psymbols.keys)
+    xfree (objfile->global_psymbols.keys);
   if (objfile->static_psymbols.list)
     xfree (objfile->static_psymbols.list);
+  if (objfile->static_psymbols.keys)
+    xfree (objfile->static_psymbols.keys);
   /* Free the obstacks for non-reusable objfiles */
   bcache_xfree (objfile->psymbol_cache);
   bcache_xfree (objfile->macro_cache);
@@ -689,6 +700,11 @@ objfile_relocate (struct objfile *objfile, struct section_offsets *new_offsets)
 				s->addr);
     }
 
+  /* The pcs of the functions, the linetables and the CFI have moved.  */
+  clear_pc_function_cache ();
+  clear_pc_line_cache ();
+  dwarf2_frame_clear_plans ();
+
   /* Relocate breakpoints as necessary, after things are relocated. */
   breakpoint_re_set ();
 }
@@ -161,6 +161,8 @@ struct objstats
     int n_stabs;		/* Number of ".stabs" read (if applicable) */
     int n_types;		/* Number of types */
     int sz_strtab;		/* Size of stringtable, (if applicable) */
+    int n_psym_compares;	/* Number of psymbol names compared by
+				   lookup_partial_symbol */
   };
 
 #define OBJSTAT(objfile, expr) (objfile -> stats.expr)
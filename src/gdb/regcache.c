@@ -29,6 +29,7 @@
 #include "gdb_string.h"
 #include "gdbcmd.h"		/* For maintenanceprintlist.  */
 #include "observer.h"
+#include "hashtab.h"
 
 /*
  * DATA STRUCTURE
@@ -409,10 +410,38 @@ regcache_invalidate (struct regcache *regcache, int regnum)
 }
 
 
-/* Global structure containing the current regcache.  */
-/* FIXME: cagney/2002-05-11: The two global arrays registers[] and
-   deprecated_register_valid[] currently point into this structure.  */
-static struct regcache *current_regcache;
+/* The register caches of the threads GDB has looked at since the
+   inferior last stopped, hashed by ptid.  Each cache stays valid
+   until its thread is resumed, so switching between stopped threads
+   (for instance by "thread apply all bt") fetches each thread's
+   registers from the target only once.  */
+
+static htab_t current_regcache;
+
+static hashval_t
+hash_regcache_ptid (const void *p)
+{
+  const struct regcache *regcache = p;
+
+  return ((ptid_get_pid (regcache->ptid) * 31
+	   + ptid_get_lwp (regcache->ptid)) * 31
+	  + ptid_get_tid (regcache->ptid));
+}
+
+static int
+eq_regcache_ptid (const void *a, const void *b)
+{
+  const struct regcache *ra = a;
+  const struct regcache *rb = b;
+
+  return ptid_equal (ra->ptid, rb->ptid);
+}
+
+static void
+free_regcache_entry (void *p)
+{
+  regcache_xfree (p);
+}
 
 /* NOTE: this is a write-through cache.  There is no "dirty" bit for
    recording if the register values have been changed (eg. by the
@@ -424,19 +453,32 @@ struct regcache *get_thread_regcache (ptid_t ptid)
   /* NOTE: uweigand/2007-05-05:  We need to detect the thread's
      current architecture at this point.  */
   struct gdbarch *thread_gdbarch = current_gdbarch;
+  struct regcache key, *new_regcache;
+  void **slot;
+
+  if (current_regcache == NULL)
+    current_regcache = htab_create_alloc (64, hash_regcache_ptid,
+					  eq_regcache_ptid,
+					  free_regcache_entry,
+					  xcalloc, xfree);
+
+  key.ptid = ptid;
+  slot = htab_find_slot (current_regcache, &key, INSERT);
+  if (*slot != NULL)
+    {
+      if (get_regcache_arch (*slot) == thread_gdbarch)
+	return *slot;
 
-  if (current_regcache && ptid_equal (current_regcache->ptid, ptid)
-      && get_regcache_arch (current_regcache) == thread_gdbarch)
-    return current_regcache;
-
-  if (current_regcache)
-    regcache_xfree (current_regcache);
+      /* The thread's architecture changed; start afresh.  */
+      regcache_xfree (*slot);
+    }
 
-  current_regcache = regcache_xmalloc (thread_gdbarch);
-  current_regcache->readonly_p = 0;
-  current_regcache->ptid = ptid;
+  new_regcache = regcache_xmalloc (thread_gdbarch);
+  new_regcache->readonly_p = 0;
+  new_regcache->ptid = ptid;
+  *slot = new_regcache;
 
-  return current_regcache;
+  return new_regcache;
 }
 
 struct regcache *get_current_regcache (void)
@@ -453,6 +495,50 @@ regcache_observer_target_changed (struct target_ops *target)
   registers_changed ();
 }
 
+/* Traversal function for registers_changed_ptid: discard the
+   register cache in *SLOT if it belongs to the process whose ptid is
+   *DATA.  */
+
+static int
+clear_regcache_of_process (void **slot, void *data)
+{
+  struct regcache *regcache = *slot;
+  ptid_t *pid_ptid = data;
+
+  if (ptid_get_pid (regcache->ptid) == ptid_get_pid (*pid_ptid))
+    htab_clear_slot (current_regcache, slot);
+  return 1;
+}
+
+/* Discard the register caches of the threads matching PTID, which
+   are about to run or have changed behind GDB's back.  PTID may be
+   minus_one_ptid for all threads, or a bare process id for all the
+   threads of that process.  The caches of the other threads stay
+   valid.  */
+
+void
+registers_changed_ptid (ptid_t ptid)
+{
+  if (current_regcache != NULL)
+    {
+      if (ptid_equal (ptid, minus_one_ptid))
+	htab_empty (current_regcache);
+      else if (ptid_get_lwp (ptid) == 0 && ptid_get_tid (ptid) == 0)
+	htab_traverse_noresize (current_regcache,
+				clear_regcache_of_process, &ptid);
+      else
+	{
+	  struct regcache key;
+
+	  key.ptid = ptid;
+	  htab_remove_elt (current_regcache, &key);
+	}
+    }
+
+  /* The frame chains of the affected threads are gone too.  */
+  reinit_frame_cache ();
+}
+
 /* Low level examining and depositing of registers.
 
    The caller is responsible for making sure that the inferior is
@@ -467,10 +553,8 @@ regcache_observer_target_changed (struct target_ops *target)
 void
 registers_changed (void)
 {
-  int i;
-
-  regcache_xfree (current_regcache);
-  current_regcache = NULL;
+  if (current_regcache != NULL)
+    htab_empty (current_regcache);
 
   /* Need to forget about any frames we have cached, too. */
   reinit_frame_cache ();
@@ -61,6 +61,7 @@
 #include "gdb/fileio.h"
 
 #include "memory-map.h"
+#include "ax.h"
 
 /* The size to align memory write packets, when practical.  The protocol
    does not guarantee any alignment, and gdb will generate short
@@ -79,10 +80,16 @@ static void cleanup_sigint_signal_handler (void *dummy);
 static void initialize_sigint_signal_handler (void);
 static int getpkt_sane (char **buf, long *sizeof_buf, int forever);
 
+static int getpkt_or_notif_sane (char **buf, long *sizeof_buf, int forever,
+				 int *is_notif);
+
+static int read_notification (void);
+
 static void handle_remote_sigint (int);
 static void handle_remote_sigint_twice (int);
 static void async_remote_interrupt (gdb_client_data);
 void async_remote_interrupt_twice (gdb_client_data);
+static void remote_async_inferior_event_handler (gdb_client_data);
 
 static void remote_files_info (struct target_ops *ignore);
 
@@ -183,6 +190,14 @@ static void remote_find_new_threads (void);
 
 static void record_currthread (ptid_t currthread);
 
+static void handle_notification (char *buf);
+
+static void discard_pending_stop_replies (void);
+
+static void remote_get_pending_stop_replies (void);
+
+static ptid_t stop_reply_ptid (char *buf);
+
 static int fromhex (int a);
 
 static int hex2bin (const char *hex, gdb_byte *bin, int count);
@@ -274,6 +289,10 @@ struct remote_state
      skip calling getpkt.  This flag is set when BUF contains a
      stop reply packet and the target is not waiting.  */
   int cached_wait_status;
+
+  /* True if the stub reported support for the vCont;t action, which
+     stops a thread in non-stop mode.  */
+  int support_vCont_t;
 };
 
 /* This data could be associated with a target, but we do not always
@@ -960,6 +979,11 @@ enum {
   PACKET_qSearch_memory,
   PACKET_vAttach,
   PACKET_vRun,
+  PACKET_ConditionalBreakpoints,
+  PACKET_vBreakpoints,
+  PACKET_vCont_range,
+  PACKET_QNonStop,
+  PACKET_qRegisters,
   PACKET_MAX
 };
 
@@ -1062,6 +1086,27 @@ static int use_threadextra_query;
 static struct async_signal_handler *sigint_remote_twice_token;
 static struct async_signal_handler *sigint_remote_token;
 
+/* In non-stop mode, the token marked when there are stop replies for
+   infrun to collect.  */
+static struct async_signal_handler *remote_async_inferior_event_token;
+
+/* In non-stop mode, a stop reply which the stub sent us, but which
+   we have not reported to infrun yet.  */
+
+struct stop_reply
+{
+  struct stop_reply *next;
+  char *buf;
+};
+
+/* The stop replies not reported yet, oldest first.  */
+static struct stop_reply *stop_reply_queue;
+
+/* Non-zero if the stub sent us a stop notification which we have not
+   acknowledged yet.  We acknowledge it, and collect the other stop
+   replies the stub has queued, with vStopped.  */
+static int pending_stop_notification;
+
 
 
 static ptid_t magic_null_ptid;
@@ -1084,7 +1129,10 @@ static ptid_t continue_thread;
 static void
 record_currthread (ptid_t currthread)
 {
-  general_thread = currthread;
+  /* In non-stop mode, the stub does not switch its general thread to
+     the thread which reported an event.  */
+  if (!non_stop)
+    general_thread = currthread;
 
   /* If this is a new thread, add it to GDB's thread list.
      If we leave it up to WFI to do this, bad things will happen.  */
@@ -1097,8 +1145,8 @@ record_currthread (ptid_t currthread)
 	     stub doesn't support qC.  This is the first stop reported
 	     after an attach, so this is the main thread.  Update the
 	     ptid in the thread list.  */
-	  struct thread_info *th = find_thread_pid (inferior_ptid);
-	  inferior_ptid = th->ptid = currthread;
+	  thread_change_ptid (inferior_ptid, currthread);
+	  inferior_ptid = currthread;
 	}
       else if (ptid_equal (magic_null_ptid, inferior_ptid))
 	{
@@ -1107,8 +1155,8 @@ record_currthread (ptid_t currthread)
 	     doesn't support qC.  This is the first stop reported
 	     after an attach, so this is the main thread.  Update the
 	     ptid in the thread list.  */
-	  struct thread_info *th = find_thread_pid (inferior_ptid);
-	  inferior_ptid = th->ptid = currthread;
+	  thread_change_ptid (inferior_ptid, currthread);
+	  inferior_ptid = currthread;
 	}
       else
 	/* This is really a new thread.  Add it.  */
@@ -1912,6 +1960,22 @@ remote_threadlist_iterator (rmt_thread_action stepfunction, void *context,
   return result;
 }
 
+/* Add PTID, a thread we have just found while listing the threads,
+   to GDB's thread list.  In non-stop mode, a thread which has not
+   reported a stop is running.  */
+
+static void
+remote_add_thread (ptid_t ptid)
+{
+  add_thread (ptid);
+
+  if (non_stop)
+    {
+      set_running (ptid, 1);
+      set_executing (ptid, 1);
+    }
+}
+
 static int
 remote_newthread_step (threadref *ref, void *context)
 {
@@ -1919,7 +1983,7 @@ remote_newthread_step (threadref *ref, void *context)
   ptid_t ptid = ptid_build (pid, 0, threadref_to_int (ref));
 
   if (!in_thread_list (ptid))
-    add_thread (ptid);
+    remote_add_thread (ptid);
   return 1;			/* continue iterator */
 }
 
@@ -2001,7 +2065,7 @@ remote_threads_info (void)
 		  pid = ptid_get_pid (inferior_ptid);
 		  new_thread = ptid_build (pid, 0, tid);
 		  if (tid != 0 && !in_thread_list (new_thread))
-		    add_thread (new_thread);
+		    remote_add_thread (new_thread);
 		}
 	      while (*bufp++ == ',');	/* comma-separated list */
 	      putpkt ("qsThreadInfo");
@@ -2116,6 +2180,8 @@ remote_close (int quitting)
   if (remote_desc)
     serial_close (remote_desc);
   remote_desc = NULL;
+
+  discard_pending_stop_replies ();
 }
 
 /* Query the remote side for the text, data and bss offsets.  */
@@ -2300,10 +2366,40 @@ remote_start_remote (struct ui_out *uiout, void *opaque)
   /* Ack any packet which the remote side has already sent.  */
   serial_write (remote_desc, "+", 1);
 
-  /* Check whether the target is running now.  */
+  /* Tell the stub which mode we want before asking it about the
+     threads, as the replies differ.  */
+  if (non_stop)
+    {
+      if (!remote_async_permitted)
+	error (_("Non-stop mode requires \"maint set remote-async on\"."));
+
+      if (remote_protocol_packets[PACKET_QNonStop].support == PACKET_DISABLE)
+	error (_("The remote target does not support non-stop mode."));
+
+      putpkt ("QNonStop:1");
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (strcmp (rs->buf, "OK") != 0)
+	error (_("Remote refused setting non-stop mode with: %s"), rs->buf);
+    }
+  else if (remote_protocol_packets[PACKET_QNonStop].support == PACKET_ENABLE)
+    {
+      /* The stub may still be in non-stop mode from an earlier
+	 connection.  */
+      putpkt ("QNonStop:0");
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (strcmp (rs->buf, "OK") != 0)
+	error (_("Remote refused setting all-stop mode with: %s"), rs->buf);
+    }
+
+  /* Check whether the target is running now.  In non-stop mode, this
+     reports the first stopped thread; we collect the others below.  */
   putpkt ("?");
   getpkt (&rs->buf, &rs->buf_size, 0);
 
+  if (non_stop && strcmp (rs->buf, "OK") == 0)
+    error (_("The target has no stopped threads; "
+	     "can not connect to it in non-stop mode."));
+
   if (rs->buf[0] == 'W' || rs->buf[0] == 'X')
     {
       if (args->extended_p)
@@ -2347,6 +2443,29 @@ remote_start_remote (struct ui_out *uiout, void *opaque)
   /* Always add the main thread.  */
   add_thread_silent (inferior_ptid);
 
+  /* In non-stop mode, the stub has queued a stop reply for each of
+     the other stopped threads.  Only the first stop is reported, but
+     add the other threads now, so that they are known to be
+     stopped.  */
+  if (non_stop)
+    {
+      pending_stop_notification = 1;
+      remote_get_pending_stop_replies ();
+
+      while (stop_reply_queue != NULL)
+	{
+	  struct stop_reply *reply = stop_reply_queue;
+	  ptid_t ptid = stop_reply_ptid (reply->buf);
+
+	  if (!ptid_equal (ptid, null_ptid) && !in_thread_list (ptid))
+	    add_thread (ptid);
+
+	  stop_reply_queue = reply->next;
+	  xfree (reply->buf);
+	  xfree (reply);
+	}
+    }
+
   get_offsets ();		/* Get text, data & bss offsets.  */
 
   /* Use the previously fetched status.  */
@@ -2557,6 +2676,14 @@ static struct protocol_feature remote_protocol_features[] = {
     PACKET_qXfer_spu_write },
   { "QPassSignals", PACKET_DISABLE, remote_supported_packet,
     PACKET_QPassSignals },
+  { "ConditionalBreakpoints", PACKET_DISABLE, remote_supported_packet,
+    PACKET_ConditionalBreakpoints },
+  { "vBreakpoints", PACKET_DISABLE, remote_supported_packet,
+    PACKET_vBreakpoints },
+  { "QNonStop", PACKET_DISABLE, remote_supported_packet,
+    PACKET_QNonStop },
+  { "qRegisters", PACKET_DISABLE, remote_supported_packet,
+    PACKET_qRegisters },
 };
 
 static void
@@ -2728,6 +2855,9 @@ remote_open_1 (char *name, int from_tty, struct target_ops *target, int extended
   xfree (last_pass_packet);
   last_pass_packet = NULL;
 
+  /* Stop replies from a previous connection mean nothing now.  */
+  discard_pending_stop_replies ();
+
   remote_fileio_reset ();
   reopen_exec_file ();
   reread_symbols ();
@@ -3077,12 +3207,14 @@ remote_vcont_probe (struct remote_state *rs)
   if (strncmp (buf, "vCont", 5) == 0)
     {
       char *p = &buf[5];
-      int support_s, support_S, support_c, support_C;
+      int support_s, support_S, support_c, support_C, support_r, support_t;
 
       support_s = 0;
       support_S = 0;
       support_c = 0;
       support_C = 0;
+      support_r = 0;
+      support_t = 0;
       while (p && *p == ';')
 	{
 	  p++;
@@ -3094,10 +3226,20 @@ remote_vcont_probe (struct remote_state *rs)
 	    support_c = 1;
 	  else if (*p == 'C' && (*(p + 1) == ';' || *(p + 1) == 0))
 	    support_C = 1;
+	  else if (*p == 'r' && (*(p + 1) == ';' || *(p + 1) == 0))
+	    support_r = 1;
+	  else if (*p == 't' && (*(p + 1) == ';' || *(p + 1) == 0))
+	    support_t = 1;
 
 	  p = strchr (p, ';');
 	}
 
+      if (remote_protocol_packets[PACKET_vCont_range].support
+	  == PACKET_SUPPORT_UNKNOWN)
+	remote_protocol_packets[PACKET_vCont_range].support
+	  = support_r ? PACKET_ENABLE : PACKET_DISABLE;
+      rs->support_vCont_t = support_t;
+
       /* If s, S, c, and C are not all supported, we can't use vCont.  Clearing
          BUF will make packet_ok disable the packet.  */
       if (!support_s || !support_S || !support_c || !support_C)
@@ -3112,6 +3254,8 @@ remote_vcont_probe (struct remote_state *rs)
    resumed thread should be single-stepped and/or signalled.  If PTID
    equals minus_one_ptid, then all threads are resumed; the thread to
    be stepped and/or signalled is given in the global INFERIOR_PTID.
+   If infrun allows it (see may_range_step), a step is done by the
+   target through the whole line being stepped.
    This function returns non-zero iff it resumes the inferior.
 
    This function issues a strict subset of all possible vCont commands at the
@@ -3122,6 +3266,7 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
 {
   struct remote_state *rs = get_remote_state ();
   char *outbuf;
+  char *step_action;
   struct cleanup *old_cleanup;
 
   if (remote_protocol_packets[PACKET_vCont].support == PACKET_SUPPORT_UNKNOWN)
@@ -3130,6 +3275,15 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
   if (remote_protocol_packets[PACKET_vCont].support == PACKET_DISABLE)
     return 0;
 
+  /* The action for a step without a signal.  */
+  if (may_range_step
+      && remote_protocol_packets[PACKET_vCont_range].support == PACKET_ENABLE)
+    step_action = xstrprintf ("r%s,%s", paddr_nz (step_range_start),
+			      paddr_nz (step_range_end));
+  else
+    step_action = xstrdup ("s");
+  old_cleanup = make_cleanup (xfree, step_action);
+
   /* If we could generate a wider range of packets, we'd have to worry
      about overflowing BUF.  Should there be a generic
      "multi-part-packet" packet?  */
@@ -3143,7 +3297,7 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
       if (step && siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;S%02x", siggnal);
       else if (step)
-	outbuf = xstrprintf ("vCont;s");
+	outbuf = xstrprintf ("vCont;%s", step_action);
       else if (siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;C%02x", siggnal);
       else
@@ -3156,7 +3310,7 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
       if (step && siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;S%02x:%x;c", siggnal, tid);
       else if (step)
-	outbuf = xstrprintf ("vCont;s:%x;c", tid);
+	outbuf = xstrprintf ("vCont;%s:%x;c", step_action, tid);
       else if (siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;C%02x:%x;c", siggnal, tid);
       else
@@ -3169,7 +3323,7 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
       if (step && siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;S%02x:%x", siggnal, tid);
       else if (step)
-	outbuf = xstrprintf ("vCont;s:%x", tid);
+	outbuf = xstrprintf ("vCont;%s:%x", step_action, tid);
       else if (siggnal != TARGET_SIGNAL_0)
 	outbuf = xstrprintf ("vCont;C%02x:%x", siggnal, tid);
       else
@@ -3177,10 +3331,19 @@ remote_vcont_resume (ptid_t ptid, int step, enum target_signal siggnal)
     }
 
   gdb_assert (outbuf && strlen (outbuf) < get_remote_packet_size ());
-  old_cleanup = make_cleanup (xfree, outbuf);
+  make_cleanup (xfree, outbuf);
 
   putpkt (outbuf);
 
+  /* In non-stop mode, the stub replies at once; the stop will be
+     reported with a notification.  */
+  if (non_stop)
+    {
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (strcmp (rs->buf, "OK") != 0)
+	error (_("Unexpected vCont reply in non-stop mode: %s"), rs->buf);
+    }
+
   do_cleanups (old_cleanup);
 
   return 1;
@@ -3208,6 +3371,12 @@ remote_resume (ptid_t ptid, int step, enum target_signal siggnal)
   if (remote_vcont_resume (ptid, step, siggnal))
     goto done;
 
+  /* The other resume packets are answered only when the target
+     stops.  */
+  if (non_stop)
+    error (_("The remote target does not support vCont, "
+	     "which non-stop mode requires."));
+
   /* All other supported resume packets do use Hc, so set the continue
      thread.  */
   if (ptid_equal (ptid, minus_one_ptid))
@@ -3331,10 +3500,36 @@ remote_interrupt_twice (int signo)
 static void
 remote_stop (ptid_t ptid)
 {
-  /* Send a break or a ^C, depending on user preference.  */
+  struct remote_state *rs = get_remote_state ();
+
   if (remote_debug)
     fprintf_unfiltered (gdb_stdlog, "remote_stop called\n");
 
+  /* In non-stop mode, ask the stub to stop PTID, or all threads; it
+     reports each stop with a notification.  */
+  if (non_stop)
+    {
+      if (remote_protocol_packets[PACKET_vCont].support
+	  == PACKET_SUPPORT_UNKNOWN)
+	remote_vcont_probe (rs);
+
+      if (!rs->support_vCont_t)
+	error (_("The remote target does not support stopping threads."));
+
+      if (ptid_equal (ptid, minus_one_ptid))
+	strcpy (rs->buf, "vCont;t");
+      else
+	xsnprintf (rs->buf, get_remote_packet_size (), "vCont;t:%x",
+		   (int) ptid_get_tid (ptid));
+      putpkt (rs->buf);
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (strcmp (rs->buf, "OK") != 0)
+	error (_("Stopping %s failed: %s"), target_pid_to_str (ptid),
+	       rs->buf);
+      return;
+    }
+
+  /* Send a break or a ^C, depending on user preference.  */
   if (remote_break)
     serial_send_break (remote_desc);
   else
@@ -3428,6 +3623,123 @@ remote_console_output (char *msg)
   gdb_flush (gdb_stdtarg);
 }
 
+/* Return the thread a stop reply in BUF is about, or null_ptid if
+   it does not say.  */
+
+static ptid_t
+stop_reply_ptid (char *buf)
+{
+  char *p;
+  ULONGEST thread_num;
+
+  if (buf[0] != 'T')
+    return null_ptid;
+
+  for (p = &buf[3]; *p != '\0'; p++)
+    {
+      if (strncmp (p, "thread:", strlen ("thread:")) == 0)
+	{
+	  unpack_varlen_hex (p + strlen ("thread:"), &thread_num);
+	  return ptid_build (ptid_get_pid (inferior_ptid), 0, thread_num);
+	}
+
+      p = strchr (p, ';');
+      if (p == NULL)
+	break;
+    }
+
+  return null_ptid;
+}
+
+/* Append the stop reply in BUF to the queue of stop replies not yet
+   reported to infrun.  */
+
+static void
+queue_stop_reply (const char *buf)
+{
+  struct stop_reply *reply, **tail;
+
+  reply = XMALLOC (struct stop_reply);
+  reply->next = NULL;
+  reply->buf = xstrdup (buf);
+
+  for (tail = &stop_reply_queue; *tail != NULL; tail = &(*tail)->next)
+    ;
+  *tail = reply;
+}
+
+/* Forget about all the stop replies we have not reported yet.  */
+
+static void
+discard_pending_stop_replies (void)
+{
+  while (stop_reply_queue != NULL)
+    {
+      struct stop_reply *reply = stop_reply_queue;
+
+      stop_reply_queue = reply->next;
+      xfree (reply->buf);
+      xfree (reply);
+    }
+
+  pending_stop_notification = 0;
+}
+
+/* Handle the asynchronous notification in BUF, which the stub may
+   send at any time in non-stop mode.  */
+
+static void
+handle_notification (char *buf)
+{
+  if (strncmp (buf, "Stop:", strlen ("Stop:")) == 0)
+    {
+      /* The stub does not send another notification until we have
+	 acknowledged this one with vStopped, so any other one is a
+	 stale duplicate.  */
+      if (pending_stop_notification)
+	return;
+
+      queue_stop_reply (buf + strlen ("Stop:"));
+      pending_stop_notification = 1;
+
+      /* Let infrun know there is something to collect.  */
+      if (target_can_async_p ())
+	mark_async_signal_handler (remote_async_inferior_event_token);
+    }
+  else if (remote_debug)
+    fprintf_unfiltered (gdb_stdlog, "Ignoring unknown notification: %s\n",
+			buf);
+}
+
+/* After a stop notification, acknowledge it and collect the other
+   stop replies the stub has queued, until it tells us there are no
+   more.  */
+
+static void
+remote_get_pending_stop_replies (void)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (!pending_stop_notification)
+    return;
+
+  while (1)
+    {
+      putpkt ("vStopped");
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (strcmp (rs->buf, "OK") == 0)
+	break;
+
+      if (rs->buf[0] != 'T' && rs->buf[0] != 'S'
+	  && rs->buf[0] != 'W' && rs->buf[0] != 'X')
+	error (_("Unexpected vStopped reply: %s"), rs->buf);
+
+      queue_stop_reply (rs->buf);
+    }
+
+  pending_stop_notification = 0;
+}
+
 /* Wait until the remote machine stops, then return,
    storing status in STATUS just as `wait' would.  */
 
@@ -3451,6 +3763,40 @@ remote_wait (ptid_t ptid, struct target_waitstatus *status)
       if (rs->cached_wait_status)
 	/* Use the cached wait status, but only once.  */
 	rs->cached_wait_status = 0;
+      else if (non_stop)
+	{
+	  struct stop_reply *reply;
+	  int is_notif;
+
+	  /* In non-stop mode, stops arrive as notifications, and are
+	     reported one at a time from the queue.  Block only if the
+	     caller is not prepared to come back later.  */
+	  if (stop_reply_queue == NULL && !pending_stop_notification)
+	    getpkt_or_notif_sane (&rs->buf, &rs->buf_size,
+				  !target_is_async_p (), &is_notif);
+	  remote_get_pending_stop_replies ();
+
+	  reply = stop_reply_queue;
+	  if (reply == NULL)
+	    {
+	      status->kind = TARGET_WAITKIND_IGNORE;
+	      return minus_one_ptid;
+	    }
+
+	  stop_reply_queue = reply->next;
+	  if (strlen (reply->buf) >= rs->buf_size)
+	    {
+	      rs->buf_size = strlen (reply->buf) + 1;
+	      rs->buf = xrealloc (rs->buf, rs->buf_size);
+	    }
+	  strcpy (rs->buf, reply->buf);
+	  xfree (reply->buf);
+	  xfree (reply);
+
+	  /* Come back for the others.  */
+	  if (stop_reply_queue != NULL && target_can_async_p ())
+	    mark_async_signal_handler (remote_async_inferior_event_token);
+	}
       else
 	{
 	  if (!target_is_async_p ())
@@ -3492,6 +3838,17 @@ remote_wait (ptid_t ptid, struct target_waitstatus *status)
 	case 'T':		/* Status with PC, SP, FP, ...  */
 	  {
 	    gdb_byte regs[MAX_REGISTER_SIZE];
+	    struct regcache *regcache;
+	    ptid_t event_ptid;
+
+	    /* Supply the expedited registers to the thread which
+	       stopped, which need not be the current one; the thread
+	       field may come after them.  */
+	    event_ptid = stop_reply_ptid (buf);
+	    if (ptid_equal (event_ptid, null_ptid))
+	      regcache = get_current_regcache ();
+	    else
+	      regcache = get_thread_regcache (event_ptid);
 
 	    /* Expedited reply, containing Signal, {regno, reg} repeat.  */
 	    /*  format is:  'Tssn...:r...;n...:r...;n...:r...;#cc', where
@@ -3585,8 +3942,7 @@ Packet: '%s'\n"),
 		    if (fieldsize < register_size (current_gdbarch,
 						   reg->regnum))
 		      warning (_("Remote reply is too short: %s"), buf);
-		    regcache_raw_supply (get_current_regcache (),
-					 reg->regnum, regs);
+		    regcache_raw_supply (regcache, reg->regnum, regs);
 		  }
 
 		if (*p != ';')
@@ -3757,21 +4113,23 @@ send_g_packet (void)
   return buf_len / 2;
 }
 
+/* Supply the registers in BUF, the contents of a 'g' packet reply,
+   to REGCACHE.  */
+
 static void
-process_g_packet (struct regcache *regcache)
+process_g_packet (struct regcache *regcache, char *buf)
 {
   struct gdbarch *gdbarch = get_regcache_arch (regcache);
-  struct remote_state *rs = get_remote_state ();
   struct remote_arch_state *rsa = get_remote_arch_state ();
   int i, buf_len;
   char *p;
   char *regs;
 
-  buf_len = strlen (rs->buf);
+  buf_len = strlen (buf);
 
   /* Further sanity checks, with knowledge of the architecture.  */
   if (buf_len > 2 * rsa->sizeof_g_packet)
-    error (_("Remote 'g' packet reply is too long: %s"), rs->buf);
+    error (_("Remote 'g' packet reply is too long: %s"), buf);
 
   /* Save the size of the packet sent to us by the target.  It is used
      as a heuristic when determining the max size of packets that the
@@ -3808,7 +4166,7 @@ process_g_packet (struct regcache *regcache)
      hex characters.  Suck them all up, then supply them to the
      register cacheing/storage mechanism.  */
 
-  p = rs->buf;
+  p = buf;
   for (i = 0; i < rsa->sizeof_g_packet; i++)
     {
       if (p[0] == 0 || p[1] == 0)
@@ -3830,13 +4188,13 @@ process_g_packet (struct regcache *regcache)
 	struct packet_reg *r = &rsa->regs[i];
 	if (r->in_g_packet)
 	  {
-	    if (r->offset * 2 >= strlen (rs->buf))
+	    if (r->offset * 2 >= strlen (buf))
 	      /* This shouldn't happen - we adjusted in_g_packet above.  */
 	      internal_error (__FILE__, __LINE__,
 			      "unexpected end of 'g' packet reply");
-	    else if (rs->buf[r->offset * 2] == 'x')
+	    else if (buf[r->offset * 2] == 'x')
 	      {
-		gdb_assert (r->offset * 2 < strlen (rs->buf));
+		gdb_assert (r->offset * 2 < strlen (buf));
 		/* The register isn't available, mark it as such (at
                    the same time setting the value to zero).  */
 		regcache_raw_supply (regcache, r->regnum, NULL);
@@ -3852,8 +4210,10 @@ process_g_packet (struct regcache *regcache)
 static void
 fetch_registers_using_g (struct regcache *regcache)
 {
+  struct remote_state *rs = get_remote_state ();
+
   send_g_packet ();
-  process_g_packet (regcache);
+  process_g_packet (regcache, rs->buf);
 }
 
 static void
@@ -3901,6 +4261,82 @@ remote_fetch_registers (struct regcache *regcache, int regnum)
 	}
 }
 
+/* Fetch the 'g' packet registers of the threads in PTIDS, as many
+   threads per "qRegisters" packet as fit.  Threads whose registers
+   are already cached are skipped.  */
+
+static void
+remote_prefetch_registers (ptid_t *ptids, int count)
+{
+  struct remote_state *rs = get_remote_state ();
+  struct remote_arch_state *rsa = get_remote_arch_state ();
+  int pc_regnum = gdbarch_pc_regnum (current_gdbarch);
+  int per_packet, i, j, first;
+
+  if (remote_protocol_packets[PACKET_qRegisters].support == PACKET_DISABLE)
+    return;
+
+  /* Each thread takes its registers in hex, plus its id.  */
+  per_packet = ((get_remote_packet_size () - 32)
+		/ (2 * rsa->sizeof_g_packet + 12));
+  if (per_packet < 2)
+    return;
+
+  i = 0;
+  while (i < count)
+    {
+      char *p = rs->buf;
+      char *endbuf = rs->buf + get_remote_packet_size ();
+      int n = 0;
+
+      p += xsnprintf (p, endbuf - p, "qRegisters:");
+      for (first = i; i < count && n < per_packet; i++)
+	{
+	  if (pc_regnum >= 0
+	      && regcache_valid_p (get_thread_regcache (ptids[i]), pc_regnum))
+	    continue;
+	  p += xsnprintf (p, endbuf - p, n == 0 ? "%lx" : ",%lx",
+			  ptid_get_tid (ptids[i]));
+	  n++;
+	}
+      if (n == 0)
+	break;
+
+      putpkt (rs->buf);
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      if (packet_ok (rs->buf, &remote_protocol_packets[PACKET_qRegisters])
+	  != PACKET_OK)
+	return;
+      if (strcmp (rs->buf, "OK") == 0)
+	continue;
+
+      /* The reply is "ID:REGS;ID:REGS;...".  */
+      p = rs->buf;
+      while (*p != '\0')
+	{
+	  ULONGEST tid;
+	  char *regs, *end;
+
+	  p = unpack_varlen_hex (p, &tid);
+	  if (*p != ':')
+	    break;
+	  regs = p + 1;
+	  end = strchr (regs, ';');
+	  if (end == NULL)
+	    break;
+	  *end = '\0';
+	  p = end + 1;
+
+	  for (j = first; j < i; j++)
+	    if ((ULONGEST) ptid_get_tid (ptids[j]) == tid)
+	      {
+		process_g_packet (get_thread_regcache (ptids[j]), regs);
+		break;
+	      }
+	}
+    }
+}
+
 /* Prepare to store registers.  Since we may send them all (using a
    'G' request), we have to read out the ones we don't want to change
    first.  */
@@ -4824,6 +5260,11 @@ putpkt_binary (char *buf, int cnt)
 	      if (tcount > 3)
 		return 0;
 	      break;		/* Retransmit buffer.  */
+	    case '%':
+	      /* A notification may arrive at any time; it is not an
+		 answer to this packet.  */
+	      read_notification ();
+	      continue;		/* Now, go look for +.  */
 	    case '$':
 	      {
 	        if (remote_debug)
@@ -5027,6 +5468,38 @@ read_frame (char **buf_p,
     }
 }
 
+/* Come here after finding the start of a notification.  Collect
+   and handle it; notifications are not acknowledged.  Returns -1 on
+   error, 0 on success.  */
+
+static int
+read_notification (void)
+{
+  static char *notif_buf;
+  static long notif_buf_size;
+  int val;
+
+  if (notif_buf == NULL)
+    {
+      notif_buf_size = get_remote_packet_size ();
+      notif_buf = xmalloc (notif_buf_size);
+    }
+
+  val = read_frame (&notif_buf, &notif_buf_size);
+  if (val < 0)
+    return -1;
+
+  if (remote_debug)
+    {
+      fprintf_unfiltered (gdb_stdlog, "Notification received: ");
+      fputstrn_unfiltered (notif_buf, val, 0, gdb_stdlog);
+      fprintf_unfiltered (gdb_stdlog, "\n");
+    }
+
+  handle_notification (notif_buf);
+  return 0;
+}
+
 /* Read a packet from the remote machine, with error checking, and
    store it in *BUF.  Resize *BUF using xrealloc if necessary to hold
    the result, and update *SIZEOF_BUF.  If FOREVER, wait forever
@@ -5054,9 +5527,22 @@ getpkt (char **buf,
    for a target that is is executing user code to stop.  If FOREVER ==
    0, this function is allowed to time out gracefully and return an
    indication of this to the caller.  Otherwise return the number
-   of bytes read.  */
+   of bytes read.
+
+   Notifications which arrive meanwhile are handled.  If IS_NOTIF is
+   non-NULL, return after the first one, setting *IS_NOTIF, rather
+   than waiting for a packet; in that case a FOREVER of zero means
+   not to wait at all.  */
+
 static int
 getpkt_sane (char **buf, long *sizeof_buf, int forever)
+{
+  return getpkt_or_notif_sane (buf, sizeof_buf, forever, NULL);
+}
+
+static int
+getpkt_or_notif_sane (char **buf, long *sizeof_buf, int forever,
+		      int *is_notif)
 {
   struct remote_state *rs = get_remote_state ();
   int c;
@@ -5070,11 +5556,15 @@ getpkt_sane (char **buf, long *sizeof_buf, int forever)
 
   strcpy (*buf, "timeout");
 
+  if (is_notif != NULL)
+    *is_notif = 0;
+
   if (forever)
     {
       timeout = watchdog > 0 ? watchdog : -1;
     }
-
+  else if (is_notif != NULL)
+    timeout = 0;
   else
     timeout = remote_timeout;
 
@@ -5104,10 +5594,23 @@ getpkt_sane (char **buf, long *sizeof_buf, int forever)
 		  target_mourn_inferior ();
 		  error (_("Watchdog timeout has expired.  Target detached."));
 		}
+	      /* Nothing has arrived; that is not an error if we were
+		 only polling.  */
+	      if (is_notif != NULL)
+		return -1;
 	      if (remote_debug)
 		fputs_filtered ("Timed out.\n", gdb_stdlog);
 	      goto retry;
 	    }
+
+	  if (c == '%')
+	    {
+	      if (read_notification () == 0 && is_notif != NULL)
+		{
+		  *is_notif = 1;
+		  return 0;
+		}
+	    }
 	}
       while (c != '$');
 
@@ -5324,6 +5827,38 @@ extended_remote_create_inferior (char *exec_file, char *args,
 }
 
 
+/* Return non-zero if the remote target can evaluate breakpoint
+   conditions itself.  */
+
+static int
+remote_supports_cond_breakpoints (void)
+{
+  return (remote_protocol_packets[PACKET_Z0].support != PACKET_DISABLE
+	  && (remote_protocol_packets[PACKET_ConditionalBreakpoints].support
+	      == PACKET_ENABLE));
+}
+
+/* Append the condition of BP_TGT, if any, to the Z0 packet ending at
+   P, for the remote target to evaluate.  */
+
+static void
+remote_add_breakpoint_condition (char *p, struct bp_target_info *bp_tgt)
+{
+  struct remote_state *rs = get_remote_state ();
+  struct agent_expr *aexpr = bp_tgt->cond_bytecode;
+
+  if (aexpr == NULL)
+    return;
+
+  /* If the condition doesn't fit, the target will report every hit
+     and GDB will check the condition instead.  */
+  if ((p - rs->buf) + 2 * aexpr->len + 32 > get_remote_packet_size ())
+    return;
+
+  p += sprintf (p, ";X%x,", aexpr->len);
+  bin2hex (aexpr->buf, p, aexpr->len);
+}
+
 /* Insert a breakpoint.  On targets that have software breakpoint
    support, we ask the remote target to do the work; on targets
    which don't, we insert a traditional memory breakpoint.  */
@@ -5354,7 +5889,10 @@ remote_insert_breakpoint (struct bp_target_info *bp_tgt)
       *(p++) = ',';
       addr = (ULONGEST) remote_address_masked (addr);
       p += hexnumstr (p, addr);
-      sprintf (p, ",%d", bpsize);
+      p += sprintf (p, ",%d", bpsize);
+
+      if (remote_supports_cond_breakpoints ())
+	remote_add_breakpoint_condition (p, bp_tgt);
 
       putpkt (rs->buf);
       getpkt (&rs->buf, &rs->buf_size, 0);
@@ -5403,6 +5941,158 @@ remote_remove_breakpoint (struct bp_target_info *bp_tgt)
   return memory_remove_breakpoint (bp_tgt);
 }
 
+/* Insert (if INSERT) or remove the software breakpoints in BP_TGTS
+   with vBreakpoints packets, as many to a packet as will fit, and
+   store the results in RESULTS as remote_insert_breakpoint or
+   remote_remove_breakpoint would.  Breakpoints with a condition for
+   the target to evaluate still get a Z0 packet of their own.  */
+
+static void
+remote_update_breakpoints (struct bp_target_info **bp_tgts, int count,
+			   int *results, int insert)
+{
+  struct remote_state *rs = get_remote_state ();
+  int cond_breakpoints = insert && remote_supports_cond_breakpoints ();
+  int max_len = get_remote_packet_size () - 1;
+  struct cleanup *old_chain;
+  int *entries;
+  int i;
+
+  entries = xmalloc (count * sizeof (int));
+  old_chain = make_cleanup (xfree, entries);
+
+  i = 0;
+  while (i < count)
+    {
+      int n_entries = 0;
+      int done;
+      char *p = rs->buf;
+
+      p += sprintf (p, "vBreakpoints:");
+      for (; i < count; i++)
+	{
+	  struct bp_target_info *bp_tgt = bp_tgts[i];
+	  CORE_ADDR addr = bp_tgt->placed_address;
+	  char entry[64];
+	  char *q = entry;
+	  int bpsize;
+
+	  /* Send what we have first, as this needs the packet
+	     buffer.  */
+	  if (cond_breakpoints && bp_tgt->cond_bytecode != NULL)
+	    break;
+
+	  if (insert)
+	    gdbarch_breakpoint_from_pc (current_gdbarch, &addr, &bpsize);
+	  else
+	    bpsize = bp_tgt->placed_size;
+
+	  *(q++) = insert ? 'Z' : 'z';
+	  *(q++) = '0';
+	  *(q++) = ',';
+	  q += hexnumstr (q, (ULONGEST) remote_address_masked (addr));
+	  q += sprintf (q, ",%x", bpsize);
+
+	  if (n_entries > 0 && (p - rs->buf) + 1 + (q - entry) > max_len)
+	    break;
+
+	  if (n_entries > 0)
+	    *(p++) = ';';
+	  memcpy (p, entry, q - entry);
+	  p += q - entry;
+	  *p = '\0';
+	  entries[n_entries++] = i;
+	}
+
+      if (n_entries == 0)
+	{
+	  /* A breakpoint with a condition.  */
+	  results[i] = remote_insert_breakpoint (bp_tgts[i]);
+	  i++;
+	  continue;
+	}
+
+      putpkt (rs->buf);
+      getpkt (&rs->buf, &rs->buf_size, 0);
+
+      if (packet_ok (rs->buf, &remote_protocol_packets[PACKET_vBreakpoints])
+	  != PACKET_OK)
+	{
+	  /* Try the rest one at a time, so that each gets its own
+	     result.  */
+	  for (i = entries[0]; i < count; i++)
+	    results[i] = (insert
+			  ? remote_insert_breakpoint (bp_tgts[i])
+			  : remote_remove_breakpoint (bp_tgts[i]));
+	  break;
+	}
+
+      /* The stub performs the entries in order, up to the first one
+	 that fails.  */
+      if (rs->buf[0] == 'P')
+	{
+	  ULONGEST n;
+
+	  unpack_varlen_hex (rs->buf + 1, &n);
+	  if (n >= n_entries)
+	    error (_("Invalid reply to vBreakpoints: %s"), rs->buf);
+	  done = n;
+	  results[entries[n]] = insert ? -1 : 1;
+	  i = entries[n] + 1;
+	}
+      else
+	done = n_entries;
+
+      for (; done > 0; done--)
+	{
+	  struct bp_target_info *bp_tgt = bp_tgts[entries[done - 1]];
+
+	  if (insert)
+	    {
+	      CORE_ADDR addr = bp_tgt->placed_address;
+	      int bpsize;
+
+	      gdbarch_breakpoint_from_pc (current_gdbarch, &addr, &bpsize);
+	      bp_tgt->placed_address = remote_address_masked (addr);
+	      bp_tgt->placed_size = bpsize;
+	    }
+	  results[entries[done - 1]] = 0;
+	}
+    }
+
+  do_cleanups (old_chain);
+}
+
+static void
+remote_insert_breakpoints (struct bp_target_info **bp_tgts, int count,
+			   int *results)
+{
+  int i;
+
+  if (remote_protocol_packets[PACKET_Z0].support != PACKET_DISABLE
+      && remote_protocol_packets[PACKET_vBreakpoints].support
+	 == PACKET_ENABLE)
+    remote_update_breakpoints (bp_tgts, count, results, 1);
+  else
+    for (i = 0; i < count; i++)
+      results[i] = remote_insert_breakpoint (bp_tgts[i]);
+}
+
+static void
+remote_remove_breakpoints (struct bp_target_info **bp_tgts, int count,
+			   int *results)
+{
+  int i;
+
+  if (remote_protocol_packets[PACKET_Z0].support != PACKET_DISABLE
+      && remote_protocol_packets[PACKET_vBreakpoints].support
+	 == PACKET_ENABLE)
+    remote_update_breakpoints (bp_tgts, count, results, 0);
+  else
+    for (i = 0; i < count; i++)
+      results[i] = remote_remove_breakpoint (bp_tgts[i]);
+}
+
 static int
 watchpoint_to_Z_packet (int type)
 {
@@ -7140,10 +7830,15 @@ Specify the serial device it is connected to\n\
   remote_ops.to_fetch_registers = remote_fetch_registers;
   remote_ops.to_store_registers = remote_store_registers;
   remote_ops.to_prepare_to_store = remote_prepare_to_store;
+  remote_ops.to_prefetch_registers = remote_prefetch_registers;
   remote_ops.deprecated_xfer_memory = remote_xfer_memory;
   remote_ops.to_files_info = remote_files_info;
   remote_ops.to_insert_breakpoint = remote_insert_breakpoint;
   remote_ops.to_remove_breakpoint = remote_remove_breakpoint;
+  remote_ops.to_insert_breakpoints = remote_insert_breakpoints;
+  remote_ops.to_remove_breakpoints = remote_remove_breakpoints;
+  remote_ops.to_supports_evaluation_of_breakpoint_conditions
+    = remote_supports_cond_breakpoints;
   remote_ops.to_stopped_by_watchpoint = remote_stopped_by_watchpoint;
   remote_ops.to_stopped_data_address = remote_stopped_data_address;
   remote_ops.to_can_use_hw_breakpoint = remote_check_watch_resources;
@@ -7262,6 +7957,17 @@ remote_async (void (*callback) (enum inferior_event_type event_type,
     serial_async (remote_desc, NULL, NULL);
 }
 
+/* In non-stop mode, let the client collect the stop replies we have
+   queued.  */
+
+static void
+remote_async_inferior_event_handler (gdb_client_data data)
+{
+  if (remote_desc != NULL && target_is_async_p ()
+      && async_client_callback != NULL)
+    async_client_callback (INF_REG_EVENT, async_client_context);
+}
+
 static int
 remote_async_mask (int new_mask)
 {
@@ -7352,6 +8058,8 @@ _initialize_remote (void)
     create_async_signal_handler (async_remote_interrupt, NULL);
   sigint_remote_twice_token =
     create_async_signal_handler (inferior_event_handler_wrapper, NULL);
+  remote_async_inferior_event_token =
+    create_async_signal_handler (remote_async_inferior_event_handler, NULL);
 
 #if 0
   init_remote_threadtests ();
@@ -7455,6 +8163,15 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_vCont],
 			 "vCont", "verbose-resume", 0);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_vCont_range],
+			 "vCont;r", "range-stepping", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_QNonStop],
+			 "QNonStop", "non-stop", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_qRegisters],
+			 "qRegisters", "prefetch-registers", 0);
+
   add_packet_config_cmd (&remote_protocol_packets[PACKET_QPassSignals],
 			 "QPassSignals", "pass-signals", 0);
 
@@ -7531,6 +8248,13 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_vRun],
 			 "vRun", "run", 0);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_ConditionalBreakpoints],
+			 "ConditionalBreakpoints", "conditional-breakpoints",
+			 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_vBreakpoints],
+			 "vBreakpoints", "breakpoint-lists", 0);
+
   /* Keep the old ``set remote Z-packet ...'' working.  Each individual
      Z sub-packet has its own set and show commands, but users may
      have sets to this variable in their .gdbinit files (or in their
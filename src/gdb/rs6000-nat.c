@@ -961,6 +961,7 @@ vmap_exec (void)
 	  exec_ops.to_sections[i].endaddr += vmap->dstart - vmap->dvma;
 	}
     }
+  target_sections_changed ();
 }
 
 /* Set the current architecture from the host running GDB.  Called when
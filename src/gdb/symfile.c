@@ -53,6 +53,10 @@
 #include "varobj.h"
 #include "elf-bfd.h"
 #include "solib.h"
+#include "event-loop.h"
+#include "exceptions.h"
+#include "vec.h"
+#include "gdbthread.h"
 
 #include <sys/types.h>
 #include <fcntl.h>
@@ -219,9 +223,19 @@ sort_pst_symbols (struct partial_symtab *pst)
 {
   /* Sort the global list; don't sort the static list */
 
-  qsort (pst->objfile->global_psymbols.list + pst->globals_offset,
+  struct psymbol_allocation_list *list = &pst->objfile->global_psymbols;
+  int i;
+
+  qsort (list->list + pst->globals_offset,
 	 pst->n_global_syms, sizeof (struct partial_symbol *),
 	 compare_psymbols);
+
+  /* Bring the keys back in step with the symbols.  */
+  if (list->keys != NULL)
+    for (i = pst->globals_offset;
+	 i < pst->globals_offset + pst->n_global_syms;
+	 i++)
+      list->keys[i] = psymbol_name_key (SYMBOL_SEARCH_NAME (list->list[i]));
 }
 
 /* Make a null terminated copy of the string at PTR with SIZE characters in
@@ -296,6 +310,171 @@ psymtab_to_symtab (struct partial_symtab *pst)
   return pst->symtab;
 }
 
+/* Partial symtabs which are likely to be needed soon, such as the
+   ones covering the frames of a thread which has just stopped.  They
+   are read in from the event loop while GDB is otherwise idle, one
+   per visit, so the user never waits on more than a single
+   compilation unit.  A lookup which needs one of them before its
+   turn comes simply reads it in through psymtab_to_symtab, as
+   before, and the queue entry is then skipped.  */
+
+typedef struct partial_symtab *partial_symtab_p;
+DEF_VEC_P (partial_symtab_p);
+
+static VEC (partial_symtab_p) *symtab_prefetch_queue;
+
+/* The id of the timer which drains SYMTAB_PREFETCH_QUEUE, or zero if
+   none is pending.  */
+
+static int symtab_prefetch_timer;
+
+/* If non-zero, queue the symtabs of the frames of a stopped thread
+   for idle-time expansion.  */
+
+static int symtab_prefetch = 1;
+
+static void
+show_symtab_prefetch (struct ui_file *file, int from_tty,
+		      struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("\
+Reading symbols for the stopped thread's frames while idle is %s.\n"),
+		    value);
+}
+
+/* The number of frames, counting from the innermost, whose symtabs
+   are queued when a thread stops.  */
+
+#define SYMTAB_PREFETCH_DEPTH 16
+
+/* Non-zero if the inferior has stopped since the frames of the
+   current thread were last queued.  The frames are only unwound once
+   GDB is idle, so stops which the user never sees, such as those of
+   a breakpoint whose commands resume the inferior, cost nothing.  */
+
+static int symtab_prefetch_frames_pending;
+
+/* Queue the partial symtabs covering the innermost frames of the
+   current thread, if it is stopped.  */
+
+static void
+queue_frame_psymtab_prefetches (void)
+{
+  volatile struct gdb_exception e;
+  struct frame_info *frame;
+  int depth;
+
+  if (!target_has_stack || !target_has_registers)
+    return;
+
+  /* The inferior may have been resumed before GDB got idle.  */
+  if (target_has_execution
+      && (ptid_equal (inferior_ptid, null_ptid)
+	  || is_executing (inferior_ptid)))
+    return;
+
+  /* Unwinding a corrupt stack may fail part way through; whatever
+     was queued until then is still worth having.  */
+  TRY_CATCH (e, RETURN_MASK_ERROR)
+    {
+      for (frame = get_current_frame (), depth = 0;
+	   frame != NULL && depth < SYMTAB_PREFETCH_DEPTH;
+	   frame = get_prev_frame (frame), depth++)
+	queue_psymtab_prefetch
+	  (find_pc_psymtab (get_frame_address_in_block (frame)));
+    }
+}
+
+static void
+symtab_prefetch_handler (gdb_client_data ignore)
+{
+  symtab_prefetch_timer = 0;
+
+  if (symtab_prefetch_frames_pending)
+    {
+      symtab_prefetch_frames_pending = 0;
+      queue_frame_psymtab_prefetches ();
+    }
+
+  while (!VEC_empty (partial_symtab_p, symtab_prefetch_queue))
+    {
+      struct partial_symtab *pst
+	= VEC_ordered_remove (partial_symtab_p, symtab_prefetch_queue, 0);
+
+      if (!pst->readin)
+	{
+	  volatile struct gdb_exception e;
+
+	  /* A failure here is not interesting; whoever actually needs
+	     this symtab later will run into the same problem and
+	     report it then.  */
+	  TRY_CATCH (e, RETURN_MASK_ERROR)
+	    {
+	      psymtab_to_symtab (pst);
+	    }
+	  break;
+	}
+    }
+
+  if (!VEC_empty (partial_symtab_p, symtab_prefetch_queue)
+      && symtab_prefetch_timer == 0)
+    symtab_prefetch_timer = create_timer (0, symtab_prefetch_handler, NULL);
+}
+
+/* Queue PST for expansion the next time GDB is idle.  */
+
+void
+queue_psymtab_prefetch (struct partial_symtab *pst)
+{
+  int ix;
+  struct partial_symtab *iter;
+
+  if (pst == NULL || pst->readin)
+    return;
+
+  for (ix = 0; VEC_iterate (partial_symtab_p, symtab_prefetch_queue, ix, iter);
+       ix++)
+    if (iter == pst)
+      return;
+
+  VEC_safe_push (partial_symtab_p, symtab_prefetch_queue, pst);
+
+  if (symtab_prefetch_timer == 0)
+    symtab_prefetch_timer = create_timer (0, symtab_prefetch_handler, NULL);
+}
+
+/* Drop any queued prefetches of partial symtabs belonging to
+   OBJFILE, which is about to have its symbols freed.  */
+
+void
+forget_psymtab_prefetches (struct objfile *objfile)
+{
+  int ix;
+  struct partial_symtab *pst;
+
+  for (ix = 0; VEC_iterate (partial_symtab_p, symtab_prefetch_queue, ix, pst);)
+    if (pst->objfile == objfile)
+      VEC_ordered_remove (partial_symtab_p, symtab_prefetch_queue, ix);
+    else
+      ix++;
+}
+
+/* Called when the inferior stops.  The symbols of the frames of the
+   stopped thread are the ones the user is most likely to ask about
+   next, through "bt", "info locals", "ptype" and the like.  Only note
+   the stop here; the frames are queued once GDB is idle.  */
+
+static void
+symtab_prefetch_normal_stop (struct bpstats *bs)
+{
+  if (!symtab_prefetch)
+    return;
+
+  symtab_prefetch_frames_pending = 1;
+  if (symtab_prefetch_timer == 0)
+    symtab_prefetch_timer = create_timer (0, symtab_prefetch_handler, NULL);
+}
+
 /* Remember the lowest-addressed loadable section we've seen.
    This function is called via bfd_map_over_sections.
 
@@ -946,6 +1125,7 @@ syms_from_objfile (struct objfile *objfile,
 #endif /* not DEPRECATED_IBM6000_TARGET */
 
   (*objfile->sf->sym_read) (objfile, mainline);
+  shrink_psymbol_lists (objfile);
 
   /* Don't allow char * to have a typename (else would get caddr_t).
      Ditto void *.  FIXME: Check whether this is now done by all the
@@ -2385,10 +2565,14 @@ reread_symbols (void)
 	         enough?  */
 	      if (objfile->global_psymbols.list)
 		xfree (objfile->global_psymbols.list);
+	      if (objfile->global_psymbols.keys)
+		xfree (objfile->global_psymbols.keys);
 	      memset (&objfile->global_psymbols, 0,
 		      sizeof (objfile->global_psymbols));
 	      if (objfile->static_psymbols.list)
 		xfree (objfile->static_psymbols.list);
+	      if (objfile->static_psymbols.keys)
+		xfree (objfile->static_psymbols.keys);
 	      memset (&objfile->static_psymbols, 0,
 		      sizeof (objfile->static_psymbols));
 
@@ -2402,6 +2586,7 @@ reread_symbols (void)
 		  htab_delete (objfile->demangled_names_hash);
 		  objfile->demangled_names_hash = NULL;
 		}
+	      forget_psymtab_prefetches (objfile);
 	      obstack_free (&objfile->objfile_obstack, 0);
 	      objfile->sections = NULL;
 	      objfile->symtabs = NULL;
@@ -2460,6 +2645,7 @@ reread_symbols (void)
 	         zero is OK since dbxread.c also does what it needs to do if
 	         objfile->global_psymbols.size is 0.  */
 	      (*objfile->sf->sym_read) (objfile, 0);
+	      shrink_psymbol_lists (objfile);
 	      if (!have_partial_symbols () && !have_full_symbols ())
 		{
 		  wrap_here ("");
@@ -3211,6 +3397,10 @@ init_psymbol_list (struct objfile *objfile, int total_symbols)
     {
       xfree (objfile->static_psymbols.list);
     }
+  xfree (objfile->global_psymbols.keys);
+  objfile->global_psymbols.keys = NULL;
+  xfree (objfile->static_psymbols.keys);
+  objfile->static_psymbols.keys = NULL;
 
   /* Current best guess is that approximately a twentieth
      of the total symbols (in a debugging file) are global or static
@@ -3235,6 +3425,87 @@ init_psymbol_list (struct objfile *objfile, int total_symbols)
     }
 }
 
+/* Give back the unused tail of LIST, which grew by doubling while the
+   symbols were being read, and compute the keys of its names.  */
+
+static void
+shrink_psymbol_list (struct psymbol_allocation_list *list)
+{
+  int n = list->next - list->list;
+  int i;
+
+  if (n == 0)
+    {
+      xfree (list->list);
+      xfree (list->keys);
+      memset (list, 0, sizeof (*list));
+      return;
+    }
+
+  if (n != list->size)
+    {
+      list->list = xrealloc (list->list,
+			     n * sizeof (struct partial_symbol *));
+      list->next = list->list + n;
+      list->size = n;
+    }
+
+  /* The keys are only allocated now that the list has its final
+     length, so they never carry any of its slack.  */
+  xfree (list->keys);
+  list->keys = xmalloc (n * sizeof (unsigned int));
+  for (i = 0; i < n; i++)
+    list->keys[i] = psymbol_name_key (SYMBOL_SEARCH_NAME (list->list[i]));
+}
+
+/* Return the key of the partial symbol search name NAME; see
+   PSYMBOL_KEY_PREFIX.  The prefix packs the first three characters
+   of NAME seven bits apiece, skipping whitespace as strcmp_iw_ordered
+   does and counting the end of the name or a '(' as zero, which is
+   how that function ranks them too.  Names with a character of 0x7f
+   or above in their prefix get PSYMBOL_KEY_NO_PREFIX instead.  */
+
+unsigned int
+psymbol_name_key (const char *name)
+{
+  const char *p = name;
+  unsigned int prefix = 0;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      unsigned char c;
+
+      while (isspace (*p))
+	p++;
+      c = *p;
+      if (c >= 0x7f)
+	{
+	  prefix = PSYMBOL_KEY_NO_PREFIX;
+	  break;
+	}
+      if (c == '(')
+	c = 0;
+      if (c != 0)
+	p++;
+      prefix = (prefix << 7) | c;
+    }
+
+  return ((prefix << PSYMBOL_KEY_HASH_BITS)
+	  | (msymbol_hash_iw (name) & ((1 << PSYMBOL_KEY_HASH_BITS) - 1)));
+}
+
+/* Trim OBJFILE's partial symbol lists to the number of symbols
+   actually in them, and give them their keys.  Should more be
+   added later, the lists simply grow again, without keys.  */
+
+void
+shrink_psymbol_lists (struct objfile *objfile)
+{
+  shrink_psymbol_list (&objfile->global_psymbols);
+  shrink_psymbol_list (&objfile->static_psymbols);
+}
+
 /* OVERLAYS:
    The following code implements an abstraction for debugging overlay sections.
 
@@ -4231,6 +4502,19 @@ the global debug-file directory prepended."),
 				     show_debug_file_directory,
 				     &setlist, &showlist);
 
+  add_setshow_boolean_cmd ("symtab-prefetch", class_support,
+			   &symtab_prefetch, _("\
+Set reading of symbols for the stopped thread's frames while idle."), _("\
+Show reading of symbols for the stopped thread's frames while idle."), _("\
+When on, the full symbols of the compilation units covering the\n\
+innermost frames of a thread are read in the background after it\n\
+stops, while GDB is waiting for a command, so that later commands\n\
+which need them do not have to wait."),
+			   NULL,
+			   show_symtab_prefetch,
+			   &setlist, &showlist);
+  observer_attach_normal_stop (symtab_prefetch_normal_stop);
+
   add_setshow_boolean_cmd ("symbol-loading", no_class,
                            &print_symbol_loading, _("\
 Set printing of symbol loading messages."), _("\
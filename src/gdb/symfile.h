@@ -60,6 +60,15 @@ struct psymbol_allocation_list
      store a pointer.  */
 
   int size;
+
+  /* The psymbol_name_key keys of the search names of the partial
+     symbols in LIST, in the same order, in an array of SIZE elements.
+     Searches compare these first, and so settle most comparisons
+     without touching the symbols or their names at all.  They are
+     computed by shrink_psymbol_lists once the list is complete, and
+     are NULL while it is still growing.  */
+
+  unsigned int *keys;
 };
 
 /* Define an array of addresses to accommodate non-contiguous dynamic
@@ -201,6 +210,20 @@ struct partial_symbol *add_psymbol_to_list (char *, int, domain_enum,
 
 extern void init_psymbol_list (struct objfile *, int);
 
+extern void shrink_psymbol_lists (struct objfile *);
+
+/* A partial symbol's key is an ordered prefix of its search name in
+   the high bits, above the low bits of its msymbol_hash_iw hash.  Two
+   names that strcmp_iw matches have equal keys, and two names whose
+   prefixes differ, neither being PSYMBOL_KEY_NO_PREFIX, compare under
+   strcmp_iw_ordered as their prefixes do.  */
+
+#define PSYMBOL_KEY_HASH_BITS 11
+#define PSYMBOL_KEY_PREFIX(key) ((key) >> PSYMBOL_KEY_HASH_BITS)
+#define PSYMBOL_KEY_NO_PREFIX (~0U >> PSYMBOL_KEY_HASH_BITS)
+
+extern unsigned int psymbol_name_key (const char *);
+
 extern void sort_pst_symbols (struct partial_symtab *);
 
 extern struct symtab *allocate_symtab (char *, struct objfile *);
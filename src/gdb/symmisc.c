@@ -195,6 +195,18 @@ print_objfile_statistics (void)
 		     obstack_memory_used (&objfile->objfile_obstack));
     printf_filtered (_("  Total memory used for psymbol cache: %d\n"),
 		     bcache_memory_used (objfile->psymbol_cache));
+    printf_filtered (_("  Total memory used for psymbol lists: %d\n"),
+		     (int) ((objfile->global_psymbols.size
+			     + objfile->static_psymbols.size)
+			    * sizeof (struct partial_symbol *)
+			    + ((objfile->global_psymbols.keys
+				? objfile->global_psymbols.size : 0)
+			       + (objfile->static_psymbols.keys
+				  ? objfile->static_psymbols.size : 0))
+			    * sizeof (unsigned int)));
+    if (OBJSTAT (objfile, n_psym_compares) > 0)
+      printf_filtered (_("  Number of psymbol names compared by lookups: %d\n"),
+		       OBJSTAT (objfile, n_psym_compares));
     printf_filtered (_("  Total memory used for macro cache: %d\n"),
 		     bcache_memory_used (objfile->macro_cache));
   }
@@ -1187,6 +1199,9 @@ extend_psymbol_list (struct psymbol_allocation_list *listp,
 	xrealloc ((char *) listp->list,
 		  new_size * sizeof (struct partial_symbol *));
     }
+  /* The keys no longer cover the whole list.  */
+  xfree (listp->keys);
+  listp->keys = NULL;
   /* Next assumes we only went one over.  Should be good if
      program works correctly */
   listp->next = listp->list + listp->size;
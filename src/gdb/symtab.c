@@ -1678,6 +1678,10 @@ lookup_partial_symbol (struct partial_symtab *pst, const char *name,
   struct partial_symbol **top, **real_top, **bottom, **center;
   int length = (global ? pst->n_global_syms : pst->n_static_syms);
   int do_linear_search = 1;
+  unsigned int *keys;
+  unsigned int key = psymbol_name_key (name);
+  unsigned int prefix = PSYMBOL_KEY_PREFIX (key);
+  unsigned int center_prefix;
   
   if (length == 0)
     {
@@ -1686,6 +1690,11 @@ lookup_partial_symbol (struct partial_symtab *pst, const char *name,
   start = (global ?
 	   pst->objfile->global_psymbols.list + pst->globals_offset :
 	   pst->objfile->static_psymbols.list + pst->statics_offset);
+  keys = (global ?
+	  pst->objfile->global_psymbols.keys :
+	  pst->objfile->static_psymbols.keys);
+  if (keys != NULL)
+    keys += global ? pst->globals_offset : pst->statics_offset;
   
   if (global)			/* This means we can use a binary search. */
     {
@@ -1710,6 +1719,21 @@ lookup_partial_symbol (struct partial_symtab *pst, const char *name,
 	    {
 	      do_linear_search = 1;
 	    }
+	  center_prefix = (keys != NULL
+			   ? PSYMBOL_KEY_PREFIX (keys[center - start])
+			   : PSYMBOL_KEY_NO_PREFIX);
+	  if (prefix != PSYMBOL_KEY_NO_PREFIX
+	      && center_prefix != PSYMBOL_KEY_NO_PREFIX
+	      && center_prefix != prefix)
+	    {
+	      /* The prefixes order the names without reading them.  */
+	      if (center_prefix > prefix)
+		top = center;
+	      else
+		bottom = center + 1;
+	      continue;
+	    }
+	  OBJSTAT (pst->objfile, n_psym_compares)++;
 	  if (strcmp_iw_ordered (SYMBOL_SEARCH_NAME (*center), name) >= 0)
 	    {
 	      top = center;
@@ -1722,11 +1746,16 @@ lookup_partial_symbol (struct partial_symtab *pst, const char *name,
       if (!(top == bottom))
 	internal_error (__FILE__, __LINE__, _("failed internal consistency check"));
 
-      while (top <= real_top
-	     && (linkage_name != NULL
-		 ? strcmp (SYMBOL_LINKAGE_NAME (*top), linkage_name) == 0
-		 : SYMBOL_MATCHES_SEARCH_NAME (*top,name)))
+      while (top <= real_top)
 	{
+	  if (linkage_name == NULL && keys != NULL
+	      && keys[top - start] != key)
+	    break;
+	  OBJSTAT (pst->objfile, n_psym_compares)++;
+	  if (linkage_name != NULL
+	      ? strcmp (SYMBOL_LINKAGE_NAME (*top), linkage_name) != 0
+	      : !SYMBOL_MATCHES_SEARCH_NAME (*top, name))
+	    break;
 	  if (symbol_matches_domain (SYMBOL_LANGUAGE (*top),
 				     SYMBOL_DOMAIN (*top), domain))
 	    return (*top);
@@ -1741,9 +1770,15 @@ lookup_partial_symbol (struct partial_symtab *pst, const char *name,
     {			
       for (psym = start; psym < start + length; psym++)
 	{
+	  /* Symbols with a different key cannot match NAME.  */
+	  if (linkage_name == NULL && keys != NULL
+	      && keys[psym - start] != key)
+	    continue;
+
 	  if (symbol_matches_domain (SYMBOL_LANGUAGE (*psym), 
 				     SYMBOL_DOMAIN (*psym), domain))
 	    {
+	      OBJSTAT (pst->objfile, n_psym_compares)++;
 	      if (linkage_name != NULL
 		  ? strcmp (SYMBOL_LINKAGE_NAME (*psym), linkage_name) == 0
 		  : SYMBOL_MATCHES_SEARCH_NAME (*psym, name))
@@ -2079,6 +2114,67 @@ find_pc_symtab (CORE_ADDR pc)
 }
 
 
+/* Return non-zero if the linetable of S is sorted by pc.  Symbol
+   readers sort the linetables of objfiles which may be reordered, and
+   most others come out sorted anyway, but check once rather than
+   assume.  */
+
+static int
+linetable_sorted_p (struct symtab *s)
+{
+  if (s->linetable_sorted == 0)
+    {
+      struct linetable *l = LINETABLE (s);
+      int i;
+
+      s->linetable_sorted = 1;
+      for (i = 1; i < l->nitems; i++)
+	if (l->item[i].pc < l->item[i - 1].pc)
+	  {
+	    s->linetable_sorted = -1;
+	    break;
+	  }
+    }
+
+  return s->linetable_sorted > 0;
+}
+
+/* A small cache of the results of find_pc_sect_line, which gets
+   asked about the same few pcs over and over again while stepping
+   and printing backtraces.  */
+
+#define PC_LINE_CACHE_SIZE 61
+
+struct pc_line_cache_entry
+{
+  int valid;
+  CORE_ADDR pc;
+  struct bfd_section *section;
+  int notcurrent;
+  struct symtab_and_line sal;
+};
+
+static struct pc_line_cache_entry pc_line_cache[PC_LINE_CACHE_SIZE];
+
+/* Clear the cache, e.g. when symbol tables are added, relocated or
+   discarded.  */
+
+void
+clear_pc_line_cache (void)
+{
+  memset (pc_line_cache, 0, sizeof (pc_line_cache));
+}
+
+static void
+pc_line_cache_new_objfile (struct objfile *objfile)
+{
+  clear_pc_line_cache ();
+}
+
+static struct symtab_and_line find_pc_sect_line_1 (CORE_ADDR,
+						    struct bfd_section *,
+						    int);
+
 /* Find the source file and line number for a given PC value and SECTION.
    Return a structure containing a symtab pointer, a line number,
    and a pc range for the entire source line.
@@ -2098,6 +2194,33 @@ find_pc_symtab (CORE_ADDR pc)
 
 struct symtab_and_line
 find_pc_sect_line (CORE_ADDR pc, struct bfd_section *section, int notcurrent)
+{
+  struct pc_line_cache_entry *entry;
+
+  /* Which sections are mapped can change behind our back when
+     debugging overlays, so don't cache anything then.  */
+  if (overlay_debugging)
+    return find_pc_sect_line_1 (pc, section, notcurrent);
+
+  entry = &pc_line_cache[pc % PC_LINE_CACHE_SIZE];
+  if (!entry->valid
+      || entry->pc != pc
+      || entry->section != section
+      || entry->notcurrent != notcurrent)
+    {
+      entry->sal = find_pc_sect_line_1 (pc, section, notcurrent);
+      entry->pc = pc;
+      entry->section = section;
+      entry->notcurrent = notcurrent;
+      entry->valid = 1;
+    }
+
+  return entry->sal;
+}
+
+static struct symtab_and_line
+find_pc_sect_line_1 (CORE_ADDR pc, struct bfd_section *section,
+		     int notcurrent)
 {
   struct symtab *s;
   struct linetable *l;
@@ -2260,15 +2383,36 @@ find_pc_sect_line (CORE_ADDR pc, struct bfd_section *section, int notcurrent)
 	  alt_symtab = s;
 	}
 
-      for (i = 0; i < len; i++, item++)
+      if (linetable_sorted_p (s))
 	{
-	  /* Leave prev pointing to the linetable entry for the last line
-	     that started at or before PC.  */
-	  if (item->pc > pc)
-	    break;
+	  /* Find the first line which starts after PC.  */
+	  int low = 0, high = len;
+
+	  while (low < high)
+	    {
+	      int mid = low + (high - low) / 2;
+
+	      if (l->item[mid].pc > pc)
+		high = mid;
+	      else
+		low = mid + 1;
+	    }
 
-	  prev = item;
+	  i = low;
+	  item = l->item + i;
+	  if (i > 0)
+	    prev = item - 1;
 	}
+      else
+	for (i = 0; i < len; i++, item++)
+	  {
+	    /* Leave prev pointing to the linetable entry for the last line
+	       that started at or before PC.  */
+	    if (item->pc > pc)
+	      break;
+
+	    prev = item;
+	  }
 
       /* At this point, prev points at the line whose start addr is <= pc, and
          item points at the next line.  If we ran off the end of the linetable
@@ -2555,10 +2699,30 @@ find_line_common (struct linetable *l, int lineno,
 int
 find_pc_line_pc_range (CORE_ADDR pc, CORE_ADDR *startptr, CORE_ADDR *endptr)
 {
-  struct symtab_and_line sal;
+  struct symtab_and_line sal, next;
+  CORE_ADDR func_end;
+
   sal = find_pc_line (pc, 0);
   *startptr = sal.pc;
   *endptr = sal.end;
+
+  /* Compilers often split the code of one line, such as a loop, into
+     several line table entries in a row.  Stepping carries on through
+     them anyway; include them in the range, so that it can be stepped
+     through at once.  Don't go past the end of the function, or
+     stepping into a function on the same line would go unnoticed.  */
+  if (sal.symtab != NULL && sal.end != 0
+      && find_pc_partial_function (pc, NULL, NULL, &func_end))
+    while (*endptr < func_end)
+      {
+	next = find_pc_line (*endptr, 0);
+	if (next.symtab != sal.symtab || next.line != sal.line
+	    || next.pc != *endptr || next.end <= *endptr
+	    || next.end > func_end)
+	  break;
+	*endptr = next.end;
+      }
+
   return sal.symtab != 0;
 }
 
@@ -2977,6 +3141,231 @@ sort_search_symbols (struct symbol_search *prevtail, int nfound)
   return symp;
 }
 
+/* A sorted index of the partial and minimal symbol names of an
+   objfile.  Symbol completion and "info functions" and friends use it
+   to visit only the names which can possibly match, and to try each
+   distinct name against a regexp just once, instead of walking every
+   symbol of every objfile.  It is built the first time it is needed,
+   and rebuilt if the objfile has gained symbols since.  */
+
+struct psymbol_index_entry
+{
+  struct partial_symbol *psym;
+  struct partial_symtab *psymtab;
+};
+
+struct symbol_name_index
+{
+  /* The global and static partial symbols of the objfile's psymtabs,
+     sorted by natural name.  */
+  struct psymbol_index_entry *psymbols;
+  int n_psymbols;
+
+  /* The objfile's minimal symbols, sorted by natural name.  */
+  struct minimal_symbol **msymbols;
+  int n_msymbols;
+
+  /* The sizes of the objfile's symbol lists when the index was built,
+     used to notice that it has become stale.  */
+  int n_global_seen;
+  int n_static_seen;
+  int n_minimal_seen;
+};
+
+static const struct objfile_data *symbol_name_index_key;
+
+static void
+free_symbol_name_index (struct objfile *objfile, void *arg)
+{
+  struct symbol_name_index *index = arg;
+
+  xfree (index->psymbols);
+  xfree (index->msymbols);
+  xfree (index);
+}
+
+static int
+compare_psymbol_index_entries (const void *a, const void *b)
+{
+  const struct psymbol_index_entry *ea = a;
+  const struct psymbol_index_entry *eb = b;
+
+  return strcmp (SYMBOL_NATURAL_NAME (ea->psym),
+		 SYMBOL_NATURAL_NAME (eb->psym));
+}
+
+static int
+compare_msymbol_index_entries (const void *a, const void *b)
+{
+  struct minimal_symbol *const *ma = a;
+  struct minimal_symbol *const *mb = b;
+
+  return strcmp (SYMBOL_NATURAL_NAME (*ma), SYMBOL_NATURAL_NAME (*mb));
+}
+
+/* Return the name index of OBJFILE, building it if necessary.  */
+
+static struct symbol_name_index *
+get_symbol_name_index (struct objfile *objfile)
+{
+  struct symbol_name_index *index;
+  struct partial_symtab *ps;
+  struct partial_symbol **psym;
+  struct minimal_symbol *msymbol;
+  int n_global = (objfile->global_psymbols.next
+		  - objfile->global_psymbols.list);
+  int n_static = (objfile->static_psymbols.next
+		  - objfile->static_psymbols.list);
+  int n;
+
+  index = objfile_data (objfile, symbol_name_index_key);
+  if (index != NULL
+      && index->n_global_seen == n_global
+      && index->n_static_seen == n_static
+      && index->n_minimal_seen == objfile->minimal_symbol_count)
+    return index;
+
+  if (index != NULL)
+    free_symbol_name_index (objfile, index);
+
+  index = XZALLOC (struct symbol_name_index);
+  index->n_global_seen = n_global;
+  index->n_static_seen = n_static;
+  index->n_minimal_seen = objfile->minimal_symbol_count;
+
+  n = 0;
+  ALL_OBJFILE_PSYMTABS (objfile, ps)
+    n += ps->n_global_syms + ps->n_static_syms;
+  index->psymbols = xmalloc (n * sizeof (struct psymbol_index_entry));
+
+  ALL_OBJFILE_PSYMTABS (objfile, ps)
+    {
+      for (psym = objfile->global_psymbols.list + ps->globals_offset;
+	   psym < (objfile->global_psymbols.list + ps->globals_offset
+		   + ps->n_global_syms);
+	   psym++)
+	{
+	  index->psymbols[index->n_psymbols].psym = *psym;
+	  index->psymbols[index->n_psymbols].psymtab = ps;
+	  index->n_psymbols++;
+	}
+
+      for (psym = objfile->static_psymbols.list + ps->statics_offset;
+	   psym < (objfile->static_psymbols.list + ps->statics_offset
+		   + ps->n_static_syms);
+	   psym++)
+	{
+	  index->psymbols[index->n_psymbols].psym = *psym;
+	  index->psymbols[index->n_psymbols].psymtab = ps;
+	  index->n_psymbols++;
+	}
+    }
+  qsort (index->psymbols, index->n_psymbols,
+	 sizeof (struct psymbol_index_entry), compare_psymbol_index_entries);
+
+  index->msymbols = xmalloc (objfile->minimal_symbol_count
+			     * sizeof (struct minimal_symbol *));
+  ALL_OBJFILE_MSYMBOLS (objfile, msymbol)
+    index->msymbols[index->n_msymbols++] = msymbol;
+  qsort (index->msymbols, index->n_msymbols,
+	 sizeof (struct minimal_symbol *), compare_msymbol_index_entries);
+
+  set_objfile_data (objfile, symbol_name_index_key, index);
+  return index;
+}
+
+/* Return the first of the N entries of BASE, each of SIZE bytes and
+   sorted by the name NAME_OF returns for them, whose name compares
+   with the first LEN characters of PREFIX as greater than or equal
+   to it, or greater than it if STRICT.  */
+
+static int
+name_index_bound (void *base, int n, size_t size,
+		  const char *(*name_of) (void *),
+		  const char *prefix, int len, int strict)
+{
+  int low = 0, high = n;
+
+  while (low < high)
+    {
+      int mid = low + (high - low) / 2;
+      int cmp = strncmp (name_of ((char *) base + mid * size), prefix, len);
+
+      if (cmp < 0 || (strict && cmp == 0))
+	low = mid + 1;
+      else
+	high = mid;
+    }
+
+  return low;
+}
+
+static const char *
+psymbol_index_entry_name (void *entry)
+{
+  return SYMBOL_NATURAL_NAME (((struct psymbol_index_entry *) entry)->psym);
+}
+
+static const char *
+msymbol_index_entry_name (void *entry)
+{
+  return SYMBOL_NATURAL_NAME (*(struct minimal_symbol **) entry);
+}
+
+/* Set *LOW and *HIGH to the bounds of the partial symbols of INDEX
+   whose names begin with the first LEN characters of PREFIX.  */
+
+static void
+psymbol_index_prefix_range (struct symbol_name_index *index,
+			    const char *prefix, int len, int *low, int *high)
+{
+  *low = name_index_bound (index->psymbols, index->n_psymbols,
+			   sizeof (struct psymbol_index_entry),
+			   psymbol_index_entry_name, prefix, len, 0);
+  *high = name_index_bound (index->psymbols, index->n_psymbols,
+			    sizeof (struct psymbol_index_entry),
+			    psymbol_index_entry_name, prefix, len, 1);
+}
+
+/* Likewise, for the minimal symbols of INDEX.  */
+
+static void
+msymbol_index_prefix_range (struct symbol_name_index *index,
+			    const char *prefix, int len, int *low, int *high)
+{
+  *low = name_index_bound (index->msymbols, index->n_msymbols,
+			   sizeof (struct minimal_symbol *),
+			   msymbol_index_entry_name, prefix, len, 0);
+  *high = name_index_bound (index->msymbols, index->n_msymbols,
+			    sizeof (struct minimal_symbol *),
+			    msymbol_index_entry_name, prefix, len, 1);
+}
+
+/* If every string REGEXP matches must begin with some fixed text,
+   return the length of that text, which starts at REGEXP + 1.
+   Otherwise, return zero.  This is deliberately simple minded: only
+   a leading "^" followed by ordinary characters qualifies.  */
+
+static int
+regexp_literal_prefix (const char *regexp)
+{
+  const char *p;
+
+  if (regexp == NULL || regexp[0] != '^' || strchr (regexp, '|') != NULL)
+    return 0;
+
+  for (p = regexp + 1; *p != '\0'; p++)
+    if (strchr (".[]*+?{}()\\^$", *p) != NULL)
+      break;
+
+  /* A repetition operator may make the last literal character
+     optional.  */
+  if (p > regexp + 1 && (*p == '*' || *p == '?' || *p == '{'))
+    p--;
+
+  return p - (regexp + 1);
+}
+
 /* Search the symbol table for matches to the regular expression REGEXP,
    returning the results in *MATCHES.
 
@@ -3003,7 +3392,6 @@ search_symbols (char *regexp, domain_enum kind, int nfiles, char *files[],
   int i = 0;
   struct dict_iterator iter;
   struct symbol *sym;
-  struct partial_symbol **psym;
   struct objfile *objfile;
   struct minimal_symbol *msymbol;
   char *val;
@@ -3028,6 +3416,7 @@ search_symbols (char *regexp, domain_enum kind, int nfiles, char *files[],
   struct symbol_search *psr;
   struct symbol_search *tail;
   struct cleanup *old_chain = NULL;
+  int prefix_len = 0;
 
   if (kind < VARIABLES_DOMAIN)
     error (_("must search on specific domain"));
@@ -3074,64 +3463,61 @@ search_symbols (char *regexp, domain_enum kind, int nfiles, char *files[],
 
       if (0 != (val = re_comp (regexp)))
 	error (_("Invalid regexp (%s): %s"), val, regexp);
+
+      prefix_len = regexp_literal_prefix (regexp);
     }
 
   /* Search through the partial symtabs *first* for all symbols
      matching the regexp.  That way we don't have to reproduce all of
-     the machinery below. */
+     the machinery below.  The name index lets us skip the names which
+     cannot match a leading literal in the regexp, and try each
+     distinct name only once.  */
 
-  ALL_PSYMTABS (objfile, ps)
+  ALL_OBJFILES (objfile)
   {
-    struct partial_symbol **bound, **gbound, **sbound;
-    int keep_going = 1;
-
-    if (ps->readin)
-      continue;
+    struct symbol_name_index *index = get_symbol_name_index (objfile);
+    const char *last_name = NULL;
+    int last_matched = 0;
+    int low, high, j;
 
-    gbound = objfile->global_psymbols.list + ps->globals_offset + ps->n_global_syms;
-    sbound = objfile->static_psymbols.list + ps->statics_offset + ps->n_static_syms;
-    bound = gbound;
+    if (prefix_len > 0)
+      psymbol_index_prefix_range (index, regexp + 1, prefix_len, &low, &high);
+    else
+      {
+	low = 0;
+	high = index->n_psymbols;
+      }
 
-    /* Go through all of the symbols stored in a partial
-       symtab in one loop. */
-    psym = objfile->global_psymbols.list + ps->globals_offset;
-    while (keep_going)
+    for (j = low; j < high; j++)
       {
-	if (psym >= bound)
-	  {
-	    if (bound == gbound && ps->n_static_syms != 0)
-	      {
-		psym = objfile->static_psymbols.list + ps->statics_offset;
-		bound = sbound;
-	      }
-	    else
-	      keep_going = 0;
-	    continue;
-	  }
-	else
+	struct partial_symbol *p = index->psymbols[j].psym;
+	char *name = SYMBOL_NATURAL_NAME (p);
+
+	ps = index->psymbols[j].psymtab;
+	if (ps->readin)
+	  continue;
+
+	QUIT;
+
+	if (last_name == NULL || strcmp (name, last_name) != 0)
 	  {
-	    QUIT;
-
-	    /* If it would match (logic taken from loop below)
-	       load the file and go on to the next one.  We check the
-	       filename here, but that's a bit bogus: we don't know
-	       what file it really comes from until we have full
-	       symtabs.  The symbol might be in a header file included by
-	       this psymtab.  This only affects Insight.  */
-	    if (file_matches (ps->filename, files, nfiles)
-		&& ((regexp == NULL
-		     || re_exec (SYMBOL_NATURAL_NAME (*psym)) != 0)
-		    && ((kind == VARIABLES_DOMAIN && SYMBOL_CLASS (*psym) != LOC_TYPEDEF
-			 && SYMBOL_CLASS (*psym) != LOC_BLOCK)
-			|| (kind == FUNCTIONS_DOMAIN && SYMBOL_CLASS (*psym) == LOC_BLOCK)
-			|| (kind == TYPES_DOMAIN && SYMBOL_CLASS (*psym) == LOC_TYPEDEF)
-			|| (kind == METHODS_DOMAIN && SYMBOL_CLASS (*psym) == LOC_BLOCK))))
-	      {
-		PSYMTAB_TO_SYMTAB (ps);
-		keep_going = 0;
-	      }
+	    last_name = name;
+	    last_matched = (regexp == NULL || re_exec (name) != 0);
 	  }
-	psym++;
+
+	/* If it would match (logic taken from loop below) load the
+	   file.  We check the filename here, but that's a bit bogus:
+	   we don't know what file it really comes from until we have
+	   full symtabs.  The symbol might be in a header file included
+	   by this psymtab.  This only affects Insight.  */
+	if (last_matched
+	    && file_matches (ps->filename, files, nfiles)
+	    && ((kind == VARIABLES_DOMAIN && SYMBOL_CLASS (p) != LOC_TYPEDEF
+		 && SYMBOL_CLASS (p) != LOC_BLOCK)
+		|| (kind == FUNCTIONS_DOMAIN && SYMBOL_CLASS (p) == LOC_BLOCK)
+		|| (kind == TYPES_DOMAIN && SYMBOL_CLASS (p) == LOC_TYPEDEF)
+		|| (kind == METHODS_DOMAIN && SYMBOL_CLASS (p) == LOC_BLOCK)))
+	  PSYMTAB_TO_SYMTAB (ps);
       }
   }
 
@@ -3150,30 +3536,47 @@ search_symbols (char *regexp, domain_enum kind, int nfiles, char *files[],
 
   if (nfiles == 0 && (kind == VARIABLES_DOMAIN || kind == FUNCTIONS_DOMAIN))
     {
-      ALL_MSYMBOLS (objfile, msymbol)
+      ALL_OBJFILES (objfile)
       {
-	if (MSYMBOL_TYPE (msymbol) == ourtype ||
-	    MSYMBOL_TYPE (msymbol) == ourtype2 ||
-	    MSYMBOL_TYPE (msymbol) == ourtype3 ||
-	    MSYMBOL_TYPE (msymbol) == ourtype4)
+	struct symbol_name_index *index = get_symbol_name_index (objfile);
+	int low, high, j;
+
+	if (prefix_len > 0)
+	  msymbol_index_prefix_range (index, regexp + 1, prefix_len,
+				      &low, &high);
+	else
 	  {
-	    if (regexp == NULL
-		|| re_exec (SYMBOL_NATURAL_NAME (msymbol)) != 0)
+	    low = 0;
+	    high = index->n_msymbols;
+	  }
+
+	for (j = low; j < high; j++)
+	  {
+	    msymbol = index->msymbols[j];
+
+	    if (MSYMBOL_TYPE (msymbol) == ourtype ||
+		MSYMBOL_TYPE (msymbol) == ourtype2 ||
+		MSYMBOL_TYPE (msymbol) == ourtype3 ||
+		MSYMBOL_TYPE (msymbol) == ourtype4)
 	      {
-		if (0 == find_pc_symtab (SYMBOL_VALUE_ADDRESS (msymbol)))
+		if (regexp == NULL
+		    || re_exec (SYMBOL_NATURAL_NAME (msymbol)) != 0)
 		  {
-		    /* FIXME: carlton/2003-02-04: Given that the
-		       semantics of lookup_symbol keeps on changing
-		       slightly, it would be a nice idea if we had a
-		       function lookup_symbol_minsym that found the
-		       symbol associated to a given minimal symbol (if
-		       any).  */
-		    if (kind == FUNCTIONS_DOMAIN
-			|| lookup_symbol (SYMBOL_LINKAGE_NAME (msymbol),
-					  (struct block *) NULL,
-					  VAR_DOMAIN, 0)
-			== NULL)
-		      found_misc = 1;
+		    if (0 == find_pc_symtab (SYMBOL_VALUE_ADDRESS (msymbol)))
+		      {
+			/* FIXME: carlton/2003-02-04: Given that the
+			   semantics of lookup_symbol keeps on changing
+			   slightly, it would be a nice idea if we had a
+			   function lookup_symbol_minsym that found the
+			   symbol associated to a given minimal symbol (if
+			   any).  */
+			if (kind == FUNCTIONS_DOMAIN
+			    || lookup_symbol (SYMBOL_LINKAGE_NAME (msymbol),
+					      (struct block *) NULL,
+					      VAR_DOMAIN, 0)
+			    == NULL)
+			  found_misc = 1;
+		      }
 		  }
 	      }
 	  }
@@ -3249,7 +3652,10 @@ search_symbols (char *regexp, domain_enum kind, int nfiles, char *files[],
 	    MSYMBOL_TYPE (msymbol) == ourtype4)
 	  {
 	    if (regexp == NULL
-		|| re_exec (SYMBOL_NATURAL_NAME (msymbol)) != 0)
+		|| ((prefix_len == 0
+		     || strncmp (SYMBOL_NATURAL_NAME (msymbol), regexp + 1,
+				 prefix_len) == 0)
+		    && re_exec (SYMBOL_NATURAL_NAME (msymbol)) != 0))
 	      {
 		/* Functions:  Look up by address. */
 		if (kind != FUNCTIONS_DOMAIN ||
@@ -3645,13 +4051,10 @@ default_make_symbol_completion_list (char *text, char *word)
 
   struct symbol *sym;
   struct symtab *s;
-  struct partial_symtab *ps;
-  struct minimal_symbol *msymbol;
   struct objfile *objfile;
   struct block *b, *surrounding_static_block = 0;
   struct dict_iterator iter;
   int j;
-  struct partial_symbol **psym;
   /* The symbol we are completing on.  Points in same buffer as text.  */
   char *sym_text;
   /* Length of sym_text.  */
@@ -3717,32 +4120,32 @@ default_make_symbol_completion_list (char *text, char *word)
   return_val[0] = NULL;
 
   /* Look through the partial symtabs for all symbols which begin
-     by matching SYM_TEXT.  Add each one that you find to the list.  */
+     by matching SYM_TEXT.  Add each one that you find to the list.
+     The name index hands us exactly those, sorted, so each distinct
+     name is added only once per objfile.  */
 
-  ALL_PSYMTABS (objfile, ps)
+  ALL_OBJFILES (objfile)
   {
-    /* If the psymtab's been read in we'll get it when we search
-       through the blockvector.  */
-    if (ps->readin)
-      continue;
+    struct symbol_name_index *index = get_symbol_name_index (objfile);
+    char *last_name = NULL;
+    int low, high, i;
 
-    for (psym = objfile->global_psymbols.list + ps->globals_offset;
-	 psym < (objfile->global_psymbols.list + ps->globals_offset
-		 + ps->n_global_syms);
-	 psym++)
+    psymbol_index_prefix_range (index, sym_text, sym_text_len, &low, &high);
+    for (i = low; i < high; i++)
       {
-	/* If interrupted, then quit. */
-	QUIT;
-	COMPLETION_LIST_ADD_SYMBOL (*psym, sym_text, sym_text_len, text, word);
-      }
+	struct partial_symbol *p = index->psymbols[i].psym;
 
-    for (psym = objfile->static_psymbols.list + ps->statics_offset;
-	 psym < (objfile->static_psymbols.list + ps->statics_offset
-		 + ps->n_static_syms);
-	 psym++)
-      {
+	/* If the psymtab's been read in we'll get it when we search
+	   through the blockvector.  */
+	if (index->psymbols[i].psymtab->readin)
+	  continue;
+
+	/* If interrupted, then quit. */
 	QUIT;
-	COMPLETION_LIST_ADD_SYMBOL (*psym, sym_text, sym_text_len, text, word);
+	if (last_name != NULL && strcmp (SYMBOL_NATURAL_NAME (p), last_name) == 0)
+	  continue;
+	last_name = SYMBOL_NATURAL_NAME (p);
+	COMPLETION_LIST_ADD_SYMBOL (p, sym_text, sym_text_len, text, word);
       }
   }
 
@@ -3751,12 +4154,33 @@ default_make_symbol_completion_list (char *text, char *word)
      anything that isn't a text symbol (everything else will be
      handled by the psymtab code above).  */
 
-  ALL_MSYMBOLS (objfile, msymbol)
+  ALL_OBJFILES (objfile)
   {
-    QUIT;
-    COMPLETION_LIST_ADD_SYMBOL (msymbol, sym_text, sym_text_len, text, word);
-    
-    completion_list_objc_symbol (msymbol, sym_text, sym_text_len, text, word);
+    struct symbol_name_index *index = get_symbol_name_index (objfile);
+    int low, high, i;
+
+    msymbol_index_prefix_range (index, sym_text, sym_text_len, &low, &high);
+    for (i = low; i < high; i++)
+      {
+	QUIT;
+	if (i > low
+	    && strcmp (SYMBOL_NATURAL_NAME (index->msymbols[i]),
+		       SYMBOL_NATURAL_NAME (index->msymbols[i - 1])) == 0)
+	  continue;
+	COMPLETION_LIST_ADD_SYMBOL (index->msymbols[i], sym_text, sym_text_len,
+				    text, word);
+      }
+
+    /* Objective-C method names begin with "-[" or "+[", and the
+       selectors within them can be completed on too.  */
+    msymbol_index_prefix_range (index, "-", 1, &low, &high);
+    for (i = low; i < high; i++)
+      completion_list_objc_symbol (index->msymbols[i], sym_text, sym_text_len,
+				   text, word);
+    msymbol_index_prefix_range (index, "+", 1, &low, &high);
+    for (i = low; i < high; i++)
+      completion_list_objc_symbol (index->msymbols[i], sym_text, sym_text_len,
+				   text, word);
   }
 
   /* Search upwards from currently selected frame (so that we can
@@ -4494,6 +4918,10 @@ expand_line_sal (struct symtab_and_line sal)
 void
 _initialize_symtab (void)
 {
+  symbol_name_index_key
+    = register_objfile_data_with_cleanup (free_symbol_name_index);
+  observer_attach_new_objfile (pc_line_cache_new_objfile);
+
   add_info ("variables", variables_info, _("\
 All global and static variable names, or those matching REGEXP."));
   if (dbx_commands)
@@ -796,6 +796,12 @@ struct symtab
 
   struct objfile *objfile;
 
+  /* Whether the items of LINETABLE are in ascending order of pc, so
+     that find_pc_sect_line can binary search them: zero if not known
+     yet, positive if they are and negative if they are not.  */
+
+  int linetable_sorted;
+
 };
 
 #define BLOCKVECTOR(symtab)	(symtab)->blockvector
@@ -1069,6 +1075,10 @@ extern struct partial_symbol *find_pc_psymbol (struct partial_symtab *,
 extern struct partial_symbol *find_pc_sect_psymbol (struct partial_symtab *,
 						    CORE_ADDR, asection *);
 
+/* Set *STARTPTR and *ENDPTR to the range of addresses of the source
+   line containing PC.  Return zero if there is no line number
+   information for PC.  */
+
 extern int find_pc_line_pc_range (CORE_ADDR, CORE_ADDR *, CORE_ADDR *);
 
 extern void reread_symbols (void);
@@ -1234,6 +1244,12 @@ extern void free_symtab (struct symtab *);
 
 extern struct symtab *psymtab_to_symtab (struct partial_symtab *);
 
+extern void queue_psymtab_prefetch (struct partial_symtab *);
+
+extern void forget_psymtab_prefetches (struct objfile *);
+
+extern void clear_pc_line_cache (void);
+
 extern void clear_solib (void);
 
 /* source.c */
@@ -54,6 +54,10 @@ static int default_watchpoint_addr_within_range (struct target_ops *,
 
 static int default_region_ok_for_hw_watchpoint (CORE_ADDR, int);
 
+static void default_insert_breakpoints (struct bp_target_info **, int, int *);
+
+static void default_remove_breakpoints (struct bp_target_info **, int, int *);
+
 static int nosymbol (char *, CORE_ADDR *);
 
 static void tcomplain (void) ATTR_NORETURN;
@@ -120,6 +124,10 @@ static int debug_to_insert_breakpoint (struct bp_target_info *);
 
 static int debug_to_remove_breakpoint (struct bp_target_info *);
 
+static void debug_to_insert_breakpoints (struct bp_target_info **, int, int *);
+
+static void debug_to_remove_breakpoints (struct bp_target_info **, int, int *);
+
 static int debug_to_can_use_hw_breakpoint (int, int, int);
 
 static int debug_to_insert_hw_breakpoint (struct bp_target_info *);
@@ -413,10 +421,14 @@ update_current_target (void)
       INHERIT (to_fetch_registers, t);
       INHERIT (to_store_registers, t);
       INHERIT (to_prepare_to_store, t);
+      INHERIT (to_prefetch_registers, t);
       INHERIT (deprecated_xfer_memory, t);
       INHERIT (to_files_info, t);
       INHERIT (to_insert_breakpoint, t);
       INHERIT (to_remove_breakpoint, t);
+      INHERIT (to_insert_breakpoints, t);
+      INHERIT (to_remove_breakpoints, t);
+      INHERIT (to_supports_evaluation_of_breakpoint_conditions, t);
       INHERIT (to_can_use_hw_breakpoint, t);
       INHERIT (to_insert_hw_breakpoint, t);
       INHERIT (to_remove_hw_breakpoint, t);
@@ -522,6 +534,9 @@ update_current_target (void)
   de_fault (to_prepare_to_store,
 	    (void (*) (struct regcache *))
 	    noprocess);
+  de_fault (to_prefetch_registers,
+	    (void (*) (ptid_t *, int))
+	    target_ignore);
   de_fault (deprecated_xfer_memory,
 	    (int (*) (CORE_ADDR, gdb_byte *, int, int, struct mem_attrib *, struct target_ops *))
 	    nomemory);
@@ -532,6 +547,10 @@ update_current_target (void)
 	    memory_insert_breakpoint);
   de_fault (to_remove_breakpoint,
 	    memory_remove_breakpoint);
+  de_fault (to_insert_breakpoints,
+	    default_insert_breakpoints);
+  de_fault (to_remove_breakpoints,
+	    default_remove_breakpoints);
   de_fault (to_can_use_hw_breakpoint,
 	    (int (*) (int, int, int))
 	    return_zero);
@@ -541,6 +560,9 @@ update_current_target (void)
   de_fault (to_remove_hw_breakpoint,
 	    (int (*) (struct bp_target_info *))
 	    return_minus_one);
+  de_fault (to_supports_evaluation_of_breakpoint_conditions,
+	    (int (*) (void))
+	    return_zero);
   de_fault (to_insert_watchpoint,
 	    (int (*) (CORE_ADDR, int, int))
 	    return_minus_one);
@@ -1516,6 +1538,7 @@ target_read_until_error (struct target_ops *ops,
 				      (gdb_byte *) buf + xfered, start, 1);
 	  if (xfer <= 0)
 	    return xfered;
+	  xfered += 1;
 	  start += 1;
 	  remaining -= 1;
 	  half = remaining/2;
@@ -1822,6 +1845,7 @@ target_resume (ptid_t ptid, int step, enum target_signal signal)
 {
   dcache_invalidate (target_dcache);
   (*current_target.to_resume) (ptid, step, signal);
+  registers_changed_ptid (ptid);
   set_executing (ptid, 1);
   set_running (ptid, 1);
 }
@@ -2145,6 +2169,31 @@ find_default_is_async_p (void)
   return 0;
 }
 
+/* Insert the breakpoints in BP_TGTS one at a time, for targets which
+   have no faster way.  */
+
+static void
+default_insert_breakpoints (struct bp_target_info **bp_tgts, int count,
+			    int *results)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    results[i] = target_insert_breakpoint (bp_tgts[i]);
+}
+
+/* Likewise, remove the breakpoints in BP_TGTS one at a time.  */
+
+static void
+default_remove_breakpoints (struct bp_target_info **bp_tgts, int count,
+			    int *results)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    results[i] = target_remove_breakpoint (bp_tgts[i]);
+}
+
 static int
 default_region_ok_for_hw_watchpoint (CORE_ADDR addr, int len)
 {
@@ -2206,6 +2255,7 @@ target_resize_to_sections (struct target_ops *target, int num_added)
 	xmalloc ((sizeof (struct section_table)) * num_added);
     }
   target->to_sections_end = target->to_sections + (num_added + old_count);
+  target_sections_changed ();
 
   /* Check to see if anyone else was pointing to this structure.
      If old_value was null, then no one was. */
@@ -2668,6 +2718,36 @@ debug_to_remove_breakpoint (struct bp_target_info *bp_tgt)
   return retval;
 }
 
+static void
+debug_to_insert_breakpoints (struct bp_target_info **bp_tgts, int count,
+			     int *results)
+{
+  int i;
+
+  debug_target.to_insert_breakpoints (bp_tgts, count, results);
+
+  for (i = 0; i < count; i++)
+    fprintf_unfiltered (gdb_stdlog,
+			"target_insert_breakpoints (0x%lx, xxx) = %ld\n",
+			(unsigned long) bp_tgts[i]->placed_address,
+			(unsigned long) results[i]);
+}
+
+static void
+debug_to_remove_breakpoints (struct bp_target_info **bp_tgts, int count,
+			     int *results)
+{
+  int i;
+
+  debug_target.to_remove_breakpoints (bp_tgts, count, results);
+
+  for (i = 0; i < count; i++)
+    fprintf_unfiltered (gdb_stdlog,
+			"target_remove_breakpoints (0x%lx, xxx) = %ld\n",
+			(unsigned long) bp_tgts[i]->placed_address,
+			(unsigned long) results[i]);
+}
+
 static int
 debug_to_can_use_hw_breakpoint (int type, int cnt, int from_tty)
 {
@@ -3080,6 +3160,8 @@ setup_target_debug (void)
   current_target.to_files_info = debug_to_files_info;
   current_target.to_insert_breakpoint = debug_to_insert_breakpoint;
   current_target.to_remove_breakpoint = debug_to_remove_breakpoint;
+  current_target.to_insert_breakpoints = debug_to_insert_breakpoints;
+  current_target.to_remove_breakpoints = debug_to_remove_breakpoints;
   current_target.to_can_use_hw_breakpoint = debug_to_can_use_hw_breakpoint;
   current_target.to_insert_hw_breakpoint = debug_to_insert_hw_breakpoint;
   current_target.to_remove_hw_breakpoint = debug_to_remove_hw_breakpoint;
@@ -332,6 +332,10 @@ struct target_ops
     void (*to_fetch_registers) (struct regcache *, int);
     void (*to_store_registers) (struct regcache *, int);
     void (*to_prepare_to_store) (struct regcache *);
+    /* Fill in the register caches of the COUNT stopped threads in
+       PTIDS, in as few operations as the target can.  This is only a
+       hint; registers it does not fetch are fetched when needed.  */
+    void (*to_prefetch_registers) (ptid_t *ptids, int count);
 
     /* Transfer LEN bytes of memory between GDB address MYADDR and
        target address MEMADDR.  If WRITE, transfer them to the target, else
@@ -362,6 +366,9 @@ struct target_ops
     void (*to_files_info) (struct target_ops *);
     int (*to_insert_breakpoint) (struct bp_target_info *);
     int (*to_remove_breakpoint) (struct bp_target_info *);
+    void (*to_insert_breakpoints) (struct bp_target_info **, int, int *);
+    void (*to_remove_breakpoints) (struct bp_target_info **, int, int *);
+    int (*to_supports_evaluation_of_breakpoint_conditions) (void);
     int (*to_can_use_hw_breakpoint) (int, int, int);
     int (*to_insert_hw_breakpoint) (struct bp_target_info *);
     int (*to_remove_hw_breakpoint) (struct bp_target_info *);
@@ -624,6 +631,12 @@ extern void target_resume (ptid_t ptid, int step, enum target_signal signal);
 #define	target_store_registers(regcache, regs)	\
      (*current_target.to_store_registers) (regcache, regs)
 
+/* Fetch the registers of the COUNT threads in PTIDS ahead of their
+   use, if the target can do so faster than one thread at a time.  */
+
+#define	target_prefetch_registers(ptids, count)	\
+     (*current_target.to_prefetch_registers) (ptids, count)
+
 /* Get ready to modify the registers array.  On machines which store
    individual registers, this doesn't need to do anything.  On machines
    which store all the registers in one fell swoop, this makes sure
@@ -730,6 +743,27 @@ extern void print_section_info (struct target_ops *, bfd *);
 #define	target_remove_breakpoint(bp_tgt)	\
      (*current_target.to_remove_breakpoint) (bp_tgt)
 
+/* Insert COUNT breakpoints at once, described by the array BP_TGTS.
+   RESULTS[I] is set to what target_insert_breakpoint would have
+   returned for BP_TGTS[I].  Targets for which each insertion is
+   costly, e.g. a round trip to a remote stub, can do them all
+   together.  */
+
+#define target_insert_breakpoints(bp_tgts, count, results)	\
+     (*current_target.to_insert_breakpoints) (bp_tgts, count, results)
+
+/* Likewise, remove COUNT breakpoints at once.  */
+
+#define target_remove_breakpoints(bp_tgts, count, results)	\
+     (*current_target.to_remove_breakpoints) (bp_tgts, count, results)
+
+/* Returns non-zero if the target can evaluate the condition in
+   BP_TGT->cond_bytecode itself when a breakpoint is hit, and only
+   report hits for which it is true.  */
+
+#define target_supports_evaluation_of_breakpoint_conditions() \
+     (*current_target.to_supports_evaluation_of_breakpoint_conditions) ()
+
 /* Initialize the terminal settings we record for the inferior,
    before we actually run the inferior.  */
 
@@ -1202,6 +1236,10 @@ struct section_table
 struct section_table *target_section_by_addr (struct target_ops *target,
 					      CORE_ADDR addr);
 
+/* Call this whenever a section table is built or resized, or the
+   addresses of its sections change.  */
+extern void target_sections_changed (void);
+
 
 /* From mem-break.c */
 
@@ -1213,6 +1251,26 @@ extern int default_memory_remove_breakpoint (struct gdbarch *, struct bp_target_
 
 extern int default_memory_insert_breakpoint (struct gdbarch *, struct bp_target_info *);
 
+extern void memory_insert_breakpoints (struct bp_target_info **, int, int *);
+
+extern void memory_remove_breakpoints (struct bp_target_info **, int, int *);
+
+extern void default_memory_insert_breakpoints (struct gdbarch *,
+					       struct bp_target_info **,
+					       int, int *);
+
+extern void default_memory_remove_breakpoints (struct gdbarch *,
+					       struct bp_target_info **,
+					       int, int *);
+
+extern void simple_memory_insert_breakpoints (struct gdbarch *,
+					      struct bp_target_info **,
+					      int, int *);
+
+extern void simple_memory_remove_breakpoints (struct gdbarch *,
+					      struct bp_target_info **,
+					      int, int *);
+
 
 /* From target.c */
 
@@ -0,0 +1,117 @@
+/* Test program for stepping over breakpoints on ARM and Thumb
+   instructions which use the PC, by executing copies of them.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+int arm_alu_pc (void);
+int arm_mov_pc (void);
+int arm_ldr_pc_reg (void);
+int thumb_cbz (int);
+int thumb_it (int);
+
+int results[7];
+
+int
+main (void)
+{
+  results[0] = arm_alu_pc ();
+  results[1] = arm_mov_pc ();
+  results[2] = arm_ldr_pc_reg ();
+  results[3] = thumb_cbz (0);
+  results[4] = thumb_cbz (5);
+  results[5] = thumb_it (1);
+  results[6] = thumb_it (0);
+
+  return 0;	/* done */
+}
+
+/* Each function has a breakpoint put on the instruction at its
+   ..._insn label.  */
+
+asm ("       .text\n"
+     "       .syntax unified\n"
+     "       .arm\n"
+
+     /* The offset of the PC read by an ALU instruction: 12.  */
+     "       .global arm_alu_pc\n"
+     "       .type arm_alu_pc, %function\n"
+     "arm_alu_pc:\n"
+     "       .global arm_alu_pc_insn\n"
+     "arm_alu_pc_insn:\n"
+     "       add r0, pc, #4\n"
+     "       adr r1, arm_alu_pc_insn\n"
+     "       sub r0, r0, r1\n"
+     "       bx lr\n"
+
+     /* The offset of the PC read by MOV, which has no Rn: 8.  */
+     "       .global arm_mov_pc\n"
+     "       .type arm_mov_pc, %function\n"
+     "arm_mov_pc:\n"
+     "       .global arm_mov_pc_insn\n"
+     "arm_mov_pc_insn:\n"
+     "       mov r0, pc\n"
+     "       adr r1, arm_mov_pc_insn\n"
+     "       sub r0, r0, r1\n"
+     "       bx lr\n"
+
+     /* A load from the PC plus a register: 42.  */
+     "       .global arm_ldr_pc_reg\n"
+     "       .type arm_ldr_pc_reg, %function\n"
+     "arm_ldr_pc_reg:\n"
+     "       mov r3, #8\n"
+     "       .global arm_ldr_pc_reg_insn\n"
+     "arm_ldr_pc_reg_insn:\n"
+     "       ldr r0, [pc, r3]\n"
+     "       bx lr\n"
+     "       nop\n"
+     "       nop\n"
+     "       .word 42\n"
+
+     "       .thumb\n"
+
+     /* 2 if the argument is zero, 1 otherwise.  */
+     "       .global thumb_cbz\n"
+     "       .type thumb_cbz, %function\n"
+     "       .thumb_func\n"
+     "thumb_cbz:\n"
+     "       .global thumb_cbz_insn\n"
+     "thumb_cbz_insn:\n"
+     "       cbz r0, 1f\n"
+     "       movs r0, #1\n"
+     "       bx lr\n"
+     "1:\n"
+     "       movs r0, #2\n"
+     "       bx lr\n"
+
+     /* 5 if the argument is one, 0 otherwise.  */
+     "       .global thumb_it\n"
+     "       .type thumb_it, %function\n"
+     "       .thumb_func\n"
+     "thumb_it:\n"
+     "       movs r1, #0\n"
+     "       cmp r0, #1\n"
+     "       .global thumb_it_insn\n"
+     "thumb_it_insn:\n"
+     "       it eq\n"
+     "       .global thumb_it_body_insn\n"
+     "thumb_it_body_insn:\n"
+     "       moveq r1, #5\n"
+     "       mov r0, r1\n"
+     "       bx lr\n"
+
+     "       .arm\n");
@@ -0,0 +1,44 @@
+/* Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Recurse 10000 levels deep, so that a core of the process has a
+   long stack to unwind.  */
+
+int depth;
+
+void
+marker (void)
+{
+}
+
+void
+recurse (int n)
+{
+  depth++;
+  if (n == 0)
+    marker ();
+  else
+    recurse (n - 1);
+  depth--;
+}
+
+int
+main (void)
+{
+  recurse (9999);
+  return 0;
+}
@@ -0,0 +1,42 @@
+/* A function with one statement per line, for looking up the lines of
+   pcs with "info line".
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+int counter;
+
+void
+bump (int n)
+{
+  counter += n;		/* line-one */
+  counter *= n;		/* line-two */
+  counter -= n;		/* line-three */
+  if (counter > 100)	/* line-four */
+    counter = 0;	/* line-five */
+  counter ^= n;		/* line-six */
+}
+
+int
+main (void)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    bump (i);		/* line-main */
+  return 0;
+}
@@ -0,0 +1,51 @@
+/* Symbols with common prefixes, for testing completion and regexp
+   searches.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+extern int symidx_beta (int);
+extern int symidx_other_dup (void);
+extern int symidx_nodebug_func (int);
+
+int symidx_var_one = 1;
+int symidx_var_two = 2;
+
+static int
+symidx_dup (void)
+{
+  return 0;
+}
+
+int
+symidx_alpha (int x)
+{
+  return x + symidx_dup ();
+}
+
+int
+symidx_alpine (int x)
+{
+  return x * 2;
+}
+
+int
+main (void)
+{
+  return symidx_alpha (symidx_var_one) + symidx_alpine (symidx_var_two)
+	 + symidx_beta (0) + symidx_other_dup () + symidx_nodebug_func (0);
+}
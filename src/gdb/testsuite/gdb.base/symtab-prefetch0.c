@@ -0,0 +1,38 @@
+/* A program whose frames span several compilation units, for testing
+   "set symtab-prefetch".
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+extern void hidden_caller (void);
+extern void shown_caller (void);
+
+int inner_calls;
+
+void
+inner (int which)
+{
+  inner_calls += which;
+}
+
+int
+main (void)
+{
+  hidden_caller ();
+  shown_caller ();
+  return 0;
+}
@@ -0,0 +1,59 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <signal.h>
+#include <stdlib.h>
+
+char big[16384];
+char neighbor[64];
+char flags[8];
+
+int counter;
+
+/* The alternate signal stack, in memory of its own.  */
+char *alt_stack;
+
+void
+touch (int i)
+{
+  big[i] = 1;
+}
+
+int
+main (void)
+{
+  stack_t ss;
+  int i;
+
+  alt_stack = malloc (1024 * 1024);
+  ss.ss_sp = alt_stack;
+  ss.ss_size = 1024 * 1024;
+  ss.ss_flags = 0;
+  sigaltstack (&ss, NULL);
+
+  /* Reads and writes which do not change BIG.  */
+  for (i = 0; i < 1000; i++)
+    counter += big[i % 16] + neighbor[i % 64];
+
+  touch (10000);
+
+  flags[0] = 1;
+  flags[3] = 1;
+  flags[5] = 1;
+
+  return 0;	/* done */
+}
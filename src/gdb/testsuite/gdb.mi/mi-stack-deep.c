@@ -0,0 +1,49 @@
+/* Copyright 2008 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+struct point
+{
+  int x;
+  int y;
+  char label[8];
+};
+
+int
+marker (void)
+{
+  return 0;
+}
+
+int
+recurse (int n, struct point p)
+{
+  int depth = n;
+  char name[] = "a \"quoted\"\tname";
+  struct point q = p;
+
+  q.x = n;
+  if (n == 0)
+    return marker ();
+  return recurse (n - 1, q) + depth + name[0];
+}
+
+int
+main (void)
+{
+  struct point p = { 1, 2, "deep" };
+
+  return recurse (1000, p);
+}
@@ -0,0 +1,74 @@
+/* Copyright 2008 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* -var-update does not evaluate again the children of a structure
+   that were read from bytes that did not change.  Check that changes
+   are still reported where the printed value depends on other
+   memory.  */
+
+struct S
+{
+  int a[3];
+  char *s;
+  int *p;
+};
+
+char text[4] = "abc";
+int target = 1;
+
+void struct_update ()
+{
+  /*: BEGIN: struct_update :*/
+  struct S v = {{1, 2, 3}, text, &target};
+  /*:
+    mi_create_varobj V v "create varobj for v"
+    mi_list_varobj_children V {
+        {V.a a 3 "int \\[3\\]"}
+        {V.s s 1 "char \\*"}
+        {V.p p 1 "int \\*"}
+    } "list children of v"
+    mi_list_varobj_children V.a {
+        {V.a.0 0 0 int}
+        {V.a.1 1 0 int}
+        {V.a.2 2 0 int}
+    } "list children of v.a"
+    mi_list_varobj_children V.p {
+        {V.p.\\*p \\*p 0 int}
+    } "list children of v.p"
+    :*/
+  v.a[1] = 20;
+  /*: mi_varobj_update V {V.a.1} "update V: one element changed" :*/
+  v.a[1] = 20;
+  /*: mi_varobj_update V {} "update V: nothing changed" :*/
+  text[1] = 'X';
+  /*: mi_varobj_update V {V.s} "update V: string pointed to changed"
+      mi_check_varobj_value V.s "$hex \\\\\"aXc\\\\\"" "check V.s"
+    :*/
+  target = 2;
+  /*: mi_varobj_update V {V.p.\\*p} "update V: value pointed to changed"
+      mi_check_varobj_value V.p.*p 2 "check V.p.*p"
+      mi_delete_varobj V "delete V"
+    :*/
+  v.a[0] = 0;
+  /*: END: struct_update :*/
+}
+
+int
+main ()
+{
+  struct_update ();
+  return 0;
+}
@@ -0,0 +1,41 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+int count;
+
+void func1 (int i) { count += i; }
+void func2 (int i) { count += i; }
+void func3 (int i) { count += i; }
+void func4 (int i) { count += i; }
+void func5 (int i) { count += i; }
+
+int
+main (int argc, char **argv)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      func1 (i);
+      func2 (i);
+      func3 (i);
+      func4 (i);
+      func5 (i);
+    }
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+
+volatile int done;
+int main_hits;
+
+void
+hit (int which)
+{
+  if (which)
+    main_hits++;
+}
+
+void *
+spin (void *arg)
+{
+  while (!done)
+    hit (0);
+  return NULL;
+}
+
+void
+all_done (void)
+{
+}
+
+int
+main (int argc, char **argv)
+{
+  pthread_t thread;
+  int i;
+
+  pthread_create (&thread, NULL, spin, NULL);
+
+  for (i = 0; i < 300; i++)
+    hit (1);
+
+  done = 1;
+  pthread_join (thread, NULL);
+  all_done ();
+  return 0;
+}
@@ -0,0 +1,65 @@
+/* Many threads hitting the same breakpoint.
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define NTHREADS 16
+#define NCALLS 50
+
+volatile int calls;
+
+void
+hot (void)
+{
+  __sync_fetch_and_add (&calls, 1);
+}
+
+void *
+worker (void *arg)
+{
+  int i;
+
+  for (i = 0; i < NCALLS; i++)
+    hot ();
+
+  return NULL;
+}
+
+void
+done (void)
+{
+}
+
+int
+main (void)
+{
+  pthread_t threads[NTHREADS];
+  int i;
+
+  for (i = 0; i < NTHREADS; i++)
+    if (pthread_create (&threads[i], NULL, worker, NULL) != 0)
+      abort ();
+
+  for (i = 0; i < NTHREADS; i++)
+    pthread_join (threads[i], NULL);
+
+  done ();
+  return 0;
+}
@@ -0,0 +1,83 @@
+/* Threads created in two batches, for listing with "info threads".
+
+   Copyright 2008 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+#include <limits.h>
+
+#define FIRST_THREADS 100
+#define MORE_THREADS 50
+#define NTHREADS (FIRST_THREADS + MORE_THREADS)
+
+static pthread_barrier_t barrier;
+static pthread_mutex_t hold = PTHREAD_MUTEX_INITIALIZER;
+
+static void *
+thread_function (void *arg)
+{
+  pthread_barrier_wait (&barrier);
+  pthread_mutex_lock (&hold);
+  pthread_mutex_unlock (&hold);
+  return arg;
+}
+
+void
+all_created (void)
+{
+}
+
+static void
+create_threads (pthread_t *threads, int count)
+{
+  pthread_attr_t attr;
+  int i;
+
+  pthread_attr_init (&attr);
+  pthread_attr_setstacksize (&attr, PTHREAD_STACK_MIN);
+
+  pthread_barrier_init (&barrier, NULL, count + 1);
+  for (i = 0; i < count; i++)
+    pthread_create (&threads[i], &attr, thread_function, NULL);
+
+  /* Wait until every thread is running.  */
+  pthread_barrier_wait (&barrier);
+  pthread_barrier_destroy (&barrier);
+
+  pthread_attr_destroy (&attr);
+}
+
+int
+main (void)
+{
+  pthread_t threads[NTHREADS];
+  int i;
+
+  pthread_mutex_lock (&hold);
+
+  create_threads (threads, FIRST_THREADS);
+  all_created ();
+
+  create_threads (threads + FIRST_THREADS, MORE_THREADS);
+  all_created ();
+
+  pthread_mutex_unlock (&hold);
+  for (i = 0; i < NTHREADS; i++)
+    pthread_join (threads[i], NULL);
+
+  return 0;
+}
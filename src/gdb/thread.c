@@ -42,6 +42,8 @@
 #include "observer.h"
 #include "annotate.h"
 #include "cli/cli-decode.h"
+#include "gdb_assert.h"
+#include "hashtab.h"
 
 /* Definition of struct thread_info exported to gdbthread.h */
 
@@ -54,6 +56,13 @@ void _initialize_thread (void);
 static struct thread_info *thread_list = NULL;
 static int highest_thread_num;
 
+/* The threads of THREAD_LIST, hashed by ptid, so that looking up a
+   thread does not take time proportional to the number of threads.
+   If several threads have the same ptid (an exited thread that could
+   not be deleted yet, and its replacement), the table holds the most
+   recently added one, which is also the first on THREAD_LIST.  */
+static htab_t thread_ptid_table;
+
 static void thread_command (char *tidstr, int from_tty);
 static void thread_apply_all_command (char *, int);
 static int thread_alive (struct thread_info *);
@@ -74,6 +83,69 @@ enum thread_state
 static enum thread_state main_thread_state = THREAD_STOPPED;
 static int main_thread_executing = 0;
 
+static hashval_t
+hash_thread_ptid (const void *p)
+{
+  const struct thread_info *tp = p;
+
+  return ((ptid_get_pid (tp->ptid) * 31
+	   + ptid_get_lwp (tp->ptid)) * 31
+	  + ptid_get_tid (tp->ptid));
+}
+
+static int
+eq_thread_ptid (const void *a, const void *b)
+{
+  const struct thread_info *ta = a;
+  const struct thread_info *tb = b;
+
+  return ptid_equal (ta->ptid, tb->ptid);
+}
+
+/* Enter TP, which has just been added to THREAD_LIST or given a new
+   ptid, in THREAD_PTID_TABLE.  */
+
+static void
+thread_ptid_table_add (struct thread_info *tp)
+{
+  void **slot;
+
+  if (thread_ptid_table == NULL)
+    thread_ptid_table = htab_create_alloc (64, hash_thread_ptid,
+					   eq_thread_ptid, NULL,
+					   xcalloc, xfree);
+
+  slot = htab_find_slot (thread_ptid_table, tp, INSERT);
+  *slot = tp;
+}
+
+/* Remove TP, which is about to be unlinked from THREAD_LIST or given a
+   new ptid, from THREAD_PTID_TABLE.  If another thread has the same
+   ptid, it takes TP's place.  */
+
+static void
+thread_ptid_table_remove (struct thread_info *tp)
+{
+  struct thread_info *other;
+  void **slot;
+
+  if (thread_ptid_table == NULL)
+    return;
+
+  slot = htab_find_slot (thread_ptid_table, tp, NO_INSERT);
+  if (slot == NULL || *slot != tp)
+    return;
+
+  for (other = thread_list; other; other = other->next)
+    if (other != tp && ptid_equal (other->ptid, tp->ptid))
+      break;
+
+  if (other != NULL)
+    *slot = other;
+  else
+    htab_clear_slot (thread_ptid_table, slot);
+}
+
 void
 delete_step_resume_breakpoint (void *arg)
 {
@@ -139,6 +211,7 @@ init_thread_list (void)
     }
 
   thread_list = NULL;
+  htab_empty (thread_ptid_table);
 }
 
 struct thread_info *
@@ -169,6 +242,7 @@ add_thread_silent (ptid_t ptid)
 	  tp->num = ++highest_thread_num;
 	  tp->next = thread_list;
 	  thread_list = tp;
+	  thread_ptid_table_add (tp);
 	  context_switch_to (minus_one_ptid);
 
 	  /* Now we can delete it.  */
@@ -176,7 +250,9 @@ add_thread_silent (ptid_t ptid)
 
 	  /* Since the context is already set to this new thread,
 	     reset its ptid, and reswitch inferior_ptid to it.  */
+	  thread_ptid_table_remove (tp);
 	  tp->ptid = ptid;
+	  thread_ptid_table_add (tp);
 	  switch_to_thread (ptid);
 
 	  observer_notify_new_thread (tp);
@@ -195,6 +271,7 @@ add_thread_silent (ptid_t ptid)
   tp->num = ++highest_thread_num;
   tp->next = thread_list;
   thread_list = tp;
+  thread_ptid_table_add (tp);
 
   observer_notify_new_thread (tp);
 
@@ -259,6 +336,7 @@ delete_thread_1 (ptid_t ptid, int silent)
        return;
      }
 
+  thread_ptid_table_remove (tp);
   if (tpprev)
     tpprev->next = tp->next;
   else
@@ -287,6 +365,18 @@ delete_thread_silent (ptid_t ptid)
   delete_thread_1 (ptid, 1 /* silent */);
 }
 
+void
+thread_change_ptid (ptid_t old_ptid, ptid_t new_ptid)
+{
+  struct thread_info *tp = find_thread_pid (old_ptid);
+
+  gdb_assert (tp != NULL);
+
+  thread_ptid_table_remove (tp);
+  tp->ptid = new_ptid;
+  thread_ptid_table_add (tp);
+}
+
 struct thread_info *
 find_thread_id (int num)
 {
@@ -303,13 +393,13 @@ find_thread_id (int num)
 struct thread_info *
 find_thread_pid (ptid_t ptid)
 {
-  struct thread_info *tp;
+  struct thread_info key;
 
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return tp;
+  if (thread_ptid_table == NULL)
+    return NULL;
 
-  return NULL;
+  key.ptid = ptid;
+  return htab_find (thread_ptid_table, &key);
 }
 
 /*
@@ -369,11 +459,10 @@ valid_thread_id (int num)
 int
 pid_to_thread_id (ptid_t ptid)
 {
-  struct thread_info *tp;
+  struct thread_info *tp = find_thread_pid (ptid);
 
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return tp->num;
+  if (tp)
+    return tp->num;
 
   return 0;
 }
@@ -391,13 +480,7 @@ thread_id_to_pid (int num)
 int
 in_thread_list (ptid_t ptid)
 {
-  struct thread_info *tp;
-
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return 1;
-
-  return 0;			/* Never heard of 'im */
+  return find_thread_pid (ptid) != NULL;
 }
 
 /* Print a list of thread ids currently known, and the total number of
@@ -749,6 +832,37 @@ set_executing (ptid_t ptid, int executing)
     }
 }
 
+/* Ask the target to fetch the registers of all the stopped threads
+   at once, before a command visits each of them in turn.  */
+
+static void
+prefetch_thread_registers (void)
+{
+  struct thread_info *tp;
+  struct cleanup *old_chain;
+  ptid_t *ptids;
+  int count = 0;
+
+  if (!target_has_execution)
+    return;
+
+  for (tp = thread_list; tp; tp = tp->next)
+    count++;
+  if (count < 2)
+    return;
+
+  ptids = xmalloc (count * sizeof (ptid_t));
+  old_chain = make_cleanup (xfree, ptids);
+
+  count = 0;
+  for (tp = thread_list; tp; tp = tp->next)
+    if (tp->state_ != THREAD_EXITED && !tp->executing_)
+      ptids[count++] = tp->ptid;
+
+  target_prefetch_registers (ptids, count);
+  do_cleanups (old_chain);
+}
+
 /* Prints the list of threads and their details on UIOUT.
    This is a version of 'info_thread_command' suitable for
    use from MI.  
@@ -766,6 +880,7 @@ print_thread_info (struct ui_out *uiout, int requested_thread)
 
   prune_threads ();
   target_find_new_threads ();
+  prefetch_thread_registers ();
   current_ptid = inferior_ptid;
 
   /* We'll be switching threads temporarily.  */
@@ -874,9 +989,10 @@ switch_to_thread (ptid_t ptid)
   if (ptid_equal (ptid, inferior_ptid))
     return;
 
+  /* Each thread has its own register cache, valid until the thread
+     is resumed; only the frame chain belongs to the old thread.  */
   inferior_ptid = ptid;
   reinit_frame_cache ();
-  registers_changed ();
 
   /* We don't check for is_stopped, because we're called at times
      while in the TARGET_RUNNING state, e.g., while handling an
@@ -1042,6 +1158,7 @@ thread_apply_all_command (char *cmd, int from_tty)
 
   prune_threads ();
   target_find_new_threads ();
+  prefetch_thread_registers ();
 
   old_chain = make_cleanup_restore_current_thread ();
 
@@ -122,6 +122,10 @@ static struct symtab_and_line traceframe_sal;
 /* Tracing command lists */
 static struct cmd_list_element *tfindlist;
 
+/* The size of the trace buffer to ask the target for, in bytes, or
+   -1 to leave it to the target.  */
+static int trace_buffer_size = -1;
+
 /* ======= Important command functions: ======= */
 static void trace_command (char *, int);
 static void tracepoints_info (char *, int);
@@ -1595,11 +1599,17 @@ encode_actions (struct tracepoint *t, char ***tdp_actions,
 		      break;
 
 		    case OP_VAR_VALUE:
-		      collect_symbol (collect,
-				      exp->elts[2].symbol,
-				      frame_reg,
-				      frame_offset);
-		      break;
+		      /* Only the symbol's own methods know where a
+			 computed location is; have them compile it.  */
+		      if (SYMBOL_CLASS (exp->elts[2].symbol) != LOC_COMPUTED)
+			{
+			  collect_symbol (collect,
+					  exp->elts[2].symbol,
+					  frame_reg,
+					  frame_offset);
+			  break;
+			}
+		      /* Fall through.  */
 
 		    default:	/* full-fledged expression */
 		      aexpr = gen_trace_for_expr (t->address, exp);
@@ -1819,6 +1829,14 @@ trace_start_command (char *args, int from_tty)
       }
       /* Tell target to treat text-like sections as transparent.  */
       remote_set_transparent_ranges ();
+      if (trace_buffer_size >= 0)
+	{
+	  sprintf (buf, "QTBuffer:size:%x", trace_buffer_size);
+	  putpkt (buf);
+	  getpkt (&target_buf, &target_buf_size, 0);
+	  if (strcmp (target_buf, "OK"))
+	    warning (_("Target does not support setting the trace buffer size."));
+	}
       /* Now insert traps and begin collecting data.  */
       putpkt ("QTStart");
       remote_get_noisy_reply (&target_buf, &target_buf_size);
@@ -1871,6 +1889,54 @@ trace_status_command (char *args, int from_tty)
 
       /* exported for use by the GUI */
       trace_running_p = (target_buf[1] == '1');
+
+      if (from_tty)
+	{
+	  char *p = target_buf + 2;
+	  unsigned long frames = 0, created = 0, tfree = 0, tsize = 0;
+	  int have_counts = 0;
+
+	  printf_filtered (trace_running_p
+			   ? _("Trace is running on the target.\n")
+			   : _("Trace is not running on the target.\n"));
+
+	  /* The target may say how much it has collected, as a list of
+	     ";NAME:HEXVALUE" items.  */
+	  while (*p == ';')
+	    {
+	      char *name = ++p;
+	      unsigned long val;
+
+	      p = strchr (p, ':');
+	      if (p == NULL)
+		break;
+	      val = strtoul (p + 1, &p, 16);
+	      if (strncmp (name, "tframes:", 8) == 0)
+		{
+		  frames = val;
+		  have_counts = 1;
+		}
+	      else if (strncmp (name, "tcreated:", 9) == 0)
+		created = val;
+	      else if (strncmp (name, "tfree:", 6) == 0)
+		tfree = val;
+	      else if (strncmp (name, "tsize:", 6) == 0)
+		tsize = val;
+	    }
+
+	  if (have_counts)
+	    {
+	      printf_filtered (_("Collected %lu trace frames"), frames);
+	      if (created > frames)
+		printf_filtered (_(" (%lu discarded to make room)"),
+				 created - frames);
+	      printf_filtered (".\n");
+	      if (tsize != 0)
+		printf_filtered (_("\
+Trace buffer has %lu bytes of %lu bytes free.\n"),
+				 tfree, tsize);
+	    }
+	}
     }
   else
     error (_("Trace can only be run on remote targets."));
@@ -2753,6 +2819,16 @@ De-select any trace frame and resume 'live' debugging."),
 	   _("Select the first trace frame in the trace buffer."),
 	   &tfindlist);
 
+  add_setshow_zinteger_cmd ("trace-buffer-size", class_trace,
+			    &trace_buffer_size, _("\
+Set the size of the trace buffer requested from the target."), _("\
+Show the size of the trace buffer requested from the target."), _("\
+The size is in bytes, and takes effect at the next \"tstart\".  When the\n\
+buffer fills, the target discards the oldest trace frames to make room.\n\
+A negative size lets the target choose."),
+			    NULL, NULL,
+			    &setlist, &showlist);
+
   add_com ("tstatus", class_trace, trace_status_command,
 	   _("Display the status of the current trace data collection."));
 
@@ -158,6 +158,11 @@ struct varobj
      not fetched if either the variable is frozen, or any parents is
      frozen.  */
   int not_fetched;
+
+  /* Set by -var-update of the parent when the bytes this variable's
+     value was read from are the same as before.  The value need not be
+     evaluated again in that case.  */
+  int unchanged_in_parent;
 };
 
 struct cpstack
@@ -214,6 +219,15 @@ static char *cppop (struct cpstack **pstack);
 static int install_new_value (struct varobj *var, struct value *value, 
 			      int initial);
 
+static int value_print_from_contents_p (struct varobj *var,
+				       struct value *value);
+
+static LONGEST children_bytes_read (struct varobj *var);
+
+static void mark_unchanged_children (struct varobj *var,
+				     struct value *old_value,
+				     struct value *new_value);
+
 /* Language-specific routines. */
 
 static enum varobj_languages variable_language (struct varobj *var);
@@ -402,6 +416,10 @@ static int rootcount = 0;	/* number of root varobjs in the list */
 /* A prime large enough to avoid too many colisions */
 #define VAROBJ_TABLE_SIZE 227
 
+/* The largest structure or array whose value is read in full when its
+   children are updated, however few of its bytes they need.  */
+#define VAROBJ_BULK_FETCH_MAX 1024
+
 /* Pointer to the varobj hash table (built at run time) */
 static struct vlist **varobj_table;
 
@@ -1045,11 +1063,50 @@ install_new_value (struct varobj *var, struct value *value, int initial)
 	}
     }
 
+  /* For a structure or array with children, fetch the whole value
+     with one read.  This is both cheaper than reading each child
+     separately and lets us find the children whose bytes did not
+     change, see mark_unchanged_children.  Only do so if the value is
+     small, or if updating the children would read most of it anyway;
+     a large array of which a few elements are shown must not be read
+     in full.  If the read fails, leave the value lazy so that each
+     child still gets what can be read of it.  */
+  if (!initial && !changeable && value && value_lazy (value)
+      && !VEC_empty (varobj_p, var->children))
+    {
+      struct varobj *parent;
+      int frozen = var->frozen;
+      LONGEST len = TYPE_LENGTH (check_typedef (value_type (value)));
+
+      for (parent = var->parent; !frozen && parent; parent = parent->parent)
+	frozen |= parent->frozen;
+
+      if (!frozen
+	  && (len <= VAROBJ_BULK_FETCH_MAX
+	      || 2 * children_bytes_read (var) >= len))
+	gdb_value_fetch_lazy (value);
+    }
+
+  /* If the new value has the same contents as the old one, and its
+     printed form depends on nothing else, reuse the old string
+     rendering instead of producing it again.  */
+  if (!initial && changeable && !var->updated
+      && var->value && !value_lazy (var->value)
+      && value && !value_lazy (value)
+      && var->print_value
+      && value_print_from_contents_p (var, var->value)
+      && value_type (var->value) == value_type (value)
+      && !value_optimized_out (var->value) && !value_optimized_out (value)
+      && value_contents_equal (var->value, value))
+    {
+      print_value = var->print_value;
+      var->print_value = NULL;
+    }
   /* Below, we'll be comparing string rendering of old and new
      values.  Don't get string rendering if the value is
      lazy -- if it is, the code above has decided that the value
-     should not be fetched.  */
-  if (value && !value_lazy (value))
+     should not be fetched.  Only changeable values are printed.  */
+  else if (changeable && value && !value_lazy (value))
       print_value = value_get_print_value (value, var->format);
 
   /* If the type is changeable, compare the old and the new values.
@@ -1090,13 +1147,21 @@ install_new_value (struct varobj *var, struct value *value, int initial)
 	      gdb_assert (!value_lazy (var->value));
 	      gdb_assert (!value_lazy (value));
 
-	      gdb_assert (var->print_value != NULL && print_value != NULL);
-	      if (strcmp (var->print_value, print_value) != 0)
+	      /* A NULL var->print_value means that print_value was
+		 taken over from it above, since the contents are the
+		 same.  */
+	      gdb_assert (print_value != NULL);
+	      if (var->print_value != NULL
+		  && strcmp (var->print_value, print_value) != 0)
 		changed = 1;
 	    }
 	}
     }
 
+  if (!initial && !changeable && var->value != NULL && value != NULL
+      && var->value != value)
+    mark_unchanged_children (var, var->value, value);
+
   /* We must always keep the new value, since children depend on it.  */
   if (var->value != NULL && var->value != value)
     value_free (var->value);
@@ -1115,6 +1180,139 @@ install_new_value (struct varobj *var, struct value *value, int initial)
   return changed;
 }
 
+/* Return non-zero if the string rendering of VALUE, as shown for VAR,
+   is determined by the contents of VALUE alone, so that values with
+   the same contents always print the same.  This is not so for
+   pointers in natural format, which may be printed along with the
+   string or the virtual table they point to.  */
+
+static int
+value_print_from_contents_p (struct varobj *var, struct value *value)
+{
+  struct type *type = check_typedef (value_type (value));
+
+  if (TYPE_CODE (type) == TYPE_CODE_PTR && var->format == FORMAT_NATURAL)
+    {
+      struct type *target = check_typedef (TYPE_TARGET_TYPE (type));
+
+      switch (TYPE_CODE (target))
+	{
+	case TYPE_CODE_INT:
+	case TYPE_CODE_CHAR:
+	case TYPE_CODE_PTR:
+	case TYPE_CODE_ARRAY:
+	  return 0;
+	default:
+	  break;
+	}
+    }
+
+  return 1;
+}
+
+/* Return how many bytes of the value of VAR, a structure, union or
+   array, updating its children reads: all of each child whose value
+   is compared or which is a union, and what the children of each other
+   child read of it.  */
+
+static LONGEST
+children_bytes_read (struct varobj *var)
+{
+  LONGEST bytes = 0;
+  int i;
+
+  for (i = 0; i < VEC_length (varobj_p, var->children); ++i)
+    {
+      struct varobj *child = VEC_index (varobj_p, var->children, i);
+
+      if (child == NULL)
+	continue;
+
+      if (child->type != NULL
+	  && (varobj_value_is_changeable_p (child)
+	      || TYPE_CODE (check_typedef (child->type)) == TYPE_CODE_UNION))
+	bytes += TYPE_LENGTH (check_typedef (child->type));
+      else
+	bytes += children_bytes_read (child);
+    }
+
+  return bytes;
+}
+
+/* VAR, a structure, union or array, is about to get NEW_VALUE in place
+   of OLD_VALUE.  Flag the children of VAR whose values were read from
+   bytes of OLD_VALUE that are the same in NEW_VALUE; such children
+   cannot have changed, and varobj_update will not evaluate them again.
+   Children reached through a pointer, bitfields, children in registers
+   and children whose printed form depends on more than their bytes are
+   never flagged.
+
+   If OLD_VALUE and NEW_VALUE are the same value, VAR itself is known
+   not to have changed, and all children read from its bytes are
+   flagged.  */
+
+static void
+mark_unchanged_children (struct varobj *var, struct value *old_value,
+			 struct value *new_value)
+{
+  CORE_ADDR addr;
+  int len;
+  int i;
+
+  if (VALUE_LVAL (old_value) != lval_memory
+      || value_bitsize (old_value) != 0)
+    return;
+
+  addr = VALUE_ADDRESS (old_value) + value_offset (old_value);
+  len = TYPE_LENGTH (value_type (old_value));
+
+  if (old_value != new_value)
+    {
+      /* Compare the bytes of the two values at the same address.  */
+      if (value_lazy (old_value) || value_lazy (new_value)
+	  || VALUE_LVAL (new_value) != lval_memory
+	  || value_bitsize (new_value) != 0
+	  || VALUE_ADDRESS (new_value) + value_offset (new_value) != addr
+	  || value_type (new_value) != value_type (old_value))
+	return;
+    }
+
+  for (i = 0; i < VEC_length (varobj_p, var->children); ++i)
+    {
+      struct varobj *child = VEC_index (varobj_p, var->children, i);
+      struct value *cv;
+      CORE_ADDR child_addr;
+      int child_len;
+
+      if (child == NULL || child->frozen || child->updated
+	  || child->not_fetched || child->value == NULL)
+	continue;
+
+      cv = child->value;
+      if (VALUE_LVAL (cv) != lval_memory || value_bitsize (cv) != 0)
+	continue;
+
+      /* A string pointer may print differently even if its bytes did
+	 not change.  */
+      if (varobj_value_is_changeable_p (child)
+	  && !value_print_from_contents_p (child, cv))
+	continue;
+
+      child_addr = VALUE_ADDRESS (cv) + value_offset (cv);
+      child_len = TYPE_LENGTH (value_type (cv));
+      if (child_addr < addr || child_addr + child_len > addr + len)
+	continue;
+
+      if (old_value != new_value
+	  && memcmp (value_contents (old_value) + (child_addr - addr),
+		     value_contents (new_value) + (child_addr - addr),
+		     child_len) != 0)
+	continue;
+
+      child->unchanged_in_parent = 1;
+    }
+}
+
 /* Update the values for a variable and its children.  This is a
    two-pronged attack.  First, re-parse the value for the root's
    expression to see if it's changed.  Then go all the way
@@ -1208,7 +1406,16 @@ VEC(varobj_update_result) *varobj_update (struct varobj **varp, int explicit)
 
       /* Update this variable, unless it's a root, which is already
 	 updated.  */
-      if (v->root->rootvar != v)
+      if (v->root->rootvar != v && v->unchanged_in_parent)
+	{
+	  /* The parent found that this child was read from bytes
+	     that did not change, so neither did the child, nor
+	     its children read from the same bytes.  */
+	  v->unchanged_in_parent = 0;
+	  if (!varobj_value_is_changeable_p (v))
+	    mark_unchanged_children (v, v->value, v->value);
+	}
+      else if (v->root->rootvar != v)
 	{	  
 	  new = value_of_child (v->parent, v->index);
 	  if (install_new_value (v, new, 0 /* type not changed */))
@@ -1479,6 +1686,7 @@ new_variable (void)
   var->print_value = NULL;
   var->frozen = 0;
   var->not_fetched = 0;
+  var->unchanged_in_parent = 0;
 
   return var;
 }